@@ -10,6 +10,7 @@
 #include "material/pbr_material.h"
 #include "camera.h"
 #include "image/stb.h"
+#include "image/image_cache.h"
 #include "texture/texture_utils.h"
 
 namespace vox {
@@ -87,16 +88,11 @@ void IrradianceApp::loadScene() {
     
     const std::string path = "SkyMap/country/";
     const std::array<std::string, 6> imageNames = {"posx.png", "negx.png", "posy.png", "negy.png", "posz.png", "negz.png"};
-    std::array<std::unique_ptr<Image>, 6> images;
-    std::array<Image *, 6> imagePtr;
+    std::array<std::shared_ptr<const Image>, 6> images;
     for (int i = 0; i < 6; i++) {
-        images[i] = Image::load(path + imageNames[i]);
-        imagePtr[i] = images[i].get();
+        images[i] = ImageCache::shared().load(path + imageNames[i]);
     }
-    _cubeMap = std::make_shared<SampledTextureCube>(*_device,
-                                                    images[0]->extent().width, images[0]->extent().height, 1, true,
-                                                    images[0]->format());
-    _cubeMap->setPixelBuffer(*_commandQueue, imagePtr);
+    _cubeMap = ImageCache::shared().textureCube(images, *_device, *_commandQueue);
     
     _scene->ambientLight().setSpecularTexture(TextureUtils::createSpecularTexture(_cubeMap->texture(), *_device, *_library, *_commandQueue));
     
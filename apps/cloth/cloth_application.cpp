@@ -71,11 +71,7 @@ void ClothApplication::waitForSimulationStep() {
 void ClothApplication::updateSimulationGraphics() {
     for (auto actor: _clothList) {
         nv::cloth::MappedRange<physx::PxVec4> particles = actor->cloth->getCurrentParticles();
-        std::vector<PxVec3> particles3(particles.size());
-        for (uint32_t i = 0; i < particles.size(); ++i)
-            particles3[i] = particles[i].getXYZ();
-        
-        actor->clothRenderer->update(particles3.data(), particles.size());
+        actor->clothRenderer->update(particles.begin(), particles.size());
     }
 }
 
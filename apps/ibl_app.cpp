@@ -11,7 +11,9 @@
 #include "rendering/subpasses/skybox_subpass.h"
 #include "camera.h"
 #include "image/stb.h"
-#include "texture/texture_utils.h"
+#include "image/image_cache.h"
+#include "lighting/ibl_baker.h"
+#include "filesystem.h"
 #include "texture/sampled_texturecube.h"
 
 namespace vox {
@@ -46,21 +48,19 @@ void IBLApp::loadScene() {
     
     const std::string path = "SkyMap/country/";
     const std::array<std::string, 6> imageNames = {"posx.png", "negx.png", "posy.png", "negy.png", "posz.png", "negz.png"};
-    std::array<std::unique_ptr<Image>, 6> images;
-    std::array<Image *, 6> imagePtr;
+    std::array<std::shared_ptr<const Image>, 6> images;
     for (int i = 0; i < 6; i++) {
-        images[i] = Image::load(path + imageNames[i]);
-        imagePtr[i] = images[i].get();
+        images[i] = ImageCache::shared().load(path + imageNames[i]);
     }
-    _cubeMap = std::make_shared<SampledTextureCube>(*_device,
-                                                    images[0]->extent().width, images[0]->extent().height, 1, true,
-                                                    images[0]->format());
-    _cubeMap->setPixelBuffer(*_commandQueue, imagePtr);
+    _cubeMap = ImageCache::shared().textureCube(images, *_device, *_commandQueue);
     
-    auto specularTexture = TextureUtils::createSpecularTexture(_cubeMap->texture(), *_device, *_library, *_commandQueue);
-    _scene->ambientLight().setSpecularTexture(specularTexture);
-    
-    _scene->ambientLight().setDiffuseTexture(_cubeMap); // todo
+    IBLBakeOptions options;
+    options.cacheDirectory = fs::path::get(fs::path::Type::Storage);
+    const auto environment = IBLBaker::bake(IBLBaker::fromFaces({images[0].get(), images[1].get(), images[2].get(),
+        images[3].get(), images[4].get(), images[5].get()}), options);
+    _scene->ambientLight().setSpecularTexture(environment.createSpecularTexture(*_device, *_commandQueue));
+    _scene->ambientLight().setDiffuseSphericalHarmonics(environment.diffuseSphericalHarmonics);
+    _scene->ambientLight().setDiffuseMode(DiffuseMode::SphericalHarmonics);
     
     auto rootEntity = _scene->createRootEntity();
     auto cameraEntity = rootEntity->createChild();
@@ -11,6 +11,7 @@
 #include "rendering/subpasses/skybox_subpass.h"
 #include "camera.h"
 #include "image/stb.h"
+#include "image/image_cache.h"
 #include "texture/sampled_texturecube.h"
 
 namespace vox {
@@ -19,16 +20,11 @@ bool SkyboxApp::prepare(Engine &engine) {
     
     const std::string path = "SkyMap/country/";
     const std::array<std::string, 6> imageNames = {"posx.png", "negx.png", "posy.png", "negy.png", "posz.png", "negz.png"};
-    std::array<std::unique_ptr<Image>, 6> images;
-    std::array<Image *, 6> imagePtr;
+    std::array<std::shared_ptr<const Image>, 6> images;
     for (int i = 0; i < 6; i++) {
-        images[i] = Image::load(path + imageNames[i]);
-        imagePtr[i] = images[i].get();
+        images[i] = ImageCache::shared().load(path + imageNames[i]);
     }
-    auto cubeMap = std::make_shared<SampledTextureCube>(*_device,
-                                                        images[0]->extent().width, images[0]->extent().height, 1, true,
-                                                        images[0]->format());
-    cubeMap->setPixelBuffer(*_commandQueue, imagePtr);
+    auto cubeMap = ImageCache::shared().textureCube(images, *_device, *_commandQueue);
     
     
     auto skybox = std::make_unique<SkyboxSubpass>(_renderContext.get(), _scene.get(), _mainCamera);
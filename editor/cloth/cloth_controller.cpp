@@ -83,11 +83,7 @@ void ClothController::waitForSimulationStep() {
 void ClothController::updateSimulationGraphics() {
     for (auto actor: _clothList) {
         nv::cloth::MappedRange<physx::PxVec4> particles = actor->cloth->getCurrentParticles();
-        std::vector<physx::PxVec3> particles3(particles.size());
-        for (uint32_t i = 0; i < particles.size(); ++i)
-            particles3[i] = particles[i].getXYZ();
-        
-        actor->update(particles3.data(), particles.size());
+        actor->update(particles.begin(), particles.size());
     }
 }
 
@@ -8,6 +8,7 @@
 #define cloth_renderer_hpp
 
 #include "renderer.h"
+#include "mesh/smooth_normals.h"
 #include <Metal/Metal.hpp>
 #include <NvClothExt/ClothMeshDesc.h>
 #include <NvCloth/Cloth.h>
@@ -33,15 +34,21 @@ public:
     
     void update(const physx::PxVec3* positions, uint32_t numVertices);
     
+    /**
+     * Update from the particles of the cloth, the fourth float is the inverse mass and is skipped.
+     */
+    void update(const physx::PxVec4* particles, uint32_t numVertices);
+    
     void _updateBounds(BoundingBox3F &worldBounds) override;
     
 private:
     void _initialize(const void* vertices, uint32_t numVertices, uint32_t vertexSize,
-                     const uint16_t* faces, uint32_t numFaces);
+                     const uint32_t* faces, uint32_t numFaces);
+    
+    void _update(const float* positions, size_t stride, uint32_t numVertices);
     
-    std::vector<Vertex> _vertices;
-    std::vector<uint16_t> _indices;
-    std::vector<uint32_t> _submeshOffsets;
+    std::vector<uint32_t> _indices;
+    SmoothNormals _normals;
     
     uint32_t _numFaces;
     uint32_t _numVertices;
@@ -6,6 +6,7 @@
 
 
 #include "job_manager.h"
+#include "physics/cpu_dispatcher.h"
 #include <NvCloth/Solver.h>
 
 namespace vox {
@@ -62,29 +63,10 @@ void Job::Wait() {
     return;
 }
 
-void JobManager::WorkerEntryPoint(JobManager *parrent) {
-    while (true) {
-        Job *job;
-        {
-            std::unique_lock<std::mutex> lock(parrent->mJobQueueLock);
-            while (parrent->mJobQueue.size() == 0 && !parrent->mQuit)
-                parrent->mJobQueueEvent.wait(lock);
-            
-            if (parrent->mQuit)
-                return;
-            
-            job = parrent->mJobQueue.front();
-            parrent->mJobQueue.pop();
-        }
-        job->Execute();
-    }
-}
-
 void JobManager::Submit(Job *job) {
-    mJobQueueLock.lock();
-    mJobQueue.push(job);
-    mJobQueueLock.unlock();
-    mJobQueueEvent.notify_one();
+    physics::CpuDispatcher::shared().submit([job]() {
+        job->Execute();
+    });
 }
 
 void MultithreadedSolverHelper::Initialize(nv::cloth::Solver *solver, JobManager *jobManager) {
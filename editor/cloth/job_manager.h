@@ -12,7 +12,6 @@
 #include <regex>
 #include "callback_implementations.h"
 #include <mutex>
-#include <thread>
 #include <condition_variable>
 
 #include <foundation/PxVec4.h>
@@ -81,18 +80,6 @@ private:
     bool mFinished;
 };
 
-class CpuDispatcher : public physx::PxCpuDispatcher {
-    virtual void submitTask(physx::PxBaseTask &task) {
-        task.run();
-        task.release();
-    }
-    
-    virtual uint32_t getWorkerCount() const {
-        return 1;
-    }
-};
-
-
 class JobManager;
 
 class Job {
@@ -146,33 +133,9 @@ private:
     Job *mDependendJob;
 };
 
+/// Runs jobs on physics::CpuDispatcher::shared(), cloth shares its workers with the rigid body scenes.
 class JobManager {
 public:
-    JobManager() {
-        mWorkerCount = 8;
-        mWorkerThreads = new std::thread[mWorkerCount];
-        mQuit = false;
-        
-        for (int i = 0; i < mWorkerCount; i++)
-            mWorkerThreads[i] = std::thread(JobManager::WorkerEntryPoint, this);
-    }
-    
-    ~JobManager() {
-        if (!mQuit)
-            Quit();
-    }
-    
-    void Quit() {
-        std::unique_lock<std::mutex> lock(mJobQueueLock);
-        mQuit = true;
-        lock.unlock();
-        mJobQueueEvent.notify_all();
-        for (int i = 0; i < mWorkerCount; i++) {
-            mWorkerThreads[i].join();
-        }
-        delete[] mWorkerThreads;
-    }
-    
     template<int count, typename F>
     void ParallelLoop(F const &function) {
         /*for(int i = 0; i < count; i++)
@@ -190,20 +153,10 @@ public:
         finalJob.Wait();
     }
     
-    static void WorkerEntryPoint(JobManager *parrent);
-    
 private:
     friend class Job;
     
     void Submit(Job *job);
-    
-    int mWorkerCount;
-    std::thread *mWorkerThreads;
-    
-    std::mutex mJobQueueLock;
-    std::queue<Job *> mJobQueue;
-    std::condition_variable mJobQueueEvent;
-    bool mQuit;
 };
 
 class MultithreadedSolverHelper {
@@ -0,0 +1,146 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#define NS_PRIVATE_IMPLEMENTATION
+#define CA_PRIVATE_IMPLEMENTATION
+#define MTL_PRIVATE_IMPLEMENTATION
+
+#include <Foundation/Foundation.hpp>
+#include <Metal/Metal.hpp>
+#include <QuartzCore/QuartzCore.hpp>
+
+#include "image/astc_encoder.h"
+#include "image/stb.h"
+#include "timer.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+using namespace vox;
+
+namespace {
+void printUsage() {
+    std::cout << "usage: texture_cook <input.png|jpg> <output.ktx2|astc> [options]\n"
+    << "  -block <x>x<y>   ASTC block size, 4x4 to 12x12, default 6x6\n"
+    << "  -veryfast | -fast | -medium | -thorough | -exhaustive   quality preset, default medium\n"
+    << "  -linear          encode for the linear formats instead of sRGB\n"
+    << "  -flip            flip the image vertically on load\n"
+    << "  -report          compress the base level with every preset and print throughput and PSNR\n"
+    << "A .ktx2 output holds the whole mip chain, an .astc output only the base level." << std::endl;
+}
+
+std::vector<uint8_t> readFile(const std::string &filename) {
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+void writeFile(const std::vector<uint8_t> &data, const std::string &filename) {
+    std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+}
+
+bool endsWith(const std::string &value, const std::string &suffix) {
+    return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// base level throughput and PSNR, decoded again with Astc
+void report(const AstcEncoder &encoder, const Image &image, bool parallel) {
+    const auto width = static_cast<uint32_t>(image.extent().width);
+    const auto height = static_cast<uint32_t>(image.extent().height);
+    Timer timer;
+    timer.start();
+    const auto blocks = encoder.encode(image.data().data(), width, height, parallel);
+    const double seconds = timer.stop<Timer::Seconds>();
+
+    const Astc decoded(encoder.astcFile(blocks, width, height), false);
+    const double psnr = AstcEncoder::psnr(image.data().data(), decoded.data().data(), size_t(width) * height * 4);
+    std::printf("%-10s %5dx%-5d %8.2f MP/s %8.2f dB\n", AstcEncoder::presetName(encoder.preset()),
+                encoder.blockdim().x, encoder.blockdim().y, width * double(height) / 1.0e6 / seconds, psnr);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        printUsage();
+        return 1;
+    }
+    const std::string input = argv[1];
+    const std::string output = argv[2];
+    BlockDim blockdim{6, 6, 1};
+    auto preset = AstcEncoder::Preset::Medium;
+    bool srgb = true;
+    bool flipY = false;
+    bool reportPresets = false;
+    for (int i = 3; i < argc; i++) {
+        const std::string option = argv[i];
+        int x = 0;
+        int y = 0;
+        if (option == "-block" && i + 1 < argc && std::sscanf(argv[i + 1], "%dx%d", &x, &y) == 2) {
+            blockdim = {static_cast<uint8_t>(x), static_cast<uint8_t>(y), 1};
+            i++;
+        } else if (option == "-veryfast") {
+            preset = AstcEncoder::Preset::VeryFast;
+        } else if (option == "-fast") {
+            preset = AstcEncoder::Preset::Fast;
+        } else if (option == "-medium") {
+            preset = AstcEncoder::Preset::Medium;
+        } else if (option == "-thorough") {
+            preset = AstcEncoder::Preset::Thorough;
+        } else if (option == "-exhaustive") {
+            preset = AstcEncoder::Preset::Exhaustive;
+        } else if (option == "-linear") {
+            srgb = false;
+        } else if (option == "-flip") {
+            flipY = true;
+        } else if (option == "-report") {
+            reportPresets = true;
+        } else {
+            std::cerr << "unknown option " << option << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    try {
+        Stb image(readFile(input), flipY);
+        const Image &source = image;
+        const AstcEncoder encoder(blockdim, preset, srgb);
+        if (reportPresets) {
+            for (auto reported : {AstcEncoder::Preset::VeryFast, AstcEncoder::Preset::Fast, AstcEncoder::Preset::Medium,
+                AstcEncoder::Preset::Thorough, AstcEncoder::Preset::Exhaustive}) {
+                report(AstcEncoder(blockdim, reported, srgb), source, true);
+            }
+        }
+
+        Timer timer;
+        timer.start();
+        std::vector<uint8_t> file;
+        if (endsWith(output, ".astc")) {
+            const auto width = static_cast<uint32_t>(source.extent().width);
+            const auto height = static_cast<uint32_t>(source.extent().height);
+            file = encoder.astcFile(encoder.encode(source.data().data(), width, height), width, height);
+        } else {
+            file = encoder.encodeKtx(image);
+        }
+        writeFile(file, output);
+        std::cout << input << " -> " << output << " (" << AstcEncoder::presetName(preset) << ", "
+        << int(blockdim.x) << "x" << int(blockdim.y) << ") in " << timer.stop<Timer::Seconds>() << " s, "
+        << file.size() << " bytes" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "animation_lod.h"
+#include "animator.h"
+#include "camera.h"
+#include "components_manager.h"
+#include "entity.h"
+#include "mesh/skinned_mesh_renderer.h"
+
+#include <gtest/gtest.h>
+#include <ozz/animation/offline/raw_skeleton.h>
+#include <ozz/animation/offline/skeleton_builder.h>
+
+using namespace vox;
+
+namespace {
+// two joints, the tip one unit above the root
+ozz::animation::Skeleton makeSkeleton() {
+    ozz::animation::offline::RawSkeleton raw;
+    raw.roots.resize(1);
+    raw.roots[0].name = "root";
+    raw.roots[0].transform = ozz::math::Transform::identity();
+    raw.roots[0].children.resize(1);
+    auto &tip = raw.roots[0].children[0];
+    tip.name = "tip";
+    tip.transform = ozz::math::Transform::identity();
+    tip.transform.translation = ozz::math::Float3(0.f, 1.f, 0.f);
+    auto skeleton = ozz::animation::offline::SkeletonBuilder()(raw);
+    return std::move(*skeleton);
+}
+
+} // namespace
+
+TEST(AnimationLod, Interval) {
+    AnimationLod lod;
+    EXPECT_EQ(1u, lod.interval(1.f));
+    EXPECT_EQ(1u, lod.interval(0.3f));
+    EXPECT_EQ(2u, lod.interval(0.2f));
+    EXPECT_EQ(4u, lod.interval(0.05f));
+    EXPECT_EQ(8u, lod.interval(0.001f));
+
+    lod.levels = {{0.5f, 1}, {0.2f, 3}};
+    EXPECT_EQ(3u, lod.interval(0.01f));
+
+    lod.enabled = false;
+    EXPECT_EQ(1u, lod.interval(0.01f));
+}
+
+TEST(AnimationLod, SpreadOverFrames) {
+    constexpr uint32_t kAnimators = 1000;
+    constexpr uint32_t kInterval = 4;
+    std::vector<uint32_t> updates(kAnimators, 0);
+    for (uint64_t frame = 1; frame <= kInterval * 10; frame++) {
+        uint32_t due = 0;
+        for (uint32_t phase = 0; phase < kAnimators; phase++) {
+            if (AnimationLod::isDue(frame, kInterval, phase)) {
+                due++;
+                updates[phase]++;
+            }
+        }
+        // the same share of animators every frame
+        EXPECT_EQ(kAnimators / kInterval, due);
+    }
+    for (const auto count : updates) {
+        EXPECT_EQ(10u, count);
+    }
+    EXPECT_TRUE(AnimationLod::isDue(7, 1, 3));
+}
+
+TEST(AnimationLod, BoundsFollowEntity) {
+    auto entity = std::make_shared<Entity>("character");
+    auto renderer = entity->addComponent<SkinnedMeshRenderer>();
+    renderer->setSkeleton(makeSkeleton());
+    auto bounds = renderer->bounds();
+    EXPECT_NEAR(0.f, bounds.midPoint().x, 1e-5f);
+    EXPECT_NEAR(0.5f, bounds.midPoint().y, 1e-5f);
+
+    // the screen height of the animation level and the culling use the bounds where the character stands
+    entity->transform->setPosition(10, 0, -5);
+    bounds = renderer->bounds();
+    EXPECT_NEAR(10.f, bounds.midPoint().x, 1e-5f);
+    EXPECT_NEAR(0.5f, bounds.midPoint().y, 1e-5f);
+    EXPECT_NEAR(-5.f, bounds.midPoint().z, 1e-5f);
+    EXPECT_NEAR(1.f, bounds.upperCorner.y - bounds.lowerCorner.y, 1e-5f);
+}
+
+TEST(AnimationLod, ThrottlesAndSkipsAnimators) {
+    constexpr float kDeltaTime = 0.1f;
+    ComponentsManager manager;
+    manager.animationLod().levels = {{0.3f, 1}, {0.f, 4}};
+
+    auto cameraEntity = std::make_shared<Entity>("camera");
+    auto camera = cameraEntity->addComponent<Camera>();
+    camera->enableFrustumCulling = false;
+    camera->cullingMask = Layer::Layer0;
+
+    // near at full rate, far every fourth frame, hidden outside of the camera mask
+    std::vector<EntityPtr> entities;
+    std::vector<Animator *> animators;
+    for (const auto &[z, layer] : {std::make_pair(-2.f, Layer::Layer0), std::make_pair(-20.f, Layer::Layer0),
+                                   std::make_pair(-20.f, Layer::Layer1)}) {
+        auto entity = std::make_shared<Entity>("character");
+        entity->layer = layer;
+        entity->transform->setPosition(0, 0, z);
+        entity->addComponent<SkinnedMeshRenderer>()->setSkeleton(makeSkeleton());
+        animators.push_back(entity->addComponent<Animator>());
+        manager.addOnUpdateAnimators(animators.back());
+        entities.push_back(entity);
+    }
+    const auto near = animators[0];
+    const auto far = animators[1];
+    const auto hidden = animators[2];
+
+    // the far animator has phase 1, it is due when the frame + 1 is a multiple of 4
+    float farPending = 0;
+    for (uint32_t frame = 1; frame <= 8; frame++) {
+        manager.callAnimatorUpdate(kDeltaTime, {camera});
+        const bool farDue = (frame + 1) % 4 == 0;
+        const auto &statistics = manager.animationLodStatistics();
+        EXPECT_EQ(farDue ? 2u : 1u, statistics.updated);
+        EXPECT_EQ(farDue ? 0u : 1u, statistics.throttled);
+        EXPECT_EQ(1u, statistics.skipped);
+
+        EXPECT_FLOAT_EQ(0.f, near->pendingDeltaTime());
+        farPending = farDue ? 0.f : farPending + kDeltaTime;
+        EXPECT_NEAR(farPending, far->pendingDeltaTime(), 1e-5f);
+        EXPECT_NEAR(kDeltaTime * frame, hidden->pendingDeltaTime(), 1e-5f);
+    }
+
+    // back in view it catches up at once, although its reduced rate frame has not come
+    camera->cullingMask = Layer::Everything;
+    manager.callAnimatorUpdate(kDeltaTime, {camera});
+    EXPECT_EQ(2u, manager.animationLodStatistics().updated);
+    EXPECT_EQ(1u, manager.animationLodStatistics().throttled);
+    EXPECT_EQ(0u, manager.animationLodStatistics().skipped);
+    EXPECT_FLOAT_EQ(0.f, hidden->pendingDeltaTime());
+
+    // the animation level of detail off, every animator samples every frame
+    manager.animationLod().enabled = false;
+    camera->cullingMask = Layer::Layer0;
+    manager.callAnimatorUpdate(kDeltaTime, {camera});
+    EXPECT_EQ(3u, manager.animationLodStatistics().updated);
+    EXPECT_FLOAT_EQ(0.f, far->pendingDeltaTime());
+}
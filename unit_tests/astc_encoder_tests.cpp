@@ -0,0 +1,127 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "image/astc_encoder.h"
+#include "image/ktx_image.h"
+#include "image/mipmap_generator.h"
+#include "texture/sampled_texture.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+using namespace vox;
+
+namespace {
+// smooth gradients with a little noise, the content of most albedo textures
+std::vector<uint8_t> makeImage(uint32_t width, uint32_t height) {
+    std::mt19937 random(5);
+    std::uniform_int_distribution<int> noise(-4, 4);
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t *texel = rgba.data() + (size_t(y) * width + x) * 4;
+            texel[0] = static_cast<uint8_t>(std::clamp(int(255.f * x / width) + noise(random), 0, 255));
+            texel[1] = static_cast<uint8_t>(std::clamp(int(255.f * y / height) + noise(random), 0, 255));
+            texel[2] = static_cast<uint8_t>(128 + 100 * std::sin(x * 0.05f) * std::cos(y * 0.07f));
+            texel[3] = 255;
+        }
+    }
+    return rgba;
+}
+
+}
+
+TEST(AstcEncoder, ParallelMatchesSerial) {
+    const auto rgba = makeImage(67, 45);
+    const AstcEncoder encoder({6, 5, 1}, AstcEncoder::Preset::Fast);
+    const auto serial = encoder.encode(rgba.data(), 67, 45, false);
+    EXPECT_EQ(size_t(12 * 9 * 16), serial.size());
+    EXPECT_EQ(serial, encoder.encode(rgba.data(), 67, 45, true));
+}
+
+TEST(AstcEncoder, Ktx) {
+    constexpr uint32_t kSize = 64;
+    const Image image(makeImage(kSize, kSize), {{0, 0, {kSize, kSize, 1}}});
+    const AstcEncoder encoder({8, 8, 1}, AstcEncoder::Preset::Fast);
+    const Ktx ktx(encoder.encodeKtx(image), false);
+
+    EXPECT_EQ(MTL::PixelFormatASTC_8x8_sRGB, ktx.format());
+    EXPECT_EQ(kSize, ktx.extent().width);
+    EXPECT_EQ(kSize, ktx.extent().height);
+    // the chain is generated on a copy, the image keeps its single level
+    EXPECT_EQ(1u, image.mipmaps().size());
+    size_t chainSize = 0;
+    const auto levels = MipmapGenerator::chain(kSize, kSize, chainSize);
+    ASSERT_EQ(levels.size(), ktx.mipmaps().size());
+    // 8x8 blocks of 16 bytes, at least one block per level
+    size_t size = 0;
+    for (const auto &mipmap : levels) {
+        size += ((mipmap.extent.width + 7) / 8) * ((mipmap.extent.height + 7) / 8) * 16;
+    }
+    EXPECT_EQ(size, ktx.data().size());
+
+    // the strides the textures upload each level with, the levels below 8x8 are a partial block
+    size_t uploaded = 0;
+    for (const auto &mipmap : ktx.mipmaps()) {
+        const auto width = static_cast<uint32_t>(mipmap.extent.width);
+        const auto height = static_cast<uint32_t>(mipmap.extent.height);
+        EXPECT_EQ((width + 7) / 8 * 16, bytesPerRow(ktx.format(), width));
+        EXPECT_EQ((width + 7) / 8 * ((height + 7) / 8) * 16, bytesPerImage(ktx.format(), width, height));
+        uploaded += bytesPerImage(ktx.format(), width, height);
+    }
+    EXPECT_EQ(ktx.data().size(), uploaded);
+
+    EXPECT_EQ(3u * 3u * 16u, bytesPerImage(MTL::PixelFormatASTC_6x5_LDR, 13, 11));
+    EXPECT_EQ(3u * 2u * 4u, bytesPerImage(MTL::PixelFormatRGBA8Unorm, 3, 2));
+}
+
+TEST(AstcEncoder, Quality) {
+    constexpr uint32_t kSize = 64;
+    const auto rgba = makeImage(kSize, kSize);
+
+    double fastPsnr = 0;
+    for (auto preset : {AstcEncoder::Preset::Fast, AstcEncoder::Preset::Medium}) {
+        const AstcEncoder encoder({4, 4, 1}, preset);
+        const Astc decoded(encoder.astcFile(encoder.encode(rgba.data(), kSize, kSize), kSize, kSize), false);
+        ASSERT_EQ(rgba.size(), decoded.data().size());
+        const double psnr = AstcEncoder::psnr(rgba.data(), decoded.data().data(), rgba.size());
+        EXPECT_GT(psnr, 30);
+        if (preset == AstcEncoder::Preset::Fast) {
+            fastPsnr = psnr;
+        } else {
+            EXPECT_GE(psnr, fastPsnr - 0.1);
+        }
+    }
+}
+
+TEST(AstcEncoder, DISABLED_Presets) {
+    constexpr uint32_t kWidth = 256;
+    constexpr uint32_t kHeight = 256;
+    const auto rgba = makeImage(kWidth, kHeight);
+    const double megapixels = kWidth * kHeight / 1.0e6;
+
+    for (auto preset : {AstcEncoder::Preset::Fast, AstcEncoder::Preset::Medium, AstcEncoder::Preset::Thorough}) {
+        const AstcEncoder encoder({4, 4, 1}, preset);
+        Timer timer;
+        timer.start();
+        const auto blocks = encoder.encode(rgba.data(), kWidth, kHeight);
+        const double seconds = timer.stop<Timer::Seconds>();
+
+        const Astc decoded(encoder.astcFile(blocks, kWidth, kHeight), false);
+        const double psnr = AstcEncoder::psnr(rgba.data(), decoded.data().data(), rgba.size());
+        RecordProperty(AstcEncoder::presetName(preset) + std::string("_mp_per_s"), std::to_string(megapixels / seconds));
+        RecordProperty(AstcEncoder::presetName(preset) + std::string("_psnr"), std::to_string(psnr));
+    }
+}
+
+TEST(AstcEncoder, Psnr) {
+    const std::vector<uint8_t> reference = {0, 100, 200, 255};
+    EXPECT_TRUE(std::isinf(AstcEncoder::psnr(reference.data(), reference.data(), 4)));
+    const std::vector<uint8_t> image = {1, 99, 201, 254};
+    EXPECT_NEAR(10 * std::log10(255.0 * 255.0), AstcEncoder::psnr(reference.data(), image.data(), 4), 1e-9);
+}
@@ -0,0 +1,80 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "image/astc.h"
+#include "thread_pool.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace vox;
+
+namespace {
+// .astc file of random blocks, which cover every block mode and the error color of invalid blocks
+std::vector<uint8_t> makeAstcFile(uint32_t width, uint32_t height, uint8_t blockX, uint8_t blockY, uint32_t seed) {
+    std::vector<uint8_t> file = {
+        0x13, 0xAB, 0xA1, 0x5C, blockX, blockY, 1,
+        static_cast<uint8_t>(width), static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width >> 16),
+        static_cast<uint8_t>(height), static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height >> 16),
+        1, 0, 0};
+    const size_t blocks = ((width + blockX - 1) / blockX) * ((height + blockY - 1) / blockY);
+    std::mt19937 random(seed);
+    for (size_t i = 0; i < blocks * 16; i++) {
+        file.push_back(static_cast<uint8_t>(random()));
+    }
+    return file;
+}
+
+}
+
+TEST(Astc, ConstantColorBlock) {
+    // LDR void extent block without extent, 16 bit green
+    std::vector<uint8_t> file = makeAstcFile(4, 4, 4, 4, 0);
+    const uint8_t block[16] = {0xFC, 0xFD, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF};
+    std::copy(block, block + 16, file.end() - 16);
+
+    const Astc astc(file, false);
+    ASSERT_EQ(4u * 4 * 4, astc.data().size());
+    for (size_t i = 0; i < 16; i++) {
+        EXPECT_EQ(0, astc.data()[i * 4]);
+        EXPECT_GE(astc.data()[i * 4 + 1], 254);
+        EXPECT_EQ(0, astc.data()[i * 4 + 2]);
+        EXPECT_GE(astc.data()[i * 4 + 3], 254);
+    }
+}
+
+TEST(Astc, ParallelMatchesSerial) {
+    // sizes which are not multiples of the block size
+    const std::vector<BlockDim> blocks = {{4, 4, 1}, {6, 5, 1}, {8, 8, 1}, {12, 12, 1}};
+    for (const auto &block : blocks) {
+        const auto file = makeAstcFile(301, 157, block.x, block.y, block.x * 16 + block.y);
+        const Astc serial(file, false, false);
+        const Astc parallel(file, false, true);
+        ASSERT_EQ(301u * 157 * 4, serial.data().size());
+        EXPECT_EQ(serial.data(), parallel.data()) << int(block.x) << "x" << int(block.y);
+    }
+}
+
+TEST(Astc, DISABLED_Benchmark) {
+    constexpr uint32_t kSize = 2048;
+    const auto file = makeAstcFile(kSize, kSize, 4, 4, 1);
+    const double megapixels = kSize * kSize / 1.0e6;
+
+    Timer timer;
+    timer.start();
+    const Astc serial(file, false, false);
+    const double serialTime = timer.stop<Timer::Seconds>();
+
+    timer.start();
+    const Astc parallel(file, false, true);
+    const double parallelTime = timer.stop<Timer::Seconds>();
+
+    RecordProperty("serial_mp_per_s", std::to_string(megapixels / serialTime));
+    RecordProperty("parallel_mp_per_s", std::to_string(megapixels / parallelTime));
+    EXPECT_EQ(serial.data(), parallel.data());
+}
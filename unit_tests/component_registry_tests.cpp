@@ -0,0 +1,168 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "component_registry.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+
+using namespace vox;
+
+namespace {
+struct FakeComponent {
+    ssize_t index = -1;
+    int updateCount = 0;
+};
+
+void expectConsistent(const ComponentRegistry<FakeComponent> &registry) {
+    for (size_t i = 0; i < registry.size(); i++) {
+        ASSERT_NE(nullptr, registry[i]);
+        EXPECT_EQ(static_cast<ssize_t>(i), registry[i]->index);
+    }
+}
+
+// vector::erase registration, with the index fix-up the old ComponentsManager was missing
+struct EraseRegistry {
+    std::vector<FakeComponent *> elements;
+
+    void add(FakeComponent *element) {
+        element->index = elements.size();
+        elements.push_back(element);
+    }
+
+    void remove(FakeComponent *element) {
+        elements.erase(elements.begin() + element->index);
+        for (size_t i = element->index; i < elements.size(); i++) {
+            elements[i]->index = i;
+        }
+        element->index = -1;
+    }
+};
+
+template<class Registry>
+double spawnDestroy(Registry &registry, std::vector<FakeComponent> &components, int frames) {
+    std::mt19937 rng(11);
+    std::vector<FakeComponent *> order(components.size());
+    for (size_t i = 0; i < components.size(); i++) {
+        order[i] = &components[i];
+    }
+
+    Timer timer;
+    timer.start();
+    for (int frame = 0; frame < frames; frame++) {
+        for (auto &component : components) {
+            registry.add(&component);
+        }
+        std::shuffle(order.begin(), order.end(), rng);
+        for (auto component : order) {
+            registry.remove(component);
+        }
+    }
+    return timer.stop<Timer::Milliseconds>() / frames;
+}
+
+}
+
+TEST(ComponentRegistry, SwapRemoveFixesIndex) {
+    ComponentRegistry<FakeComponent> registry(&FakeComponent::index);
+    std::vector<FakeComponent> components(5);
+    for (auto &component : components) {
+        registry.add(&component);
+    }
+    expectConsistent(registry);
+
+    registry.remove(&components[1]);
+    EXPECT_EQ(-1, components[1].index);
+    EXPECT_EQ(4u, registry.size());
+    // the last element took the empty position
+    EXPECT_EQ(&components[4], registry[1]);
+    expectConsistent(registry);
+
+    registry.remove(&components[4]);
+    registry.remove(&components[3]);
+    expectConsistent(registry);
+    EXPECT_EQ(2u, registry.size());
+
+    registry.remove(&components[0]);
+    registry.remove(&components[2]);
+    EXPECT_EQ(0u, registry.size());
+}
+
+TEST(ComponentRegistry, RemoveDuringIteration) {
+    ComponentRegistry<FakeComponent> registry(&FakeComponent::index);
+    std::vector<FakeComponent> components(8);
+    FakeComponent late;
+    for (auto &component : components) {
+        registry.add(&component);
+    }
+
+    registry.beginIteration();
+    for (size_t i = 0; i < registry.size(); i++) {
+        auto element = registry[i];
+        if (element == nullptr) {
+            continue;
+        }
+        element->updateCount++;
+        if (element == &components[2]) {
+            // before and after the cursor, and the element itself
+            registry.remove(&components[0]);
+            registry.remove(&components[7]);
+            registry.remove(&components[2]);
+            registry.add(&late);
+        }
+    }
+    // removed elements stay as holes until the iteration ends
+    EXPECT_EQ(9u, registry.size());
+    EXPECT_EQ(nullptr, registry[0]);
+    registry.endIteration();
+
+    EXPECT_EQ(6u, registry.size());
+    expectConsistent(registry);
+    EXPECT_EQ(1, components[0].updateCount);
+    EXPECT_EQ(0, components[7].updateCount);
+    for (int i = 1; i < 7; i++) {
+        EXPECT_EQ(1, components[i].updateCount);
+    }
+    EXPECT_EQ(1, late.updateCount);
+    EXPECT_EQ(-1, components[2].index);
+}
+
+TEST(ComponentRegistry, NestedIteration) {
+    ComponentRegistry<FakeComponent> registry(&FakeComponent::index);
+    std::vector<FakeComponent> components(3);
+    for (auto &component : components) {
+        registry.add(&component);
+    }
+    registry.beginIteration();
+    registry.beginIteration();
+    registry.remove(&components[0]);
+    registry.endIteration();
+    EXPECT_EQ(3u, registry.size());
+    // re-registration while the hole is pending
+    registry.add(&components[0]);
+    registry.endIteration();
+    EXPECT_EQ(3u, registry.size());
+    expectConsistent(registry);
+}
+
+TEST(ComponentRegistry, DISABLED_SpawnDestroyBenchmark) {
+    constexpr int kEntityCount = 10000;
+    constexpr int kFrames = 10;
+    std::vector<FakeComponent> components(kEntityCount);
+
+    ComponentRegistry<FakeComponent> registry(&FakeComponent::index);
+    const double swapTime = spawnDestroy(registry, components, kFrames);
+    EXPECT_EQ(0u, registry.size());
+
+    EraseRegistry eraseRegistry;
+    const double eraseTime = spawnDestroy(eraseRegistry, components, 1);
+    EXPECT_EQ(0u, eraseRegistry.elements.size());
+
+    RecordProperty("swap_and_pop_ms", std::to_string(swapTime));
+    RecordProperty("erase_ms", std::to_string(eraseTime));
+}
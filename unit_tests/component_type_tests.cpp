@@ -0,0 +1,141 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "component_type.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+
+using namespace vox;
+
+namespace {
+struct FakeComponent {
+    virtual ~FakeComponent() = default;
+
+    float value = 0;
+};
+
+struct FakeTransform : public FakeComponent {};
+
+struct FakeRenderer : public FakeComponent {};
+
+struct FakeMeshRenderer : public FakeRenderer {};
+
+struct FakeScript : public FakeComponent {};
+
+using FakeComponentPtr = std::unique_ptr<FakeComponent>;
+
+struct FakeEntity {
+    std::vector<FakeComponentPtr> components;
+    ComponentTypeCache cache;
+
+    template<class T>
+    T *scan() {
+        for (const auto &component : components) {
+            T *match = dynamic_cast<T *>(component.get());
+            if (match) {
+                return match;
+            }
+        }
+        return nullptr;
+    }
+};
+
+}
+
+TEST(ComponentType, DenseStableIds) {
+    const auto transform = componentTypeId<FakeTransform>();
+    const auto renderer = componentTypeId<FakeRenderer>();
+    EXPECT_NE(transform, renderer);
+    EXPECT_EQ(transform, componentTypeId<FakeTransform>());
+    EXPECT_EQ(renderer, componentTypeId<FakeRenderer>());
+}
+
+TEST(ComponentType, CacheFirstMatch) {
+    FakeEntity entity;
+    entity.components.emplace_back(new FakeTransform());
+    entity.components.emplace_back(new FakeMeshRenderer());
+    entity.components.emplace_back(new FakeRenderer());
+
+    // base type query finds the derived component, as dynamic_cast does
+    EXPECT_EQ(entity.components[1].get(), entity.cache.find<FakeRenderer>(entity.components));
+    EXPECT_EQ(entity.components[1].get(), entity.cache.find<FakeMeshRenderer>(entity.components));
+    EXPECT_EQ(entity.components[0].get(), entity.cache.find<FakeComponent>(entity.components));
+    EXPECT_EQ(nullptr, entity.cache.find<FakeScript>(entity.components));
+
+    entity.components.erase(entity.components.begin() + 1);
+    entity.cache.invalidate();
+    EXPECT_EQ(entity.components[1].get(), entity.cache.find<FakeRenderer>(entity.components));
+    EXPECT_EQ(nullptr, entity.cache.find<FakeMeshRenderer>(entity.components));
+
+    entity.components.emplace_back(new FakeScript());
+    entity.cache.invalidate();
+    EXPECT_EQ(entity.components[2].get(), entity.cache.find<FakeScript>(entity.components));
+}
+
+TEST(ComponentType, CacheAllMatches) {
+    FakeEntity entity;
+    entity.components.emplace_back(new FakeRenderer());
+    entity.components.emplace_back(new FakeScript());
+    entity.components.emplace_back(new FakeMeshRenderer());
+
+    std::vector<FakeRenderer *> renderers;
+    entity.cache.findAll<FakeRenderer>(entity.components, renderers);
+    ASSERT_EQ(2u, renderers.size());
+    EXPECT_EQ(entity.components[0].get(), renderers[0]);
+    EXPECT_EQ(entity.components[2].get(), renderers[1]);
+    EXPECT_EQ(entity.components[0].get(), entity.cache.find<FakeRenderer>(entity.components));
+
+    // results are appended, as for the children of an entity
+    entity.cache.findAll<FakeRenderer>(entity.components, renderers);
+    EXPECT_EQ(4u, renderers.size());
+
+    entity.components.erase(entity.components.begin());
+    entity.cache.invalidate();
+    renderers.clear();
+    entity.cache.findAll<FakeRenderer>(entity.components, renderers);
+    ASSERT_EQ(1u, renderers.size());
+    EXPECT_EQ(entity.components[1].get(), renderers[0]);
+
+    std::vector<FakeTransform *> transforms;
+    entity.cache.findAll<FakeTransform>(entity.components, transforms);
+    EXPECT_TRUE(transforms.empty());
+}
+
+TEST(ComponentType, DISABLED_GetComponentBenchmark) {
+    constexpr size_t kEntityCount = 100000;
+    std::vector<FakeEntity> entities(kEntityCount);
+    for (auto &entity : entities) {
+        entity.components.emplace_back(new FakeTransform());
+        entity.components.emplace_back(new FakeScript());
+        entity.components.emplace_back(new FakeScript());
+        entity.components.emplace_back(new FakeMeshRenderer());
+    }
+
+    Timer timer;
+    timer.start();
+    size_t found = 0;
+    for (auto &entity : entities) {
+        found += entity.scan<FakeRenderer>() != nullptr;
+    }
+    const double scanTime = timer.stop<Timer::Milliseconds>();
+    EXPECT_EQ(kEntityCount, found);
+
+    for (auto &entity : entities) {
+        entity.cache.find<FakeRenderer>(entity.components);
+    }
+    timer.start();
+    found = 0;
+    for (auto &entity : entities) {
+        found += entity.cache.find<FakeRenderer>(entity.components) != nullptr;
+    }
+    const double cacheTime = timer.stop<Timer::Milliseconds>();
+    EXPECT_EQ(kEntityCount, found);
+
+    RecordProperty("scan_ms", std::to_string(scanTime));
+    RecordProperty("cached_ms", std::to_string(cacheTime));
+}
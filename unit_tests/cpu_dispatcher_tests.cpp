@@ -0,0 +1,163 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "physics/cpu_dispatcher.h"
+#include "physics/physics.h"
+#include "thread_pool.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <future>
+#include <thread>
+
+using namespace vox;
+using namespace vox::physics;
+
+namespace {
+class CountingTask : public physx::PxBaseTask {
+public:
+    std::atomic<int> runs{0};
+    std::atomic<int> releases{0};
+
+    void run() override {
+        runs++;
+    }
+
+    void release() override {
+        releases++;
+    }
+
+    const char *getName() const override {
+        return "CountingTask";
+    }
+};
+
+}
+
+TEST(CpuDispatcher, RunsEveryJob) {
+    CpuDispatcher dispatcher(3);
+    std::atomic<int> count{0};
+    for (int i = 0; i < 1000; i++) {
+        dispatcher.submit([&count]() {
+            count++;
+        });
+    }
+    dispatcher.wait();
+    EXPECT_EQ(1000, count.load());
+}
+
+TEST(CpuDispatcher, RunsAndReleasesTasks) {
+    CpuDispatcher dispatcher(2);
+    std::vector<CountingTask> tasks(64);
+    for (auto &task : tasks) {
+        dispatcher.submitTask(task);
+    }
+    dispatcher.wait();
+    for (const auto &task : tasks) {
+        EXPECT_EQ(1, task.runs.load());
+        EXPECT_EQ(1, task.releases.load());
+    }
+}
+
+TEST(CpuDispatcher, WorkerLimit) {
+    if (ThreadPool::shared().threadCount() < 3) {
+        GTEST_SKIP() << "needs three pool workers";
+    }
+    CpuDispatcher dispatcher(2);
+    EXPECT_EQ(2u, dispatcher.getWorkerCount());
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    for (int i = 0; i < 32; i++) {
+        dispatcher.submit([&]() {
+            const int now = ++running;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            running--;
+        });
+    }
+    dispatcher.wait();
+    EXPECT_EQ(2, peak.load());
+}
+
+TEST(CpuDispatcher, InlineWithoutWorkers) {
+    CpuDispatcher dispatcher(0);
+    std::thread::id ran;
+    dispatcher.submit([&ran]() {
+        ran = std::this_thread::get_id();
+    });
+    EXPECT_EQ(std::this_thread::get_id(), ran);
+}
+
+TEST(CpuDispatcher, GrowingStartsQueuedJobs) {
+    if (ThreadPool::shared().threadCount() < 2) {
+        GTEST_SKIP() << "needs two pool workers";
+    }
+    CpuDispatcher dispatcher(1);
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    dispatcher.submit([released]() {
+        released.wait();
+    });
+    std::promise<void> ran;
+    dispatcher.submit([&ran]() {
+        ran.set_value();
+    });
+
+    // the only worker is blocked, the second job waits for another one
+    auto future = ran.get_future();
+    EXPECT_EQ(std::future_status::timeout, future.wait_for(std::chrono::milliseconds(20)));
+    dispatcher.setWorkerCount(2);
+    EXPECT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(5)));
+    release.set_value();
+    dispatcher.wait();
+}
+
+TEST(CpuDispatcher, DISABLED_Benchmark) {
+    // boxes of the stacking scene of physx_dynamic_app, in pyramids large enough to spread over workers
+    constexpr int kStackCount = 8;
+    constexpr int kStackSize = 12;
+    constexpr int kStepCount = 240;
+    static Physics nativePhysics;
+    PxPhysics &physics = *nativePhysics();
+    PxMaterial *material = physics.createMaterial(1, 2, 0.1f);
+
+    std::vector<uint32_t> workerCounts{0, 1, 2, 4};
+    workerCounts.push_back(static_cast<uint32_t>(ThreadPool::shared().threadCount()));
+    for (const auto workerCount : workerCounts) {
+        CpuDispatcher dispatcher(workerCount);
+        PxSceneDesc sceneDesc(physics.getTolerancesScale());
+        sceneDesc.gravity = PxVec3(0.0f, -9.81f, 0.0f);
+        sceneDesc.cpuDispatcher = &dispatcher;
+        sceneDesc.filterShader = PxDefaultSimulationFilterShader;
+        PxScene *scene = physics.createScene(sceneDesc);
+
+        scene->addActor(*PxCreatePlane(physics, PxPlane(0, 1, 0, 0), *material));
+        const PxBoxGeometry box(0.5f, 0.5f, 0.5f);
+        for (int stack = 0; stack < kStackCount; stack++) {
+            for (int row = 0; row < kStackSize; row++) {
+                for (int i = 0; i < kStackSize - row; i++) {
+                    const PxVec3 position(i - (kStackSize - row) * 0.5f, row + 0.5f, stack * 3.f - kStackCount * 1.5f);
+                    scene->addActor(*PxCreateDynamic(physics, PxTransform(position), box, *material, 10));
+                }
+            }
+        }
+
+        Timer timer;
+        timer.start();
+        for (int step = 0; step < kStepCount; step++) {
+            scene->simulate(1.f / 60);
+            scene->fetchResults(true);
+        }
+        const double time = timer.stop<Timer::Milliseconds>();
+        scene->release();
+
+        RecordProperty("ms_on_" + std::to_string(workerCount) + "_workers", std::to_string(time));
+    }
+    material->release();
+}
@@ -0,0 +1,215 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "loader/gltf_accessor.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <cstring>
+
+using namespace vox;
+using namespace vox::loader;
+
+namespace {
+int addView(tinygltf::Model &model, const void *data, size_t size, size_t byteStride = 0) {
+    if (model.buffers.empty()) {
+        model.buffers.emplace_back();
+    }
+    auto &buffer = model.buffers[0].data;
+    tinygltf::BufferView view;
+    view.buffer = 0;
+    view.byteOffset = buffer.size();
+    view.byteLength = size;
+    view.byteStride = byteStride;
+    buffer.resize(buffer.size() + size);
+    memcpy(buffer.data() + view.byteOffset, data, size);
+    model.bufferViews.push_back(view);
+    return static_cast<int>(model.bufferViews.size() - 1);
+}
+
+int addAccessor(tinygltf::Model &model, int view, size_t byteOffset, int type, int componentType, size_t count,
+                bool normalized = false) {
+    tinygltf::Accessor accessor;
+    accessor.bufferView = view;
+    accessor.byteOffset = byteOffset;
+    accessor.componentType = componentType;
+    accessor.type = type;
+    accessor.count = count;
+    accessor.normalized = normalized;
+    model.accessors.push_back(accessor);
+    return static_cast<int>(model.accessors.size() - 1);
+}
+
+#pragma pack(push, 1)
+// layout of an interleaved glTF vertex, 24 bytes
+struct PackedVertex {
+    float position[3];
+    int16_t normal[3];
+    uint16_t uv[2];
+    uint8_t padding[2];
+};
+#pragma pack(pop)
+
+}
+
+TEST(AccessorView, StridedFloat) {
+    tinygltf::Model model;
+    const float interleaved[] = {1, 2, 3, -1, 4, 5, 6, -1, 7, 8, 9, -1};
+    const int view = addView(model, interleaved, sizeof(interleaved), 16);
+    const AccessorView positions(model, addAccessor(model, view, 0, TINYGLTF_TYPE_VEC3, TINYGLTF_COMPONENT_TYPE_FLOAT, 3));
+    ASSERT_TRUE(positions.valid());
+    EXPECT_EQ(16u, positions.stride);
+
+    // into a vertex with 2 floats of other data in front
+    std::vector<float> vertices(3 * 6, 0);
+    convertToFloat(positions, vertices.data() + 2, 6, 3, 0, positions.count);
+    EXPECT_EQ(4, vertices[8]);
+    EXPECT_EQ(9, vertices[16]);
+    EXPECT_EQ(0, vertices[17]);
+
+    // rgb to rgba
+    std::vector<float> colors(12, 0);
+    convertToFloat(positions, colors.data(), 4, 4, 1, positions.count);
+    EXPECT_EQ((std::vector<float>{1, 2, 3, 1, 4, 5, 6, 1, 7, 8, 9, 1}), colors);
+}
+
+TEST(AccessorView, NormalizedIntegers) {
+    tinygltf::Model model;
+    const uint8_t colors[] = {0, 255, 51, 255};
+    const int16_t normals[] = {32767, -32767, -32768, 0};
+    const uint16_t joints[] = {3, 65535, 0, 7};
+    const int colorAccessor = addAccessor(model, addView(model, colors, sizeof(colors)), 0,
+                                          TINYGLTF_TYPE_VEC4, TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, 1, true);
+    const int normalAccessor = addAccessor(model, addView(model, normals, sizeof(normals)), 0,
+                                           TINYGLTF_TYPE_VEC4, TINYGLTF_COMPONENT_TYPE_SHORT, 1, true);
+    const int jointAccessor = addAccessor(model, addView(model, joints, sizeof(joints)), 0,
+                                          TINYGLTF_TYPE_VEC4, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, 1);
+    // views point into the buffer, so they are made after the buffer stops growing
+    const AccessorView color(model, colorAccessor);
+    const AccessorView normal(model, normalAccessor);
+    const AccessorView joint(model, jointAccessor);
+
+    float out[4];
+    convertToFloat(color, out, 4, 4, 0, 1);
+    EXPECT_FLOAT_EQ(0, out[0]);
+    EXPECT_FLOAT_EQ(1, out[1]);
+    EXPECT_FLOAT_EQ(0.2f, out[2]);
+    convertToFloat(normal, out, 4, 4, 0, 1);
+    EXPECT_FLOAT_EQ(1, out[0]);
+    EXPECT_FLOAT_EQ(-1, out[1]);
+    // clamped to -1
+    EXPECT_FLOAT_EQ(-1, out[2]);
+    // joint indices are not normalized
+    convertToFloat(joint, out, 4, 4, 0, 1);
+    EXPECT_FLOAT_EQ(3, out[0]);
+    EXPECT_FLOAT_EQ(65535, out[1]);
+    EXPECT_FLOAT_EQ(7, out[3]);
+}
+
+TEST(AccessorView, Sparse) {
+    tinygltf::Model model;
+    const float base[] = {0, 0, 1, 1, 2, 2, 3, 3};
+    const uint8_t indices[] = {1, 3};
+    const float values[] = {10, 11, 30, 31};
+    const int baseAccessor = addAccessor(model, addView(model, base, sizeof(base)), 0,
+                                         TINYGLTF_TYPE_VEC2, TINYGLTF_COMPONENT_TYPE_FLOAT, 4);
+    auto &accessor = model.accessors[baseAccessor];
+    accessor.sparse.isSparse = true;
+    accessor.sparse.count = 2;
+    accessor.sparse.indices.bufferView = addView(model, indices, sizeof(indices));
+    accessor.sparse.indices.componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+    accessor.sparse.values.bufferView = addView(model, values, sizeof(values));
+
+    std::vector<float> out(8);
+    convertToFloat(AccessorView(model, baseAccessor), out.data(), 2, 2, 0, 4);
+    EXPECT_EQ((std::vector<float>{0, 0, 10, 11, 2, 2, 30, 31}), out);
+
+    // without buffer view the base values are zeros
+    model.accessors[baseAccessor].bufferView = -1;
+    convertToFloat(AccessorView(model, baseAccessor), out.data(), 2, 2, 0, 4);
+    EXPECT_EQ((std::vector<float>{0, 0, 10, 11, 0, 0, 30, 31}), out);
+}
+
+TEST(AccessorView, Indices) {
+    tinygltf::Model model;
+    const uint8_t small[] = {2, 1, 0};
+    const uint16_t medium[] = {65535, 1, 7};
+    const int smallAccessor = addAccessor(model, addView(model, small, sizeof(small)), 0,
+                                          TINYGLTF_TYPE_SCALAR, TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, 3);
+    const int mediumAccessor = addAccessor(model, addView(model, medium, sizeof(medium)), 0,
+                                           TINYGLTF_TYPE_SCALAR, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, 3);
+    const int floatAccessor = addAccessor(model, 0, 0, TINYGLTF_TYPE_SCALAR, TINYGLTF_COMPONENT_TYPE_FLOAT, 1);
+
+    std::vector<uint32_t> out(3);
+    ASSERT_TRUE(convertToIndices(AccessorView(model, smallAccessor), out.data()));
+    EXPECT_EQ((std::vector<uint32_t>{2, 1, 0}), out);
+    ASSERT_TRUE(convertToIndices(AccessorView(model, mediumAccessor), out.data()));
+    EXPECT_EQ((std::vector<uint32_t>{65535, 1, 7}), out);
+    EXPECT_FALSE(convertToIndices(AccessorView(model, floatAccessor), out.data()));
+}
+
+TEST(AccessorView, OutOfBuffer) {
+    tinygltf::Model model;
+    const float data[] = {1, 2, 3};
+    const int view = addView(model, data, sizeof(data));
+    EXPECT_FALSE(AccessorView(model, addAccessor(model, view, 0, TINYGLTF_TYPE_VEC3, TINYGLTF_COMPONENT_TYPE_FLOAT, 2)).valid());
+    EXPECT_FALSE(AccessorView(model, addAccessor(model, view, 4, TINYGLTF_TYPE_VEC3, TINYGLTF_COMPONENT_TYPE_FLOAT, 1)).valid());
+    EXPECT_FALSE(AccessorView(model, addAccessor(model, 7, 0, TINYGLTF_TYPE_VEC3, TINYGLTF_COMPONENT_TYPE_FLOAT, 1)).valid());
+
+    model.bufferViews[view].buffer = 3;
+    EXPECT_FALSE(AccessorView(model, addAccessor(model, view, 0, TINYGLTF_TYPE_SCALAR, TINYGLTF_COMPONENT_TYPE_FLOAT, 1)).valid());
+    model.bufferViews[view].buffer = -1;
+    EXPECT_FALSE(AccessorView(model, addAccessor(model, view, 0, TINYGLTF_TYPE_SCALAR, TINYGLTF_COMPONENT_TYPE_FLOAT, 1)).valid());
+}
+
+TEST(AccessorView, DISABLED_InterleaveBenchmark) {
+    constexpr size_t kVertexCount = 1 << 20;
+    std::vector<PackedVertex> source(kVertexCount);
+    for (size_t i = 0; i < kVertexCount; i++) {
+        source[i] = {{float(i), float(i + 1), float(i + 2)}, {0, 32767, 0}, {uint16_t(i), uint16_t(i * 3)}, {0, 0}};
+    }
+    tinygltf::Model model;
+    const int view = addView(model, source.data(), source.size() * sizeof(PackedVertex), sizeof(PackedVertex));
+    const AccessorView position(model, addAccessor(model, view, 0, TINYGLTF_TYPE_VEC3,
+                                                   TINYGLTF_COMPONENT_TYPE_FLOAT, kVertexCount));
+    const AccessorView normal(model, addAccessor(model, view, 12, TINYGLTF_TYPE_VEC3,
+                                                 TINYGLTF_COMPONENT_TYPE_SHORT, kVertexCount, true));
+    const AccessorView uv(model, addAccessor(model, view, 18, TINYGLTF_TYPE_VEC2,
+                                             TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, kVertexCount, true));
+    ASSERT_TRUE(position.valid() && normal.valid() && uv.valid());
+
+    // per vertex insert through temporary attribute arrays, as the loader did before
+    Timer timer;
+    timer.start();
+    std::vector<float> normals(kVertexCount * 3);
+    std::vector<float> uvs(kVertexCount * 2);
+    for (size_t i = 0; i < kVertexCount; i++) {
+        for (int c = 0; c < 3; c++) {
+            normals[i * 3 + c] = std::max(source[i].normal[c] / 32767.f, -1.f);
+        }
+        for (int c = 0; c < 2; c++) {
+            uvs[i * 2 + c] = source[i].uv[c] / 65535.f;
+        }
+    }
+    std::vector<float> inserted;
+    inserted.reserve(kVertexCount * 8);
+    for (size_t i = 0; i < kVertexCount; i++) {
+        inserted.insert(inserted.end(), &source[i].position[0], &source[i].position[3]);
+        inserted.insert(inserted.end(), &normals[i * 3], &normals[i * 3 + 3]);
+        inserted.insert(inserted.end(), &uvs[i * 2], &uvs[i * 2 + 2]);
+    }
+    const double insertTime = timer.stop<Timer::Milliseconds>();
+
+    timer.start();
+    std::vector<float> vertices(kVertexCount * 8);
+    convertToFloat(position, vertices.data(), 8, 3, 0, kVertexCount);
+    convertToFloat(normal, vertices.data() + 3, 8, 3, 0, kVertexCount);
+    convertToFloat(uv, vertices.data() + 6, 8, 2, 0, kVertexCount);
+    const double kernelTime = timer.stop<Timer::Milliseconds>();
+    EXPECT_EQ(inserted, vertices);
+    RecordProperty("insert_ms", std::to_string(insertTime));
+    RecordProperty("kernels_ms", std::to_string(kernelTime));
+}
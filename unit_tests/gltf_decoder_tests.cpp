@@ -0,0 +1,134 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "loader/gltf_decoder.h"
+
+#include <gtest/gtest.h>
+#include <cstring>
+
+using namespace vox;
+using namespace vox::loader;
+
+namespace {
+template<class T>
+int addAccessor(tinygltf::Model &model, const std::vector<T> &values, int type, int componentType, size_t count) {
+    auto &buffer = model.buffers[0].data;
+    tinygltf::BufferView view;
+    view.buffer = 0;
+    view.byteOffset = buffer.size();
+    view.byteLength = values.size() * sizeof(T);
+    buffer.resize(buffer.size() + view.byteLength);
+    memcpy(buffer.data() + view.byteOffset, values.data(), view.byteLength);
+    model.bufferViews.push_back(view);
+
+    tinygltf::Accessor accessor;
+    accessor.bufferView = static_cast<int>(model.bufferViews.size() - 1);
+    accessor.componentType = componentType;
+    accessor.type = type;
+    accessor.count = count;
+    model.accessors.push_back(accessor);
+    return static_cast<int>(model.accessors.size() - 1);
+}
+
+void addTriangle(tinygltf::Model &model, tinygltf::Mesh &mesh, float x) {
+    tinygltf::Primitive primitive;
+    primitive.attributes["POSITION"] = addAccessor(model, std::vector<float>{x, 0, 0, x + 1, 0, 0, x, 1, 0},
+                                                   TINYGLTF_TYPE_VEC3, TINYGLTF_COMPONENT_TYPE_FLOAT, 3);
+    model.accessors.back().minValues = {x, 0, 0};
+    model.accessors.back().maxValues = {x + 1, 1, 0};
+    primitive.attributes["TEXCOORD_0"] = addAccessor(model, std::vector<float>{0, 0, 1, 0, 0, 1},
+                                                     TINYGLTF_TYPE_VEC2, TINYGLTF_COMPONENT_TYPE_FLOAT, 3);
+    primitive.attributes["COLOR_0"] = addAccessor(model, std::vector<float>{1, 0, 0, 0, 1, 0, 0, 0, 1},
+                                                  TINYGLTF_TYPE_VEC3, TINYGLTF_COMPONENT_TYPE_FLOAT, 3);
+    primitive.indices = addAccessor(model, std::vector<uint16_t>{0, 1, 2},
+                                    TINYGLTF_TYPE_SCALAR, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, 3);
+    primitive.material = 0;
+    mesh.primitives.push_back(primitive);
+}
+
+GLTFContent makeContent(size_t meshCount) {
+    GLTFContent content;
+    auto &model = content.model;
+    model.buffers.emplace_back();
+    for (size_t i = 0; i < meshCount; i++) {
+        tinygltf::Mesh mesh;
+        addTriangle(model, mesh, static_cast<float>(i));
+        model.meshes.push_back(mesh);
+    }
+
+    tinygltf::Image image;
+    image.width = 2;
+    image.height = 2;
+    image.image.assign(2 * 2 * 4, 255);
+    model.images.push_back(image);
+    return content;
+}
+
+}
+
+TEST(GLTFDecoder, InterleaveVertices) {
+    auto content = makeContent(1);
+    tinygltf::Primitive points;
+    points.attributes = content.model.meshes[0].primitives[0].attributes;
+    content.model.meshes[0].primitives.push_back(points);
+
+    ThreadPool pool(2);
+    GLTFDecoder decoder(pool);
+    decoder.decode(content);
+    EXPECT_EQ(1.f, decoder.progress());
+
+    ASSERT_EQ(1u, content.meshes.size());
+    ASSERT_EQ(2u, content.meshes[0].size());
+    const auto &triangle = content.meshes[0][0];
+    // position, uv, rgb color widened to rgba
+    ASSERT_EQ(3u, triangle.attributes.size());
+    EXPECT_EQ(Color_0, triangle.attributes[2].semantic);
+    EXPECT_EQ(20u, triangle.attributes[2].offset);
+    EXPECT_EQ(36u, triangle.stride);
+    ASSERT_EQ(3u * 9, triangle.vertices.size());
+    const float second[] = {1, 0, 0, 1, 0, 0, 1, 0, 1};
+    for (size_t i = 0; i < 9; i++) {
+        EXPECT_EQ(second[i], triangle.vertices[9 + i]);
+    }
+    EXPECT_EQ((std::vector<uint32_t>{0, 1, 2}), triangle.indices);
+    EXPECT_EQ(1.f, triangle.bounds.upperCorner.x);
+    EXPECT_EQ(0, triangle.material);
+
+    // primitives without indices are not drawn
+    EXPECT_TRUE(content.meshes[0][1].indices.empty());
+
+    ASSERT_EQ(1u, content.images.size());
+    ASSERT_NE(nullptr, content.images[0]);
+    EXPECT_EQ(2u, content.images[0]->extent().width);
+}
+
+TEST(GLTFDecoder, ParallelMatchesSerial) {
+    auto serialContent = makeContent(64);
+    ThreadPool single(1);
+    GLTFDecoder(single).decode(serialContent);
+
+    auto parallelContent = makeContent(64);
+    ThreadPool pool(4);
+    GLTFDecoder(pool).decode(parallelContent);
+
+    ASSERT_EQ(serialContent.meshes.size(), parallelContent.meshes.size());
+    for (size_t i = 0; i < serialContent.meshes.size(); i++) {
+        EXPECT_EQ(serialContent.meshes[i][0].vertices, parallelContent.meshes[i][0].vertices);
+        EXPECT_EQ(serialContent.meshes[i][0].indices, parallelContent.meshes[i][0].indices);
+    }
+}
+
+TEST(GLTFDecoder, RequiredUnsupportedExtension) {
+    auto content = makeContent(1);
+    content.model.extensionsUsed = {"KHR_lights_punctual", "KHR_draco_mesh_compression"};
+    content.model.extensionsRequired = {"KHR_draco_mesh_compression"};
+    EXPECT_THROW(GLTFDecoder().decode(content), std::runtime_error);
+
+    content.model.extensionsRequired.clear();
+    GLTFDecoder().decode(content);
+    EXPECT_TRUE(content.isExtensionEnabled("KHR_lights_punctual"));
+    EXPECT_FALSE(content.isExtensionEnabled("KHR_draco_mesh_compression"));
+}
@@ -0,0 +1,171 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "lighting/ibl_baker.h"
+#include "mesh/vertex_compression.h"
+
+#include <gtest/gtest.h>
+#include <cstring>
+
+using namespace vox;
+
+namespace {
+EnvironmentCube makeEnvironment(uint32_t size, const std::array<Color, 6> &colors) {
+    EnvironmentCube environment;
+    environment.size = size;
+    for (size_t face = 0; face < 6; face++) {
+        for (uint32_t i = 0; i < size * size; i++) {
+            environment.faces[face].insert(environment.faces[face].end(),
+                                           {colors[face].r, colors[face].g, colors[face].b, 1});
+        }
+    }
+    return environment;
+}
+
+EnvironmentCube makeEnvironment(uint32_t size, const Color &color) {
+    return makeEnvironment(size, {color, color, color, color, color, color});
+}
+
+// rgb of a texel of a baked face
+Color texel(const Image &face, uint32_t level, uint32_t x, uint32_t y) {
+    const auto &mipmap = face.mipmaps().at(level);
+    uint16_t halves[4];
+    std::memcpy(halves, face.data().data() + mipmap.offset + (size_t(y) * mipmap.extent.width + x) * 8, sizeof(halves));
+    return Color(compression::decodeHalf(halves[0]), compression::decodeHalf(halves[1]),
+                 compression::decodeHalf(halves[2]));
+}
+
+}
+
+TEST(IBLBaker, ConstantEnvironmentIrradiance) {
+    const Color radiance(0.5, 1, 2);
+    auto sh = IBLBaker::projectSH(makeEnvironment(16, radiance));
+
+    // the solid angles of all texels add up to the whole sphere
+    EXPECT_NEAR(0.282095f * 4 * M_PI * 0.5f, sh.coefficients()[0], 1e-4);
+    for (size_t i = 3; i < 27; i++) {
+        EXPECT_NEAR(0, sh.coefficients()[i], 1e-4);
+    }
+    // a uniform environment lights every normal with pi times its radiance
+    for (const auto &normal : {Vector3F(1, 0, 0), Vector3F(0, -1, 0), Vector3F(0.6f, 0, 0.8f)}) {
+        const auto irradiance = sh(normal);
+        EXPECT_NEAR(M_PI * 0.5f, irradiance.r, 1e-3);
+        EXPECT_NEAR(M_PI * 1.f, irradiance.g, 1e-3);
+        EXPECT_NEAR(M_PI * 2.f, irradiance.b, 1e-3);
+    }
+}
+
+TEST(IBLBaker, DirectionalIrradiance) {
+    // light from the +Y face only
+    std::array<Color, 6> colors;
+    colors.fill(Color(0, 0, 0));
+    colors[2] = Color(1, 1, 1);
+    auto sh = IBLBaker::projectSH(makeEnvironment(16, colors));
+
+    const float up = sh(Vector3F(0, 1, 0)).r;
+    const float side = sh(Vector3F(1, 0, 0)).r;
+    EXPECT_GT(up, side);
+    EXPECT_GT(side, sh(Vector3F(0, -1, 0)).r);
+    EXPECT_NEAR(side, sh(Vector3F(-1, 0, 0)).r, 1e-4);
+    EXPECT_NEAR(side, sh(Vector3F(0, 0, 1)).r, 1e-4);
+    // a face covers a sixth of the sphere
+    EXPECT_NEAR(0.282095f * 4 * M_PI / 6, sh.coefficients()[0], 1e-4);
+}
+
+TEST(IBLBaker, FacesDecodeSRGB) {
+    std::vector<std::unique_ptr<Image>> images;
+    std::array<const Image *, 6> faces{};
+    for (size_t i = 0; i < 6; i++) {
+        images.push_back(std::make_unique<Image>(std::vector<uint8_t>(4 * 4 * 4, 128),
+                                                 std::vector<Mipmap>{{0, 0, {4, 4, 1}}}));
+        faces[i] = images.back().get();
+    }
+    const auto environment = IBLBaker::fromFaces(faces);
+    EXPECT_EQ(4u, environment.size);
+    // Image defaults to RGBA8Unorm, read as it is
+    EXPECT_NEAR(128 / 255.f, environment.faces[3][0], 1e-6);
+
+    images[1] = std::make_unique<Image>(std::vector<uint8_t>(2 * 2 * 4, 128), std::vector<Mipmap>{{0, 0, {2, 2, 1}}});
+    faces[1] = images[1].get();
+    EXPECT_THROW(IBLBaker::fromFaces(faces), std::runtime_error);
+}
+
+TEST(IBLBaker, Equirectangular) {
+    std::vector<float> pixels;
+    for (int i = 0; i < 16 * 8; i++) {
+        pixels.insert(pixels.end(), {0.25f, 0.5f, 4, 1});
+    }
+    std::vector<uint8_t> data(pixels.size() * sizeof(float));
+    std::memcpy(data.data(), pixels.data(), data.size());
+
+    class FloatImage : public Image {
+    public:
+        FloatImage(std::vector<uint8_t> &&data) : Image(std::move(data), {{0, 0, {16, 8, 1}}}) {
+            setFormat(MTL::PixelFormatRGBA32Float);
+        }
+    };
+    const auto environment = IBLBaker::fromEquirectangular(FloatImage(std::move(data)), 8);
+    EXPECT_EQ(8u, environment.size);
+    for (const auto &face : environment.faces) {
+        ASSERT_EQ(8u * 8 * 4, face.size());
+        for (size_t i = 0; i < face.size(); i += 4) {
+            EXPECT_NEAR(0.25f, face[i], 1e-5);
+            EXPECT_NEAR(4.f, face[i + 2], 1e-5);
+        }
+    }
+}
+
+TEST(IBLBaker, ConstantEnvironmentSpecular) {
+    const auto faces = IBLBaker::prefilterSpecular(makeEnvironment(16, Color(0.5, 1, 2)), 16, 32);
+    for (const auto &face : faces) {
+        ASSERT_EQ(5u, static_cast<const Image &>(*face).mipmaps().size());
+        for (uint32_t level = 0; level < 5; level++) {
+            const auto color = texel(*face, level, 0, 0);
+            EXPECT_NEAR(0.5f, color.r, 2e-3);
+            EXPECT_NEAR(2.f, color.b, 4e-3);
+        }
+    }
+}
+
+TEST(IBLBaker, RoughnessSpreadsLight) {
+    // light from the +Z face only
+    std::array<Color, 6> colors;
+    colors.fill(Color(0, 0, 0));
+    colors[4] = Color(1, 1, 1);
+    const auto faces = IBLBaker::prefilterSpecular(makeEnvironment(32, colors), 32, 64);
+
+    // mirror like level 0 keeps the faces apart
+    EXPECT_NEAR(1.f, texel(*faces[4], 0, 16, 16).r, 1e-3);
+    EXPECT_NEAR(0.f, texel(*faces[0], 0, 16, 16).r, 1e-3);
+    // the roughest level mixes +Z into the center of +X and dims it at its own center
+    const auto last = static_cast<uint32_t>(static_cast<const Image &>(*faces[0]).mipmaps().size() - 1);
+    EXPECT_GT(texel(*faces[0], last - 1, 0, 0).r, 0.05f);
+    EXPECT_LT(texel(*faces[4], last - 1, 0, 0).r, 0.9f);
+    EXPECT_NEAR(0.f, texel(*faces[5], last - 1, 0, 0).r, 1e-3);
+}
+
+TEST(IBLBaker, BakeCache) {
+    std::array<Color, 6> colors;
+    for (size_t i = 0; i < 6; i++) {
+        colors[i] = Color(0.1f * i, 0.2f, 0.3f);
+    }
+    const auto environment = makeEnvironment(16, colors);
+    IBLBakeOptions options;
+    options.specularSize = 8;
+    options.sampleCount = 16;
+    options.cacheDirectory = testing::TempDir();
+
+    const auto baked = IBLBaker::bake(environment, options);
+    const auto cached = IBLBaker::bake(environment, options);
+    EXPECT_EQ(baked.diffuseSphericalHarmonics.coefficients(), cached.diffuseSphericalHarmonics.coefficients());
+    for (size_t i = 0; i < 6; i++) {
+        const Image &a = *baked.specularFaces[i];
+        const Image &b = *cached.specularFaces[i];
+        EXPECT_EQ(a.data(), b.data());
+        EXPECT_EQ(a.mipmaps().size(), b.mipmaps().size());
+        EXPECT_EQ(MTL::PixelFormatRGBA16Float, b.format());
+    }
+}
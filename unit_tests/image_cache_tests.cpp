@@ -0,0 +1,163 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "image/image_cache.h"
+
+#include <gtest/gtest.h>
+#include <stb_image_write.h>
+#include <filesystem>
+#include <fstream>
+
+using namespace vox;
+
+namespace {
+std::unique_ptr<Image> makeImage(uint32_t size, uint8_t value) {
+    return std::make_unique<Image>(std::vector<uint8_t>(size_t(size) * size * 4, value),
+                                   std::vector<Mipmap>{{0, 0, {size, size, 1}}});
+}
+
+// png file of a gradient
+std::vector<uint8_t> makePng(uint32_t size) {
+    std::vector<uint8_t> pixels(size_t(size) * size * 4);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = static_cast<uint8_t>(i * 7);
+    }
+    std::vector<uint8_t> file;
+    stbi_write_png_to_func([](void *context, void *data, int size) {
+        auto &file = *static_cast<std::vector<uint8_t> *>(context);
+        auto bytes = static_cast<uint8_t *>(data);
+        file.insert(file.end(), bytes, bytes + size);
+    }, &file, size, size, 4, pixels.data(), size * 4);
+    return file;
+}
+
+}
+
+TEST(ImageCache, AddSharesSamePixels) {
+    ImageCache cache;
+    const auto a = cache.add(makeImage(4, 1));
+    const auto b = cache.add(makeImage(4, 1));
+    const auto c = cache.add(makeImage(4, 2));
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+
+    const auto statistics = cache.statistics();
+    EXPECT_EQ(1u, statistics.hits);
+    EXPECT_EQ(2u, statistics.misses);
+    EXPECT_EQ(2u, statistics.imageCount);
+    EXPECT_EQ(2u * 4 * 4 * 4, statistics.imageBytes);
+}
+
+TEST(ImageCache, ImageHash) {
+    const auto image = makeImage(4, 1);
+    EXPECT_EQ(ImageCache::imageHash(*image), ImageCache::imageHash(*makeImage(4, 1)));
+    EXPECT_NE(ImageCache::imageHash(*image), ImageCache::imageHash(*makeImage(4, 2)));
+    // same bytes with another shape
+    const auto wide = std::make_unique<Image>(std::vector<uint8_t>(4 * 4 * 4, 1),
+                                              std::vector<Mipmap>{{0, 0, {8, 2, 1}}});
+    EXPECT_NE(ImageCache::imageHash(*image), ImageCache::imageHash(*wide));
+}
+
+TEST(ImageCache, ReleasedWithLastUser) {
+    ImageCache cache;
+    auto image = cache.add(makeImage(4, 1));
+    image.reset();
+
+    const auto statistics = cache.statistics();
+    EXPECT_EQ(0u, statistics.imageCount);
+    EXPECT_EQ(0u, statistics.imageBytes);
+
+    // the content is decoded again instead of being found
+    image = cache.add(makeImage(4, 1));
+    EXPECT_EQ(2u, cache.statistics().misses);
+}
+
+TEST(ImageCache, DecodeSameFile) {
+    ImageCache cache;
+    const auto file = makePng(8);
+    const auto a = cache.decode(file, "png");
+    const auto b = cache.decode(file, "png");
+    ASSERT_NE(nullptr, a);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(8u, a->extent().width);
+
+    // a flipped image is another image
+    EXPECT_NE(a, cache.decode(file, "png", true));
+    EXPECT_EQ(nullptr, cache.decode(file, "bmp"));
+    EXPECT_EQ(1u, cache.statistics().hits);
+}
+
+TEST(ImageCache, DiskCache) {
+    const auto file = makePng(8);
+    std::shared_ptr<const Image> decoded;
+    {
+        ImageCache cache;
+        cache.setDiskCacheDirectory(testing::TempDir());
+        decoded = cache.decode(file, "png");
+        ASSERT_NE(nullptr, decoded);
+    }
+
+    ImageCache cache;
+    cache.setDiskCacheDirectory(testing::TempDir());
+    const auto cached = cache.decode(file, "png");
+    ASSERT_NE(nullptr, cached);
+    EXPECT_EQ(1u, cache.statistics().diskHits);
+    EXPECT_EQ(ImageCache::imageHash(*decoded), ImageCache::imageHash(*cached));
+}
+
+TEST(ImageCache, DiskCacheRejectsLevelPastData) {
+    const auto directory = testing::TempDir() + "/image_cache_levels";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    const auto file = makePng(8);
+    {
+        ImageCache cache;
+        cache.setDiskCacheDirectory(directory);
+        ASSERT_NE(nullptr, cache.decode(file, "png"));
+    }
+
+    // widen the level in the stored header, its pixels now end past the data
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+        std::fstream stored(entry.path(), std::ios::in | std::ios::out | std::ios::binary);
+        const uint32_t width = 1024;
+        stored.seekp(32 + sizeof(uint32_t));
+        stored.write(reinterpret_cast<const char *>(&width), sizeof(width));
+    }
+
+    ImageCache cache;
+    cache.setDiskCacheDirectory(directory);
+    const auto image = cache.decode(file, "png");
+    ASSERT_NE(nullptr, image);
+    EXPECT_EQ(0u, cache.statistics().diskHits);
+    EXPECT_EQ(8u, image->extent().width);
+}
+
+TEST(ImageCache, DiskCacheRejectsDataPastFile) {
+    const auto directory = testing::TempDir() + "/image_cache_size";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    const auto file = makePng(8);
+    {
+        ImageCache cache;
+        cache.setDiskCacheDirectory(directory);
+        ASSERT_NE(nullptr, cache.decode(file, "png"));
+    }
+
+    // a data size no file holds, it is not allocated
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+        std::fstream stored(entry.path(), std::ios::in | std::ios::out | std::ios::binary);
+        const uint64_t dataSize = uint64_t(1) << 60;
+        stored.seekp(24);
+        stored.write(reinterpret_cast<const char *>(&dataSize), sizeof(dataSize));
+    }
+
+    ImageCache cache;
+    cache.setDiskCacheDirectory(directory);
+    const auto image = cache.decode(file, "png");
+    ASSERT_NE(nullptr, image);
+    EXPECT_EQ(0u, cache.statistics().diskHits);
+    EXPECT_EQ(8u, image->extent().width);
+}
@@ -0,0 +1,324 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "loader/mesh_cache.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+
+using namespace vox;
+using namespace vox::loader;
+
+namespace {
+GLTFContent makeContent() {
+    GLTFContent content;
+    content.meshes.resize(2);
+    for (int i = 0; i < 3; i++) {
+        GLTFPrimitive primitive;
+        primitive.attributes = {{Position, MTL::VertexFormatFloat3, 0}, {UV_0, MTL::VertexFormatFloat2, 12}};
+        primitive.stride = 20;
+        primitive.vertices = {0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 1, float(i), 0, 1};
+        primitive.indices = {0, 1, 2};
+        primitive.bounds = BoundingBox3F(Point3F(0, 0, 0), Point3F(1, 1, float(i)));
+        primitive.material = i - 1;
+        content.meshes[i == 0 ? 0 : 1].push_back(primitive);
+    }
+
+    GLTFNode root;
+    root.name = "root";
+    root.children = {1};
+    root.translation[1] = 2;
+    GLTFNode child;
+    child.name = "child";
+    child.mesh = 1;
+    child.skin = 0;
+    child.hasMatrix = true;
+    child.matrix[0] = child.matrix[5] = child.matrix[10] = child.matrix[15] = 1;
+    child.matrix[12] = 4;
+    content.nodes = {root, child};
+
+    GLTFSkin skin;
+    skin.name = "skin";
+    skin.joints = {0, 1};
+    skin.inverseBindMatrices.resize(2);
+    skin.inverseBindMatrices[1].data()[3] = 7;
+    content.skins = {skin};
+    content.sceneNodes = {0};
+    content.model.materials.resize(2);
+    return content;
+}
+
+std::string cacheFile(const std::string &name) {
+    return testing::TempDir() + name;
+}
+
+// drop the file from the page cache where the platform allows it
+void evict(const std::string &filename) {
+#ifdef POSIX_FADV_DONTNEED
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+#endif
+}
+
+}
+
+TEST(MeshCache, RoundTrip) {
+    const auto content = makeContent();
+    const auto filename = cacheFile("round_trip.vmc");
+    ASSERT_TRUE(MeshCache::write(filename, 42, content));
+
+    auto cache = MeshCache::open(filename, 42);
+    ASSERT_NE(nullptr, cache);
+    EXPECT_EQ(2u, cache->header().meshCount);
+    const auto &record = cache->primitive(cache->mesh(1).firstPrimitive + 1);
+    EXPECT_EQ(2.f, cache->vertices(record)[12]);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(cache->vertices(record)) % 16);
+
+    GLTFContent loaded;
+    cache->read(loaded);
+    ASSERT_EQ(content.meshes.size(), loaded.meshes.size());
+    for (size_t i = 0; i < content.meshes.size(); i++) {
+        ASSERT_EQ(content.meshes[i].size(), loaded.meshes[i].size());
+        for (size_t j = 0; j < content.meshes[i].size(); j++) {
+            const auto &expected = content.meshes[i][j];
+            const auto &actual = loaded.meshes[i][j];
+            EXPECT_EQ(expected.vertices, actual.vertices);
+            EXPECT_EQ(expected.indices, actual.indices);
+            EXPECT_EQ(expected.stride, actual.stride);
+            EXPECT_EQ(expected.material, actual.material);
+            EXPECT_EQ(expected.bounds.upperCorner.z, actual.bounds.upperCorner.z);
+            ASSERT_EQ(2u, actual.attributes.size());
+            EXPECT_EQ(UV_0, actual.attributes[1].semantic);
+            EXPECT_EQ(MTL::VertexFormatFloat2, actual.attributes[1].format);
+            EXPECT_EQ(12u, actual.attributes[1].offset);
+        }
+    }
+    ASSERT_EQ(2u, loaded.nodes.size());
+    EXPECT_EQ("child", loaded.nodes[1].name);
+    EXPECT_EQ(std::vector<int>{1}, loaded.nodes[0].children);
+    EXPECT_EQ(2.f, loaded.nodes[0].translation[1]);
+    EXPECT_EQ(1.f, loaded.nodes[0].rotation[3]);
+    EXPECT_TRUE(loaded.nodes[1].hasMatrix);
+    EXPECT_EQ(4.f, loaded.nodes[1].matrix[12]);
+    EXPECT_EQ(0, loaded.nodes[1].skin);
+    ASSERT_EQ(1u, loaded.skins.size());
+    EXPECT_EQ("skin", loaded.skins[0].name);
+    EXPECT_EQ((std::vector<int>{0, 1}), loaded.skins[0].joints);
+    ASSERT_EQ(2u, loaded.skins[0].inverseBindMatrices.size());
+    EXPECT_EQ(7.f, loaded.skins[0].inverseBindMatrices[1].data()[3]);
+    EXPECT_EQ(std::vector<int>{0}, loaded.sceneNodes);
+}
+
+TEST(MeshCache, Invalidation) {
+    const auto filename = cacheFile("invalidation.vmc");
+    ASSERT_TRUE(MeshCache::write(filename, 1, makeContent()));
+    EXPECT_NE(nullptr, MeshCache::open(filename, 1));
+    // source changed
+    EXPECT_EQ(nullptr, MeshCache::open(filename, 2));
+    EXPECT_EQ(nullptr, MeshCache::open(cacheFile("missing.vmc"), 1));
+
+    std::ifstream stream(filename, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    {
+        std::ofstream truncated(filename, std::ios::binary | std::ios::trunc);
+        truncated.write(bytes.data(), bytes.size() - 8);
+    }
+    EXPECT_EQ(nullptr, MeshCache::open(filename, 1));
+
+    // primitive pointing outside of the data section
+    auto damaged = bytes;
+    MeshCache::Header header;
+    memcpy(&header, damaged.data(), sizeof(header));
+    MeshCache::PrimitiveRecord primitive;
+    memcpy(&primitive, damaged.data() + header.primitiveOffset, sizeof(primitive));
+    primitive.indexCount = 1u << 30;
+    memcpy(damaged.data() + header.primitiveOffset, &primitive, sizeof(primitive));
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file.write(damaged.data(), damaged.size());
+    }
+    EXPECT_EQ(nullptr, MeshCache::open(filename, 1));
+
+    // index past the last vertex, three vertices of 20 bytes
+    damaged = bytes;
+    memcpy(&primitive, damaged.data() + header.primitiveOffset, sizeof(primitive));
+    uint32_t index = 3;
+    memcpy(damaged.data() + header.dataOffset + primitive.indexOffset + sizeof(uint32_t), &index, sizeof(index));
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file.write(damaged.data(), damaged.size());
+    }
+    EXPECT_EQ(nullptr, MeshCache::open(filename, 1));
+
+    index = 2;
+    memcpy(damaged.data() + header.dataOffset + primitive.indexOffset + sizeof(uint32_t), &index, sizeof(index));
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file.write(damaged.data(), damaged.size());
+    }
+    EXPECT_NE(nullptr, MeshCache::open(filename, 1));
+}
+
+TEST(MeshCache, RejectsIndicesPastRecords) {
+    const auto filename = cacheFile("indices.vmc");
+    auto expectRejected = [&](const GLTFContent &content) {
+        ASSERT_TRUE(MeshCache::write(filename, 1, content));
+        EXPECT_EQ(nullptr, MeshCache::open(filename, 1));
+    };
+
+    auto content = makeContent();
+    content.meshes[1][0].material = 2;
+    expectRejected(content);
+
+    content = makeContent();
+    content.nodes[1].mesh = 2;
+    expectRejected(content);
+
+    content = makeContent();
+    content.nodes[1].skin = 1;
+    expectRejected(content);
+
+    content = makeContent();
+    content.nodes[0].children = {2};
+    expectRejected(content);
+
+    content = makeContent();
+    content.skins[0].joints = {0, -1};
+    expectRejected(content);
+
+    content = makeContent();
+    content.sceneNodes = {2};
+    expectRejected(content);
+
+    // -1 is no material, mesh or skin
+    content = makeContent();
+    content.meshes[1][0].material = -1;
+    content.nodes[1].mesh = -1;
+    content.nodes[1].skin = -1;
+    ASSERT_TRUE(MeshCache::write(filename, 1, content));
+    EXPECT_NE(nullptr, MeshCache::open(filename, 1));
+}
+
+TEST(MeshCache, ContentHash) {
+    const std::string text = "interleaved vertex streams";
+    EXPECT_EQ(contentHash(text.data(), text.size()), contentHash(text.data(), text.size()));
+    EXPECT_NE(contentHash(text.data(), text.size()), contentHash(text.data(), text.size() - 1));
+    auto changed = text;
+    changed[3] ^= 1;
+    EXPECT_NE(contentHash(text.data(), text.size()), contentHash(changed.data(), changed.size()));
+    EXPECT_NE(contentHash(text.data(), text.size(), 1), contentHash(text.data(), text.size(), 2));
+}
+
+TEST(MeshCache, DISABLED_LoadBenchmark) {
+    constexpr size_t kMeshCount = 64;
+    constexpr size_t kVertexCount = 16384;
+
+    // glTF source with separate position, normal and uv accessors
+    GLTFContent source;
+    auto &model = source.model;
+    model.buffers.emplace_back();
+    for (size_t m = 0; m < kMeshCount; m++) {
+        tinygltf::Primitive primitive;
+        const char *names[] = {"POSITION", "NORMAL", "TEXCOORD_0"};
+        const int components[] = {3, 3, 2};
+        for (int a = 0; a < 3; a++) {
+            tinygltf::BufferView view;
+            view.buffer = 0;
+            view.byteOffset = model.buffers[0].data.size();
+            view.byteLength = kVertexCount * components[a] * sizeof(float);
+            model.buffers[0].data.resize(view.byteOffset + view.byteLength, 0);
+            model.bufferViews.push_back(view);
+            tinygltf::Accessor accessor;
+            accessor.bufferView = static_cast<int>(model.bufferViews.size() - 1);
+            accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+            accessor.type = components[a] == 3 ? TINYGLTF_TYPE_VEC3 : TINYGLTF_TYPE_VEC2;
+            accessor.count = kVertexCount;
+            if (a == 0) {
+                accessor.minValues = {0, 0, 0};
+                accessor.maxValues = {1, 1, 1};
+            }
+            model.accessors.push_back(accessor);
+            primitive.attributes[names[a]] = static_cast<int>(model.accessors.size() - 1);
+        }
+        tinygltf::BufferView view;
+        view.buffer = 0;
+        view.byteOffset = model.buffers[0].data.size();
+        view.byteLength = kVertexCount * 3 * sizeof(uint16_t);
+        model.buffers[0].data.resize(view.byteOffset + view.byteLength, 0);
+        model.bufferViews.push_back(view);
+        tinygltf::Accessor indices;
+        indices.bufferView = static_cast<int>(model.bufferViews.size() - 1);
+        indices.componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+        indices.type = TINYGLTF_TYPE_SCALAR;
+        indices.count = kVertexCount * 3;
+        model.accessors.push_back(indices);
+        primitive.indices = static_cast<int>(model.accessors.size() - 1);
+
+        tinygltf::Mesh mesh;
+        mesh.primitives.push_back(primitive);
+        model.meshes.push_back(mesh);
+    }
+
+    // buffers are already in memory, so the source time leaves out json parsing and file reads
+    Timer timer;
+    timer.start();
+    ThreadPool pool(1);
+    GLTFDecoder(pool).decode(source);
+    const double sourceTime = timer.stop<Timer::Milliseconds>();
+
+    const auto filename = cacheFile("benchmark.vmc");
+    ASSERT_TRUE(MeshCache::write(filename, 7, source));
+    evict(filename);
+
+    // what decodeFile does: streams stay in the mapping and are copied once into GPU buffers
+    auto upload = [](const GLTFContent &content) {
+        std::vector<float> vertexBuffer;
+        for (const auto &mesh : content.meshes) {
+            for (const auto &primitive : mesh) {
+                vertexBuffer.resize(primitive.vertexCount());
+                memcpy(vertexBuffer.data(), primitive.vertexData(), primitive.vertexCount() * sizeof(float));
+            }
+        }
+    };
+    GLTFContent cold;
+    timer.start();
+    auto coldCache = MeshCache::open(filename, 7);
+    coldCache->read(cold, false);
+    upload(cold);
+    const double coldTime = timer.stop<Timer::Milliseconds>();
+
+    GLTFContent warm;
+    timer.start();
+    auto cache = MeshCache::open(filename, 7);
+    cache->read(warm, false);
+    upload(warm);
+    const double warmTime = timer.stop<Timer::Milliseconds>();
+    ASSERT_EQ(source.meshes.back()[0].vertices.size(), warm.meshes.back()[0].vertexCount());
+    EXPECT_EQ(0, memcmp(source.meshes.back()[0].vertices.data(), warm.meshes.back()[0].vertexData(),
+                        warm.meshes.back()[0].vertexCount() * sizeof(float)));
+
+    timer.start();
+    upload(source);
+    const double uploadTime = timer.stop<Timer::Milliseconds>();
+
+    GLTFContent copied;
+    timer.start();
+    cache->read(copied);
+    const double copyTime = timer.stop<Timer::Milliseconds>();
+    EXPECT_EQ(source.meshes[3][0].indices, copied.meshes[3][0].indices);
+    RecordProperty("convert_and_upload_ms", std::to_string(sourceTime + uploadTime));
+    RecordProperty("cache_cold_ms", std::to_string(coldTime));
+    RecordProperty("cache_warm_ms", std::to_string(warmTime));
+    RecordProperty("copy_ms", std::to_string(copyTime));
+}
@@ -0,0 +1,169 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "mesh/mesh_optimizer.h"
+#include "vector3.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <random>
+
+using namespace vox;
+
+namespace {
+// quads of a size x size grid as two triangles, every triangle with its own three vertices
+void unweldedGrid(size_t size, std::vector<Vector3F> &positions, std::vector<uint32_t> &indices) {
+    positions.clear();
+    indices.clear();
+    for (size_t y = 0; y < size; y++) {
+        for (size_t x = 0; x < size; x++) {
+            const Vector3F corners[] = {
+                Vector3F(x, y, 0), Vector3F(x + 1, y, 0), Vector3F(x + 1, y + 1, 0),
+                Vector3F(x, y, 0), Vector3F(x + 1, y + 1, 0), Vector3F(x, y + 1, 0)};
+            for (const auto &corner : corners) {
+                indices.push_back(static_cast<uint32_t>(positions.size()));
+                positions.push_back(corner);
+            }
+        }
+    }
+}
+
+// triangles as sorted corner positions, independent of vertex and triangle order
+std::vector<std::array<float, 9>> triangleSet(const std::vector<Vector3F> &positions,
+                                              const std::vector<uint32_t> &indices) {
+    std::vector<std::array<float, 9>> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        std::array<std::array<float, 3>, 3> corners;
+        for (size_t k = 0; k < 3; k++) {
+            const auto &position = positions[indices[i + k]];
+            corners[k] = {position.x, position.y, position.z};
+        }
+        // rotate the smallest corner first, keeps the winding
+        const size_t first = std::min_element(corners.begin(), corners.end()) - corners.begin();
+        std::array<float, 9> triangle;
+        for (size_t k = 0; k < 3; k++) {
+            std::copy(corners[(first + k) % 3].begin(), corners[(first + k) % 3].end(), triangle.begin() + k * 3);
+        }
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+void shuffleTriangles(std::vector<uint32_t> &indices, uint32_t seed) {
+    std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+    memcpy(triangles.data(), indices.data(), indices.size() * sizeof(uint32_t));
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+    memcpy(indices.data(), triangles.data(), indices.size() * sizeof(uint32_t));
+}
+
+size_t weld(std::vector<Vector3F> &positions, std::vector<uint32_t> &indices) {
+    std::vector<uint32_t> remap;
+    const size_t count = MeshOptimizer::weldVertices({{positions.data(), sizeof(Vector3F), sizeof(Vector3F)}},
+                                                     positions.size(), remap);
+    MeshOptimizer::remapIndices(indices, remap);
+    MeshOptimizer::remapVertices(positions, remap, count);
+    return count;
+}
+
+}
+
+TEST(MeshOptimizer, WeldVertices) {
+    std::vector<Vector3F> positions;
+    std::vector<uint32_t> indices;
+    unweldedGrid(8, positions, indices);
+    const auto expected = triangleSet(positions, indices);
+
+    EXPECT_EQ(9u * 9u, weld(positions, indices));
+    EXPECT_EQ(9u * 9u, positions.size());
+    EXPECT_EQ(expected, triangleSet(positions, indices));
+
+    // a second stream keeps vertices apart where it differs
+    std::vector<Vector3F> grid;
+    std::vector<uint32_t> gridIndices;
+    unweldedGrid(1, grid, gridIndices);
+    std::vector<float> seam = {0, 0, 0, 1, 0, 0};
+    std::vector<uint32_t> remap;
+    const size_t count = MeshOptimizer::weldVertices({{grid.data(), sizeof(Vector3F), sizeof(Vector3F)},
+        {seam.data(), sizeof(float), sizeof(float)}}, grid.size(), remap);
+    EXPECT_EQ(5u, count);
+    EXPECT_EQ((std::vector<uint32_t>{0, 1, 2, 3, 2, 4}), remap);
+}
+
+TEST(MeshOptimizer, VertexCache) {
+    std::vector<Vector3F> positions;
+    std::vector<uint32_t> indices;
+    unweldedGrid(64, positions, indices);
+    weld(positions, indices);
+    shuffleTriangles(indices, 1);
+    const auto expected = triangleSet(positions, indices);
+
+    const auto before = MeshOptimizer::analyzeVertexCache(indices, positions.size());
+    MeshOptimizer::optimizeVertexCache(indices, positions.size());
+    const auto after = MeshOptimizer::analyzeVertexCache(indices, positions.size());
+    EXPECT_EQ(expected, triangleSet(positions, indices));
+    // a shuffled grid misses almost every vertex, an ordered one gets close to 0.5 per triangle
+    EXPECT_GT(before.acmr, 2.f);
+    EXPECT_LT(after.acmr, 0.8f);
+    EXPECT_LT(after.atvr, 1.6f);
+    EXPECT_GE(after.atvr, 1.f);
+}
+
+TEST(MeshOptimizer, VertexFetch) {
+    std::vector<Vector3F> positions;
+    std::vector<uint32_t> indices;
+    unweldedGrid(16, positions, indices);
+    weld(positions, indices);
+    // an unused vertex is dropped
+    positions.push_back(Vector3F(-1, -1, -1));
+    shuffleTriangles(indices, 2);
+    const auto expected = triangleSet(positions, indices);
+
+    std::vector<uint32_t> remap;
+    const size_t count = MeshOptimizer::optimizeVertexFetch(indices, positions.size(), remap);
+    EXPECT_EQ(17u * 17u, count);
+    EXPECT_EQ(~0u, remap.back());
+    MeshOptimizer::remapIndices(indices, remap);
+    MeshOptimizer::remapVertices(positions, remap, count);
+    EXPECT_EQ(count, positions.size());
+    EXPECT_EQ(expected, triangleSet(positions, indices));
+
+    // every index is at most one past the largest before it
+    uint32_t next = 0;
+    for (const auto index : indices) {
+        ASSERT_LE(index, next);
+        next = std::max(next, index + 1);
+    }
+}
+
+TEST(MeshOptimizer, Index16) {
+    EXPECT_TRUE(MeshOptimizer::fitsUInt16(0));
+    EXPECT_TRUE(MeshOptimizer::fitsUInt16(65536));
+    EXPECT_FALSE(MeshOptimizer::fitsUInt16(65537));
+    EXPECT_EQ((std::vector<uint16_t>{0, 65535, 7}), MeshOptimizer::toUInt16({0, 65535, 7}));
+}
+
+TEST(MeshOptimizer, Statistics) {
+    std::vector<Vector3F> positions;
+    std::vector<uint32_t> indices;
+    unweldedGrid(256, positions, indices);
+    const size_t sourceVertices = positions.size();
+    shuffleTriangles(indices, 3);
+
+    weld(positions, indices);
+    const auto before = MeshOptimizer::analyzeVertexCache(indices, positions.size());
+    MeshOptimizer::optimizeVertexCache(indices, positions.size());
+    std::vector<uint32_t> remap;
+    const size_t count = MeshOptimizer::optimizeVertexFetch(indices, positions.size(), remap);
+    MeshOptimizer::remapIndices(indices, remap);
+    MeshOptimizer::remapVertices(positions, remap, count);
+    const auto after = MeshOptimizer::analyzeVertexCache(indices, positions.size());
+
+    EXPECT_LT(after.acmr, before.acmr);
+    EXPECT_FALSE(MeshOptimizer::fitsUInt16(sourceVertices));
+    EXPECT_FALSE(MeshOptimizer::fitsUInt16(positions.size()));
+}
@@ -0,0 +1,151 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "mesh/mesh_simplifier.h"
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <set>
+
+using namespace vox;
+
+namespace {
+// closed torus without borders, u around the ring and v around the tube
+void torus(size_t segments, size_t sides, std::vector<Vector3F> &positions, std::vector<uint32_t> &indices) {
+    positions.clear();
+    indices.clear();
+    for (size_t u = 0; u < segments; u++) {
+        const float theta = 2 * M_PI * u / segments;
+        for (size_t v = 0; v < sides; v++) {
+            const float phi = 2 * M_PI * v / sides;
+            const float radius = 1 + 0.3f * std::cos(phi);
+            positions.emplace_back(radius * std::cos(theta), 0.3f * std::sin(phi), radius * std::sin(theta));
+        }
+    }
+    for (size_t u = 0; u < segments; u++) {
+        for (size_t v = 0; v < sides; v++) {
+            const auto a = static_cast<uint32_t>(u * sides + v);
+            const auto b = static_cast<uint32_t>(((u + 1) % segments) * sides + v);
+            const auto c = static_cast<uint32_t>(((u + 1) % segments) * sides + (v + 1) % sides);
+            const auto d = static_cast<uint32_t>(u * sides + (v + 1) % sides);
+            indices.insert(indices.end(), {a, b, c, a, c, d});
+        }
+    }
+}
+
+void plane(size_t size, std::vector<Vector3F> &positions, std::vector<uint32_t> &indices) {
+    positions.clear();
+    indices.clear();
+    for (size_t y = 0; y <= size; y++) {
+        for (size_t x = 0; x <= size; x++) {
+            positions.emplace_back(x, 0, y);
+        }
+    }
+    for (size_t y = 0; y < size; y++) {
+        for (size_t x = 0; x < size; x++) {
+            const auto a = static_cast<uint32_t>(y * (size + 1) + x);
+            const auto b = a + 1;
+            const auto c = a + static_cast<uint32_t>(size + 1) + 1;
+            const auto d = a + static_cast<uint32_t>(size + 1);
+            indices.insert(indices.end(), {a, c, b, a, d, c});
+        }
+    }
+}
+
+void expectValid(const std::vector<uint32_t> &indices, size_t vertexCount) {
+    ASSERT_EQ(0u, indices.size() % 3);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        ASSERT_LT(indices[i], vertexCount);
+        ASSERT_LT(indices[i + 1], vertexCount);
+        ASSERT_LT(indices[i + 2], vertexCount);
+        ASSERT_TRUE(indices[i] != indices[i + 1] && indices[i + 1] != indices[i + 2] && indices[i] != indices[i + 2]);
+    }
+}
+
+}
+
+TEST(MeshSimplifier, Torus) {
+    std::vector<Vector3F> positions;
+    std::vector<uint32_t> indices;
+    torus(128, 64, positions, indices);
+
+    float error = 0;
+    const auto result = MeshSimplifier::simplify(positions, indices, indices.size() / 4, 1.f, &error);
+    expectValid(result, positions.size());
+    EXPECT_LE(result.size(), indices.size() / 4);
+    EXPECT_GT(result.size(), indices.size() / 8);
+    EXPECT_GT(error, 0.f);
+    EXPECT_LT(error, 0.01f);
+
+    // the error limit wins over the target
+    float limitedError = 0;
+    const auto limited = MeshSimplifier::simplify(positions, indices, 0, 1e-4f, &limitedError);
+    EXPECT_LE(limitedError, 1e-4f);
+    EXPECT_GT(limited.size(), result.size());
+}
+
+TEST(MeshSimplifier, PlaneKeepsBorder) {
+    std::vector<Vector3F> positions;
+    std::vector<uint32_t> indices;
+    plane(16, positions, indices);
+
+    float error = 1;
+    const auto result = MeshSimplifier::simplify(positions, indices, 0, 1e-6f, &error);
+    expectValid(result, positions.size());
+    // interior vertices of a flat plane collapse for free
+    EXPECT_EQ(0.f, error);
+    EXPECT_LT(result.size(), indices.size() / 4);
+
+    const std::set<uint32_t> used(result.begin(), result.end());
+    for (uint32_t i = 0; i <= 16; i++) {
+        EXPECT_TRUE(used.count(i));
+        EXPECT_TRUE(used.count(16 * 17 + i));
+        EXPECT_TRUE(used.count(i * 17));
+        EXPECT_TRUE(used.count(i * 17 + 16));
+    }
+
+    // triangles still face up and cover the plane
+    double area = 0;
+    for (size_t i = 0; i < result.size(); i += 3) {
+        const auto &p0 = positions[result[i]];
+        const auto &p1 = positions[result[i + 1]];
+        const auto &p2 = positions[result[i + 2]];
+        const double normalY = (p1.z - p0.z) * (p2.x - p0.x) - (p1.x - p0.x) * (p2.z - p0.z);
+        EXPECT_GT(normalY, 0);
+        area += normalY / 2;
+    }
+    EXPECT_NEAR(16.0 * 16.0, area, 1e-6);
+}
+
+TEST(MeshSimplifier, LodChains) {
+    constexpr size_t kMeshCount = 8;
+    const std::vector<float> ratios = {0.5f, 0.25f, 0.125f, 0.0625f};
+    std::vector<std::vector<Vector3F>> positions(kMeshCount);
+    std::vector<std::vector<uint32_t>> indices(kMeshCount);
+    std::vector<MeshSimplifier::Source> sources;
+    for (size_t i = 0; i < kMeshCount; i++) {
+        torus(128 + i * 8, 64, positions[i], indices[i]);
+        sources.push_back({&positions[i], &indices[i]});
+    }
+
+    std::vector<std::vector<LodLevel>> serial;
+    for (const auto &source : sources) {
+        serial.push_back(MeshSimplifier::generateLodChain(*source.positions, *source.indices, ratios));
+    }
+    const auto parallel = MeshSimplifier::generateLodChains(sources, ratios);
+
+    ASSERT_EQ(kMeshCount, parallel.size());
+    for (size_t i = 0; i < kMeshCount; i++) {
+        ASSERT_EQ(ratios.size(), parallel[i].size());
+        for (size_t level = 0; level < ratios.size(); level++) {
+            EXPECT_EQ(serial[i][level].indices, parallel[i][level].indices);
+            if (level > 0) {
+                EXPECT_LT(parallel[i][level].indices.size(), parallel[i][level - 1].indices.size());
+                EXPECT_GE(parallel[i][level].error, parallel[i][level - 1].error);
+            }
+        }
+    }
+}
@@ -0,0 +1,181 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "mesh/meshlet_builder.h"
+#include "mesh/meshlet_culler.h"
+#include "matrix_utils.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <array>
+#include <cmath>
+
+using namespace vox;
+
+namespace {
+// closed torus, u around the ring and v around the tube, normals point out
+void torus(size_t segments, size_t sides, std::vector<Vector3F> &positions, std::vector<uint32_t> &indices) {
+    positions.clear();
+    indices.clear();
+    for (size_t u = 0; u < segments; u++) {
+        const float theta = 2 * M_PI * u / segments;
+        for (size_t v = 0; v < sides; v++) {
+            const float phi = 2 * M_PI * v / sides;
+            const float radius = 1 + 0.3f * std::cos(phi);
+            positions.emplace_back(radius * std::cos(theta), 0.3f * std::sin(phi), radius * std::sin(theta));
+        }
+    }
+    for (size_t u = 0; u < segments; u++) {
+        for (size_t v = 0; v < sides; v++) {
+            const auto a = static_cast<uint32_t>(u * sides + v);
+            const auto b = static_cast<uint32_t>(((u + 1) % segments) * sides + v);
+            const auto c = static_cast<uint32_t>(((u + 1) % segments) * sides + (v + 1) % sides);
+            const auto d = static_cast<uint32_t>(u * sides + (v + 1) % sides);
+            indices.insert(indices.end(), {a, c, b, a, d, c});
+        }
+    }
+}
+
+std::vector<std::array<uint32_t, 3>> sortedTriangles(const std::vector<uint32_t> &indices) {
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        triangles.push_back({indices[i], indices[i + 1], indices[i + 2]});
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+// camera at (0, 0, 20) looking down -z
+BoundingFrustum testFrustum() {
+    const auto view = makeLookAtMatrix(Point3F(0, 0, 20), Point3F(0, 0, 0), Vector3F(0, 1, 0));
+    const auto projection = makepPerspective<float>(M_PI / 4, 1, 0.1f, 100);
+    return BoundingFrustum(projection * view);
+}
+
+}
+
+TEST(Meshlet, Build) {
+    std::vector<Vector3F> positions;
+    std::vector<uint32_t> indices;
+    torus(64, 32, positions, indices);
+    const auto data = MeshletBuilder::build(positions, indices);
+
+    ASSERT_EQ(data.meshlets.size(), data.bounds.size());
+    EXPECT_EQ(sortedTriangles(indices), sortedTriangles(data.indices));
+    uint32_t nextTriangle = 0;
+    for (size_t i = 0; i < data.meshlets.size(); i++) {
+        const auto &meshlet = data.meshlets[i];
+        EXPECT_LE(meshlet.vertexCount, MeshletBuilder::kMaxVertices);
+        EXPECT_LE(meshlet.triangleCount, MeshletBuilder::kMaxTriangles);
+        EXPECT_EQ(nextTriangle, meshlet.triangleOffset);
+        nextTriangle += meshlet.triangleCount;
+        // local indices, the meshlet order index buffer and the bounds agree
+        const auto &bounds = data.bounds[i];
+        for (uint32_t k = 0; k < meshlet.triangleCount * 3; k++) {
+            const uint8_t local = data.triangles[meshlet.triangleOffset * 3 + k];
+            ASSERT_LT(local, meshlet.vertexCount);
+            const uint32_t vertex = data.vertices[meshlet.vertexOffset + local];
+            ASSERT_EQ(data.indices[meshlet.triangleOffset * 3 + k], vertex);
+            EXPECT_LE(Point3F(positions[vertex].x, positions[vertex].y, positions[vertex].z).distanceTo(bounds.center),
+                      bounds.radius * 1.0001f);
+        }
+    }
+    // grown over shared vertices, meshlets are nearly full
+    EXPECT_LT(data.meshlets.size(), indices.size() / 3 / 70);
+}
+
+TEST(Meshlet, ConeCullingIsConservative) {
+    std::vector<Vector3F> positions;
+    std::vector<uint32_t> indices;
+    torus(128, 64, positions, indices);
+    const auto data = MeshletBuilder::build(positions, indices);
+    const Matrix4x4F identity;
+    const Point3F camera(0, 0, 20);
+
+    std::vector<MeshletRange> ranges;
+    const auto statistics = MeshletCuller::cull(data, identity, testFrustum(), camera, ranges);
+    EXPECT_EQ(0u, statistics.frustumCulled);
+    EXPECT_GT(statistics.backfaceCulled, data.meshlets.size() / 5);
+    EXPECT_EQ(data.meshlets.size(), statistics.visibleMeshlets + statistics.backfaceCulled);
+
+    // nothing visible is dropped
+    std::vector<bool> drawn(data.indices.size() / 3, false);
+    uint32_t drawnIndices = 0;
+    for (const auto &range : ranges) {
+        for (uint32_t i = range.firstIndex; i < range.firstIndex + range.indexCount; i += 3) {
+            drawn[i / 3] = true;
+        }
+        drawnIndices += range.indexCount;
+    }
+    EXPECT_EQ(statistics.visibleTriangles * 3, drawnIndices);
+    for (size_t t = 0; t < drawn.size(); t++) {
+        if (drawn[t]) {
+            continue;
+        }
+        const auto &p0 = positions[data.indices[t * 3]];
+        const auto &p1 = positions[data.indices[t * 3 + 1]];
+        const auto &p2 = positions[data.indices[t * 3 + 2]];
+        const auto normal = (p1 - p0).cross(p2 - p0);
+        const Vector3F view(p0.x - camera.x, p0.y - camera.y, p0.z - camera.z);
+        ASSERT_GE(normal.dot(view), 0) << "front facing triangle " << t << " was culled";
+    }
+}
+
+TEST(Meshlet, FrustumAndRanges) {
+    std::vector<Vector3F> positions;
+    std::vector<uint32_t> indices;
+    torus(64, 32, positions, indices);
+    const auto data = MeshletBuilder::build(positions, indices);
+    const auto frustum = testFrustum();
+    std::vector<MeshletRange> ranges;
+
+    // moved far to the side everything is outside
+    Matrix4x4F aside;
+    aside[12] = -40;
+    auto statistics = MeshletCuller::cull(data, aside, frustum, Point3F(0, 0, 20), ranges);
+    EXPECT_EQ(0u, statistics.visibleMeshlets);
+    EXPECT_TRUE(ranges.empty());
+
+    // half way out of the left plane, scaled up
+    Matrix4x4F edge;
+    edge[0] = edge[5] = edge[10] = 4;
+    edge[12] = -8.3f;
+    statistics = MeshletCuller::cull(data, edge, frustum, Point3F(0, 0, 20), ranges);
+    EXPECT_GT(statistics.frustumCulled, 0u);
+    EXPECT_GT(statistics.visibleMeshlets, 0u);
+
+    // ranges are ordered, disjoint and not adjacent
+    for (size_t i = 1; i < ranges.size(); i++) {
+        EXPECT_GT(ranges[i].firstIndex, ranges[i - 1].firstIndex + ranges[i - 1].indexCount);
+    }
+    EXPECT_LT(ranges.size(), statistics.visibleMeshlets);
+}
+
+TEST(Meshlet, DISABLED_Benchmark) {
+    std::vector<Vector3F> positions;
+    std::vector<uint32_t> indices;
+    torus(512, 256, positions, indices);
+    const size_t triangleCount = indices.size() / 3;
+
+    Timer timer;
+    timer.start();
+    const auto data = MeshletBuilder::build(positions, indices);
+    const double buildTime = timer.stop<Timer::Milliseconds>();
+
+    constexpr int kViews = 100;
+    const auto frustum = testFrustum();
+    std::vector<MeshletRange> ranges;
+    MeshletCuller::Statistics statistics;
+    timer.start();
+    for (int i = 0; i < kViews; i++) {
+        const float angle = 2 * M_PI * i / kViews;
+        statistics = MeshletCuller::cull(data, Matrix4x4F(), frustum, Point3F(20 * std::sin(angle), 5, 20 * std::cos(angle)), ranges);
+    }
+    const double cullTime = timer.stop<Timer::Milliseconds>();
+    RecordProperty("build_ms", std::to_string(buildTime));
+    RecordProperty("cull_ms_per_view", std::to_string(cullTime / kViews));
+    EXPECT_LT(statistics.visibleTriangles, triangleCount);
+}
@@ -0,0 +1,198 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "image/mipmap_generator.h"
+#include "thread_pool.h"
+#include "timer.h"
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+
+#include <stb_image_resize.h>
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace vox;
+
+namespace {
+std::vector<uint8_t> makeChain(uint32_t width, uint32_t height, std::vector<Mipmap> &levels, uint32_t seed) {
+    size_t size = 0;
+    levels = MipmapGenerator::chain(width, height, size);
+    std::vector<uint8_t> data(size);
+    std::mt19937 random(seed);
+    for (size_t i = 0; i < size_t(width) * height * 4; i++) {
+        data[i] = static_cast<uint8_t>(random());
+    }
+    return data;
+}
+
+// mip chain of the former Image::generateMipmaps, which grew the data for every level
+void stbGenerateMipmaps(std::vector<uint8_t> &data, uint32_t width, uint32_t height) {
+    uint32_t offset = 0;
+    while (width > 1 || height > 1) {
+        const uint32_t nextWidth = std::max(1u, width / 2);
+        const uint32_t nextHeight = std::max(1u, height / 2);
+        const auto nextOffset = static_cast<uint32_t>(data.size());
+        data.resize(data.size() + nextWidth * nextHeight * 4);
+        stbir_resize_uint8(data.data() + offset, width, height, 0,
+                           data.data() + nextOffset, nextWidth, nextHeight, 0, 4);
+        offset = nextOffset;
+        width = nextWidth;
+        height = nextHeight;
+    }
+}
+
+}
+
+TEST(MipmapGenerator, Chain) {
+    size_t size = 0;
+    const auto levels = MipmapGenerator::chain(5, 3, size);
+    ASSERT_EQ(3u, levels.size());
+    EXPECT_EQ(2u, levels[1].extent.width);
+    EXPECT_EQ(1u, levels[1].extent.height);
+    EXPECT_EQ(1u, levels[2].extent.width);
+    EXPECT_EQ(1u, levels[2].extent.height);
+    EXPECT_EQ(5u * 3 * 4, levels[1].offset);
+    EXPECT_EQ((5u * 3 + 2) * 4, levels[2].offset);
+    EXPECT_EQ((5u * 3 + 2 + 1) * 4, size);
+
+    EXPECT_EQ(13u, MipmapGenerator::chain(4096, 4096, size).size());
+}
+
+TEST(MipmapGenerator, Box) {
+    std::vector<Mipmap> levels;
+    auto data = makeChain(2, 2, levels, 0);
+    const uint8_t texels[] = {0, 0, 0, 0, 255, 255, 255, 255, 0, 0, 0, 0, 255, 255, 255, 255};
+    std::copy(texels, texels + 16, data.begin());
+
+    MipmapGenerator().generate(data.data(), levels);
+    EXPECT_EQ(128, data[levels[1].offset]);
+    EXPECT_EQ(128, data[levels[1].offset + 3]);
+
+    // half of the light in linear space is brighter in sRGB, alpha stays linear
+    MipmapOptions options;
+    options.srgb = true;
+    MipmapGenerator(options).generate(data.data(), levels);
+    EXPECT_EQ(188, data[levels[1].offset]);
+    EXPECT_EQ(128, data[levels[1].offset + 3]);
+}
+
+TEST(MipmapGenerator, BoxOddSizes) {
+    // the texel in the last row and column counts as much as the others
+    std::vector<Mipmap> levels;
+    auto data = makeChain(3, 3, levels, 0);
+    std::fill(data.begin(), data.begin() + 3 * 3 * 4, 0);
+    std::fill(data.begin() + 8 * 4, data.begin() + 9 * 4, 255);
+    MipmapGenerator().generate(data.data(), levels);
+    ASSERT_EQ(2u, levels.size());
+    EXPECT_EQ(28, data[levels[1].offset]);
+    EXPECT_EQ(28, data[levels[1].offset + 3]);
+
+    // five texels into two, the middle one is shared
+    data = makeChain(5, 1, levels, 0);
+    for (uint8_t x = 0; x < 5; x++) {
+        std::fill(data.begin() + x * 4, data.begin() + x * 4 + 4, static_cast<uint8_t>(x * 50));
+    }
+    MipmapGenerator().generate(data.data(), levels);
+    EXPECT_EQ(40, data[levels[1].offset]);
+    EXPECT_EQ(160, data[levels[1].offset + 4]);
+}
+
+TEST(MipmapGenerator, KaiserKeepsConstant) {
+    std::vector<Mipmap> levels;
+    auto data = makeChain(37, 20, levels, 0);
+    for (size_t i = 0; i < 37 * 20; i++) {
+        data[i * 4 + 0] = 10;
+        data[i * 4 + 1] = 100;
+        data[i * 4 + 2] = 200;
+        data[i * 4 + 3] = 255;
+    }
+    MipmapOptions options;
+    options.filter = MipmapOptions::Filter::Kaiser;
+    options.srgb = true;
+    MipmapGenerator(options).generate(data.data(), levels);
+    for (const auto &level : levels) {
+        for (size_t i = 0; i < level.extent.width * level.extent.height; i++) {
+            const uint8_t *texel = data.data() + level.offset + i * 4;
+            ASSERT_NEAR(10, texel[0], 1);
+            ASSERT_NEAR(100, texel[1], 1);
+            ASSERT_NEAR(200, texel[2], 1);
+            ASSERT_EQ(255, texel[3]);
+        }
+    }
+}
+
+TEST(MipmapGenerator, AlphaCoverage) {
+    // foliage like alpha, a quarter of the texels pass the test
+    std::vector<Mipmap> levels;
+    auto data = makeChain(256, 256, levels, 1);
+    std::mt19937 random(2);
+    for (size_t i = 0; i < 256 * 256; i++) {
+        data[i * 4 + 3] = static_cast<uint8_t>(random() % 171);
+    }
+    const auto base = data;
+
+    auto coverage = [&](const std::vector<uint8_t> &chain, const Mipmap &level) {
+        size_t passed = 0;
+        const size_t texels = level.extent.width * level.extent.height;
+        for (size_t i = 0; i < texels; i++) {
+            passed += chain[level.offset + i * 4 + 3] >= 128 ? 1 : 0;
+        }
+        return float(passed) / texels;
+    };
+
+    MipmapGenerator().generate(data.data(), levels);
+    EXPECT_LT(coverage(data, levels[3]), 0.1f);
+
+    auto preserved = base;
+    MipmapOptions options;
+    options.alphaCutoff = 0.5f;
+    MipmapGenerator(options).generate(preserved.data(), levels);
+    // deeper levels have too few texels and distinct alpha values to match closely
+    for (size_t i = 1; i < 4; i++) {
+        EXPECT_NEAR(0.25f, coverage(preserved, levels[i]), 0.03f) << "level " << i;
+    }
+}
+
+TEST(MipmapGenerator, ParallelMatchesSerial) {
+    for (auto filter : {MipmapOptions::Filter::Box, MipmapOptions::Filter::Kaiser}) {
+        std::vector<Mipmap> levels;
+        auto serial = makeChain(301, 157, levels, 3);
+        auto parallel = serial;
+        MipmapOptions options;
+        options.filter = filter;
+        options.srgb = true;
+        options.alphaCutoff = 0.3f;
+        MipmapGenerator(options).generate(serial.data(), levels, false);
+        MipmapGenerator(options).generate(parallel.data(), levels, true);
+        EXPECT_EQ(serial, parallel);
+    }
+}
+
+TEST(MipmapGenerator, DISABLED_Benchmark) {
+    constexpr uint32_t kSize = 4096;
+    std::vector<Mipmap> levels;
+    auto data = makeChain(kSize, kSize, levels, 4);
+    std::vector<uint8_t> former(data.begin(), data.begin() + kSize * kSize * 4);
+
+    Timer timer;
+    timer.start();
+    stbGenerateMipmaps(former, kSize, kSize);
+    const double stbTime = timer.stop<Timer::Milliseconds>();
+
+    MipmapOptions options;
+    options.srgb = true;
+    timer.start();
+    MipmapGenerator(options).generate(data.data(), levels);
+    const double boxTime = timer.stop<Timer::Milliseconds>();
+
+    options.filter = MipmapOptions::Filter::Kaiser;
+    timer.start();
+    MipmapGenerator(options).generate(data.data(), levels);
+    const double kaiserTime = timer.stop<Timer::Milliseconds>();
+    RecordProperty("stb_ms", std::to_string(stbTime));
+    RecordProperty("box_ms", std::to_string(boxTime));
+    RecordProperty("kaiser_ms", std::to_string(kaiserTime));
+}
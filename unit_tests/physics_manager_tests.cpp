@@ -0,0 +1,166 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "scene.h"
+#include "entity.h"
+#include "physics/physics_manager.h"
+#include "physics/dynamic_collider.h"
+#include "physics/shape/box_collider_shape.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <Metal/Metal.hpp>
+
+using namespace vox;
+using namespace vox::physics;
+
+class PhysicsManagerTest : public testing::Test {
+public:
+    void SetUp() override {
+        device = MTL::CreateSystemDefaultDevice();
+        scene = std::make_unique<Scene>(*device);
+        // steps which are exact in binary, so the accumulator does not drift
+        manager().fixedTimeStep = 0.25f;
+        manager().asynchronous = false;
+    }
+
+    void TearDown() override {
+        scene.reset();
+        device->release();
+    }
+
+    PhysicsManager &manager() {
+        return scene->_physicsManager;
+    }
+
+    // a falling box, there is no ground
+    EntityPtr addBody(const Point3F &position) {
+        auto entity = scene->createRootEntity();
+        entity->transform->setPosition(position);
+        auto collider = entity->addComponent<DynamicCollider>();
+        collider->addShape(std::make_shared<BoxColliderShape>());
+        return entity;
+    }
+
+    MTL::Device *device{nullptr};
+    std::unique_ptr<Scene> scene;
+};
+
+TEST_F(PhysicsManagerTest, FixedStepAccumulator) {
+    addBody(Point3F(0, 10, 0));
+
+    uint32_t steps = 0;
+    for (uint32_t i = 0; i < 10; i++) {
+        manager().update(0.125f);
+        EXPECT_EQ(i % 2, manager().timing().steps);
+        steps += manager().timing().steps;
+    }
+    EXPECT_EQ(5u, steps);
+
+    manager().update(0.75f);
+    EXPECT_EQ(3u, manager().timing().steps);
+}
+
+TEST_F(PhysicsManagerTest, MaxSubStepsDropsTime) {
+    addBody(Point3F(0, 10, 0));
+    manager().maxSubSteps = 4;
+
+    manager().update(10.f);
+    EXPECT_EQ(4u, manager().timing().steps);
+
+    // the time past the last sub step is not caught up
+    manager().update(0.125f);
+    EXPECT_EQ(0u, manager().timing().steps);
+    manager().update(0.125f);
+    EXPECT_EQ(1u, manager().timing().steps);
+}
+
+TEST_F(PhysicsManagerTest, InterpolatesBetweenPoses) {
+    auto entity = addBody(Point3F(0, 10, 0));
+
+    manager().interpolation = false;
+    manager().update(0.25f);
+    manager().callColliderOnLateUpdate();
+    const float previous = entity->transform->worldPosition().y;
+    manager().update(0.25f);
+    manager().callColliderOnLateUpdate();
+    const float current = entity->transform->worldPosition().y;
+    ASSERT_LT(current, previous);
+
+    // half a step is left in the accumulator
+    manager().interpolation = true;
+    manager().update(0.125f);
+    EXPECT_EQ(0u, manager().timing().steps);
+    manager().callColliderOnLateUpdate();
+    const float interpolated = entity->transform->worldPosition().y;
+    EXPECT_LT(interpolated, previous);
+    EXPECT_GT(interpolated, current);
+    EXPECT_NEAR(0.5f * (previous + current), interpolated, 1e-4f);
+}
+
+TEST_F(PhysicsManagerTest, TeleportIsNotInterpolated) {
+    auto entity = addBody(Point3F(0, 10, 0));
+    manager().update(0.25f);
+    manager().update(0.25f);
+
+    entity->transform->setWorldPosition(Point3F(5, 0, 0));
+    manager().callColliderOnUpdate();
+    manager().update(0.125f);
+    manager().callColliderOnLateUpdate();
+
+    const auto position = entity->transform->worldPosition();
+    EXPECT_FLOAT_EQ(5.f, position.x);
+    EXPECT_FLOAT_EQ(0.f, position.y);
+    EXPECT_FLOAT_EQ(0.f, position.z);
+}
+
+TEST_F(PhysicsManagerTest, AsynchronousStepIsFetchedWhenDue) {
+    auto entity = addBody(Point3F(0, 10, 0));
+    manager().asynchronous = true;
+    manager().interpolation = false;
+
+    // no step is due, the next one runs in the background
+    manager().update(0.125f);
+    EXPECT_EQ(0u, manager().timing().steps);
+    manager().waitForSimulation();
+    manager().callColliderOnLateUpdate();
+    EXPECT_FLOAT_EQ(10.f, entity->transform->worldPosition().y);
+
+    // the background step is fetched instead of simulating another one
+    manager().update(0.125f);
+    EXPECT_EQ(1u, manager().timing().steps);
+    manager().callColliderOnLateUpdate();
+    const float first = entity->transform->worldPosition().y;
+    EXPECT_LT(first, 10.f);
+
+    manager().update(0.125f);
+    EXPECT_EQ(0u, manager().timing().steps);
+    manager().callColliderOnLateUpdate();
+    EXPECT_FLOAT_EQ(first, entity->transform->worldPosition().y);
+
+    manager().update(0.125f);
+    EXPECT_EQ(1u, manager().timing().steps);
+    manager().callColliderOnLateUpdate();
+    EXPECT_LT(entity->transform->worldPosition().y, first);
+}
+
+TEST_F(PhysicsManagerTest, ExternalWaitIsCounted) {
+    // overlapping boxes, so the step takes long enough to be measured
+    for (uint32_t i = 0; i < 256; i++) {
+        addBody(Point3F(0, 0, 0));
+    }
+    manager().asynchronous = true;
+    manager().update(0.125f);
+
+    Timer timer;
+    timer.start();
+    manager().waitForSimulation();
+    const auto wait = static_cast<float>(timer.stop<Timer::Milliseconds>());
+
+    manager().update(0.125f);
+    EXPECT_EQ(1u, manager().timing().steps);
+    EXPECT_GE(manager().timing().wait, 0.5f * wait);
+}
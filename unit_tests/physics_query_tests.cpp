@@ -0,0 +1,176 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "scene.h"
+#include "entity.h"
+#include "physics/physics_manager.h"
+#include "physics/static_collider.h"
+#include "physics/shape/box_collider_shape.h"
+
+#include <gtest/gtest.h>
+#include <Metal/Metal.hpp>
+
+using namespace vox;
+using namespace vox::physics;
+
+class PhysicsQueryTest : public testing::Test {
+public:
+    // a unit box on Layer1 in front of a unit box on Layer0, both on the x axis
+    void SetUp() override {
+        device = MTL::CreateSystemDefaultDevice();
+        scene = std::make_unique<Scene>(*device);
+        blocker = addBox(Point3F(5, 0, 0), Layer::Layer1);
+        target = addBox(Point3F(10, 0, 0), Layer::Layer0);
+    }
+
+    void TearDown() override {
+        scene.reset();
+        device->release();
+    }
+
+    PhysicsManager &manager() {
+        return scene->_physicsManager;
+    }
+
+    Entity *addBox(const Point3F &position, Layer layer) {
+        auto entity = scene->createRootEntity();
+        entity->layer = layer;
+        entity->transform->setPosition(position);
+        auto collider = entity->addComponent<StaticCollider>();
+        collider->addShape(std::make_shared<BoxColliderShape>());
+        return entity.get();
+    }
+
+    static OverlapQuery overlapQuery(const Point3F &position, const Vector3F &halfExtents) {
+        OverlapQuery query;
+        query.geometry = PxBoxGeometry(halfExtents.x, halfExtents.y, halfExtents.z);
+        query.position = position;
+        return query;
+    }
+
+    MTL::Device *device{nullptr};
+    std::unique_ptr<Scene> scene;
+    Entity *blocker{nullptr};
+    Entity *target{nullptr};
+};
+
+TEST_F(PhysicsQueryTest, RaycastSkipsMaskedBlocker) {
+    const Ray3F ray(Point3F(0, 0, 0), Vector3F(1, 0, 0));
+    std::vector<HitResult> hits;
+    manager().raycast({{ray}, {ray, 100.f, Layer::Layer0}, {ray, 7.f, Layer::Layer0}}, hits);
+    ASSERT_EQ(3u, hits.size());
+
+    EXPECT_EQ(blocker, hits[0].entity);
+    EXPECT_NEAR(4.5f, hits[0].distance, 1e-4f);
+    EXPECT_NEAR(-1.f, hits[0].normal.x, 1e-4f);
+
+    // the collider outside of the mask does not hide the one behind it
+    EXPECT_EQ(target, hits[1].entity);
+    EXPECT_NEAR(9.5f, hits[1].distance, 1e-4f);
+    EXPECT_NEAR(9.5f, hits[1].point.x, 1e-4f);
+
+    EXPECT_EQ(nullptr, hits[2].entity);
+}
+
+TEST_F(PhysicsQueryTest, SweepHitsColliders) {
+    SweepQuery query;
+    query.geometry = PxSphereGeometry(0.5f);
+    query.direction = Vector3F(1, 0, 0);
+    query.distance = 100.f;
+
+    std::vector<SweepQuery> queries(3, query);
+    queries[1].layerMask = Layer::Layer0;
+    queries[2].direction = Vector3F(-1, 0, 0);
+
+    std::vector<HitResult> hits;
+    manager().sweep(queries, hits);
+    ASSERT_EQ(3u, hits.size());
+
+    EXPECT_EQ(blocker, hits[0].entity);
+    EXPECT_NEAR(4.f, hits[0].distance, 1e-3f);
+    EXPECT_NEAR(-1.f, hits[0].normal.x, 1e-4f);
+    EXPECT_EQ(target, hits[1].entity);
+    EXPECT_NEAR(9.f, hits[1].distance, 1e-3f);
+    EXPECT_EQ(nullptr, hits[2].entity);
+}
+
+TEST_F(PhysicsQueryTest, OverlapPadsWithNull) {
+    const std::vector<OverlapQuery> queries = {
+        overlapQuery(Point3F(7.5f, 0, 0), Vector3F(5, 1, 1)),
+        overlapQuery(Point3F(0, 50, 0), Vector3F(1, 1, 1)),
+        overlapQuery(Point3F(10, 0, 0), Vector3F(1, 1, 1)),
+    };
+
+    std::vector<Entity *> entities;
+    manager().overlap(queries, 3, entities);
+    ASSERT_EQ(9u, entities.size());
+
+    // both boxes, in any order
+    EXPECT_TRUE((entities[0] == blocker && entities[1] == target) ||
+                (entities[0] == target && entities[1] == blocker));
+    EXPECT_EQ(nullptr, entities[2]);
+    for (size_t i = 3; i < 6; i++) {
+        EXPECT_EQ(nullptr, entities[i]);
+    }
+    EXPECT_EQ(target, entities[6]);
+    EXPECT_EQ(nullptr, entities[7]);
+    EXPECT_EQ(nullptr, entities[8]);
+}
+
+TEST_F(PhysicsQueryTest, OverlapOverflowKeepsStride) {
+    const std::vector<OverlapQuery> queries = {
+        overlapQuery(Point3F(7.5f, 0, 0), Vector3F(5, 1, 1)),
+        overlapQuery(Point3F(5, 0, 0), Vector3F(1, 1, 1)),
+    };
+
+    // the first shape touches more entities than a slot holds
+    std::vector<Entity *> entities;
+    manager().overlap(queries, 1, entities);
+    ASSERT_EQ(2u, entities.size());
+    EXPECT_TRUE(entities[0] == blocker || entities[0] == target);
+    EXPECT_EQ(blocker, entities[1]);
+
+    manager().overlap(queries, 0, entities);
+    EXPECT_TRUE(entities.empty());
+}
+
+TEST_F(PhysicsQueryTest, BatchMatchesSingleQueries) {
+    // more queries than a job runs, rays through the boxes, their edges and past them
+    std::vector<RaycastQuery> rays;
+    std::vector<OverlapQuery> overlaps;
+    for (uint32_t i = 0; i < 100; i++) {
+        const float offset = -1.f + 0.02f * static_cast<float>(i);
+        const Layer mask = i % 3 == 0 ? Layer::Layer0 : Layer::Everything;
+        rays.push_back({Ray3F(Point3F(0, offset, 0.25f * offset), Vector3F(1, 0, 0)), 20.f, mask});
+
+        auto overlap = overlapQuery(Point3F(5.f + 5.f * offset, 0, 0), Vector3F(1, 1, 1));
+        overlap.layerMask = mask;
+        overlaps.push_back(overlap);
+    }
+
+    std::vector<HitResult> hits;
+    manager().raycast(rays, hits);
+    ASSERT_EQ(rays.size(), hits.size());
+    for (size_t i = 0; i < rays.size(); i++) {
+        HitResult single;
+        const bool result = manager().raycast(rays[i].ray, rays[i].distance, rays[i].layerMask, single);
+        EXPECT_EQ(result, hits[i].entity != nullptr);
+        EXPECT_EQ(single.entity, hits[i].entity);
+        EXPECT_EQ(single.distance, hits[i].distance);
+        EXPECT_EQ(single.point, hits[i].point);
+        EXPECT_EQ(single.normal, hits[i].normal);
+    }
+
+    std::vector<Entity *> entities;
+    manager().overlap(overlaps, 2, entities);
+    ASSERT_EQ(2 * overlaps.size(), entities.size());
+    for (size_t i = 0; i < overlaps.size(); i++) {
+        std::vector<Entity *> single;
+        manager().overlap({overlaps[i]}, 2, single);
+        EXPECT_EQ(single[0], entities[2 * i]);
+        EXPECT_EQ(single[1], entities[2 * i + 1]);
+    }
+}
@@ -0,0 +1,184 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "rendering/pipeline_key.h"
+
+#include <gtest/gtest.h>
+
+using namespace vox;
+
+namespace {
+RenderPipelineKey makeKey(const std::string &vertex, int lightCount) {
+    RenderPipelineKey key;
+    key.vertexFunction.source = vertex;
+    key.vertexFunction.macros.enable(HAS_UV, std::make_pair(1, MTL::DataTypeBool));
+    key.vertexFunction.macros.enable(DIRECT_LIGHT_COUNT, std::make_pair(lightCount, MTL::DataTypeInt));
+    key.fragmentFunction = FunctionKey();
+    key.fragmentFunction->source = "fragment_" + vertex;
+    key.fragmentFunction->macros = key.vertexFunction.macros;
+
+    VertexAttributeKey position;
+    position.format = 30;
+    key.vertexLayout.attributes.push_back(position);
+    VertexAttributeKey uv;
+    uv.index = 3;
+    uv.format = 29;
+    uv.offset = 12;
+    key.vertexLayout.attributes.push_back(uv);
+    VertexBufferLayoutKey layout;
+    layout.stride = 20;
+    key.vertexLayout.layouts.push_back(layout);
+
+    ColorAttachmentKey color;
+    color.pixelFormat = 80;
+    color.writeMask = 0xF;
+    key.renderState.colorAttachments.push_back(color);
+    key.renderState.depthPixelFormat = 260;
+    key.renderState.stencilPixelFormat = 260;
+    return key;
+}
+
+}
+
+TEST(PipelineKey, FullKeyEquality) {
+    const auto key = makeKey("vertex_blinn_phong", 1);
+    EXPECT_EQ(key, makeKey("vertex_blinn_phong", 1));
+    EXPECT_EQ(std::hash<RenderPipelineKey>{}(key), std::hash<RenderPipelineKey>{}(makeKey("vertex_blinn_phong", 1)));
+
+    EXPECT_FALSE(key == makeKey("vertex_blinn_phong", 2));
+    EXPECT_FALSE(key == makeKey("vertex_pbr", 1));
+
+    auto other = key;
+    other.vertexLayout.attributes[1].offset = 16;
+    EXPECT_FALSE(key == other);
+
+    other = key;
+    other.renderState.colorAttachments[0].blendingEnabled = 1;
+    EXPECT_FALSE(key == other);
+
+    other = key;
+    other.fragmentFunction = std::nullopt;
+    EXPECT_FALSE(key == other);
+
+    other = key;
+    other.renderState.sampleCount = 4;
+    EXPECT_FALSE(key == other);
+}
+
+TEST(PipelineKey, DepthStencilEquality) {
+    DepthStencilKey a;
+    a.depthCompareFunction = 1;
+    a.depthWriteEnabled = 1;
+    auto b = a;
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(std::hash<DepthStencilKey>{}(a), std::hash<DepthStencilKey>{}(b));
+    b.backFaceStencil.writeMask = 0xFF;
+    EXPECT_FALSE(a == b);
+}
+
+TEST(PipelineManifest, RecordOnce) {
+    PipelineManifest manifest;
+    EXPECT_TRUE(manifest.record(makeKey("vertex_unlit", 0)));
+    EXPECT_TRUE(manifest.record(makeKey("vertex_unlit", 1)));
+    EXPECT_FALSE(manifest.record(makeKey("vertex_unlit", 0)));
+
+    ComputePipelineKey compute;
+    compute.computeFunction.source = "build_cluster";
+    EXPECT_TRUE(manifest.record(compute));
+    EXPECT_FALSE(manifest.record(compute));
+
+    EXPECT_EQ(3u, manifest.size());
+    EXPECT_TRUE(manifest.contains(makeKey("vertex_unlit", 1)));
+    EXPECT_FALSE(manifest.contains(makeKey("vertex_unlit", 2)));
+    // first use order is kept
+    EXPECT_EQ(0, manifest.renderPipelines()[0].vertexFunction.macros.value(DIRECT_LIGHT_COUNT).first);
+
+    PipelineManifest other;
+    other.record(makeKey("vertex_unlit", 1));
+    other.record(makeKey("vertex_pbr", 1));
+    manifest.merge(other);
+    EXPECT_EQ(4u, manifest.size());
+}
+
+TEST(PipelineManifest, RoundTrip) {
+    PipelineManifest manifest;
+    manifest.record(makeKey("vertex_blinn_phong", 2));
+    auto shadow = makeKey("vertex_depth", 0);
+    shadow.fragmentFunction = std::nullopt;
+    shadow.renderState.colorAttachments.clear();
+    manifest.record(shadow);
+    ComputePipelineKey compute;
+    compute.computeFunction.source = "particle_simulation";
+    compute.computeFunction.macros.enable(HAS_SH, std::make_pair(1, MTL::DataTypeBool));
+    manifest.record(compute);
+
+    PipelineManifest loaded;
+    ASSERT_TRUE(loaded.deserialize(manifest.serialize()));
+    ASSERT_EQ(manifest.renderPipelines().size(), loaded.renderPipelines().size());
+    for (size_t i = 0; i < manifest.renderPipelines().size(); i++) {
+        EXPECT_EQ(manifest.renderPipelines()[i], loaded.renderPipelines()[i]);
+    }
+    ASSERT_EQ(1u, loaded.computePipelines().size());
+    EXPECT_EQ(compute, loaded.computePipelines()[0]);
+    EXPECT_EQ(manifest.serialize(), loaded.serialize());
+}
+
+TEST(PipelineManifest, RejectDamagedData) {
+    PipelineManifest manifest;
+    manifest.record(makeKey("vertex_blinn_phong", 2));
+    const auto data = manifest.serialize();
+
+    PipelineManifest loaded;
+    loaded.record(makeKey("vertex_pbr", 1));
+    EXPECT_FALSE(loaded.deserialize({}));
+    EXPECT_EQ(0u, loaded.size());
+
+    auto truncated = data;
+    truncated.resize(data.size() / 2);
+    EXPECT_FALSE(loaded.deserialize(truncated));
+    EXPECT_EQ(0u, loaded.size());
+
+    auto wrongMagic = data;
+    wrongMagic[0] ^= 0xFF;
+    EXPECT_FALSE(loaded.deserialize(wrongMagic));
+
+    EXPECT_FALSE(loaded.load("this/file/does/not/exist.bin"));
+    EXPECT_TRUE(loaded.deserialize(data));
+    EXPECT_EQ(1u, loaded.size());
+}
+
+TEST(PipelineManifest, RejectIndexOutOfRange) {
+    PipelineManifest loaded;
+    auto attribute = makeKey("vertex_blinn_phong", 2);
+    attribute.vertexLayout.attributes[1].index = 31;
+    PipelineManifest manifest;
+    manifest.record(attribute);
+    EXPECT_FALSE(loaded.deserialize(manifest.serialize()));
+
+    auto bufferIndex = makeKey("vertex_blinn_phong", 2);
+    bufferIndex.vertexLayout.attributes[1].bufferIndex = 0xFFFFFFFF;
+    manifest.clear();
+    manifest.record(bufferIndex);
+    EXPECT_FALSE(loaded.deserialize(manifest.serialize()));
+
+    auto layout = makeKey("vertex_blinn_phong", 2);
+    layout.vertexLayout.layouts[0].index = 64;
+    manifest.clear();
+    manifest.record(layout);
+    EXPECT_FALSE(loaded.deserialize(manifest.serialize()));
+
+    auto attachment = makeKey("vertex_blinn_phong", 2);
+    attachment.renderState.colorAttachments[0].index = 8;
+    manifest.clear();
+    manifest.record(attachment);
+    EXPECT_FALSE(loaded.deserialize(manifest.serialize()));
+    EXPECT_EQ(0u, loaded.size());
+
+    attachment.renderState.colorAttachments[0].index = 7;
+    manifest.clear();
+    manifest.record(attachment);
+    EXPECT_TRUE(loaded.deserialize(manifest.serialize()));
+}
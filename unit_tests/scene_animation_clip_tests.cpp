@@ -0,0 +1,153 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "scene_animation_clip.h"
+#include "transform.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+using namespace vox;
+
+namespace {
+// key lookup of the former update, a scan from the first key
+uint32_t linearFindKey(const std::vector<float> &inputs, float time) {
+    for (size_t i = 0; i < inputs.size() - 1; i++) {
+        if (time >= inputs[i] && time <= inputs[i + 1]) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    return 0;
+}
+
+SceneAnimationClip::AnimationSampler makeSampler(size_t keys, float duration, uint32_t components,
+                                                 SceneAnimationClip::AnimationSampler::InterpolationType interpolation) {
+    SceneAnimationClip::AnimationSampler sampler;
+    sampler.interpolation = interpolation;
+    sampler.components = components;
+    for (size_t i = 0; i < keys; i++) {
+        const float time = duration * i / (keys - 1);
+        sampler.inputs.push_back(time);
+        if (components == 4) {
+            // rotation around y
+            sampler.outputs.insert(sampler.outputs.end(), {0, std::sin(time * 0.5f), 0, std::cos(time * 0.5f)});
+        } else {
+            sampler.outputs.insert(sampler.outputs.end(), {time, 2 * time, 1});
+        }
+    }
+    return sampler;
+}
+
+}
+
+TEST(SceneAnimationClip, FindKey) {
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> step(0.001f, 0.01f);
+    std::vector<float> inputs{0};
+    for (int i = 1; i < 10000; i++) {
+        inputs.push_back(inputs.back() + step(random));
+    }
+
+    uint32_t cursor = 0;
+    // playback, jumps back and forth and times outside of the keys
+    std::uniform_real_distribution<float> anywhere(-1, inputs.back() + 1);
+    float time = 0;
+    for (int i = 0; i < 20000; i++) {
+        time = i % 100 == 0 ? anywhere(random) : time + 0.004f;
+        const uint32_t key = SceneAnimationClip::findKey(inputs, time, cursor);
+        ASSERT_EQ(key, cursor);
+        ASSERT_LE(key, inputs.size() - 2);
+        if (time < inputs.front()) {
+            ASSERT_EQ(0u, key);
+        } else if (time > inputs.back()) {
+            ASSERT_EQ(inputs.size() - 2, key);
+        } else {
+            ASSERT_LE(inputs[key], time);
+            ASSERT_GE(inputs[key + 1], time);
+        }
+    }
+
+    std::vector<float> single{1};
+    EXPECT_EQ(0u, SceneAnimationClip::findKey(single, 2, cursor));
+}
+
+TEST(SceneAnimationClip, Sample) {
+    auto node = std::make_shared<Entity>("node");
+    SceneAnimationClip clip("clip");
+    clip.setStart(0);
+    clip.setEnd(4);
+    clip.addSampler(makeSampler(5, 4, 3, SceneAnimationClip::AnimationSampler::LINEAR));
+    clip.addSampler(makeSampler(5, 4, 4, SceneAnimationClip::AnimationSampler::LINEAR));
+    clip.addSampler(makeSampler(5, 4, 3, SceneAnimationClip::AnimationSampler::STEP));
+    clip.addChannel({SceneAnimationClip::AnimationChannel::TRANSLATION, node, 0});
+    clip.addChannel({SceneAnimationClip::AnimationChannel::ROTATION, node, 1});
+    clip.addChannel({SceneAnimationClip::AnimationChannel::SCALE, node, 2});
+
+    clip.update(1.5f);
+    const auto position = node->transform->position();
+    EXPECT_NEAR(1.5f, position.x, 1e-5f);
+    EXPECT_NEAR(3.f, position.y, 1e-5f);
+    const auto rotation = node->transform->rotationQuaternion();
+    EXPECT_NEAR(std::sin(0.75f), rotation.y, 1e-3f);
+    EXPECT_NEAR(std::cos(0.75f), rotation.w, 1e-3f);
+    // step holds the value of the key before
+    EXPECT_NEAR(1.f, node->transform->scale().x, 1e-5f);
+
+    // wraps around the end
+    clip.update(3.f);
+    EXPECT_NEAR(0.5f, node->transform->position().x, 1e-5f);
+}
+
+TEST(SceneAnimationClip, DISABLED_Benchmark) {
+    constexpr size_t kNodes = 1000;
+    constexpr size_t kKeys = 10000;
+    constexpr size_t kSamplers = 8;
+    constexpr float kDuration = 100;
+    constexpr int kFrames = 100;
+
+    SceneAnimationClip clip("clip");
+    clip.setStart(0);
+    clip.setEnd(kDuration);
+    // nodes share the keys, every channel keeps its own cursor
+    for (size_t i = 0; i < kSamplers; i++) {
+        clip.addSampler(makeSampler(kKeys, kDuration, 3, SceneAnimationClip::AnimationSampler::LINEAR));
+        clip.addSampler(makeSampler(kKeys, kDuration, 4, SceneAnimationClip::AnimationSampler::LINEAR));
+    }
+    std::vector<EntityPtr> nodes;
+    for (size_t i = 0; i < kNodes; i++) {
+        nodes.push_back(std::make_shared<Entity>());
+        const auto sampler = static_cast<uint32_t>(i % kSamplers) * 2;
+        clip.addChannel({SceneAnimationClip::AnimationChannel::TRANSLATION, nodes.back(), sampler});
+        clip.addChannel({SceneAnimationClip::AnimationChannel::ROTATION, nodes.back(), sampler + 1});
+        clip.addChannel({SceneAnimationClip::AnimationChannel::SCALE, nodes.back(), sampler});
+    }
+
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < kFrames; i++) {
+        clip.update(1.f / 60);
+    }
+    const double clipTime = timer.stop<Timer::Milliseconds>() / kFrames;
+
+    // the lookups alone of the former linear scan, half way through the clip
+    const auto inputs = makeSampler(kKeys, kDuration, 3, SceneAnimationClip::AnimationSampler::LINEAR).inputs;
+    uint32_t checksum = 0;
+    constexpr int kLinearFrames = 5;
+    timer.start();
+    for (int i = 0; i < kLinearFrames; i++) {
+        for (size_t channel = 0; channel < kNodes * 3; channel++) {
+            checksum += linearFindKey(inputs, kDuration / 2 + i / 60.f);
+        }
+    }
+    const double linearTime = timer.stop<Timer::Milliseconds>() / kLinearFrames;
+
+    RecordProperty("update_ms", std::to_string(clipTime));
+    RecordProperty("linear_scan_ms", std::to_string(linearTime));
+    EXPECT_GT(checksum, 0u);
+    EXPECT_NEAR(100.f / 60, nodes.front()->transform->position().x, 1e-3f);
+}
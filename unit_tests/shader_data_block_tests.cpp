@@ -0,0 +1,123 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "shader/shader_data_block.h"
+
+#include "unit_tests_utils.h"
+
+using namespace vox;
+
+TEST(ShaderDataBlock, Empty) {
+    ShaderDataBlock block;
+    EXPECT_EQ(0u, block.size());
+    EXPECT_FALSE(block.isDirty());
+    EXPECT_FALSE(block.has(0));
+    EXPECT_FALSE(block.offset(3).has_value());
+    EXPECT_FALSE(block.getAny(3).has_value());
+}
+
+TEST(ShaderDataBlock, SlotLayout) {
+    ShaderDataBlock block(256);
+    block.set(4, 1.5f);
+    block.set(1, Matrix4x4F::makeIdentity());
+    block.set(9, Vector3F(1, 2, 3));
+
+    EXPECT_EQ(0u, block.offset(4).value());
+    EXPECT_EQ(256u, block.offset(1).value());
+    EXPECT_EQ(512u, block.offset(9).value());
+    EXPECT_EQ(768u, block.size());
+    for (int id : {1, 4, 9}) {
+        EXPECT_EQ(0u, block.offset(id).value() % block.alignment());
+    }
+
+    // rewrite in place
+    block.set(4, 2.5f);
+    EXPECT_EQ(0u, block.offset(4).value());
+    EXPECT_EQ(768u, block.size());
+
+    // bigger value moves the slot to the end
+    block.set(4, std::array<float, 80>{});
+    EXPECT_EQ(768u, block.offset(4).value());
+    EXPECT_EQ(768u + 512u, block.size());
+}
+
+TEST(ShaderDataBlock, BytesMatchGPULayout) {
+    ShaderDataBlock block(16);
+    block.set(0, Vector3F(1, 2, 3));
+    block.set(1, Color(0.1f, 0.2f, 0.3f, 0.4f));
+    block.set(2, uint32_t(7));
+
+    // float3 occupies 16 bytes
+    EXPECT_EQ(16u, block.offset(1).value());
+    const auto *vector = reinterpret_cast<const float *>(block.data());
+    EXPECT_FLOAT_EQ(1.f, vector[0]);
+    EXPECT_FLOAT_EQ(2.f, vector[1]);
+    EXPECT_FLOAT_EQ(3.f, vector[2]);
+    const auto *color = reinterpret_cast<const float *>(block.data() + block.offset(1).value());
+    EXPECT_FLOAT_EQ(0.3f, color[2]);
+    const auto *integer = reinterpret_cast<const uint32_t *>(block.data() + block.offset(2).value());
+    EXPECT_EQ(7u, *integer);
+}
+
+TEST(ShaderDataBlock, GetValue) {
+    ShaderDataBlock block;
+    block.set(2, Vector4F(1, 2, 3, 4));
+    block.set(3, Point3F(5, 6, 7));
+    block.set(5, true);
+
+    EXPECT_EQ(Vector4F(1, 2, 3, 4), block.get<Vector4F>(2).value());
+    EXPECT_EQ(Point3F(5, 6, 7), block.get<Point3F>(3).value());
+    EXPECT_TRUE(block.get<bool>(5).value());
+    EXPECT_FALSE(block.get<Matrix4x4F>(2).has_value());
+
+    auto any = block.getAny(2);
+    ASSERT_TRUE(any.has_value());
+    EXPECT_EQ(Vector4F(1, 2, 3, 4), std::any_cast<Vector4F>(any.value()));
+    EXPECT_TRUE(std::any_cast<bool>(block.getAny(5).value()));
+}
+
+TEST(ShaderDataBlock, DirtyRange) {
+    ShaderDataBlock block(64);
+    block.set(0, 1.f);
+    block.set(1, 2.f);
+    block.set(2, 3.f);
+    // new slots dirty the whole block
+    EXPECT_TRUE(block.isDirty());
+    EXPECT_EQ(std::make_pair(size_t(0), size_t(192)), block.dirtyRange());
+
+    block.clearDirty();
+    EXPECT_FALSE(block.isDirty());
+
+    block.set(1, 4.f);
+    EXPECT_EQ(std::make_pair(size_t(64), size_t(68)), block.dirtyRange());
+    block.set(2, 5.f);
+    EXPECT_EQ(std::make_pair(size_t(64), size_t(132)), block.dirtyRange());
+    block.set(0, 6.f);
+    EXPECT_EQ(std::make_pair(size_t(0), size_t(132)), block.dirtyRange());
+}
+
+TEST(ShaderDataBlock, Remove) {
+    ShaderDataBlock block;
+    block.set(1, 1.f);
+    block.remove(1);
+    block.remove(42);
+    EXPECT_FALSE(block.has(1));
+    EXPECT_FALSE(block.getAny(1).has_value());
+
+    block.set(1, 2.f);
+    EXPECT_EQ(0u, block.offset(1).value());
+    EXPECT_FLOAT_EQ(2.f, block.get<float>(1).value());
+}
+
+TEST(ShaderDataBlock, UniformValueTraits) {
+    EXPECT_TRUE(is_uniform_value_v<float>);
+    EXPECT_TRUE(is_uniform_value_v<Matrix4x4F>);
+    EXPECT_TRUE((is_uniform_value_v<std::array<float, 27>>));
+    EXPECT_FALSE(is_uniform_value_v<std::shared_ptr<int>>);
+    EXPECT_FALSE(is_uniform_value_v<const float *>);
+    EXPECT_EQ(16u, uniform_size<Vector3F>::value);
+    EXPECT_EQ(4u, uniform_size<float>::value);
+}
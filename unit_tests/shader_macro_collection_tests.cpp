@@ -0,0 +1,197 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "shader/shader_macro_collection.h"
+
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace vox;
+
+namespace {
+// Map based collection with the semantics ShaderMacroCollection used to have,
+// enabling an enabled macro was an insert and kept the first value.
+struct LegacyMacroCollection {
+    std::unordered_map<MacroName, std::pair<int, MTL::DataType>> value;
+
+    void enable(MacroName name, std::pair<int, MTL::DataType> v) {
+        value.insert(std::make_pair(name, v));
+    }
+
+    void disable(MacroName name) {
+        value.erase(name);
+    }
+
+    static void unionCollection(const LegacyMacroCollection &left, const LegacyMacroCollection &right,
+                                LegacyMacroCollection &result) {
+        result.value.insert(left.value.begin(), left.value.end());
+        result.value.insert(right.value.begin(), right.value.end());
+    }
+};
+
+void expectSame(const LegacyMacroCollection &legacy, const ShaderMacroCollection &macros) {
+    EXPECT_EQ(legacy.value.size(), macros.count());
+    for (int i = 0; i < MacroName::TOTAL_COUNT; i++) {
+        auto iter = legacy.value.find(MacroName(i));
+        EXPECT_EQ(iter != legacy.value.end(), macros.isEnabled(MacroName(i)));
+        if (iter != legacy.value.end()) {
+            EXPECT_EQ(iter->second, macros.value(MacroName(i)));
+        }
+    }
+}
+
+std::pair<int, MTL::DataType> randomValue(std::mt19937 &rng) {
+    if (rng() % 2) {
+        return std::make_pair(1, MTL::DataTypeBool);
+    }
+    return std::make_pair(int(rng() % 8), MTL::DataTypeInt);
+}
+
+}
+
+TEST(ShaderMacroCollection, Empty) {
+    ShaderMacroCollection macros;
+    EXPECT_EQ(0u, macros.count());
+    EXPECT_EQ(0u, macros.mask());
+    EXPECT_EQ(0u, macros.hash());
+    EXPECT_EQ(ShaderMacroCollection(), macros);
+}
+
+TEST(ShaderMacroCollection, EnableDisable) {
+    ShaderMacroCollection macros;
+    macros.enable(HAS_UV, std::make_pair(1, MTL::DataTypeBool));
+    macros.enable(JOINTS_COUNT, std::make_pair(4, MTL::DataTypeInt));
+    EXPECT_TRUE(macros.isEnabled(HAS_UV));
+    EXPECT_TRUE(macros.isEnabled(JOINTS_COUNT));
+    EXPECT_FALSE(macros.isEnabled(HAS_NORMAL));
+    EXPECT_EQ(2u, macros.count());
+    EXPECT_EQ(4, macros.value(JOINTS_COUNT).first);
+
+    macros.disable(HAS_UV);
+    macros.disable(HAS_UV);
+    EXPECT_FALSE(macros.isEnabled(HAS_UV));
+    EXPECT_EQ(1u, macros.count());
+
+    macros.disable(JOINTS_COUNT);
+    EXPECT_EQ(ShaderMacroCollection(), macros);
+    EXPECT_EQ(0u, macros.hash());
+}
+
+TEST(ShaderMacroCollection, EnableUpdatesValue) {
+    LegacyMacroCollection legacy;
+    legacy.enable(POINT_LIGHT_COUNT, std::make_pair(2, MTL::DataTypeInt));
+    legacy.enable(POINT_LIGHT_COUNT, std::make_pair(3, MTL::DataTypeInt));
+    EXPECT_EQ(2, legacy.value[POINT_LIGHT_COUNT].first);
+
+    // a light count which changes between frames is not left at its first value
+    ShaderMacroCollection macros;
+    macros.enable(POINT_LIGHT_COUNT, std::make_pair(2, MTL::DataTypeInt));
+    macros.enable(POINT_LIGHT_COUNT, std::make_pair(3, MTL::DataTypeInt));
+    EXPECT_EQ(1u, macros.count());
+    EXPECT_EQ(3, macros.value(POINT_LIGHT_COUNT).first);
+
+    ShaderMacroCollection rebuilt;
+    rebuilt.enable(POINT_LIGHT_COUNT, std::make_pair(3, MTL::DataTypeInt));
+    EXPECT_EQ(rebuilt.hash(), macros.hash());
+    EXPECT_EQ(rebuilt, macros);
+}
+
+TEST(ShaderMacroCollection, HashIsOrderIndependent) {
+    ShaderMacroCollection a;
+    a.enable(HAS_UV, std::make_pair(1, MTL::DataTypeBool));
+    a.enable(HAS_SKIN, std::make_pair(1, MTL::DataTypeBool));
+    a.enable(DIRECT_LIGHT_COUNT, std::make_pair(2, MTL::DataTypeInt));
+
+    ShaderMacroCollection b;
+    b.enable(DIRECT_LIGHT_COUNT, std::make_pair(5, MTL::DataTypeInt));
+    b.enable(HAS_SKIN, std::make_pair(1, MTL::DataTypeBool));
+    b.enable(HAS_NORMAL, std::make_pair(1, MTL::DataTypeBool));
+    b.disable(HAS_NORMAL);
+    b.enable(HAS_UV, std::make_pair(1, MTL::DataTypeBool));
+    b.enable(DIRECT_LIGHT_COUNT, std::make_pair(2, MTL::DataTypeInt));
+
+    EXPECT_EQ(a.hash(), b.hash());
+    EXPECT_EQ(a, b);
+}
+
+TEST(ShaderMacroCollection, HashCoversValue) {
+    ShaderMacroCollection a;
+    a.enable(JOINTS_COUNT, std::make_pair(2, MTL::DataTypeInt));
+    ShaderMacroCollection b;
+    b.enable(JOINTS_COUNT, std::make_pair(3, MTL::DataTypeInt));
+    EXPECT_NE(a.hash(), b.hash());
+    EXPECT_NE(a, b);
+}
+
+TEST(ShaderMacroCollection, UnionKeepsFirstValue) {
+    ShaderMacroCollection scene;
+    scene.enable(POINT_LIGHT_COUNT, std::make_pair(3, MTL::DataTypeInt));
+    scene.enable(HAS_SH, std::make_pair(1, MTL::DataTypeBool));
+
+    ShaderMacroCollection material;
+    material.enable(POINT_LIGHT_COUNT, std::make_pair(7, MTL::DataTypeInt));
+    material.enable(HAS_BASE_TEXTURE, std::make_pair(1, MTL::DataTypeBool));
+
+    // same aliasing as ShaderData::mergeMacro(macros, macros)
+    auto macros = scene;
+    ShaderMacroCollection::unionCollection(macros, material, macros);
+    EXPECT_EQ(3u, macros.count());
+    EXPECT_EQ(3, macros.value(POINT_LIGHT_COUNT).first);
+    EXPECT_TRUE(macros.isEnabled(HAS_BASE_TEXTURE));
+
+    ShaderMacroCollection rebuilt;
+    rebuilt.enable(HAS_BASE_TEXTURE, std::make_pair(1, MTL::DataTypeBool));
+    rebuilt.enable(HAS_SH, std::make_pair(1, MTL::DataTypeBool));
+    rebuilt.enable(POINT_LIGHT_COUNT, std::make_pair(3, MTL::DataTypeInt));
+    EXPECT_EQ(rebuilt.hash(), macros.hash());
+    EXPECT_EQ(rebuilt, macros);
+}
+
+TEST(ShaderMacroCollection, EquivalentToLegacyMap) {
+    std::mt19937 rng(7);
+    constexpr int kCount = 64;
+    std::vector<LegacyMacroCollection> legacy(kCount);
+    std::vector<ShaderMacroCollection> macros(kCount);
+
+    for (int i = 0; i < kCount; i++) {
+        const int ops = int(rng() % 24);
+        for (int op = 0; op < ops; op++) {
+            // restrict names so that collisions between collections are likely
+            auto name = MacroName(rng() % 6);
+            if (rng() % 4 == 0) {
+                legacy[i].disable(name);
+                macros[i].disable(name);
+            } else {
+                // enable now updates the value, which the map only did after a disable
+                auto value = randomValue(rng);
+                legacy[i].disable(name);
+                legacy[i].enable(name, value);
+                macros[i].enable(name, value);
+            }
+        }
+        expectSame(legacy[i], macros[i]);
+    }
+
+    for (int i = 0; i < kCount; i++) {
+        for (int j = 0; j < kCount; j++) {
+            const bool legacyEqual = legacy[i].value == legacy[j].value;
+            EXPECT_EQ(legacyEqual, macros[i] == macros[j]);
+            EXPECT_EQ(legacyEqual, macros[i].hash() == macros[j].hash());
+
+            auto legacyUnion = legacy[i];
+            LegacyMacroCollection::unionCollection(legacyUnion, legacy[j], legacyUnion);
+            auto unionResult = macros[i];
+            ShaderMacroCollection::unionCollection(unionResult, macros[j], unionResult);
+            expectSame(legacyUnion, unionResult);
+
+            ShaderMacroCollection rebuilt;
+            for (auto &item : legacyUnion.value) {
+                rebuilt.enable(item.first, item.second);
+            }
+            EXPECT_EQ(rebuilt.hash(), unionResult.hash());
+        }
+    }
+}
@@ -0,0 +1,263 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "mesh/skinning.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <ozz/animation/offline/animation_builder.h>
+#include <ozz/animation/offline/raw_animation.h>
+#include <ozz/animation/offline/raw_skeleton.h>
+#include <ozz/animation/offline/skeleton_builder.h>
+#include <ozz/animation/runtime/animation.h>
+#include <ozz/animation/runtime/local_to_model_job.h>
+#include <ozz/animation/runtime/sampling_job.h>
+#include <ozz/base/maths/simd_math.h>
+#include <cmath>
+#include <random>
+#include <string>
+
+using namespace vox;
+
+namespace {
+constexpr int kJoints = 64;
+
+// chain of joints along y
+ozz::unique_ptr<ozz::animation::Skeleton> chainSkeleton() {
+    ozz::animation::offline::RawSkeleton raw;
+    raw.roots.resize(1);
+    auto *joint = &raw.roots[0];
+    for (int i = 0; i < kJoints; i++) {
+        joint->name = ("joint" + std::to_string(i)).c_str();
+        joint->transform = ozz::math::Transform::identity();
+        joint->transform.translation = ozz::math::Float3(0.f, i == 0 ? 0.f : 0.1f, 0.f);
+        if (i + 1 < kJoints) {
+            joint->children.resize(1);
+            joint = &joint->children[0];
+        }
+    }
+    return ozz::animation::offline::SkeletonBuilder()(raw);
+}
+
+// every joint swings around z
+ozz::unique_ptr<ozz::animation::Animation> swingAnimation() {
+    ozz::animation::offline::RawAnimation raw;
+    raw.duration = 1.f;
+    raw.tracks.resize(kJoints);
+    for (int i = 0; i < kJoints; i++) {
+        auto &track = raw.tracks[i];
+        track.translations.push_back({0.f, ozz::math::Float3(0.f, i == 0 ? 0.f : 0.1f, 0.f)});
+        for (int key = 0; key <= 4; key++) {
+            const float angle = 0.3f * std::sin(key * static_cast<float>(M_PI) / 2 + i * 0.1f);
+            track.rotations.push_back({key / 4.f, ozz::math::Quaternion::FromAxisAngle(ozz::math::Float3::z_axis(), angle)});
+        }
+    }
+    return ozz::animation::offline::AnimationBuilder()(raw);
+}
+
+void addPart(ozz::loader::Mesh &mesh, size_t vertexCount, int influences, std::mt19937 &random) {
+    std::uniform_real_distribution<float> coordinate(-0.2f, 0.2f);
+    std::uniform_int_distribution<int> joint(0, kJoints - 1);
+    ozz::loader::Mesh::Part part;
+    for (size_t i = 0; i < vertexCount; i++) {
+        const float height = 6.3f * i / vertexCount;
+        part.positions.insert(part.positions.end(), {coordinate(random), height, coordinate(random)});
+        part.normals.insert(part.normals.end(), {1.f, 0.f, 0.f});
+        part.tangents.insert(part.tangents.end(), {0.f, 0.f, 1.f, 1.f});
+        part.uvs.insert(part.uvs.end(), {0.5f, height});
+        float remaining = 1.f;
+        for (int k = 0; k < influences; k++) {
+            part.joint_indices.push_back(static_cast<uint16_t>(joint(random)));
+            if (k + 1 < influences) {
+                part.joint_weights.push_back(remaining * 0.5f);
+                remaining *= 0.5f;
+            }
+        }
+    }
+    mesh.parts.push_back(part);
+}
+
+ozz::loader::Mesh characterMesh(size_t vertexCount) {
+    std::mt19937 random(7);
+    ozz::loader::Mesh mesh;
+    addPart(mesh, vertexCount / 4, 1, random);
+    addPart(mesh, vertexCount - vertexCount / 4, 4, random);
+
+    // inverse of the model space rest pose
+    auto skeleton = chainSkeleton();
+    std::vector<ozz::math::Float4x4> models(kJoints);
+    ozz::animation::LocalToModelJob job;
+    job.skeleton = skeleton.get();
+    job.input = skeleton->joint_rest_poses();
+    job.output = ozz::make_span(models);
+    job.Run();
+    for (uint16_t i = 0; i < kJoints; i++) {
+        mesh.joint_remaps.push_back(i);
+        mesh.inverse_bind_poses.push_back(ozz::math::Invert(models[i]));
+    }
+    return mesh;
+}
+
+struct Character {
+    ozz::animation::SamplingJob::Context context;
+    std::vector<ozz::math::SoaTransform> locals;
+    std::vector<ozz::math::SoaTransform> blended;
+    std::vector<ozz::math::Float4x4> models;
+    std::vector<ozz::math::Float4x4> skinningMatrices;
+    ozz::animation::BlendingJob::Layer layer;
+    std::vector<float> vertices;
+    float ratio;
+};
+
+}
+
+TEST(Skinning, RestPoseKeepsPositions) {
+    const auto skeleton = chainSkeleton();
+    const auto mesh = characterMesh(1000);
+    std::vector<ozz::math::SoaTransform> blended(skeleton->num_soa_joints());
+    std::vector<ozz::math::Float4x4> models(skeleton->num_joints());
+    ASSERT_TRUE(Skinning::computeModels(*skeleton, {}, 0.1f, ozz::make_span(blended), ozz::make_span(models)));
+    std::vector<ozz::math::Float4x4> matrices;
+    Skinning::computeSkinningMatrices(mesh, ozz::make_span(models), matrices);
+
+    std::vector<float> vertices(mesh.vertex_count() * 9);
+    std::vector<float> uvs(mesh.vertex_count() * 2);
+    Skinning::fillStatic(mesh, vertices.data(), uvs.data());
+    std::vector<SkinningRange> ranges;
+    Skinning::split(mesh, ozz::make_span(matrices), vertices.data(), ranges, 100);
+    EXPECT_EQ(3u + 8u, ranges.size());
+    ASSERT_TRUE(Skinning::skin(ranges));
+
+    size_t vertex = 0;
+    for (const auto &part : mesh.parts) {
+        for (int i = 0; i < part.vertex_count(); i++, vertex++) {
+            for (int k = 0; k < 3; k++) {
+                EXPECT_NEAR(part.positions[i * 3 + k], vertices[vertex * 9 + k], 1e-4f);
+                EXPECT_NEAR(part.normals[i * 3 + k], vertices[vertex * 9 + 3 + k], 1e-4f);
+            }
+            EXPECT_EQ(part.uvs[i * 2 + 1], uvs[vertex * 2 + 1]);
+        }
+    }
+}
+
+TEST(Skinning, RangesMatchWholeParts) {
+    const auto skeleton = chainSkeleton();
+    const auto animation = swingAnimation();
+    const auto mesh = characterMesh(5000);
+
+    Character character;
+    character.context.Resize(skeleton->num_joints());
+    character.locals.resize(skeleton->num_soa_joints());
+    ozz::animation::SamplingJob sampling;
+    sampling.animation = animation.get();
+    sampling.context = &character.context;
+    sampling.ratio = 0.3f;
+    sampling.output = ozz::make_span(character.locals);
+    ASSERT_TRUE(sampling.Run());
+    ozz::animation::BlendingJob::Layer layer;
+    layer.transform = ozz::make_span(character.locals);
+    std::vector<ozz::math::SoaTransform> blended(skeleton->num_soa_joints());
+    std::vector<ozz::math::Float4x4> models(skeleton->num_joints());
+    ASSERT_TRUE(Skinning::computeModels(*skeleton, {&layer, 1}, 0.1f, ozz::make_span(blended), ozz::make_span(models)));
+    std::vector<ozz::math::Float4x4> matrices;
+    Skinning::computeSkinningMatrices(mesh, ozz::make_span(models), matrices);
+
+    std::vector<float> whole(mesh.vertex_count() * 9, 0.f);
+    std::vector<float> ranged(mesh.vertex_count() * 9, 0.f);
+    std::vector<SkinningRange> ranges;
+    Skinning::split(mesh, ozz::make_span(matrices), whole.data(), ranges, mesh.vertex_count());
+    ASSERT_EQ(mesh.parts.size(), ranges.size());
+    ASSERT_TRUE(Skinning::skin(ranges));
+    ranges.clear();
+    Skinning::split(mesh, ozz::make_span(matrices), ranged.data(), ranges, 64);
+    ThreadPool pool(3);
+    ASSERT_TRUE(Skinning::skin(ranges, pool));
+    for (size_t i = 0; i < whole.size(); i++) {
+        ASSERT_NEAR(whole[i], ranged[i], 1e-5f);
+    }
+}
+
+TEST(Skinning, DISABLED_Benchmark) {
+    constexpr size_t kCharacters = 500;
+    constexpr int kFrames = 10;
+    const auto skeleton = chainSkeleton();
+    const auto animation = swingAnimation();
+    const auto mesh = characterMesh(5000);
+
+    std::vector<Character> characters(kCharacters);
+    for (size_t i = 0; i < kCharacters; i++) {
+        auto &character = characters[i];
+        character.context.Resize(skeleton->num_joints());
+        character.locals.resize(skeleton->num_soa_joints());
+        character.blended.resize(skeleton->num_soa_joints());
+        character.models.resize(skeleton->num_joints());
+        character.layer.transform = ozz::make_span(character.locals);
+        character.vertices.resize(mesh.vertex_count() * 9);
+        character.ratio = static_cast<float>(i) / kCharacters;
+    }
+
+    // sample, blend and local to model of one character
+    const auto pose = [&](Character &character) {
+        character.ratio = std::fmod(character.ratio + 1.f / 60, 1.f);
+        ozz::animation::SamplingJob sampling;
+        sampling.animation = animation.get();
+        sampling.context = &character.context;
+        sampling.ratio = character.ratio;
+        sampling.output = ozz::make_span(character.locals);
+        sampling.Run();
+        Skinning::computeModels(*skeleton, {&character.layer, 1}, 0.1f,
+                                ozz::make_span(character.blended), ozz::make_span(character.models));
+        Skinning::computeSkinningMatrices(mesh, ozz::make_span(character.models), character.skinningMatrices);
+    };
+
+    const auto frame = [&](ThreadPool *pool, size_t verticesPerRange) {
+        std::vector<SkinningRange> ranges;
+        if (pool) {
+            pool->parallelFor(kCharacters, [&](size_t i) {
+                pose(characters[i]);
+            });
+        } else {
+            for (auto &character : characters) {
+                pose(character);
+            }
+        }
+        for (auto &character : characters) {
+            Skinning::split(mesh, ozz::make_span(character.skinningMatrices), character.vertices.data(), ranges, verticesPerRange);
+        }
+        if (pool) {
+            return Skinning::skin(ranges, *pool);
+        }
+        bool succeeded = true;
+        for (const auto &range : ranges) {
+            succeeded &= Skinning::skin(range);
+        }
+        return succeeded;
+    };
+
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < kFrames; i++) {
+        ASSERT_TRUE(frame(nullptr, mesh.vertex_count()));
+    }
+    const double serialTime = timer.stop<Timer::Milliseconds>() / kFrames;
+    const auto serialVertices = characters.back().vertices;
+
+    for (size_t i = 0; i < kCharacters; i++) {
+        characters[i].ratio = static_cast<float>(i) / kCharacters;
+    }
+    auto &pool = ThreadPool::shared();
+    timer.start();
+    for (int i = 0; i < kFrames; i++) {
+        ASSERT_TRUE(frame(&pool, Skinning::kVerticesPerRange));
+    }
+    const double parallelTime = timer.stop<Timer::Milliseconds>() / kFrames;
+
+    RecordProperty("serial_ms", std::to_string(serialTime));
+    RecordProperty("parallel_ms", std::to_string(parallelTime));
+    for (size_t i = 0; i < serialVertices.size(); i++) {
+        ASSERT_NEAR(serialVertices[i], characters.back().vertices[i], 1e-4f);
+    }
+}
@@ -0,0 +1,173 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "mesh/smooth_normals.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace vox;
+
+namespace {
+// (size + 1)^2 vertices in the xz plane, the faces look at +y, four floats per position as cloth particles
+void makeGrid(uint32_t size, std::vector<float> &positions, std::vector<uint32_t> &indices) {
+    const uint32_t row = size + 1;
+    positions.clear();
+    for (uint32_t j = 0; j < row; j++) {
+        for (uint32_t i = 0; i < row; i++) {
+            positions.insert(positions.end(), {float(i), 0, float(j), 1});
+        }
+    }
+    indices.clear();
+    for (uint32_t j = 0; j < size; j++) {
+        for (uint32_t i = 0; i < size; i++) {
+            const uint32_t v = j * row + i;
+            indices.insert(indices.end(), {v, v + 1, v + row, v + 1, v + row + 1, v + row});
+        }
+    }
+}
+
+void bend(std::vector<float> &positions) {
+    for (size_t i = 0; i < positions.size(); i += 4) {
+        positions[i + 1] = std::sin(positions[i] * 0.3f) * std::cos(positions[i + 2] * 0.2f) * 2;
+    }
+}
+
+// serial area weighted normals
+std::vector<float> referenceNormals(const std::vector<float> &positions, const std::vector<uint32_t> &indices) {
+    std::vector<float> normals(positions.size() / 4 * 3, 0);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const float *p0 = &positions[indices[i] * 4];
+        const float *p1 = &positions[indices[i + 1] * 4];
+        const float *p2 = &positions[indices[i + 2] * 4];
+        const float a[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        const float b[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        const float n[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+        for (size_t k = 0; k < 3; k++) {
+            for (size_t c = 0; c < 3; c++) {
+                normals[indices[i + k] * 3 + c] += n[c];
+            }
+        }
+    }
+    for (size_t i = 0; i < normals.size(); i += 3) {
+        const float length = std::sqrt(normals[i] * normals[i] + normals[i + 1] * normals[i + 1] +
+                                       normals[i + 2] * normals[i + 2]);
+        for (size_t c = 0; c < 3; c++) {
+            normals[i + c] /= length;
+        }
+    }
+    return normals;
+}
+
+}
+
+TEST(SmoothNormals, FlatGrid) {
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+    makeGrid(8, positions, indices);
+    SmoothNormals normals(indices, positions.size() / 4);
+    EXPECT_EQ(81u, normals.vertexCount());
+
+    std::vector<float> vertices(normals.vertexCount() * 6);
+    normals.update(positions.data(), sizeof(float) * 4, vertices.data());
+    for (size_t i = 0; i < normals.vertexCount(); i++) {
+        EXPECT_EQ(positions[i * 4], vertices[i * 6]);
+        EXPECT_EQ(positions[i * 4 + 2], vertices[i * 6 + 2]);
+        EXPECT_NEAR(0, vertices[i * 6 + 3], 1e-6);
+        EXPECT_NEAR(1, vertices[i * 6 + 4], 1e-6);
+        EXPECT_NEAR(0, vertices[i * 6 + 5], 1e-6);
+    }
+}
+
+TEST(SmoothNormals, MatchesSerial) {
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+    makeGrid(100, positions, indices);
+    bend(positions);
+    const auto expected = referenceNormals(positions, indices);
+
+    // several jobs of the pool
+    SmoothNormals normals(indices, positions.size() / 4);
+    std::vector<float> vertices(normals.vertexCount() * 6);
+    normals.update(positions.data(), sizeof(float) * 4, vertices.data());
+    for (size_t i = 0; i < normals.vertexCount(); i++) {
+        EXPECT_EQ(positions[i * 4 + 1], vertices[i * 6 + 1]);
+        for (size_t c = 0; c < 3; c++) {
+            ASSERT_NEAR(expected[i * 3 + c], vertices[i * 6 + 3 + c], 1e-5);
+        }
+    }
+}
+
+TEST(SmoothNormals, PackedPositions) {
+    std::vector<float> particles;
+    std::vector<uint32_t> indices;
+    makeGrid(4, particles, indices);
+    bend(particles);
+    std::vector<float> positions;
+    for (size_t i = 0; i < particles.size(); i += 4) {
+        positions.insert(positions.end(), {particles[i], particles[i + 1], particles[i + 2]});
+    }
+
+    SmoothNormals normals(indices, positions.size() / 3);
+    std::vector<float> packed(normals.vertexCount() * 6);
+    std::vector<float> strided(normals.vertexCount() * 6);
+    normals.update(positions.data(), sizeof(float) * 3, packed.data());
+    normals.update(particles.data(), sizeof(float) * 4, strided.data());
+    EXPECT_EQ(strided, packed);
+}
+
+TEST(SmoothNormals, DISABLED_Benchmark) {
+    // 256x256 quads of cloth
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+    makeGrid(256, positions, indices);
+    bend(positions);
+    const size_t vertexCount = positions.size() / 4;
+    std::vector<float> vertices(vertexCount * 6);
+    constexpr int kFrames = 20;
+
+    // the former ClothRenderer::update, serial with a normalized normal per face
+    Timer timer;
+    timer.start();
+    for (int frame = 0; frame < kFrames; frame++) {
+        for (size_t i = 0; i < vertexCount; i++) {
+            std::copy_n(&positions[i * 4], 3, &vertices[i * 6]);
+            std::fill_n(&vertices[i * 6 + 3], 3, 0.f);
+        }
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            const float *p0 = &vertices[indices[i] * 6];
+            const float *p1 = &vertices[indices[i + 1] * 6];
+            const float *p2 = &vertices[indices[i + 2] * 6];
+            const float a[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            const float b[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            float n[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+            const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (size_t k = 0; k < 3; k++) {
+                for (size_t c = 0; c < 3; c++) {
+                    vertices[indices[i + k] * 6 + 3 + c] += n[c] / length;
+                }
+            }
+        }
+        for (size_t i = 0; i < vertexCount; i++) {
+            float *n = &vertices[i * 6 + 3];
+            const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            n[0] /= length;
+            n[1] /= length;
+            n[2] /= length;
+        }
+    }
+    const double serialTime = timer.stop<Timer::Milliseconds>() / kFrames;
+
+    SmoothNormals normals(indices, vertexCount);
+    timer.start();
+    for (int frame = 0; frame < kFrames; frame++) {
+        normals.update(positions.data(), sizeof(float) * 4, vertices.data());
+    }
+    const double parallelTime = timer.stop<Timer::Milliseconds>() / kFrames;
+    RecordProperty("serial_ms", std::to_string(serialTime));
+    RecordProperty("adjacency_ms", std::to_string(parallelTime));
+}
@@ -0,0 +1,207 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "texture/texture_streamer.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+
+using namespace vox;
+
+namespace {
+// records the levels instead of uploading them
+class FakeBackend : public TextureStreamingBackend {
+public:
+    void upload(uint32_t texture, const Image &image, uint32_t firstLevel) override {
+        if (texture >= firstLevels.size()) {
+            firstLevels.resize(texture + 1);
+        }
+        firstLevels[texture] = firstLevel;
+        uploads++;
+    }
+
+    void trim(uint32_t texture, uint32_t firstLevel) override {
+        EXPECT_GT(firstLevel, firstLevels.at(texture));
+        firstLevels[texture] = firstLevel;
+        trims++;
+    }
+
+    std::vector<uint32_t> firstLevels;
+    uint32_t uploads = 0;
+    uint32_t trims = 0;
+};
+
+std::unique_ptr<Image> makeImage(uint32_t size) {
+    return std::make_unique<Image>(std::vector<uint8_t>(size_t(size) * size * 4, 128),
+                                   std::vector<Mipmap>{{0, 0, {size, size, 1}}});
+}
+
+TextureStreamer::Loader makeLoader(uint32_t size, std::atomic<uint32_t> *loads = nullptr) {
+    return [size, loads]() {
+        if (loads) {
+            (*loads)++;
+        }
+        return makeImage(size);
+    };
+}
+
+// bytes of the RGBA8 levels from firstLevel of a square texture
+size_t chainBytes(uint32_t size, uint32_t firstLevel) {
+    size_t bytes = 0;
+    for (uint32_t level = firstLevel; (size >> level) > 0; level++) {
+        bytes += size_t(size >> level) * (size >> level) * 4;
+    }
+    return bytes;
+}
+
+}
+
+TEST(TextureStreamer, AddUploadsSmallLevels) {
+    FakeBackend backend;
+    TextureStreamer streamer(backend, 1 << 30, false);
+    const auto texture = streamer.add(makeImage(256), makeLoader(256));
+
+    EXPECT_EQ(9u, streamer.levelCount(texture));
+    // 64x64 is the largest level kept from the start
+    EXPECT_EQ(2u, streamer.residentLevel(texture));
+    EXPECT_EQ(2u, backend.firstLevels.at(texture));
+    EXPECT_EQ(chainBytes(256, 2), streamer.statistics().residentBytes);
+
+    // a small texture is resident as a whole
+    EXPECT_EQ(0u, streamer.residentLevel(streamer.add(makeImage(32), makeLoader(32))));
+}
+
+TEST(TextureStreamer, RequiredLevel) {
+    FakeBackend backend;
+    TextureStreamer streamer(backend, 1 << 30, false);
+    const auto texture = streamer.add(makeImage(256), makeLoader(256));
+    EXPECT_EQ(0u, streamer.requiredLevel(texture, 1000));
+    EXPECT_EQ(0u, streamer.requiredLevel(texture, 256));
+    EXPECT_EQ(0u, streamer.requiredLevel(texture, 200));
+    EXPECT_EQ(1u, streamer.requiredLevel(texture, 100));
+    EXPECT_EQ(2u, streamer.requiredLevel(texture, 64));
+    EXPECT_EQ(8u, streamer.requiredLevel(texture, 1));
+}
+
+TEST(TextureStreamer, LoadsRequestedLevel) {
+    FakeBackend backend;
+    TextureStreamer streamer(backend, 1 << 30, false);
+    const auto texture = streamer.add(makeImage(256), makeLoader(256));
+
+    streamer.request(texture, 1);
+    streamer.request(texture, 3);
+    streamer.update();
+    EXPECT_EQ(1u, streamer.residentLevel(texture));
+    EXPECT_EQ(1u, backend.firstLevels[texture]);
+    EXPECT_EQ(chainBytes(256, 1), streamer.statistics().residentBytes);
+
+    // without pressure the levels stay after the texture is not requested anymore
+    streamer.update();
+    EXPECT_EQ(1u, streamer.residentLevel(texture));
+    EXPECT_EQ(0u, backend.trims);
+}
+
+TEST(TextureStreamer, InMemorySource) {
+    FakeBackend backend;
+    TextureStreamer streamer(backend, 1 << 30, false);
+    const auto texture = streamer.add(makeImage(128));
+    streamer.request(texture, 0);
+    streamer.update();
+    EXPECT_EQ(0u, streamer.residentLevel(texture));
+}
+
+TEST(TextureStreamer, EvictsLeastRecentlyUsed) {
+    FakeBackend backend;
+    // small levels of three textures and the whole chain of one
+    const size_t budget = 3 * chainBytes(256, 2) + chainBytes(256, 0) - chainBytes(256, 2);
+    TextureStreamer streamer(backend, budget, false);
+    const auto a = streamer.add(makeImage(256), makeLoader(256));
+    const auto b = streamer.add(makeImage(256), makeLoader(256));
+    const auto c = streamer.add(makeImage(256), makeLoader(256));
+
+    streamer.request(a, 0);
+    streamer.update();
+    EXPECT_EQ(0u, streamer.residentLevel(a));
+
+    streamer.request(c, 0);
+    streamer.update();
+    streamer.request(b, 0);
+    streamer.update();
+    // a was evicted for c, then c for b
+    EXPECT_EQ(2u, streamer.residentLevel(a));
+    EXPECT_EQ(2u, streamer.residentLevel(c));
+    EXPECT_EQ(0u, streamer.residentLevel(b));
+    EXPECT_EQ(2u, streamer.statistics().evictions);
+    EXPECT_LE(streamer.statistics().residentBytes, budget);
+
+    // both stay visible, the second one gets what is left of the budget
+    streamer.request(b, 0);
+    streamer.request(a, 0);
+    streamer.update();
+    EXPECT_EQ(0u, streamer.residentLevel(b));
+    EXPECT_EQ(2u, streamer.residentLevel(a));
+    EXPECT_EQ(1u, streamer.statistics().starved);
+    EXPECT_LE(streamer.statistics().residentBytes, budget);
+}
+
+TEST(TextureStreamer, ShrinkBudget) {
+    FakeBackend backend;
+    TextureStreamer streamer(backend, 1 << 30, false);
+    const auto texture = streamer.add(makeImage(256), makeLoader(256));
+    streamer.request(texture, 0);
+    streamer.update();
+
+    streamer.setBudget(chainBytes(256, 2));
+    streamer.update();
+    EXPECT_EQ(2u, streamer.residentLevel(texture));
+    EXPECT_EQ(2u, backend.firstLevels[texture]);
+    EXPECT_EQ(chainBytes(256, 2), streamer.statistics().residentBytes);
+}
+
+TEST(TextureStreamer, AsyncLoads) {
+    FakeBackend backend;
+    TextureStreamer streamer(backend, 1 << 30, true);
+    streamer.maxPendingLoads = 2;
+    std::atomic<uint32_t> loads{0};
+    std::vector<uint32_t> textures;
+    for (int i = 0; i < 3; i++) {
+        textures.push_back(streamer.add(makeImage(256), makeLoader(256, &loads)));
+    }
+
+    for (const auto texture : textures) {
+        streamer.request(texture, 0);
+    }
+    streamer.update();
+    EXPECT_EQ(2u, streamer.statistics().pendingLoads);
+    EXPECT_EQ(2 * (chainBytes(256, 0) - chainBytes(256, 2)), streamer.statistics().pendingBytes);
+
+    streamer.finishLoads();
+    EXPECT_EQ(0u, streamer.statistics().pendingLoads);
+    EXPECT_EQ(0u, streamer.statistics().pendingBytes);
+    for (const auto texture : textures) {
+        streamer.request(texture, 0);
+    }
+    streamer.update();
+    streamer.finishLoads();
+    for (const auto texture : textures) {
+        EXPECT_EQ(0u, streamer.residentLevel(texture));
+    }
+    EXPECT_EQ(3u, loads.load());
+}
+
+TEST(TextureStreamer, FailedLoadStopsStreaming) {
+    FakeBackend backend;
+    TextureStreamer streamer(backend, 1 << 30, false);
+    const auto texture = streamer.add(makeImage(256), []() {
+        return std::unique_ptr<Image>();
+    });
+    for (int frame = 0; frame < 3; frame++) {
+        streamer.request(texture, 0);
+        streamer.update();
+    }
+    EXPECT_EQ(2u, streamer.residentLevel(texture));
+    EXPECT_EQ(1u, backend.uploads);
+}
@@ -0,0 +1,87 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "thread_pool.h"
+
+#include <gtest/gtest.h>
+#include <numeric>
+#include <stdexcept>
+
+using namespace vox;
+
+TEST(ThreadPool, Enqueue) {
+    ThreadPool pool(3);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 32; i++) {
+        results.push_back(pool.enqueue([i]() {
+            return i * i;
+        }));
+    }
+    for (int i = 0; i < 32; i++) {
+        EXPECT_EQ(i * i, results[i].get());
+    }
+}
+
+TEST(ThreadPool, ParallelFor) {
+    ThreadPool pool(4);
+    std::vector<int> visits(10000, 0);
+    pool.parallelFor(visits.size(), [&](size_t i) {
+        visits[i]++;
+    });
+    EXPECT_EQ(static_cast<int>(visits.size()), std::accumulate(visits.begin(), visits.end(), 0));
+    for (auto visit : visits) {
+        EXPECT_EQ(1, visit);
+    }
+}
+
+TEST(ThreadPool, NestedParallelFor) {
+    // every worker is busy with an outer job, the inner loops must not wait for queued helpers
+    ThreadPool pool(2);
+    std::atomic<size_t> sum{0};
+    std::vector<std::future<void>> outer;
+    for (int i = 0; i < 4; i++) {
+        outer.push_back(pool.enqueue([&]() {
+            pool.parallelFor(100, [&](size_t j) {
+                sum += j;
+            });
+        }));
+    }
+    for (auto &future : outer) {
+        future.get();
+    }
+    EXPECT_EQ(4u * 4950u, sum.load());
+}
+
+TEST(ThreadPool, EnqueueException) {
+    ThreadPool pool(2);
+    auto failed = pool.enqueue([]() -> int {
+        throw std::runtime_error("job");
+    });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+    // the worker survived
+    EXPECT_EQ(3, pool.enqueue([]() {
+        return 3;
+    }).get());
+}
+
+TEST(ThreadPool, ParallelForException) {
+    ThreadPool pool(4);
+    std::atomic<size_t> calls{0};
+    EXPECT_THROW(pool.parallelFor(1000, [&](size_t i) {
+        calls++;
+        if (i == 10) {
+            throw std::runtime_error("index");
+        }
+    }), std::runtime_error);
+    EXPECT_LE(calls.load(), 1000u);
+
+    // every worker is still running jobs
+    std::vector<int> visits(1000, 0);
+    pool.parallelFor(visits.size(), [&](size_t i) {
+        visits[i]++;
+    });
+    EXPECT_EQ(1000, std::accumulate(visits.begin(), visits.end(), 0));
+}
@@ -0,0 +1,131 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "mesh/vertex_compression.h"
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace vox;
+using namespace vox::compression;
+
+namespace {
+Vector3F randomDirection(std::mt19937 &engine) {
+    std::normal_distribution<float> distribution;
+    Vector3F direction;
+    do {
+        direction = Vector3F(distribution(engine), distribution(engine), distribution(engine));
+    } while (direction.length() < 1e-3f);
+    return direction.normalized();
+}
+
+// atan2 in double, acos of a float dot product is only good to about 0.02 degree
+float angleDegree(const Vector3F &a, const Vector3F &b) {
+    const double cx = double(a.y) * b.z - double(a.z) * b.y;
+    const double cy = double(a.z) * b.x - double(a.x) * b.z;
+    const double cz = double(a.x) * b.y - double(a.y) * b.x;
+    const double dot = double(a.x) * b.x + double(a.y) * b.y + double(a.z) * b.z;
+    return static_cast<float>(std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot) * 180.0 / M_PI);
+}
+
+}
+
+TEST(VertexCompression, Normal) {
+    std::mt19937 engine(7);
+    float maxError = 0;
+    for (int i = 0; i < 100000; i++) {
+        const auto normal = randomDirection(engine);
+        int16_t encoded[2];
+        encodeNormal(normal, encoded);
+        maxError = std::max(maxError, angleDegree(normal, decodeNormal(encoded)));
+    }
+    EXPECT_LT(maxError, 0.01f);
+
+    // axes and the folded hemisphere edges
+    const Vector3F axes[] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+        Vector3F(1, 1, -1).normalized(), Vector3F(-1, 0, -1).normalized()};
+    for (const auto &axis : axes) {
+        int16_t encoded[2];
+        encodeNormal(axis, encoded);
+        EXPECT_LT(angleDegree(axis, decodeNormal(encoded)), 0.01f);
+    }
+}
+
+TEST(VertexCompression, Tangent) {
+    std::mt19937 engine(11);
+    float maxError = 0;
+    for (int i = 0; i < 100000; i++) {
+        const auto direction = randomDirection(engine);
+        const float sign = i % 2 ? 1.f : -1.f;
+        int16_t encoded[2];
+        encodeTangent(Vector4F(direction.x, direction.y, direction.z, sign), encoded);
+        const auto decoded = decodeTangent(encoded);
+        ASSERT_EQ(sign, decoded.w);
+        maxError = std::max(maxError, angleDegree(direction, Vector3F(decoded.x, decoded.y, decoded.z)));
+    }
+    // one bit less than normals
+    EXPECT_LT(maxError, 0.02f);
+}
+
+TEST(VertexCompression, Half) {
+    // exactly representable
+    for (float value : {0.f, -0.f, 1.f, -2.f, 0.5f, 65504.f, 6.103515625e-05f, 5.960464477539063e-08f}) {
+        EXPECT_EQ(value, decodeHalf(encodeHalf(value)));
+    }
+    EXPECT_EQ(0x3c00, encodeHalf(1.f));
+    EXPECT_EQ(0x7bff, encodeHalf(65504.f));
+    // rounds above the largest half
+    EXPECT_TRUE(std::isinf(decodeHalf(encodeHalf(65520.f))));
+    EXPECT_TRUE(std::isinf(decodeHalf(encodeHalf(std::numeric_limits<float>::infinity()))));
+    EXPECT_TRUE(std::isnan(decodeHalf(encodeHalf(std::numeric_limits<float>::quiet_NaN()))));
+    // ties round to even
+    EXPECT_EQ(0x3c00, encodeHalf(1.f + 1.f / 2048));
+    EXPECT_EQ(0x3c02, encodeHalf(1.f + 3.f / 2048));
+
+    std::mt19937 engine(3);
+    std::uniform_real_distribution<float> distribution(-4, 4);
+    for (int i = 0; i < 100000; i++) {
+        const float value = distribution(engine);
+        const float decoded = decodeHalf(encodeHalf(value));
+        // half has 11 bits of mantissa, normal values are off by half an ulp at most
+        EXPECT_LE(std::abs(decoded - value), std::max(std::abs(value), 6.103515625e-05f) / 2048.f);
+    }
+}
+
+TEST(VertexCompression, Normalized) {
+    for (int i = 0; i <= 255; i++) {
+        EXPECT_EQ(i, encodeUnorm8(decodeUnorm8(static_cast<uint8_t>(i))));
+    }
+    EXPECT_EQ(255, encodeUnorm8(2));
+    EXPECT_EQ(0, encodeUnorm8(-1));
+    EXPECT_EQ(65535, encodeUnorm16(1));
+    EXPECT_NEAR(0.3f, decodeUnorm16(encodeUnorm16(0.3f)), 0.5f / 65535);
+    EXPECT_EQ(32767, encodeSnorm16(1));
+    EXPECT_EQ(-32767, encodeSnorm16(-1));
+    EXPECT_EQ(-1, decodeSnorm16(-32768));
+    EXPECT_NEAR(-0.7f, decodeSnorm16(encodeSnorm16(-0.7f)), 0.5f / 32767);
+}
+
+TEST(VertexCompression, Position) {
+    const BoundingBox3F bounds(Point3F(-10, 0, 5), Point3F(30, 2, 5));
+    const auto quantization = positionQuantization(bounds);
+    // flat axis keeps a finite scale
+    EXPECT_EQ(1, quantization.scale[2]);
+
+    std::mt19937 engine(5);
+    std::uniform_real_distribution<float> x(-10, 30), y(0, 2);
+    for (int i = 0; i < 10000; i++) {
+        const Vector3F position(x(engine), y(engine), 5);
+        uint16_t encoded[4];
+        encodePosition(position, quantization, encoded);
+        const auto decoded = decodePosition(encoded, quantization);
+        EXPECT_LE(std::abs(decoded.x - position.x), 40.f / 65535 * 0.501f);
+        EXPECT_LE(std::abs(decoded.y - position.y), 2.f / 65535 * 0.501f);
+        EXPECT_EQ(5, decoded.z);
+    }
+}
@@ -8,7 +8,8 @@
 
 namespace vox {
 
-SphericalHarmonics3::SphericalHarmonics3() {
+SphericalHarmonics3::SphericalHarmonics3() :
+_coefficients{} {
 }
 
 SphericalHarmonics3::SphericalHarmonics3(std::array<float, 27> coefficients) :
@@ -0,0 +1,22 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "animation_lod.h"
+
+namespace vox {
+uint32_t AnimationLod::interval(float screenRelativeHeight) const {
+    if (!enabled || levels.empty()) {
+        return 1;
+    }
+    for (const auto &level : levels) {
+        if (screenRelativeHeight >= level.screenRelativeHeight) {
+            return level.interval;
+        }
+    }
+    return levels.back().interval;
+}
+
+}
@@ -0,0 +1,59 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef animation_lod_hpp
+#define animation_lod_hpp
+
+#include <cstdint>
+#include <vector>
+
+namespace vox {
+/**
+ * Characters handled by the animation stage in the last frame.
+ */
+struct AnimationLodStatistics {
+    /** Sampled this frame. */
+    uint32_t updated{0};
+    /** Visible but waiting for their reduced rate frame. */
+    uint32_t throttled{0};
+    /** Outside of every camera. */
+    uint32_t skipped{0};
+};
+
+/**
+ * Update rate of animators by the screen size of their SkinnedMeshRenderer.
+ * @remarks Throttled and skipped animators keep the elapsed time and catch up on their next update,
+ * an animator coming back into view updates right away.
+ */
+class AnimationLod {
+public:
+    struct Level {
+        /** Smallest height of the bounds, as a fraction of the screen height, which uses this level. */
+        float screenRelativeHeight;
+        /** Sample every interval frames. */
+        uint32_t interval;
+    };
+
+    /** When false every animator samples every frame and culled characters are still skinned. */
+    bool enabled = true;
+
+    /** From the full rate level, with decreasing screenRelativeHeight. Smaller characters use the last level. */
+    std::vector<Level> levels = {{0.3f, 1}, {0.1f, 2}, {0.03f, 4}, {0.f, 8}};
+
+    uint32_t interval(float screenRelativeHeight) const;
+
+    /**
+     * Whether an animator updates in this frame.
+     * @param phase - Offset of the animator, consecutive phases spread animators of the same interval over the frames
+     */
+    static bool isDue(uint64_t frame, uint32_t interval, uint32_t phase) {
+        return interval <= 1 || (frame + phase) % interval == 0;
+    }
+};
+
+}
+
+#endif /* animation_lod_hpp */
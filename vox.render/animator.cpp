@@ -83,6 +83,10 @@ ozz::span<ozz::animation::BlendingJob::Layer> Animator::layers() {
     return make_span(_layers);
 }
 
+float Animator::pendingDeltaTime() const {
+    return _pendingDeltaTime;
+}
+
 void Animator::_onEnable() {
     scene()->_componentsManager.addOnUpdateAnimators(this);
 }
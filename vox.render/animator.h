@@ -54,6 +54,11 @@ public:
     
     ozz::span<ozz::animation::BlendingJob::Layer> layers();
     
+    /**
+     * Elapsed time held back by the animation level of detail, it is sampled on the next update.
+     */
+    float pendingDeltaTime() const;
+    
 private:
     void _onEnable() override;
     
@@ -63,6 +68,11 @@ private:
     friend class ComponentsManager;
     
     ssize_t _onUpdateIndex = -1;
+    // animation level of detail, see AnimationLod
+    uint32_t _lodPhase = 0;
+    float _pendingDeltaTime = 0;
+    bool _sampled = false;
+    bool _culled = false;
     ozz::vector<ozz::unique_ptr<AnimationClip>> _clips;
     ozz::vector<ozz::animation::BlendingJob::Layer> _layers;
 };
@@ -0,0 +1,104 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef component_registry_hpp
+#define component_registry_hpp
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <sys/types.h>
+
+namespace vox {
+/**
+ * Dense array of components, the position of every element is stored in the element itself.
+ * @remarks Removal swaps the last element into the empty position, so it is O(1) and the order is not kept.
+ * Removal between beginIteration and endIteration leaves a nullptr, the array is compacted by the last endIteration.
+ */
+template<class T>
+class ComponentRegistry {
+public:
+    /**
+     * @param index - Member of T which holds the position, -1 when it is not registered
+     */
+    explicit ComponentRegistry(ssize_t T::*index) :
+    _index(index) {
+    }
+
+    void add(T *element) {
+        element->*_index = static_cast<ssize_t>(_elements.size());
+        _elements.push_back(element);
+    }
+
+    void remove(T *element) {
+        const auto position = static_cast<size_t>(element->*_index);
+        element->*_index = -1;
+        if (_iterationDepth > 0) {
+            // moving the last element now would make the running loop skip it
+            _elements[position] = nullptr;
+            _holes.push_back(position);
+        } else {
+            _swapRemove(position);
+        }
+    }
+
+    /**
+     * Remove every element, the index of elements is not reset.
+     */
+    void clear() {
+        _elements.clear();
+        _holes.clear();
+    }
+
+    size_t size() const {
+        return _elements.size();
+    }
+
+    /**
+     * Element at position, nullptr if it was removed during the iteration.
+     */
+    T *operator[](size_t position) const {
+        return _elements[position];
+    }
+
+    void beginIteration() {
+        _iterationDepth++;
+    }
+
+    void endIteration() {
+        _iterationDepth--;
+        if (_iterationDepth == 0 && !_holes.empty()) {
+            // from the back, so the last element is never a hole when it is moved
+            std::sort(_holes.begin(), _holes.end(), std::greater<size_t>());
+            for (auto position : _holes) {
+                if (position < _elements.size()) {
+                    _swapRemove(position);
+                }
+            }
+            _holes.clear();
+        }
+    }
+
+private:
+    void _swapRemove(size_t position) {
+        auto last = _elements.back();
+        _elements.pop_back();
+        if (position < _elements.size()) {
+            _elements[position] = last;
+            last->*_index = static_cast<ssize_t>(position);
+        }
+    }
+
+    ssize_t T::*_index;
+    std::vector<T *> _elements{};
+    std::vector<size_t> _holes{};
+    uint32_t _iterationDepth{0};
+};
+
+}
+
+#endif /* component_registry_hpp */
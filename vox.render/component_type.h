@@ -0,0 +1,98 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef component_type_hpp
+#define component_type_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace vox {
+using ComponentTypeId = uint32_t;
+
+namespace detail {
+inline ComponentTypeId nextComponentTypeId() {
+    static std::atomic<ComponentTypeId> counter{0};
+    return counter++;
+}
+}
+
+/**
+ * Dense id of component type, assigned once per type without RTTI.
+ */
+template<class T>
+ComponentTypeId componentTypeId() {
+    static const ComponentTypeId id = detail::nextComponentTypeId();
+    return id;
+}
+
+/**
+ * Per entity result of "components which are a T", indexed by componentTypeId.
+ * @remarks The first query of a type scans the components, later ones are O(1) until invalidate.
+ */
+class ComponentTypeCache {
+public:
+    /**
+     * First component which is a T.
+     */
+    template<class T, class Container>
+    T *find(const Container &components) {
+        const auto &matches = _entry<T>(components).components;
+        return matches.empty() ? nullptr : static_cast<T *>(matches.front());
+    }
+
+    /**
+     * Append every component which is a T, in the order of the components.
+     */
+    template<class T, class Container>
+    void findAll(const Container &components, std::vector<T *> &results) {
+        for (auto match : _entry<T>(components).components) {
+            results.push_back(static_cast<T *>(match));
+        }
+    }
+
+    /**
+     * Must be called when a component is added or removed.
+     */
+    void invalidate() {
+        for (auto &entry : _entries) {
+            entry.cached = false;
+        }
+    }
+
+private:
+    struct Entry {
+        std::vector<void *> components{};
+        bool cached{false};
+    };
+
+    template<class T, class Container>
+    Entry &_entry(const Container &components) {
+        const auto id = componentTypeId<T>();
+        if (id >= _entries.size()) {
+            _entries.resize(id + 1);
+        }
+        auto &entry = _entries[id];
+        if (!entry.cached) {
+            entry.components.clear();
+            for (const auto &component : components) {
+                T *match = dynamic_cast<T *>(component.get());
+                if (match) {
+                    entry.components.push_back(match);
+                }
+            }
+            entry.cached = true;
+        }
+        return entry;
+    }
+
+    std::vector<Entry> _entries{};
+};
+
+}
+
+#endif /* component_type_hpp */
@@ -11,26 +11,39 @@
 #include "camera.h"
 #include "animator.h"
 #include "scene_animator.h"
+#include "mesh/lod_group.h"
+#include "mesh/skinned_mesh_renderer.h"
+#include "material/material.h"
+#include "texture/sampled_texture_streamer.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <limits>
 
 namespace vox {
+ComponentsManager::ComponentsManager() :
+_onStartScripts(&Script::_onStartIndex),
+_onUpdateScripts(&Script::_onUpdateIndex),
+_renderers(&Renderer::_rendererIndex),
+_onUpdateAnimators(&Animator::_onUpdateIndex),
+_onUpdateSceneAnimators(&SceneAnimator::_onUpdateIndex),
+_onUpdateSkinnedMeshRenderers(&SkinnedMeshRenderer::_onUpdateIndex) {
+}
+
+//MARK: - Script
 void ComponentsManager::addOnStartScript(Script *script) {
-    script->_onStartIndex = _onStartScripts.size();
-    _onStartScripts.push_back(script);
+    _onStartScripts.add(script);
 }
 
 void ComponentsManager::removeOnStartScript(Script *script) {
-    _onStartScripts.erase(_onStartScripts.begin() + script->_onStartIndex);
-    script->_onStartIndex = -1;
+    _onStartScripts.remove(script);
 }
 
 void ComponentsManager::addOnUpdateScript(Script *script) {
-    script->_onUpdateIndex = _onUpdateScripts.size();
-    _onUpdateScripts.push_back(script);
+    _onUpdateScripts.add(script);
 }
 
 void ComponentsManager::removeOnUpdateScript(Script *script) {
-    _onUpdateScripts.erase(_onUpdateScripts.begin() + script->_onUpdateIndex);
-    script->_onUpdateIndex = -1;
+    _onUpdateScripts.remove(script);
 }
 
 void ComponentsManager::addDestroyComponent(Script *component) {
@@ -47,78 +60,104 @@ void ComponentsManager::callComponentDestroy() {
 }
 
 void ComponentsManager::callScriptOnStart() {
-    if (_onStartScripts.size() > 0) {
+    auto &elements = _onStartScripts;
+    if (elements.size() > 0) {
+        elements.beginIteration();
         // The 'onStartScripts.length' maybe add if you add some Script with addComponent() in some Script's onStart()
-        for (size_t i = 0; i < _onStartScripts.size(); i++) {
-            const auto &script = _onStartScripts[i];
+        for (size_t i = 0; i < elements.size(); i++) {
+            const auto script = elements[i];
+            if (script == nullptr) {
+                continue;
+            }
             script->_started = true;
             script->_onStartIndex = -1;
             script->onStart();
         }
-        _onStartScripts.clear();
+        elements.clear();
+        elements.endIteration();
     }
 }
 
 void ComponentsManager::callScriptOnUpdate(float deltaTime) {
-    for (size_t i = 0; i < _onUpdateScripts.size(); i++) {
-        const auto &element = _onUpdateScripts[i];
-        if (element->_started) {
+    auto &elements = _onUpdateScripts;
+    elements.beginIteration();
+    for (size_t i = 0; i < elements.size(); i++) {
+        const auto element = elements[i];
+        if (element != nullptr && element->_started) {
             element->onUpdate(deltaTime);
         }
     }
+    elements.endIteration();
 }
 
 void ComponentsManager::callScriptOnLateUpdate(float deltaTime) {
-    for (size_t i = 0; i < _onUpdateScripts.size(); i++) {
-        const auto &element = _onUpdateScripts[i];
-        if (element->_started) {
+    auto &elements = _onUpdateScripts;
+    elements.beginIteration();
+    for (size_t i = 0; i < elements.size(); i++) {
+        const auto element = elements[i];
+        if (element != nullptr && element->_started) {
             element->onLateUpdate(deltaTime);
         }
     }
+    elements.endIteration();
 }
 
 void ComponentsManager::callScriptInputEvent(const InputEvent &inputEvent) {
-    for (size_t i = 0; i < _onUpdateScripts.size(); i++) {
-        const auto &element = _onUpdateScripts[i];
-        if (element->_started) {
+    auto &elements = _onUpdateScripts;
+    elements.beginIteration();
+    for (size_t i = 0; i < elements.size(); i++) {
+        const auto element = elements[i];
+        if (element != nullptr && element->_started) {
             element->inputEvent(inputEvent);
         }
     }
+    elements.endIteration();
 }
 
 void ComponentsManager::callScriptResize(uint32_t win_width, uint32_t win_height,
                                          uint32_t fb_width, uint32_t fb_height) {
-    for (size_t i = 0; i < _onUpdateScripts.size(); i++) {
-        const auto &element = _onUpdateScripts[i];
-        if (element->_started) {
+    auto &elements = _onUpdateScripts;
+    elements.beginIteration();
+    for (size_t i = 0; i < elements.size(); i++) {
+        const auto element = elements[i];
+        if (element != nullptr && element->_started) {
             element->resize(win_width, win_height, fb_width, fb_height);
         }
     }
+    elements.endIteration();
 }
 
 //MARK: -
 void ComponentsManager::addRenderer(Renderer *renderer) {
-    renderer->_rendererIndex = _renderers.size();
-    _renderers.push_back(renderer);
+    _renderers.add(renderer);
 }
 
 void ComponentsManager::removeRenderer(Renderer *renderer) {
-    _renderers.erase(_renderers.begin() + renderer->_rendererIndex);
-    renderer->_rendererIndex = -1;
+    _renderers.remove(renderer);
 }
 
 void ComponentsManager::callRendererOnUpdate(float deltaTime) {
-    for (size_t i = 0; i < _renderers.size(); i++) {
-        _renderers[i]->update(deltaTime);
+    auto &elements = _renderers;
+    elements.beginIteration();
+    for (size_t i = 0; i < elements.size(); i++) {
+        if (elements[i] != nullptr) {
+            elements[i]->update(deltaTime);
+        }
     }
+    elements.endIteration();
 }
 
 void ComponentsManager::callRender(Camera *camera,
                                    std::vector<RenderElement> &opaqueQueue,
                                    std::vector<RenderElement> &alphaTestQueue,
                                    std::vector<RenderElement> &transparentQueue) {
-    for (size_t i = 0; i < _renderers.size(); i++) {
-        const auto &element = _renderers[i];
+    auto &elements = _renderers;
+    elements.beginIteration();
+    for (size_t i = 0; i < elements.size(); i++) {
+        const auto element = elements[i];
+        if (element == nullptr) {
+            continue;
+        }
         
         // filter by camera culling mask.
         if (!(camera->cullingMask & element->_entity->layer)) {
@@ -143,45 +182,60 @@ void ComponentsManager::callRender(Camera *camera,
         } else {
             element->setDistanceForSort(center.distanceSquaredTo(position));
         }
+        
+        // pick the level of detail, renderers smaller than the last level are skipped
+        if (!_updateLod(element, camera)) {
+            continue;
+        }
                 
         element->_render(opaqueQueue, alphaTestQueue, transparentQueue);
     }
+    elements.endIteration();
 }
 
-void ComponentsManager::callRender(const BoundingFrustum &frustrum,
+void ComponentsManager::callRender(const BoundingFrustum &frustrum, const Camera *camera,
                                    std::vector<RenderElement> &opaqueQueue,
                                    std::vector<RenderElement> &alphaTestQueue,
                                    std::vector<RenderElement> &transparentQueue) {
-    for (size_t i = 0; i < _renderers.size(); i++) {
-        const auto &renderer = _renderers[i];
+    auto &elements = _renderers;
+    elements.beginIteration();
+    for (size_t i = 0; i < elements.size(); i++) {
+        const auto renderer = elements[i];
         // filter by renderer castShadow and frustrum cull
-        if (frustrum.intersectsBox(renderer->bounds())) {
+        if (renderer != nullptr && frustrum.intersectsBox(renderer->bounds()) && _updateLod(renderer, camera)) {
             renderer->_render(opaqueQueue, alphaTestQueue, transparentQueue);
         }
     }
+    elements.endIteration();
+}
+
+bool ComponentsManager::_updateLod(Renderer *renderer, const Camera *camera) {
+    // looked up every time, so the group may be added before the renderer or outlive it
+    auto lodGroup = renderer->entity()->getComponent<LODGroup>();
+    if (lodGroup == nullptr || !lodGroup->enabled()) {
+        return true;
+    }
+    return lodGroup->_update(renderer, camera);
 }
 
 //MARK: - 
 void ComponentsManager::callCameraOnBeginRender(Camera *camera) {
-    const auto &camComps = camera->entity()->_components;
-    for (size_t i = 0; i < camComps.size(); i++) {
-        const auto &camComp = camComps[i].get();
-        auto pointer = dynamic_cast<Script *>(camComp);
-        if (pointer != nullptr) {
-            pointer->onBeginRender(camera);
-        }
+    // snapshot, a callback may enable or disable scripts of the camera
+    auto &scripts = _cameraScripts;
+    scripts = camera->entity()->_scripts;
+    for (auto script : scripts) {
+        script->onBeginRender(camera);
     }
+    scripts.clear();
 }
 
 void ComponentsManager::callCameraOnEndRender(Camera *camera) {
-    const auto &camComps = camera->entity()->_components;
-    for (size_t i = 0; i < camComps.size(); i++) {
-        const auto &camComp = camComps[i].get();
-        auto pointer = dynamic_cast<Script *>(camComp);
-        if (pointer != nullptr) {
-            pointer->onEndRender(camera);
-        }
+    auto &scripts = _cameraScripts;
+    scripts = camera->entity()->_scripts;
+    for (auto script : scripts) {
+        script->onEndRender(camera);
     }
+    scripts.clear();
 }
 
 std::vector<Component *> ComponentsManager::getActiveChangedTempList() {
@@ -195,37 +249,185 @@ void ComponentsManager::putActiveChangedTempList(std::vector<Component *> &compo
 
 //MARK: -
 void ComponentsManager::addOnUpdateAnimators(Animator *animator) {
-    animator->_onUpdateIndex = _onUpdateAnimators.size();
-    _onUpdateAnimators.push_back(animator);
+    // consecutive phases spread the reduced rate animators evenly over the frames
+    animator->_lodPhase = _nextAnimatorPhase++;
+    _onUpdateAnimators.add(animator);
 }
 
 void ComponentsManager::removeOnUpdateAnimators(Animator *animator) {
-    _onUpdateAnimators.erase(_onUpdateAnimators.begin() + animator->_onUpdateIndex);
-    animator->_onUpdateIndex = -1;
+    _onUpdateAnimators.remove(animator);
 }
 
-void ComponentsManager::callAnimatorUpdate(float deltaTime) {
-    const auto &elements = _onUpdateAnimators;
-    for (size_t i = 0; i < _onUpdateAnimators.size(); i++) {
-        elements[i]->update(deltaTime);
+void ComponentsManager::callAnimatorUpdate(float deltaTime, const std::vector<Camera *> &cameras) {
+    auto &statistics = _animationLodStatistics;
+    statistics = AnimationLodStatistics();
+    _animationFrame++;
+    
+    auto &elements = _onUpdateAnimators;
+    elements.beginIteration();
+    _sampledAnimators.clear();
+    for (size_t i = 0; i < elements.size(); i++) {
+        const auto animator = elements[i];
+        if (animator == nullptr) {
+            continue;
+        }
+        animator->_sampled = false;
+        animator->_pendingDeltaTime += deltaTime;
+        
+        uint32_t interval = 1;
+        if (_animationLod.enabled) {
+            const auto renderer = animator->entity()->getComponent<SkinnedMeshRenderer>();
+            if (renderer != nullptr) {
+                const float height = _animationScreenHeight(renderer, cameras);
+                if (height < 0) {
+                    animator->_culled = true;
+                    statistics.skipped++;
+                    continue;
+                }
+                interval = _animationLod.interval(height);
+            }
+        }
+        // back in view, catch up right away
+        if (!animator->_culled && !AnimationLod::isDue(_animationFrame, interval, animator->_lodPhase)) {
+            statistics.throttled++;
+            continue;
+        }
+        animator->_culled = false;
+        animator->_sampled = true;
+        statistics.updated++;
+        _sampledAnimators.push_back(animator);
     }
+    
+    // animators only touch their own clips, each one samples as a job
+    ThreadPool::shared().parallelFor(_sampledAnimators.size(), [&](size_t i) {
+        const auto animator = _sampledAnimators[i];
+        animator->update(animator->_pendingDeltaTime);
+        animator->_pendingDeltaTime = 0;
+    });
+    elements.endIteration();
+}
+
+AnimationLod &ComponentsManager::animationLod() {
+    return _animationLod;
+}
+
+const AnimationLodStatistics &ComponentsManager::animationLodStatistics() const {
+    return _animationLodStatistics;
+}
+
+void ComponentsManager::callTextureStreamingRequest(SampledTextureStreamer &streamer, const std::vector<Camera *> &cameras) {
+    auto &elements = _renderers;
+    elements.beginIteration();
+    for (size_t i = 0; i < elements.size(); i++) {
+        const auto renderer = elements[i];
+        if (renderer == nullptr) {
+            continue;
+        }
+        float screenPixels = 0;
+        const auto bounds = renderer->bounds();
+        for (const auto camera : cameras) {
+            if (!(camera->cullingMask & renderer->_entity->layer)) {
+                continue;
+            }
+            if (camera->enableFrustumCulling && !camera->_frustum.intersectsBox(bounds)) {
+                continue;
+            }
+            screenPixels = std::max(screenPixels, LODGroup::screenRelativeHeight(camera, bounds) * camera->framebufferHeight());
+        }
+        if (screenPixels <= 0) {
+            continue;
+        }
+        for (const auto &material : renderer->getMaterials()) {
+            if (material) {
+                material->shaderData.forEachSampledTexture([&](const SampledTexturePtr &texture) {
+                    streamer.request(texture.get(), screenPixels);
+                });
+            }
+        }
+    }
+    elements.endIteration();
+}
+
+float ComponentsManager::_animationScreenHeight(Renderer *renderer, const std::vector<Camera *> &cameras) {
+    const auto bounds = renderer->bounds();
+    if (cameras.empty()) {
+        return std::numeric_limits<float>::max();
+    }
+    float height = -1;
+    for (const auto camera : cameras) {
+        if (!(camera->cullingMask & renderer->_entity->layer)) {
+            continue;
+        }
+        if (camera->enableFrustumCulling && !camera->_frustum.intersectsBox(bounds)) {
+            continue;
+        }
+        height = std::max(height, LODGroup::screenRelativeHeight(camera, bounds));
+    }
+    return height;
 }
 
 void ComponentsManager::addOnUpdateSceneAnimators(SceneAnimator *animator) {
-    animator->_onUpdateIndex = _onUpdateSceneAnimators.size();
-    _onUpdateSceneAnimators.push_back(animator);
+    _onUpdateSceneAnimators.add(animator);
 }
 
 void ComponentsManager::removeOnUpdateSceneAnimators(SceneAnimator *animator) {
-    _onUpdateSceneAnimators.erase(_onUpdateSceneAnimators.begin() + animator->_onUpdateIndex);
-    animator->_onUpdateIndex = -1;
+    _onUpdateSceneAnimators.remove(animator);
 }
 
 void ComponentsManager::callSceneAnimatorUpdate(float deltaTime) {
-    const auto &elements = _onUpdateSceneAnimators;
-    for (size_t i = 0; i < _onUpdateSceneAnimators.size(); i++) {
-        elements[i]->update(deltaTime);
+    auto &elements = _onUpdateSceneAnimators;
+    elements.beginIteration();
+    for (size_t i = 0; i < elements.size(); i++) {
+        if (elements[i] != nullptr) {
+            elements[i]->update(deltaTime);
+        }
+    }
+    elements.endIteration();
+}
+
+void ComponentsManager::addOnUpdateSkinnedMeshRenderer(SkinnedMeshRenderer *renderer) {
+    _onUpdateSkinnedMeshRenderers.add(renderer);
+}
+
+void ComponentsManager::removeOnUpdateSkinnedMeshRenderer(SkinnedMeshRenderer *renderer) {
+    _onUpdateSkinnedMeshRenderers.remove(renderer);
+}
+
+void ComponentsManager::callSkinnedMeshRendererUpdate(const std::vector<Camera *> &cameras) {
+    auto &elements = _onUpdateSkinnedMeshRenderers;
+    elements.beginIteration();
+    _posedRenderers.clear();
+    for (size_t i = 0; i < elements.size(); i++) {
+        const auto renderer = elements[i];
+        if (renderer == nullptr) {
+            continue;
+        }
+        if (renderer->_animator == nullptr) {
+            renderer->_animator = renderer->entity()->getComponent<Animator>();
+        }
+        if (renderer->_animator != nullptr && renderer->_animator->_sampled) {
+            renderer->_poseDirty = true;
+        }
+        // culled renderers stay dirty and are skinned once they are visible again
+        if (!renderer->_poseDirty ||
+            (_animationLod.enabled && _animationScreenHeight(renderer, cameras) < 0)) {
+            continue;
+        }
+        renderer->_poseDirty = false;
+        _posedRenderers.push_back(renderer);
+    }
+    
+    ThreadPool::shared().parallelFor(_posedRenderers.size(), [&](size_t i) {
+        _posedRenderers[i]->_updatePose();
+    });
+    
+    // vertex ranges of all characters share the workers, big meshes don't serialize the stage
+    std::vector<SkinningRange> ranges;
+    for (const auto renderer : _posedRenderers) {
+        renderer->_appendSkinningRanges(ranges);
     }
+    elements.endIteration();
+    Skinning::skin(ranges);
 }
 
 }        // namespace vox
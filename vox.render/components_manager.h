@@ -12,16 +12,24 @@
 #include "input_events.h"
 #include "scene_forward.h"
 #include "rendering/render_element.h"
+#include "component_registry.h"
+#include "animation_lod.h"
 #include <typeindex>
 #include <unordered_map>
 #include <vector>
 
 namespace vox {
+class SampledTextureStreamer;
+
 /**
  * The manager of the components.
+ * @remarks Registered components are kept in ComponentRegistry, so registration and removal are O(1)
+ * and a component can be removed while the manager is calling them.
  */
 class ComponentsManager {
 public:
+    ComponentsManager();
+    
     void addOnStartScript(Script *script);
     
     void removeOnStartScript(Script *script);
@@ -57,7 +65,11 @@ public:
                     std::vector<RenderElement> &alphaTestQueue,
                     std::vector<RenderElement> &transparentQueue);
     
-    void callRender(const BoundingFrustum &frustrum,
+    /**
+     * Collect the renderers inside the frustum.
+     * @param camera - Camera picking the level of detail, so the meshes match the ones it draws
+     */
+    void callRender(const BoundingFrustum &frustrum, const Camera *camera,
                     std::vector<RenderElement> &opaqueQueue,
                     std::vector<RenderElement> &alphaTestQueue,
                     std::vector<RenderElement> &transparentQueue);
@@ -67,7 +79,11 @@ public:
     
     void removeOnUpdateAnimators(Animator *animator);
     
-    void callAnimatorUpdate(float deltaTime);
+    /**
+     * Sample the animators due in this frame, see animationLod.
+     * @param cameras - Cameras of the last frame, they decide the visibility and screen size of characters
+     */
+    void callAnimatorUpdate(float deltaTime, const std::vector<Camera *> &cameras);
     
     void addOnUpdateSceneAnimators(SceneAnimator *animator);
     
@@ -75,6 +91,29 @@ public:
     
     void callSceneAnimatorUpdate(float deltaTime);
     
+    void addOnUpdateSkinnedMeshRenderer(SkinnedMeshRenderer *renderer);
+    
+    void removeOnUpdateSkinnedMeshRenderer(SkinnedMeshRenderer *renderer);
+    
+    /**
+     * Skinning stage, blends every character as a job then skins vertex ranges on the workers.
+     * @remarks Runs after the animators were sampled, only visible renderers whose animator sampled are skinned.
+     */
+    void callSkinnedMeshRendererUpdate(const std::vector<Camera *> &cameras);
+    
+    AnimationLod &animationLod();
+    
+    /**
+     * Counters of the last callAnimatorUpdate.
+     */
+    const AnimationLodStatistics &animationLodStatistics() const;
+    
+    /**
+     * Request the texture levels of the materials of visible renderers from their screen size.
+     * @remarks Assumes the textures of a material cover the renderer once.
+     */
+    void callTextureStreamingRequest(SampledTextureStreamer &streamer, const std::vector<Camera *> &cameras);
+    
 public:
     void callCameraOnBeginRender(Camera *camera);
     
@@ -86,19 +125,40 @@ public:
     
 private:
     // Script
-    std::vector<Script *> _onStartScripts;
-    std::vector<Script *> _onUpdateScripts;
+    ComponentRegistry<Script> _onStartScripts;
+    ComponentRegistry<Script> _onUpdateScripts;
     std::vector<Script *> _destroyComponents;
+    std::vector<Script *> _cameraScripts;
     
     // Render
-    std::vector<Renderer *> _renderers;
+    ComponentRegistry<Renderer> _renderers;
     
     // Delay dispose active/inActive Pool
     std::vector<std::vector<Component *>> _componentsContainerPool;
     
     // Animatior
-    std::vector<Animator *> _onUpdateAnimators;
-    std::vector<SceneAnimator *> _onUpdateSceneAnimators;
+    ComponentRegistry<Animator> _onUpdateAnimators;
+    ComponentRegistry<SceneAnimator> _onUpdateSceneAnimators;
+    ComponentRegistry<SkinnedMeshRenderer> _onUpdateSkinnedMeshRenderers;
+    std::vector<Animator *> _sampledAnimators;
+    std::vector<SkinnedMeshRenderer *> _posedRenderers;
+    
+    // Animation level of detail
+    AnimationLod _animationLod;
+    AnimationLodStatistics _animationLodStatistics;
+    uint64_t _animationFrame = 0;
+    uint32_t _nextAnimatorPhase = 0;
+    
+    /**
+     * Largest screen relative height of the renderer over the cameras, -1 if no camera sees it.
+     */
+    static float _animationScreenHeight(Renderer *renderer, const std::vector<Camera *> &cameras);
+    
+    /**
+     * Apply the LODGroup of the entity, if any.
+     * @returns Whether the renderer is drawn for the camera.
+     */
+    static bool _updateLod(Renderer *renderer, const Camera *camera);
 };
 
 }        // namespace vox
@@ -179,6 +179,7 @@ void Entity::destroy() {
         abilityArray[i]->destroy();
     }
     _components.clear();
+    _componentCache.invalidate();
     
     const auto &children = _children;
     for (size_t i = 0; i < children.size(); i++) {
@@ -203,6 +204,7 @@ void Entity::_removeComponent(Component *component) {
                                     components.end(), [&](const std::unique_ptr<Component> &x) {
         return x.get() == component;
     }), components.end());
+    _componentCache.invalidate();
 }
 
 void Entity::_addScript(Script *script) {
@@ -211,7 +213,13 @@ void Entity::_addScript(Script *script) {
 }
 
 void Entity::_removeScript(Script *script) {
-    std::remove(_scripts.begin(), _scripts.end(), script);
+    const auto index = script->_entityCacheIndex;
+    auto last = _scripts.back();
+    _scripts.pop_back();
+    if (last != script) {
+        _scripts[index] = last;
+        last->_entityCacheIndex = index;
+    }
     script->_entityCacheIndex = -1;
 }
 
@@ -13,6 +13,7 @@
 #include <vector>
 #include "layer.h"
 #include "transform.h"
+#include "component_type.h"
 
 //#include "scene_graph/components/transform.h"
 
@@ -76,6 +77,7 @@ public:
         auto component = std::make_unique<T>(this);
         T *componentPtr = component.get();
         _components.emplace_back(std::move(component));
+        _componentCache.invalidate();
         if (_isActiveInHierarchy) {
             componentPtr->_setActive(true);
         }
@@ -84,32 +86,23 @@ public:
     
     /**
      * Get component which match the type.
+     * @remarks The result is cached per type, so repeated queries are O(1).
      * @returns    The first component which match type.
      */
     template<typename T>
     T *getComponent() {
-        for (size_t i = 0; i < _components.size(); i++) {
-            T *component = dynamic_cast<T *>(_components[i].get());
-            if (component) {
-                return component;
-            }
-        }
-        return nullptr;
+        return _componentCache.find<T>(_components);
     }
     
     /**
      * Get components which match the type.
+     * @remarks The matches are cached per type like getComponent.
      * @returns    The components which match type.
      */
     template<typename T>
     std::vector<T *> getComponents() {
         std::vector<T *> results;
-        for (size_t i = 0; i < _components.size(); i++) {
-            T *component = dynamic_cast<T *>(_components[i].get());
-            if (component) {
-                results.push_back(component);
-            }
-        }
+        _componentCache.findAll<T>(_components, results);
         return results;
     }
     
@@ -208,12 +201,7 @@ private:
     
     template<typename T>
     void _getComponentsInChildren(std::vector<T *> &results) {
-        for (size_t i = 0; i < _components.size(); i++) {
-            T *component = dynamic_cast<T *>(_components[i].get());
-            if (component) {
-                results.push_back(component);
-            }
-        }
+        _componentCache.findAll<T>(_components, results);
         for (size_t i = 0; i < _children.size(); i++) {
             _children[i]->_getComponentsInChildren(results);
         }
@@ -232,7 +220,9 @@ private:
     static void _traverseSetOwnerScene(Entity *entity, Scene *scene);
     
     bool _isActiveInHierarchy = false;
+    // owned per entity, the managers iterate the enabled components of a scene through ComponentRegistry
     std::vector<std::unique_ptr<Component>> _components{};
+    ComponentTypeCache _componentCache{};
     std::vector<Script *> _scripts{};
     std::vector<EntityPtr> _children{};
     Scene *_scene = nullptr;
@@ -8,10 +8,18 @@
 #include "rendering/subpasses/forward_subpass.h"
 #include "engine.h"
 #include "camera.h"
+#include "filesystem.h"
 #include "metal_helpers.h"
 
 namespace vox {
+namespace {
+const char *kPipelineManifest = "forward_pipelines.bin";
+}
+
 ForwardApplication::~ForwardApplication() {
+    if (_renderPass) {
+        _renderPass->resourceCache().manifest().save(fs::path::get(fs::path::Type::Storage, kPipelineManifest));
+    }
     _renderPass.reset();
 }
 
@@ -44,6 +52,11 @@ bool ForwardApplication::prepare(Engine &engine) {
     _renderPassDescriptor->stencilAttachment()->setTexture(_renderContext->depthStencilTexture());
     _renderPass = std::make_unique<RenderPass>(*_library, *_renderPassDescriptor);
     _renderPass->addSubpass(std::make_unique<ForwardSubpass>(_renderContext.get(), _scene.get(), _mainCamera));
+    // compile the pipelines used by the last run before the first frame needs them
+    PipelineManifest manifest;
+    if (manifest.load(fs::path::get(fs::path::Type::Storage, kPipelineManifest))) {
+        _renderPass->resourceCache().prewarm(*_library, manifest);
+    }
     if (_gui) {
         _renderPass->setGUI(_gui.get());
     }
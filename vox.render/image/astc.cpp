@@ -5,6 +5,7 @@
 //  property of any third parties.
 
 #include "astc.h"
+#include "thread_pool.h"
 #include <mutex>
 #include <astc_codec_internals.h>
 
@@ -86,18 +87,23 @@ struct AstcHeader {
 
 void Astc::init() {
     // Initializes ASTC library
-    static bool initialized{false};
-    static std::mutex initialization;
-    std::unique_lock<std::mutex> lock{initialization};
-    if (!initialized) {
-        // Init stuff
+    static std::once_flag initialization;
+    std::call_once(initialization, []() {
         prepare_angular_tables();
         build_quantization_mode_table();
-        initialized = true;
-    }
+    });
+}
+
+void Astc::initBlockTables(BlockDim blockdim) {
+    // get_block_size_descriptor and get_partition_table fill their caches on first use,
+    // the decoding threads only read them afterwards
+    static std::mutex initialization;
+    std::unique_lock<std::mutex> lock{initialization};
+    get_block_size_descriptor(blockdim.x, blockdim.y, blockdim.z);
+    get_partition_table(blockdim.x, blockdim.y, blockdim.z, 1);
 }
 
-void Astc::decode(BlockDim blockdim, MTL::Size extent, const uint8_t *data_) {
+void Astc::decode(BlockDim blockdim, MTL::Size extent, const uint8_t *data_, bool parallel) {
     // Actual decoding
     astc_decode_mode decode_mode = DECODE_LDR_SRGB;
     uint32_t bitness = 8;
@@ -127,21 +133,31 @@ void Astc::decode(BlockDim blockdim, MTL::Size extent, const uint8_t *data_) {
     
     auto astc_image = allocate_image(bitness, xsize, ysize, zsize, 0);
     initialize_image(astc_image);
+    initBlockTables(blockdim);
     
-    imageblock pb;
-    for (int z = 0; z < zblocks; z++) {
-        for (int y = 0; y < yblocks; y++) {
-            for (int x = 0; x < xblocks; x++) {
-                int offset = (((z * yblocks + y) * xblocks) + x) * 16;
-                const uint8_t *bp = data_ + offset;
-                
-                physical_compressed_block pcb = *reinterpret_cast<const physical_compressed_block *>(bp);
-                symbolic_compressed_block scb;
-                
-                physical_to_symbolic(xdim, ydim, zdim, pcb, &scb);
-                decompress_symbolic_block(decode_mode, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, &scb, &pb);
-                write_imageblock(astc_image, &pb, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, swz_decode);
-            }
+    // every row of blocks writes its own texels of astc_image
+    auto decodeRow = [&](size_t row) {
+        const int z = static_cast<int>(row) / yblocks;
+        const int y = static_cast<int>(row) % yblocks;
+        imageblock pb;
+        for (int x = 0; x < xblocks; x++) {
+            int offset = (((z * yblocks + y) * xblocks) + x) * 16;
+            const uint8_t *bp = data_ + offset;
+            
+            physical_compressed_block pcb = *reinterpret_cast<const physical_compressed_block *>(bp);
+            symbolic_compressed_block scb;
+            
+            physical_to_symbolic(xdim, ydim, zdim, pcb, &scb);
+            decompress_symbolic_block(decode_mode, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, &scb, &pb);
+            write_imageblock(astc_image, &pb, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, swz_decode);
+        }
+    };
+    const size_t rows = static_cast<size_t>(zblocks) * yblocks;
+    if (parallel) {
+        ThreadPool::shared().parallelFor(rows, decodeRow);
+    } else {
+        for (size_t row = 0; row < rows; row++) {
+            decodeRow(row);
         }
     }
     
@@ -154,13 +170,13 @@ void Astc::decode(BlockDim blockdim, MTL::Size extent, const uint8_t *data_) {
     destroy_image(astc_image);
 }
 
-Astc::Astc(const Image &image, bool flipY) :
+Astc::Astc(const Image &image, bool flipY, bool parallel) :
 Image{} {
     init();
-    decode(toBlockdim(image.format()), image.extent(), image.data().data());
+    decode(toBlockdim(image.format()), image.extent(), image.data().data(), parallel);
 }
 
-Astc::Astc(const std::vector<uint8_t> &data, bool flipY) :
+Astc::Astc(const std::vector<uint8_t> &data, bool flipY, bool parallel) :
 Image{} {
     init();
     
@@ -187,7 +203,7 @@ Image{} {
         /* height = */ static_cast<uint32_t>(header.ysize[0] + 256 * header.ysize[1] + 65536 * header.ysize[2]),
         /* depth  = */ static_cast<uint32_t>(header.zsize[0] + 256 * header.zsize[1] + 65536 * header.zsize[2])};
     
-    decode(blockdim, extent, data.data() + sizeof(AstcHeader));
+    decode(blockdim, extent, data.data() + sizeof(AstcHeader), parallel);
 }
 
 }        // namespace vox
@@ -21,30 +21,40 @@ public:
     /**
      * @brief Decodes an ASTC image
      * @param image Image to decode
+     * @param parallel Decode block rows on the shared thread pool, the result is identical to the serial decode
      */
-    Astc(const Image &image, bool flipY);
+    Astc(const Image &image, bool flipY, bool parallel = true);
     
     /**
      * @brief Decodes ASTC data with an ASTC header
      * @param data ASTC data with header
+     * @param parallel Decode block rows on the shared thread pool, the result is identical to the serial decode
      */
-    Astc(const std::vector<uint8_t> &data, bool flipY);
+    Astc(const std::vector<uint8_t> &data, bool flipY, bool parallel = true);
     
     virtual ~Astc() = default;
     
 private:
+    friend class AstcEncoder;
+    
     /**
      * @brief Decodes ASTC data
      * @param blockdim Dimensions of the block
      * @param extent Extent of the image
      * @param data Pointer to ASTC image data
+     * @param parallel Decode block rows on the shared thread pool
      */
-    void decode(BlockDim blockdim, MTL::Size extent, const uint8_t *data);
+    void decode(BlockDim blockdim, MTL::Size extent, const uint8_t *data, bool parallel);
     
     /**
      * @brief Initializes ASTC library
      */
-    void init();
+    static void init();
+    
+    /**
+     * @brief Builds the block size and partition tables of a block size, which the codec creates lazily and unsynchronized
+     */
+    static void initBlockTables(BlockDim blockdim);
 };
 
 }        // namespace vox
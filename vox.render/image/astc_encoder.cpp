@@ -0,0 +1,282 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "astc_encoder.h"
+#include "thread_pool.h"
+#include <astc_codec_internals.h>
+#include <ktx.h>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+namespace vox {
+namespace {
+// 2D block sizes in the order of VK_FORMAT_ASTC_4x4_UNORM_BLOCK... and GL_COMPRESSED_RGBA_ASTC_4x4_KHR...
+const BlockDim kBlockDims[] = {{4, 4, 1}, {5, 4, 1}, {5, 5, 1}, {6, 5, 1}, {6, 6, 1}, {8, 5, 1}, {8, 6, 1},
+    {8, 8, 1}, {10, 5, 1}, {10, 6, 1}, {10, 8, 1}, {10, 10, 1}, {12, 10, 1}, {12, 12, 1}};
+
+constexpr uint32_t kVkFormatAstcUnorm = 157;
+
+// settings of the astcenc presets
+struct PresetParams {
+    int partitionLimit;
+    float partition1To2Limit;
+    float lowestCorrelation;
+    // dB limit is max(a - 35 * log10(texels), b - 19 * log10(texels))
+    float dbLimitA;
+    float dbLimitB;
+    float blockModeCutoff;
+    int maxIterations;
+};
+
+PresetParams presetParams(AstcEncoder::Preset preset) {
+    switch (preset) {
+        case AstcEncoder::Preset::VeryFast:
+            return {2, 1.0f, 0.5f, 70, 53, 25, 1};
+        case AstcEncoder::Preset::Fast:
+            return {4, 1.0f, 0.5f, 85, 63, 50, 1};
+        case AstcEncoder::Preset::Medium:
+            return {25, 1.2f, 0.75f, 95, 70, 75, 2};
+        case AstcEncoder::Preset::Thorough:
+            return {100, 2.5f, 0.95f, 105, 77, 95, 4};
+        case AstcEncoder::Preset::Exhaustive:
+            return {PARTITION_COUNT, 1000.0f, 0.99f, 999, 999, 100, 4};
+    }
+    return {25, 1.2f, 0.75f, 95, 70, 75, 2};
+}
+
+error_weighting_params makeErrorWeighting(BlockDim blockdim, AstcEncoder::Preset preset) {
+    error_weighting_params ewp{};
+    ewp.rgb_power = 1.0f;
+    ewp.alpha_power = 1.0f;
+    ewp.rgb_base_weight = 1.0f;
+    ewp.alpha_base_weight = 1.0f;
+    ewp.rgba_weights[0] = 1.0f;
+    ewp.rgba_weights[1] = 1.0f;
+    ewp.rgba_weights[2] = 1.0f;
+    ewp.rgba_weights[3] = 1.0f;
+
+    const auto params = presetParams(preset);
+    const float log10Texels = std::log10(static_cast<float>(blockdim.x * blockdim.y));
+    const float dbLimit = std::max(params.dbLimitA - 35 * log10Texels, params.dbLimitB - 19 * log10Texels);
+    ewp.partition_search_limit = params.partitionLimit;
+    ewp.partition_1_to_2_limit = params.partition1To2Limit;
+    ewp.lowest_correlation_cutoff = params.lowestCorrelation;
+    ewp.texel_avg_error_limit = std::pow(0.1f, dbLimit * 0.1f) * 65535.0f * 65535.0f;
+    ewp.block_mode_cutoff = params.blockModeCutoff / 100.0f;
+    ewp.max_refinement_iters = params.maxIterations;
+    expand_block_artifact_suppression(blockdim.x, blockdim.y, blockdim.z, &ewp);
+    return ewp;
+}
+
+// scratch memory of compress_symbolic_block, one per encoding task
+struct EncodeBuffers {
+    EncodeBuffers() {
+        buffers.ewb = new error_weight_block;
+        buffers.ewbo = new error_weight_block_orig;
+        buffers.tempblocks = new symbolic_compressed_block[4];
+        buffers.temp = new imageblock;
+        buffers.planes2 = new compress_fixed_partition_buffers;
+        buffers.planes2->ei1 = new endpoints_and_weights;
+        buffers.planes2->ei2 = new endpoints_and_weights;
+        buffers.planes2->eix1 = new endpoints_and_weights[MAX_DECIMATION_MODES];
+        buffers.planes2->eix2 = new endpoints_and_weights[MAX_DECIMATION_MODES];
+        buffers.planes2->decimated_quantized_weights = new float[2 * MAX_DECIMATION_MODES * MAX_WEIGHTS_PER_BLOCK];
+        buffers.planes2->decimated_weights = new float[2 * MAX_DECIMATION_MODES * MAX_WEIGHTS_PER_BLOCK];
+        buffers.planes2->flt_quantized_decimated_quantized_weights = new float[2 * MAX_WEIGHT_MODES * MAX_WEIGHTS_PER_BLOCK];
+        buffers.planes2->u8_quantized_decimated_quantized_weights = new uint8_t[2 * MAX_WEIGHT_MODES * MAX_WEIGHTS_PER_BLOCK];
+        buffers.plane1 = buffers.planes2;
+    }
+
+    ~EncodeBuffers() {
+        delete[] buffers.planes2->decimated_quantized_weights;
+        delete[] buffers.planes2->decimated_weights;
+        delete[] buffers.planes2->flt_quantized_decimated_quantized_weights;
+        delete[] buffers.planes2->u8_quantized_decimated_quantized_weights;
+        delete[] buffers.planes2->eix1;
+        delete[] buffers.planes2->eix2;
+        delete buffers.planes2->ei1;
+        delete buffers.planes2->ei2;
+        delete buffers.planes2;
+        delete[] buffers.tempblocks;
+        delete buffers.temp;
+        delete buffers.ewbo;
+        delete buffers.ewb;
+    }
+
+    EncodeBuffers(const EncodeBuffers &) = delete;
+
+    EncodeBuffers &operator=(const EncodeBuffers &) = delete;
+
+    compress_symbolic_block_buffers buffers;
+};
+
+}
+
+AstcEncoder::AstcEncoder(BlockDim blockdim, Preset preset, bool srgb) :
+_blockdim(blockdim),
+_preset(preset),
+_srgb(srgb),
+_formatIndex(std::numeric_limits<uint32_t>::max()) {
+    for (uint32_t i = 0; i < std::size(kBlockDims); i++) {
+        if (kBlockDims[i].x == blockdim.x && kBlockDims[i].y == blockdim.y && blockdim.z == 1) {
+            _formatIndex = i;
+        }
+    }
+    if (_formatIndex == std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error{"Error encoding astc: invalid block"};
+    }
+}
+
+BlockDim AstcEncoder::blockdim() const {
+    return _blockdim;
+}
+
+AstcEncoder::Preset AstcEncoder::preset() const {
+    return _preset;
+}
+
+std::vector<uint8_t> AstcEncoder::encode(const uint8_t *rgba, uint32_t width, uint32_t height, bool parallel) const {
+    if (width == 0 || height == 0) {
+        throw std::runtime_error{"Error encoding astc: invalid size"};
+    }
+    Astc::init();
+    Astc::initBlockTables(_blockdim);
+
+    const int xdim = _blockdim.x;
+    const int ydim = _blockdim.y;
+    const int zdim = 1;
+    const int xblocks = (static_cast<int>(width) + xdim - 1) / xdim;
+    const int yblocks = (static_cast<int>(height) + ydim - 1) / ydim;
+    const astc_decode_mode decodeMode = _srgb ? DECODE_LDR_SRGB : DECODE_LDR;
+    const swizzlepattern swizzle = {0, 1, 2, 3};
+    const error_weighting_params ewp = makeErrorWeighting(_blockdim, _preset);
+
+    // the codec works on its own image, without padding as the presets weight no neighborhood
+    auto image = allocate_image(8, static_cast<int>(width), static_cast<int>(height), 1, 0);
+    for (uint32_t y = 0; y < height; y++) {
+        std::memcpy(image->imagedata8[0][y], rgba + size_t(y) * width * 4, size_t(width) * 4);
+    }
+
+    std::vector<uint8_t> blocks(size_t(xblocks) * yblocks * 16);
+    // every row of blocks reads the shared image and writes its own blocks
+    auto encodeRow = [&](size_t row) {
+        const int y = static_cast<int>(row);
+        EncodeBuffers scratch;
+        imageblock pb;
+        symbolic_compressed_block scb;
+        for (int x = 0; x < xblocks; x++) {
+            fetch_imageblock(image, &pb, xdim, ydim, zdim, x * xdim, y * ydim, 0, swizzle);
+            compress_symbolic_block(image, decodeMode, xdim, ydim, zdim, &ewp, &pb, &scb, &scratch.buffers);
+            const physical_compressed_block pcb = symbolic_to_physical(xdim, ydim, zdim, &scb);
+            std::memcpy(blocks.data() + (size_t(y) * xblocks + x) * 16, &pcb, 16);
+        }
+    };
+    if (parallel) {
+        ThreadPool::shared().parallelFor(yblocks, encodeRow);
+    } else {
+        for (int y = 0; y < yblocks; y++) {
+            encodeRow(y);
+        }
+    }
+
+    destroy_image(image);
+    return blocks;
+}
+
+std::vector<uint8_t> AstcEncoder::encodeKtx(const Image &image, bool parallel) const {
+    if (image.format() != MTL::PixelFormatRGBA8Unorm && image.format() != MTL::PixelFormatRGBA8Unorm_sRGB) {
+        throw std::runtime_error{"Error encoding astc: source is not RGBA8"};
+    }
+    // the image may be shared through the image cache
+    Image chain;
+    const Image *source = &image;
+    if (image.mipmaps().size() == 1) {
+        chain = image;
+        chain.generateMipmaps();
+        source = &chain;
+    }
+    const auto &mipmaps = source->mipmaps();
+
+    ktxTextureCreateInfo info{};
+    info.vkFormat = kVkFormatAstcUnorm + _formatIndex * 2 + (_srgb ? 1 : 0);
+    info.baseWidth = static_cast<ktx_uint32_t>(image.extent().width);
+    info.baseHeight = static_cast<ktx_uint32_t>(image.extent().height);
+    info.baseDepth = 1;
+    info.numDimensions = 2;
+    info.numLevels = static_cast<ktx_uint32_t>(mipmaps.size());
+    info.numLayers = 1;
+    info.numFaces = 1;
+    info.isArray = KTX_FALSE;
+    info.generateMipmaps = KTX_FALSE;
+
+    ktxTexture2 *texture;
+    if (ktxTexture2_Create(&info, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture) != KTX_SUCCESS) {
+        throw std::runtime_error{"Error creating KTX texture"};
+    }
+    for (const auto &mipmap : mipmaps) {
+        const auto width = static_cast<uint32_t>(mipmap.extent.width);
+        const auto height = static_cast<uint32_t>(mipmap.extent.height);
+        const auto blocks = encode(source->data().data() + mipmap.offset, width, height, parallel);
+        if (ktxTexture_SetImageFromMemory(ktxTexture(texture), mipmap.level, 0, 0,
+                                          blocks.data(), blocks.size()) != KTX_SUCCESS) {
+            ktxTexture_Destroy(ktxTexture(texture));
+            throw std::runtime_error{"Error setting KTX image data"};
+        }
+    }
+
+    ktx_uint8_t *bytes = nullptr;
+    ktx_size_t size = 0;
+    const auto result = ktxTexture_WriteToMemory(ktxTexture(texture), &bytes, &size);
+    ktxTexture_Destroy(ktxTexture(texture));
+    if (result != KTX_SUCCESS) {
+        throw std::runtime_error{"Error writing KTX texture"};
+    }
+    std::vector<uint8_t> file(bytes, bytes + size);
+    free(bytes);
+    return file;
+}
+
+std::vector<uint8_t> AstcEncoder::astcFile(const std::vector<uint8_t> &blocks, uint32_t width, uint32_t height) const {
+    std::vector<uint8_t> file = {
+        0x13, 0xAB, 0xA1, 0x5C, _blockdim.x, _blockdim.y, 1,
+        static_cast<uint8_t>(width), static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width >> 16),
+        static_cast<uint8_t>(height), static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height >> 16),
+        1, 0, 0};
+    file.insert(file.end(), blocks.begin(), blocks.end());
+    return file;
+}
+
+double AstcEncoder::psnr(const uint8_t *reference, const uint8_t *image, size_t size) {
+    double error = 0;
+    for (size_t i = 0; i < size; i++) {
+        const double difference = double(reference[i]) - double(image[i]);
+        error += difference * difference;
+    }
+    if (error == 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return 10 * std::log10(255.0 * 255.0 * size / error);
+}
+
+const char *AstcEncoder::presetName(Preset preset) {
+    switch (preset) {
+        case Preset::VeryFast:
+            return "veryfast";
+        case Preset::Fast:
+            return "fast";
+        case Preset::Medium:
+            return "medium";
+        case Preset::Thorough:
+            return "thorough";
+        case Preset::Exhaustive:
+            return "exhaustive";
+    }
+    return "";
+}
+
+}
@@ -0,0 +1,71 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef astc_encoder_hpp
+#define astc_encoder_hpp
+
+#include "astc.h"
+
+namespace vox {
+/**
+ * Compresses RGBA8 images to 2D ASTC blocks with the vendored codec.
+ */
+class AstcEncoder {
+public:
+    /**
+     * Search effort of the codec, the presets of the astcenc command line.
+     */
+    enum class Preset {
+        VeryFast, Fast, Medium, Thorough, Exhaustive
+    };
+
+    /**
+     * @param blockdim - One of the 2D block sizes of ASTC, from 4x4 to 12x12
+     * @param srgb - Encode for the sRGB formats, otherwise for the linear LDR ones
+     */
+    AstcEncoder(BlockDim blockdim, Preset preset = Preset::Medium, bool srgb = true);
+
+    BlockDim blockdim() const;
+
+    Preset preset() const;
+
+    /**
+     * Compresses one level.
+     * @param rgba - Tightly packed RGBA8 texels
+     * @param parallel - Encode block rows on the shared thread pool, the blocks are identical to the serial encode
+     * @return 16 bytes per block, row by row
+     */
+    std::vector<uint8_t> encode(const uint8_t *rgba, uint32_t width, uint32_t height, bool parallel = true) const;
+
+    /**
+     * Compresses every mip level of an RGBA8 image into a KTX2 container, which Ktx loads.
+     * @remarks Mipmaps are generated on a copy when the image only has its base level.
+     */
+    std::vector<uint8_t> encodeKtx(const Image &image, bool parallel = true) const;
+
+    /**
+     * Wraps blocks of encode in an .astc file, which Astc loads.
+     */
+    std::vector<uint8_t> astcFile(const std::vector<uint8_t> &blocks, uint32_t width, uint32_t height) const;
+
+    /**
+     * Peak signal to noise ratio in dB over every channel of two RGBA8 images of the same size, infinity if they are equal.
+     */
+    static double psnr(const uint8_t *reference, const uint8_t *image, size_t size);
+
+    static const char *presetName(Preset preset);
+
+private:
+    BlockDim _blockdim;
+    Preset _preset;
+    bool _srgb;
+    // index in the ASTC block sizes, the order of the Vulkan and OpenGL formats
+    uint32_t _formatIndex;
+};
+
+}
+
+#endif /* astc_encoder_hpp */
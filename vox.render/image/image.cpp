@@ -8,10 +8,7 @@
 #include "std_helpers.h"
 #include "filesystem.h"
 
-#define STB_IMAGE_RESIZE_IMPLEMENTATION
-
-#include <stb_image_resize.h>
-
+#include "image/mipmap_generator.h"
 #include "image/stb.h"
 #include "image/astc.h"
 #include "image/ktx_image.h"
@@ -54,7 +51,7 @@ const std::vector<std::vector<uint64_t>> &Image::offsets() const {
     return _offsets;
 }
 
-std::shared_ptr<SampledTexture2D> Image::createSampledTexture(MTL::Device &device, MTL::CommandQueue &queue, MTL::TextureUsage usage) {
+std::shared_ptr<SampledTexture2D> Image::createSampledTexture(MTL::Device &device, MTL::CommandQueue &queue, MTL::TextureUsage usage) const {
     auto sampledTex = std::make_shared<SampledTexture2D>(device,
                                                          _mipmaps.at(0).extent.width,
                                                          _mipmaps.at(0).extent.height,
@@ -71,6 +68,10 @@ Mipmap &Image::mipmap(const size_t index) {
 }
 
 void Image::generateMipmaps() {
+    generateMipmaps(MipmapOptions{});
+}
+
+void Image::generateMipmaps(const MipmapOptions &options) {
     assert(_mipmaps.size() == 1 && "Mipmaps already generated");
     
     if (_mipmaps.size() > 1) {
@@ -78,42 +79,14 @@ void Image::generateMipmaps() {
     }
     
     const MTL::Size &extent = this->extent();
-    auto next_width = std::max<uint32_t>(1u, static_cast<uint32_t>(extent.width) / 2);
-    auto next_height = std::max<uint32_t>(1u, static_cast<uint32_t>(extent.height) / 2);
-    auto channels = 4;
-    auto next_size = next_width * next_height * channels;
+    size_t size = 0;
+    auto levels = MipmapGenerator::chain(static_cast<uint32_t>(extent.width), static_cast<uint32_t>(extent.height), size);
+    _data.resize(size);
     
-    while (true) {
-        // Make space for next mipmap
-        auto old_size = to_u32(_data.size());
-        _data.resize(old_size + next_size);
-        
-        auto &prev_mipmap = _mipmaps.back();
-        // Update mipmaps
-        Mipmap next_mipmap{};
-        next_mipmap.level = prev_mipmap.level + 1;
-        next_mipmap.offset = old_size;
-        next_mipmap.extent = {next_width, next_height, 1u};
-        
-        // Fill next mipmap memory
-        stbir_resize_uint8(_data.data() + prev_mipmap.offset,
-                           static_cast<uint32_t>(prev_mipmap.extent.width),
-                           static_cast<uint32_t>(prev_mipmap.extent.height), 0,
-                           _data.data() + next_mipmap.offset,
-                           static_cast<uint32_t>(next_mipmap.extent.width),
-                           static_cast<uint32_t>(next_mipmap.extent.height), 0, channels);
-        
-        _mipmaps.emplace_back(std::move(next_mipmap));
-        
-        // Next mipmap values
-        next_width = std::max<uint32_t>(1u, next_width / 2);
-        next_height = std::max<uint32_t>(1u, next_height / 2);
-        next_size = next_width * next_height * channels;
-        
-        if (next_width == 1 && next_height == 1) {
-            break;
-        }
-    }
+    auto chainOptions = options;
+    chainOptions.srgb = chainOptions.srgb || _format == MTL::PixelFormatRGBA8Unorm_sRGB;
+    MipmapGenerator(chainOptions).generate(_data.data(), levels);
+    _mipmaps = std::move(levels);
 }
 
 std::vector<Mipmap> &Image::mipmaps() {
@@ -154,12 +127,11 @@ void Image::setOffsets(const std::vector<std::vector<uint64_t>> &o) {
 }
 
 std::unique_ptr<Image> Image::load(const std::string &uri, bool flipY) {
+    return decode(fs::readAsset(uri), fs::extraExtension(uri), flipY);
+}
+
+std::unique_ptr<Image> Image::decode(const std::vector<uint8_t> &data, const std::string &extension, bool flipY) {
     std::unique_ptr<Image> image{nullptr};
-    
-    auto data = fs::readAsset(uri);
-    
-    // Get extension
-    auto extension = fs::extraExtension(uri);
     if (extension == "png" || extension == "jpg") {
         image = std::make_unique<Stb>(data, flipY);
     } else if (extension == "astc") {
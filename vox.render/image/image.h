@@ -13,6 +13,7 @@
 
 namespace vox {
 class SampledTexture2D;
+struct MipmapOptions;
 
 /**
  * @brief Mipmap information
@@ -34,6 +35,13 @@ public:
     
     static std::unique_ptr<Image> load(const std::string &uri, bool flipY = false);
     
+    /**
+     * Decode a file already in memory.
+     * @param extension - png, jpg, astc, ktx or ktx2
+     * @returns nullptr if the extension is not supported.
+     */
+    static std::unique_ptr<Image> decode(const std::vector<uint8_t> &data, const std::string &extension, bool flipY = false);
+    
     virtual ~Image() = default;
     
     const std::vector<uint8_t> &data() const;
@@ -50,12 +58,17 @@ public:
     
     const std::vector<std::vector<uint64_t>> &offsets() const;
     
+    /**
+     * @brief Generates the mip chain down to 1x1 with a box filter, in linear space for sRGB formats
+     */
     void generateMipmaps();
     
+    void generateMipmaps(const MipmapOptions &options);
+    
 public:
     std::shared_ptr<SampledTexture2D>
     createSampledTexture(MTL::Device &device, MTL::CommandQueue &queue,
-                         MTL::TextureUsage usage = MTL::TextureUsageShaderRead);
+                         MTL::TextureUsage usage = MTL::TextureUsageShaderRead) const;
     
 protected:
     std::vector<uint8_t> &data();
@@ -0,0 +1,352 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "image_cache.h"
+#include "filesystem.h"
+#include "loader/mesh_cache.h"
+#include "texture/sampled_texture2d.h"
+#include "texture/sampled_texturecube.h"
+#include <glog/logging.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace vox {
+namespace {
+constexpr uint32_t kDiskMagic = 0x49435856; // "VXCI"
+constexpr uint32_t kDiskVersion = 1;
+// seeds which keep the hashes of files, pixels and cube maps apart
+constexpr uint64_t kFileSeed = 0x66696c65;
+constexpr uint64_t kCubeSeed = 0x63756265;
+
+struct DiskHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t hash;
+    uint32_t format;
+    uint32_t levelCount;
+    uint64_t dataSize;
+};
+
+struct DiskLevel {
+    uint32_t offset;
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+};
+
+// image read back from the on-disk cache
+class CachedImage : public Image {
+public:
+    CachedImage(std::vector<uint8_t> &&data, std::vector<Mipmap> &&mipmaps, MTL::PixelFormat format) :
+    Image(std::move(data), std::move(mipmaps)) {
+        setFormat(format);
+    }
+};
+
+// bytes of a level as the textures upload it, 0 for the formats the disk cache doesn't keep
+uint64_t levelBytes(MTL::PixelFormat format, uint32_t width, uint32_t height, uint32_t depth) {
+    uint32_t blockWidth, blockHeight;
+    if (format != MTL::PixelFormatRGBA8Unorm && format != MTL::PixelFormatRGBA8Unorm_sRGB &&
+        !astcBlockSize(format, blockWidth, blockHeight)) {
+        return 0;
+    }
+    return uint64_t(bytesPerImage(format, width, height)) * std::max(depth, 1u);
+}
+
+// the extension picks the decoder, the same bytes may decode differently
+uint64_t fileHash(const std::vector<uint8_t> &data, const std::string &extension, bool flipY) {
+    const uint64_t seed = loader::contentHash(extension.data(), extension.size(), kFileSeed + flipY);
+    return loader::contentHash(data.data(), data.size(), seed);
+}
+
+} // namespace
+
+ImageCache &ImageCache::shared() {
+    static ImageCache cache;
+    return cache;
+}
+
+void ImageCache::setDiskCacheDirectory(const std::string &directory) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _diskDirectory = directory;
+}
+
+std::shared_ptr<const Image> ImageCache::load(const std::string &uri, bool flipY) {
+    const std::string key = flipY ? uri + "#flipY" : uri;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto path = _paths.find(key);
+        if (path != _paths.end()) {
+            if (auto image = _find(path->second)) {
+                _statistics.hits++;
+                return image;
+            }
+        }
+    }
+
+    const auto data = fs::readAsset(uri);
+    const auto extension = fs::extraExtension(uri);
+    auto image = decode(data, extension, flipY);
+    if (image) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _paths[key] = fileHash(data, extension, flipY);
+    }
+    return image;
+}
+
+std::shared_ptr<const Image> ImageCache::decode(const std::vector<uint8_t> &data, const std::string &extension, bool flipY) {
+    const uint64_t hash = fileHash(data, extension, flipY);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (auto image = _find(hash)) {
+            _statistics.hits++;
+            return image;
+        }
+    }
+
+    auto image = _readDisk(hash);
+    const bool fromDisk = image != nullptr;
+    if (!fromDisk) {
+        image = Image::decode(data, extension, flipY);
+        if (!image) {
+            return nullptr;
+        }
+        _writeDisk(hash, *image);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _statistics.misses++;
+    _statistics.diskHits += fromDisk ? 1 : 0;
+    return _insert(hash, std::move(image));
+}
+
+std::shared_ptr<const Image> ImageCache::add(std::unique_ptr<Image> image) {
+    const uint64_t hash = imageHash(*image);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (auto cached = _find(hash)) {
+        _statistics.hits++;
+        return cached;
+    }
+    _statistics.misses++;
+    return _insert(hash, std::move(image));
+}
+
+std::shared_ptr<SampledTexture2D> ImageCache::texture(const std::shared_ptr<const Image> &image,
+                                                      MTL::Device &device, MTL::CommandQueue &queue,
+                                                      uint64_t samplerKey) {
+    const uint64_t imageHash = _hash(*image);
+    const uint64_t hash = samplerKey == 0 ? imageHash : loader::contentHash(&samplerKey, sizeof(samplerKey), imageHash);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (auto texture = _findTexture<SampledTexture2D>(hash)) {
+            _statistics.textureHits++;
+            return texture;
+        }
+    }
+
+    auto texture = image->createSampledTexture(device, queue);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _statistics.textureMisses++;
+    _textures[hash] = {texture, image->data().size()};
+    return texture;
+}
+
+std::shared_ptr<SampledTextureCube> ImageCache::textureCube(const std::array<std::shared_ptr<const Image>, 6> &faces,
+                                                            MTL::Device &device, MTL::CommandQueue &queue) {
+    std::array<uint64_t, 6> hashes{};
+    size_t bytes = 0;
+    for (size_t i = 0; i < faces.size(); i++) {
+        hashes[i] = _hash(*faces[i]);
+        bytes += faces[i]->data().size();
+    }
+    const uint64_t hash = loader::contentHash(hashes.data(), sizeof(hashes), kCubeSeed);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (auto texture = _findTexture<SampledTextureCube>(hash)) {
+            _statistics.textureHits++;
+            return texture;
+        }
+    }
+
+    const auto &extent = faces[0]->extent();
+    auto texture = std::make_shared<SampledTextureCube>(device, extent.width, extent.height, 1, true, faces[0]->format());
+    std::array<const Image *, 6> images{};
+    for (size_t i = 0; i < faces.size(); i++) {
+        images[i] = faces[i].get();
+    }
+    texture->setPixelBuffer(queue, images);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _statistics.textureMisses++;
+    _textures[hash] = {texture, bytes};
+    return texture;
+}
+
+ImageCacheStatistics ImageCache::statistics() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto statistics = _statistics;
+    for (auto iter = _images.begin(); iter != _images.end();) {
+        if (const auto image = iter->second.value.lock()) {
+            statistics.imageCount++;
+            statistics.imageBytes += image->data().size();
+            ++iter;
+        } else {
+            iter = _images.erase(iter);
+        }
+    }
+    for (auto iter = _imageHashes.begin(); iter != _imageHashes.end();) {
+        iter = _images.count(iter->second) ? std::next(iter) : _imageHashes.erase(iter);
+    }
+    for (auto iter = _paths.begin(); iter != _paths.end();) {
+        iter = _images.count(iter->second) ? std::next(iter) : _paths.erase(iter);
+    }
+    for (auto iter = _textures.begin(); iter != _textures.end();) {
+        if (!iter->second.value.expired()) {
+            statistics.textureCount++;
+            statistics.textureBytes += iter->second.bytes;
+            ++iter;
+        } else {
+            iter = _textures.erase(iter);
+        }
+    }
+    return statistics;
+}
+
+uint64_t ImageCache::imageHash(const Image &image) {
+    uint64_t hash = loader::contentHash(image.data().data(), image.data().size(), image.format());
+    for (const auto &mipmap : image.mipmaps()) {
+        const uint64_t level[4] = {mipmap.offset, mipmap.extent.width, mipmap.extent.height, mipmap.extent.depth};
+        hash = loader::contentHash(level, sizeof(level), hash);
+    }
+    return hash;
+}
+
+std::shared_ptr<const Image> ImageCache::_find(uint64_t hash) {
+    const auto iter = _images.find(hash);
+    return iter == _images.end() ? nullptr : iter->second.value.lock();
+}
+
+std::shared_ptr<const Image> ImageCache::_insert(uint64_t hash, std::unique_ptr<Image> image) {
+    // another thread may have decoded the same content meanwhile
+    if (auto cached = _find(hash)) {
+        return cached;
+    }
+    std::shared_ptr<const Image> shared = std::move(image);
+    _images[hash] = {shared, shared->data().size()};
+    _imageHashes[shared.get()] = hash;
+    return shared;
+}
+
+uint64_t ImageCache::_hash(const Image &image) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto iter = _imageHashes.find(&image);
+        // the address may belong to an image which was released
+        if (iter != _imageHashes.end() && _find(iter->second).get() == &image) {
+            return iter->second;
+        }
+    }
+    return imageHash(image);
+}
+
+template<class T>
+std::shared_ptr<T> ImageCache::_findTexture(uint64_t hash) {
+    const auto iter = _textures.find(hash);
+    return iter == _textures.end() ? nullptr : std::static_pointer_cast<T>(iter->second.value.lock());
+}
+
+//MARK: - Disk Cache
+std::string ImageCache::_diskFile(uint64_t hash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.vci", static_cast<unsigned long long>(hash));
+    return _diskDirectory + "/" + name;
+}
+
+std::unique_ptr<Image> ImageCache::_readDisk(uint64_t hash) {
+    std::string filename;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_diskDirectory.empty()) {
+            return nullptr;
+        }
+        filename = _diskFile(hash);
+    }
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return nullptr;
+    }
+
+    DiskHeader header{};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || header.magic != kDiskMagic || header.version != kDiskVersion || header.hash != hash ||
+        header.levelCount == 0) {
+        return nullptr;
+    }
+    std::vector<Mipmap> mipmaps;
+    for (uint32_t i = 0; i < header.levelCount; i++) {
+        DiskLevel level{};
+        file.read(reinterpret_cast<char *>(&level), sizeof(level));
+        // a level past the pixels would be read out of bounds by the upload
+        const uint64_t bytes = levelBytes(static_cast<MTL::PixelFormat>(header.format), level.width, level.height, level.depth);
+        if (!file || bytes == 0 || level.offset + bytes > header.dataSize) {
+            return nullptr;
+        }
+        mipmaps.push_back({i, level.offset, {level.width, level.height, level.depth}});
+    }
+    // the pixels end the file, a damaged size is rejected before it is allocated
+    const auto position = file.tellg();
+    file.seekg(0, std::ios::end);
+    const auto end = file.tellg();
+    file.seekg(position);
+    if (!file || end < position || header.dataSize > static_cast<uint64_t>(end - position)) {
+        return nullptr;
+    }
+    std::vector<uint8_t> data(header.dataSize);
+    file.read(reinterpret_cast<char *>(data.data()), data.size());
+    if (!file) {
+        return nullptr;
+    }
+    return std::make_unique<CachedImage>(std::move(data), std::move(mipmaps),
+                                         static_cast<MTL::PixelFormat>(header.format));
+}
+
+void ImageCache::_writeDisk(uint64_t hash, const Image &image) {
+    std::string filename;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_diskDirectory.empty()) {
+            return;
+        }
+        filename = _diskFile(hash);
+    }
+    // array and cube layers are addressed by offsets which are not stored
+    if (image.offsets().size() > 1 || image.extent().depth > 1 || levelBytes(image.format(), 1, 1, 1) == 0) {
+        return;
+    }
+
+    const DiskHeader header{kDiskMagic, kDiskVersion, hash, static_cast<uint32_t>(image.format()),
+        static_cast<uint32_t>(image.mipmaps().size()), image.data().size()};
+    // written aside and renamed, a reader never sees a partial file
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG(WARNING) << "Failed to write image cache " << filename << std::endl;
+            return;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        for (const auto &mipmap : image.mipmaps()) {
+            const DiskLevel level{mipmap.offset, static_cast<uint32_t>(mipmap.extent.width),
+                static_cast<uint32_t>(mipmap.extent.height), static_cast<uint32_t>(mipmap.extent.depth)};
+            file.write(reinterpret_cast<const char *>(&level), sizeof(level));
+        }
+        file.write(reinterpret_cast<const char *>(image.data().data()), image.data().size());
+    }
+    std::rename(temporary.c_str(), filename.c_str());
+}
+
+}
@@ -0,0 +1,131 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef image_cache_hpp
+#define image_cache_hpp
+
+#include "image.h"
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace vox {
+class SampledTexture;
+class SampledTexture2D;
+class SampledTextureCube;
+
+struct ImageCacheStatistics {
+    uint32_t hits{0};
+    uint32_t misses{0};
+    /** Misses read from the on-disk cache instead of being decoded. */
+    uint32_t diskHits{0};
+    uint32_t textureHits{0};
+    uint32_t textureMisses{0};
+
+    /** Images and textures still referenced by a loader. */
+    size_t imageCount{0};
+    size_t imageBytes{0};
+    size_t textureCount{0};
+    size_t textureBytes{0};
+};
+
+/**
+ * Shares decoded images and their textures between loaders, found by path and by content hash.
+ * @remarks The cache only keeps weak references, an image or texture is released with its last user.
+ * Images can be requested from any thread, decoding runs outside of the lock. Textures are uploaded on the calling thread.
+ */
+class ImageCache {
+public:
+    static ImageCache &shared();
+
+    /**
+     * Directory of the decoded pixels, which are read back instead of decoding the same file again.
+     * @remarks Empty disables the on-disk cache, which is the default.
+     */
+    void setDiskCacheDirectory(const std::string &directory);
+
+    /**
+     * Image of a file, decoded once for every path and content.
+     * @param uri - Path relative to the assets
+     * @returns nullptr if the extension is not supported.
+     */
+    std::shared_ptr<const Image> load(const std::string &uri, bool flipY = false);
+
+    /**
+     * Image of a file in memory.
+     * @param extension - png, jpg, astc, ktx or ktx2
+     */
+    std::shared_ptr<const Image> decode(const std::vector<uint8_t> &data, const std::string &extension, bool flipY = false);
+
+    /**
+     * Share an image decoded elsewhere.
+     * @returns The cached image with the same pixels, or the image itself.
+     * @remarks Cached images are shared and never modified, copy one to change it.
+     */
+    std::shared_ptr<const Image> add(std::unique_ptr<Image> image);
+
+    /**
+     * Texture with all the levels of an image, uploaded once for every content and sampler.
+     * @param samplerKey - Identifies the sampler state the caller sets, users of another key get their own texture
+     * @remarks Samplers are shared along with the texture, set the same state for the same key.
+     */
+    std::shared_ptr<SampledTexture2D> texture(const std::shared_ptr<const Image> &image,
+                                              MTL::Device &device, MTL::CommandQueue &queue,
+                                              uint64_t samplerKey = 0);
+
+    /**
+     * Cube texture of six faces in +X, -X, +Y, -Y, +Z, -Z order.
+     */
+    std::shared_ptr<SampledTextureCube> textureCube(const std::array<std::shared_ptr<const Image>, 6> &faces,
+                                                    MTL::Device &device, MTL::CommandQueue &queue);
+
+    /**
+     * Counters since the cache was created, and memory held by the images and textures in use.
+     */
+    ImageCacheStatistics statistics();
+
+    /**
+     * Hash of the format, levels and pixels of an image.
+     */
+    static uint64_t imageHash(const Image &image);
+
+private:
+    template<class T>
+    struct Entry {
+        std::weak_ptr<T> value;
+        size_t bytes{0};
+    };
+
+    std::shared_ptr<const Image> _find(uint64_t hash);
+
+    std::shared_ptr<const Image> _insert(uint64_t hash, std::unique_ptr<Image> image);
+
+    uint64_t _hash(const Image &image);
+
+    template<class T>
+    std::shared_ptr<T> _findTexture(uint64_t hash);
+
+    std::unique_ptr<Image> _readDisk(uint64_t hash);
+
+    void _writeDisk(uint64_t hash, const Image &image);
+
+    std::string _diskFile(uint64_t hash) const;
+
+    std::mutex _mutex;
+    std::string _diskDirectory{};
+    // path and flip to the hash of the file
+    std::unordered_map<std::string, uint64_t> _paths{};
+    std::unordered_map<uint64_t, Entry<const Image>> _images{};
+    // hash of every cached image, for the texture lookups
+    std::unordered_map<const Image *, uint64_t> _imageHashes{};
+    std::unordered_map<uint64_t, Entry<SampledTexture>> _textures{};
+    ImageCacheStatistics _statistics{};
+};
+
+}
+
+#endif /* image_cache_hpp */
@@ -38,6 +38,54 @@ static ktx_error_code_e KTX_APIENTRY optimal_tiling_callback(int mip_level,
     return KTX_SUCCESS;
 }
 
+/// ASTC formats in the order of VK_FORMAT_ASTC_4x4_UNORM_BLOCK... and GL_COMPRESSED_RGBA_ASTC_4x4_KHR...
+static const MTL::PixelFormat astc_formats[][2] = {
+    {MTL::PixelFormatASTC_4x4_LDR, MTL::PixelFormatASTC_4x4_sRGB},
+    {MTL::PixelFormatASTC_5x4_LDR, MTL::PixelFormatASTC_5x4_sRGB},
+    {MTL::PixelFormatASTC_5x5_LDR, MTL::PixelFormatASTC_5x5_sRGB},
+    {MTL::PixelFormatASTC_6x5_LDR, MTL::PixelFormatASTC_6x5_sRGB},
+    {MTL::PixelFormatASTC_6x6_LDR, MTL::PixelFormatASTC_6x6_sRGB},
+    {MTL::PixelFormatASTC_8x5_LDR, MTL::PixelFormatASTC_8x5_sRGB},
+    {MTL::PixelFormatASTC_8x6_LDR, MTL::PixelFormatASTC_8x6_sRGB},
+    {MTL::PixelFormatASTC_8x8_LDR, MTL::PixelFormatASTC_8x8_sRGB},
+    {MTL::PixelFormatASTC_10x5_LDR, MTL::PixelFormatASTC_10x5_sRGB},
+    {MTL::PixelFormatASTC_10x6_LDR, MTL::PixelFormatASTC_10x6_sRGB},
+    {MTL::PixelFormatASTC_10x8_LDR, MTL::PixelFormatASTC_10x8_sRGB},
+    {MTL::PixelFormatASTC_10x10_LDR, MTL::PixelFormatASTC_10x10_sRGB},
+    {MTL::PixelFormatASTC_12x10_LDR, MTL::PixelFormatASTC_12x10_sRGB},
+    {MTL::PixelFormatASTC_12x12_LDR, MTL::PixelFormatASTC_12x12_sRGB}};
+
+/// Pixel format of the RGBA8 and ASTC textures, others keep the default format.
+static bool to_pixel_format(ktxTexture *texture, MTL::PixelFormat &format) {
+    const uint32_t astc_count = sizeof(astc_formats) / sizeof(astc_formats[0]);
+    if (texture->classId == ktxTexture2_c) {
+        const uint32_t vk_format = reinterpret_cast<ktxTexture2 *>(texture)->vkFormat;
+        if (vk_format == 37 || vk_format == 43) {        // VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R8G8B8A8_SRGB
+            format = vk_format == 37 ? MTL::PixelFormatRGBA8Unorm : MTL::PixelFormatRGBA8Unorm_sRGB;
+            return true;
+        }
+        if (vk_format >= 157 && vk_format < 157 + astc_count * 2) {        // VK_FORMAT_ASTC_4x4_UNORM_BLOCK
+            format = astc_formats[(vk_format - 157) / 2][(vk_format - 157) % 2];
+            return true;
+        }
+    } else {
+        const uint32_t gl_format = reinterpret_cast<ktxTexture1 *>(texture)->glInternalformat;
+        if (gl_format == 0x8058 || gl_format == 0x8C43) {        // GL_RGBA8, GL_SRGB8_ALPHA8
+            format = gl_format == 0x8058 ? MTL::PixelFormatRGBA8Unorm : MTL::PixelFormatRGBA8Unorm_sRGB;
+            return true;
+        }
+        if (gl_format >= 0x93B0 && gl_format < 0x93B0 + astc_count) {        // GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+            format = astc_formats[gl_format - 0x93B0][0];
+            return true;
+        }
+        if (gl_format >= 0x93D0 && gl_format < 0x93D0 + astc_count) {        // GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR
+            format = astc_formats[gl_format - 0x93D0][1];
+            return true;
+        }
+    }
+    return false;
+}
+
 Ktx::Ktx(const std::vector<uint8_t> &data, bool flipY) :
 Image{} {
     auto data_buffer = reinterpret_cast<const ktx_uint8_t *>(data.data());
@@ -81,8 +129,10 @@ Image{} {
     }
     
     // Update format
-    // auto updated_format = ktxTexture_GetVkFormat(texture);
-    // setFormat(updated_format);
+    MTL::PixelFormat format;
+    if (to_pixel_format(texture, format)) {
+        setFormat(format);
+    }
     
     // Update mip levels
     auto &mipmap_levels = mipmaps();
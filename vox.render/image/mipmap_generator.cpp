@@ -0,0 +1,349 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "mipmap_generator.h"
+#include "color.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace vox {
+namespace {
+// destination rows filtered by one task
+constexpr uint32_t kRowsPerTask = 16;
+// resolution of the linear to sRGB table, fine enough to round to the nearest 8 bit value near black
+constexpr uint32_t kEncodeSteps = 16383;
+
+struct Tables {
+    Tables() {
+        for (uint32_t i = 0; i < 256; i++) {
+            unorm[i] = i / 255.f;
+            toLinear[i] = gammaToLinearSpace(i / 255.f);
+        }
+        for (uint32_t i = 0; i <= kEncodeSteps; i++) {
+            toGamma[i] = static_cast<uint8_t>(std::lround(linearToGammaSpace(float(i) / kEncodeSteps) * 255));
+        }
+    }
+
+    std::array<float, 256> unorm;
+    std::array<float, 256> toLinear;
+    std::array<uint8_t, kEncodeSteps + 1> toGamma;
+};
+
+const Tables &tables() {
+    static const Tables instance;
+    return instance;
+}
+
+// one RGBA texel in floats
+#if defined(__SSE2__)
+using Texel = __m128;
+
+inline Texel texelZero() {
+    return _mm_setzero_ps();
+}
+
+inline Texel texelLoad(const float *p) {
+    return _mm_loadu_ps(p);
+}
+
+inline void texelStore(float *p, Texel t) {
+    _mm_storeu_ps(p, t);
+}
+
+inline Texel texelMadd(Texel sum, Texel t, float w) {
+    return _mm_add_ps(sum, _mm_mul_ps(t, _mm_set1_ps(w)));
+}
+
+// clamps to [0, 1] and rounds t * scale to the nearest integers
+inline void texelQuantize(Texel t, const float *scale, int32_t *out) {
+    t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(1.f));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_cvtps_epi32(_mm_mul_ps(t, _mm_loadu_ps(scale))));
+}
+#else
+struct Texel {
+    float v[4];
+};
+
+inline Texel texelZero() {
+    return {{0, 0, 0, 0}};
+}
+
+inline Texel texelLoad(const float *p) {
+    return {{p[0], p[1], p[2], p[3]}};
+}
+
+inline void texelStore(float *p, const Texel &t) {
+    std::copy(t.v, t.v + 4, p);
+}
+
+inline Texel texelMadd(Texel sum, const Texel &t, float w) {
+    for (int i = 0; i < 4; i++) {
+        sum.v[i] += t.v[i] * w;
+    }
+    return sum;
+}
+
+inline void texelQuantize(const Texel &t, const float *scale, int32_t *out) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = static_cast<int32_t>(std::nearbyint(std::clamp(t.v[i], 0.f, 1.f) * scale[i]));
+    }
+}
+#endif
+
+float bessel0(float x) {
+    // power series of the modified Bessel function of the first kind, converges quickly for the window
+    float sum = 1;
+    float term = 1;
+    for (int k = 1; k < 20; k++) {
+        term *= (x * 0.5f / k) * (x * 0.5f / k);
+        sum += term;
+    }
+    return sum;
+}
+
+std::vector<float> filterWeights(MipmapOptions::Filter filter) {
+    if (filter == MipmapOptions::Filter::Box) {
+        return {0.5f, 0.5f};
+    }
+    // sinc windowed over two destination texels, sampled at the centers of 8 source texels
+    constexpr float kRadius = 2;
+    constexpr float kAlpha = 4;
+    std::vector<float> weights(8);
+    float sum = 0;
+    for (int i = 0; i < 8; i++) {
+        const float t = (i - 3.5f) * 0.5f;
+        const float sinc = std::sin(float(M_PI) * t) / (float(M_PI) * t);
+        const float window = bessel0(kAlpha * std::sqrt(1 - (t / kRadius) * (t / kRadius))) / bessel0(kAlpha);
+        weights[i] = sinc * window;
+        sum += weights[i];
+    }
+    for (auto &weight : weights) {
+        weight /= sum;
+    }
+    return weights;
+}
+
+// source texels weighted into each destination texel along one axis
+struct Footprint {
+    int taps;
+    // first source texel of every destination texel, taps past the edges are clamped
+    std::vector<int> first;
+    // taps weights of every destination texel
+    std::vector<float> weights;
+};
+
+Footprint footprint(MipmapOptions::Filter filter, const std::vector<float> &kernel, uint32_t sourceSize, uint32_t size) {
+    Footprint result;
+    if (sourceSize == size) {
+        // a dimension of 1 stays in place instead of halving
+        result.taps = 1;
+        for (uint32_t x = 0; x < size; x++) {
+            result.first.push_back(static_cast<int>(x));
+            result.weights.push_back(1);
+        }
+    } else if (filter == MipmapOptions::Filter::Box && sourceSize % 2 == 1) {
+        // 2n + 1 texels into n, every source texel adds the same total weight and the last one isn't dropped
+        result.taps = 3;
+        const float n = static_cast<float>(sourceSize);
+        for (uint32_t x = 0; x < size; x++) {
+            result.first.push_back(static_cast<int>(x) * 2);
+            result.weights.insert(result.weights.end(), {(size - x) / n, size / n, (x + 1) / n});
+        }
+    } else {
+        result.taps = static_cast<int>(kernel.size());
+        for (uint32_t x = 0; x < size; x++) {
+            result.first.push_back(static_cast<int>(x) * 2 + 1 - result.taps / 2);
+            result.weights.insert(result.weights.end(), kernel.begin(), kernel.end());
+        }
+    }
+    return result;
+}
+
+}
+
+MipmapGenerator::MipmapGenerator(const MipmapOptions &options) :
+_options(options),
+_weights(filterWeights(options.filter)) {
+}
+
+std::vector<Mipmap> MipmapGenerator::chain(uint32_t width, uint32_t height, size_t &size) {
+    std::vector<Mipmap> levels;
+    size = 0;
+    while (true) {
+        Mipmap mipmap{};
+        mipmap.level = static_cast<uint32_t>(levels.size());
+        mipmap.offset = static_cast<uint32_t>(size);
+        mipmap.extent = {width, height, 1u};
+        levels.push_back(mipmap);
+        size += size_t(width) * height * 4;
+        if (width == 1 && height == 1) {
+            break;
+        }
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+    return levels;
+}
+
+void MipmapGenerator::generate(uint8_t *data, const std::vector<Mipmap> &levels, bool parallel) const {
+    float coverage = 0;
+    if (_options.alphaCutoff > 0 && !levels.empty()) {
+        const auto &base = levels.front().extent;
+        coverage = _coverage(_alphaHistogram(data, base.width * base.height), _options.alphaCutoff, 1);
+    }
+    for (size_t i = 1; i < levels.size(); i++) {
+        const auto &source = levels[i - 1];
+        const auto &destination = levels[i];
+        _downsample(data + source.offset,
+                    static_cast<uint32_t>(source.extent.width), static_cast<uint32_t>(source.extent.height),
+                    data + destination.offset,
+                    static_cast<uint32_t>(destination.extent.width), static_cast<uint32_t>(destination.extent.height),
+                    parallel);
+        if (_options.alphaCutoff > 0) {
+            _preserveCoverage(data + destination.offset, destination.extent.width * destination.extent.height, coverage);
+        }
+    }
+}
+
+void MipmapGenerator::_downsample(const uint8_t *source, uint32_t sourceWidth, uint32_t sourceHeight,
+                                  uint8_t *destination, uint32_t width, uint32_t height, bool parallel) const {
+    const auto &lut = tables();
+    const float *colorTable = _options.srgb ? lut.toLinear.data() : lut.unorm.data();
+    const float *alphaTable = lut.unorm.data();
+    const float colorScale = _options.srgb ? float(kEncodeSteps) : 255.f;
+    const float scale[4] = {colorScale, colorScale, colorScale, 255.f};
+    const auto columns = footprint(_options.filter, _weights, sourceWidth, width);
+    const auto rows = footprint(_options.filter, _weights, sourceHeight, height);
+
+    auto filterRows = [&](size_t task) {
+        const int y0 = static_cast<int>(task * kRowsPerTask);
+        const int y1 = std::min<int>(y0 + kRowsPerTask, height);
+        const int rowBegin = rows.first[y0];
+        const int rowEnd = rows.first[y1 - 1] + rows.taps;
+
+        // source rows in linear floats, then filtered horizontally to the destination width
+        std::vector<float> linear(size_t(sourceWidth) * 4);
+        std::vector<float> horizontal(size_t(rowEnd - rowBegin) * width * 4);
+        for (int row = rowBegin; row < rowEnd; row++) {
+            const uint8_t *texels = source + size_t(std::clamp<int>(row, 0, sourceHeight - 1)) * sourceWidth * 4;
+            for (uint32_t x = 0; x < sourceWidth; x++) {
+                linear[x * 4 + 0] = colorTable[texels[x * 4 + 0]];
+                linear[x * 4 + 1] = colorTable[texels[x * 4 + 1]];
+                linear[x * 4 + 2] = colorTable[texels[x * 4 + 2]];
+                linear[x * 4 + 3] = alphaTable[texels[x * 4 + 3]];
+            }
+            float *filtered = horizontal.data() + size_t(row - rowBegin) * width * 4;
+            const int taps = columns.taps;
+            for (uint32_t x = 0; x < width; x++) {
+                const float *weights = columns.weights.data() + size_t(x) * taps;
+                Texel sum = texelZero();
+                const int left = columns.first[x];
+                if (left >= 0 && left + taps <= static_cast<int>(sourceWidth)) {
+                    const float *texel = linear.data() + left * 4;
+                    for (int k = 0; k < taps; k++) {
+                        sum = texelMadd(sum, texelLoad(texel + k * 4), weights[k]);
+                    }
+                } else {
+                    for (int k = 0; k < taps; k++) {
+                        const int column = std::clamp<int>(left + k, 0, sourceWidth - 1);
+                        sum = texelMadd(sum, texelLoad(linear.data() + column * 4), weights[k]);
+                    }
+                }
+                texelStore(filtered + x * 4, sum);
+            }
+        }
+
+        int32_t quantized[4];
+        for (int y = y0; y < y1; y++) {
+            uint8_t *texels = destination + size_t(y) * width * 4;
+            const int top = rows.first[y] - rowBegin;
+            const float *weights = rows.weights.data() + size_t(y) * rows.taps;
+            for (uint32_t x = 0; x < width; x++) {
+                Texel sum = texelZero();
+                for (int k = 0; k < rows.taps; k++) {
+                    sum = texelMadd(sum, texelLoad(horizontal.data() + (size_t(top + k) * width + x) * 4), weights[k]);
+                }
+                texelQuantize(sum, scale, quantized);
+                if (_options.srgb) {
+                    texels[x * 4 + 0] = lut.toGamma[quantized[0]];
+                    texels[x * 4 + 1] = lut.toGamma[quantized[1]];
+                    texels[x * 4 + 2] = lut.toGamma[quantized[2]];
+                } else {
+                    texels[x * 4 + 0] = static_cast<uint8_t>(quantized[0]);
+                    texels[x * 4 + 1] = static_cast<uint8_t>(quantized[1]);
+                    texels[x * 4 + 2] = static_cast<uint8_t>(quantized[2]);
+                }
+                texels[x * 4 + 3] = static_cast<uint8_t>(quantized[3]);
+            }
+        }
+    };
+
+    const size_t tasks = (height + kRowsPerTask - 1) / kRowsPerTask;
+    if (parallel) {
+        ThreadPool::shared().parallelFor(tasks, filterRows);
+    } else {
+        for (size_t task = 0; task < tasks; task++) {
+            filterRows(task);
+        }
+    }
+}
+
+MipmapGenerator::Histogram MipmapGenerator::_alphaHistogram(const uint8_t *data, size_t texels) {
+    Histogram histogram{};
+    for (size_t i = 0; i < texels; i++) {
+        histogram[data[i * 4 + 3]]++;
+    }
+    return histogram;
+}
+
+float MipmapGenerator::_coverage(const Histogram &histogram, float cutoff, float scale) {
+    size_t texels = 0;
+    size_t passed = 0;
+    const float reference = cutoff * 255;
+    for (uint32_t alpha = 0; alpha < 256; alpha++) {
+        texels += histogram[alpha];
+        if (alpha * scale >= reference) {
+            passed += histogram[alpha];
+        }
+    }
+    return texels > 0 ? float(passed) / texels : 0;
+}
+
+void MipmapGenerator::_preserveCoverage(uint8_t *data, size_t texels, float coverage) const {
+    // the coverage of scaled alpha grows with the scale, bisect for the scale which matches the base level
+    const auto histogram = _alphaHistogram(data, texels);
+    float low = 0;
+    float high = 4;
+    float best = 1;
+    float bestError = std::abs(_coverage(histogram, _options.alphaCutoff, 1) - coverage);
+    for (int i = 0; i < 16; i++) {
+        const float mid = (low + high) * 0.5f;
+        const float current = _coverage(histogram, _options.alphaCutoff, mid);
+        if (std::abs(current - coverage) < bestError) {
+            best = mid;
+            bestError = std::abs(current - coverage);
+        }
+        if (current < coverage) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    if (best == 1) {
+        return;
+    }
+    for (size_t i = 0; i < texels; i++) {
+        data[i * 4 + 3] = static_cast<uint8_t>(std::min(255.f, std::nearbyint(data[i * 4 + 3] * best)));
+    }
+}
+
+}
@@ -0,0 +1,73 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef mipmap_generator_hpp
+#define mipmap_generator_hpp
+
+#include "image.h"
+#include <array>
+
+namespace vox {
+struct MipmapOptions {
+    enum class Filter {
+        /** Average of 2x2 texels, along odd dimensions 3 texels weighted so that every source texel counts the same. */
+        Box,
+        /** Kaiser windowed sinc over 8x8 texels, sharper minification without aliasing. */
+        Kaiser
+    };
+    Filter filter = Filter::Box;
+
+    /** Filter the color channels in linear space, for sRGB color textures. Alpha is always linear. */
+    bool srgb = false;
+
+    /**
+     * Alpha test reference in [0, 1], which keeps the fraction of texels passing the test equal to the base level.
+     * @remarks 0 leaves alpha as filtered.
+     */
+    float alphaCutoff = 0;
+};
+
+/**
+ * Builds the mip chain of an RGBA8 image on the CPU.
+ */
+class MipmapGenerator {
+public:
+    explicit MipmapGenerator(const MipmapOptions &options = {});
+
+    /**
+     * Levels of a full chain down to 1x1, tightly packed one after the other.
+     * @param size - Bytes of the whole chain
+     */
+    static std::vector<Mipmap> chain(uint32_t width, uint32_t height, size_t &size);
+
+    /**
+     * Fills level 1 and below, each from the level above.
+     * @param data - Chain laid out by chain(), level 0 holds the image
+     * @param parallel - Filter rows on the shared thread pool, the result is identical to the serial one
+     */
+    void generate(uint8_t *data, const std::vector<Mipmap> &levels, bool parallel = true) const;
+
+private:
+    void _downsample(const uint8_t *source, uint32_t sourceWidth, uint32_t sourceHeight,
+                     uint8_t *destination, uint32_t width, uint32_t height, bool parallel) const;
+
+    using Histogram = std::array<size_t, 256>;
+
+    void _preserveCoverage(uint8_t *data, size_t texels, float coverage) const;
+
+    static Histogram _alphaHistogram(const uint8_t *data, size_t texels);
+
+    // fraction of texels with alpha * scale at least cutoff
+    static float _coverage(const Histogram &histogram, float cutoff, float scale);
+
+    MipmapOptions _options;
+    // taps of the 2:1 filter, on source texels -taps / 2 + 1 ... taps / 2 around the pair of each destination texel
+    std::vector<float> _weights;
+};
+
+}
+
+#endif /* mipmap_generator_hpp */
@@ -26,18 +26,6 @@ _brdfTextureProperty(Shader::createProperty("u_env_brdfTexture", ShaderDataGroup
     //                           value->engine()->resourceLoader()->createBRDFLookupTable());
 }
 
-void AmbientLight::registerUploader(Scene *scene) {
-    _scene->registerFragmentUploader<EnvMapLight>([](const EnvMapLight &x, size_t location,
-                                                     MTL::RenderCommandEncoder &encoder) {
-        encoder.setFragmentBytes(&x, sizeof(EnvMapLight), location);
-    });
-    
-    _scene->registerFragmentUploader<std::array<float, 27>>([](const std::array<float, 27> &x, size_t location,
-                                                               MTL::RenderCommandEncoder &encoder) {
-        encoder.setFragmentBytes(&x, sizeof(std::array<float, 27>), location);
-    });
-}
-
 DiffuseMode AmbientLight::diffuseMode() const {
     return _diffuseMode;
 }
@@ -160,7 +148,7 @@ void AmbientLight::setBRDFTexture(const SampledTexture2DPtr &value) {
     
 }
 
-std::array<float, 27> AmbientLight::_preComputeSH(const SphericalHarmonics3 &sh) {
+std::array<simd_float3, 9> AmbientLight::_preComputeSH(const SphericalHarmonics3 &sh) {
     /**
      * Basis constants
      *
@@ -186,39 +174,17 @@ std::array<float, 27> AmbientLight::_preComputeSH(const SphericalHarmonics3 &sh)
      */
     
     const auto &src = sh.coefficients();
-    std::array<float, 27> out;
-    // l0
-    out[0] = src[0] * 0.886227; // kernel0 * basis0 = 0.886227
-    out[1] = src[1] * 0.886227;
-    out[2] = src[2] * 0.886227;
-    
-    // l1
-    out[3] = src[3] * -1.023327; // kernel1 * basis1 = -1.023327;
-    out[4] = src[4] * -1.023327;
-    out[5] = src[5] * -1.023327;
-    out[6] = src[6] * 1.023327; // kernel1 * basis2 = 1.023327
-    out[7] = src[7] * 1.023327;
-    out[8] = src[8] * 1.023327;
-    out[9] = src[9] * -1.023327; // kernel1 * basis3 = -1.023327
-    out[10] = src[10] * -1.023327;
-    out[11] = src[11] * -1.023327;
-    
-    // l2
-    out[12] = src[12] * 0.858086; // kernel2 * basis4 = 0.858086
-    out[13] = src[13] * 0.858086;
-    out[14] = src[14] * 0.858086;
-    out[15] = src[15] * -0.858086; // kernel2 * basis5 = -0.858086
-    out[16] = src[16] * -0.858086;
-    out[17] = src[17] * -0.858086;
-    out[18] = src[18] * 0.247708; // kernel2 * basis6 = 0.247708
-    out[19] = src[19] * 0.247708;
-    out[20] = src[20] * 0.247708;
-    out[21] = src[21] * -0.858086; // kernel2 * basis7 = -0.858086
-    out[22] = src[22] * -0.858086;
-    out[23] = src[23] * -0.858086;
-    out[24] = src[24] * 0.429042; // kernel2 * basis8 = 0.429042
-    out[25] = src[25] * 0.429042;
-    out[26] = src[26] * 0.429042;
+    // kernel * basis of each coefficient
+    const std::array<float, 9> scale = {
+        0.886227, // l0
+        -1.023327, 1.023327, -1.023327, // l1
+        0.858086, -0.858086, 0.247708, -0.858086, 0.429042 // l2
+    };
+    // the shaders read constant float3 *, which has the stride of a float4
+    std::array<simd_float3, 9> out;
+    for (size_t i = 0; i < out.size(); i++) {
+        out[i] = simd_make_float3(src[i * 3], src[i * 3 + 1], src[i * 3 + 2]) * scale[i];
+    }
     
     return out;
 }
@@ -42,8 +42,6 @@ class AmbientLight {
 public:
     AmbientLight(Scene *value);
     
-    void registerUploader(Scene *scene);
-    
     /**
      * Diffuse mode of ambient light.
      */
@@ -115,7 +113,7 @@ public:
     void setBRDFTexture(const SampledTexture2DPtr &value);
     
 private:
-    std::array<float, 27> _preComputeSH(const SphericalHarmonics3 &sh);
+    std::array<simd_float3, 9> _preComputeSH(const SphericalHarmonics3 &sh);
     
     ShaderProperty _envMapProperty;
     ShaderProperty _diffuseSHProperty;
@@ -128,7 +126,6 @@ private:
     
     DiffuseMode _diffuseMode = DiffuseMode::SolidColor;
     SphericalHarmonics3 _diffuseSphericalHarmonics;
-    std::array<float, 27> _shArray{};
     SampledTextureCubePtr _diffuseTexture{nullptr};
     
     bool _specularTextureDecodeRGBM{false};
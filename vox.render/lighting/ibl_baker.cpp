@@ -0,0 +1,578 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "ibl_baker.h"
+#include "color.h"
+#include "thread_pool.h"
+#include "loader/mesh_cache.h"
+#include "mesh/vertex_compression.h"
+#include "texture/sampled_texturecube.h"
+#include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace vox {
+namespace {
+constexpr uint32_t kCacheMagic = 0x4c424958; // "XIBL"
+constexpr uint32_t kCacheVersion = 1;
+// rows of a face filtered by one task
+constexpr uint32_t kRowsPerTask = 8;
+// SH3 keeps only the lowest frequencies, larger environments are projected from a filtered level
+constexpr uint32_t kSHSize = 64;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t hash;
+    uint32_t size;
+    uint32_t levelCount;
+};
+
+// one RGBA texel in floats
+#if defined(__SSE2__)
+using Texel = __m128;
+
+inline Texel texelZero() {
+    return _mm_setzero_ps();
+}
+
+inline Texel texelLoad(const float *p) {
+    return _mm_loadu_ps(p);
+}
+
+inline void texelStore(float *p, Texel t) {
+    _mm_storeu_ps(p, t);
+}
+
+inline Texel texelMadd(Texel sum, Texel t, float w) {
+    return _mm_add_ps(sum, _mm_mul_ps(t, _mm_set1_ps(w)));
+}
+#else
+struct Texel {
+    float v[4];
+};
+
+inline Texel texelZero() {
+    return {{0, 0, 0, 0}};
+}
+
+inline Texel texelLoad(const float *p) {
+    return {{p[0], p[1], p[2], p[3]}};
+}
+
+inline void texelStore(float *p, const Texel &t) {
+    std::copy(t.v, t.v + 4, p);
+}
+
+inline Texel texelMadd(Texel sum, const Texel &t, float w) {
+    for (int i = 0; i < 4; i++) {
+        sum.v[i] += t.v[i] * w;
+    }
+    return sum;
+}
+#endif
+
+// image holding baked half floats
+class HalfImage : public Image {
+public:
+    HalfImage(std::vector<uint8_t> &&data, std::vector<Mipmap> &&mipmaps) :
+    Image(std::move(data), std::move(mipmaps)) {
+        setFormat(MTL::PixelFormatRGBA16Float);
+    }
+};
+
+// GGX direction around +Z with its weight and the source level it is read from
+struct Sample {
+    float x, y, z;
+    float weight;
+    float lod;
+};
+
+// same mapping as convertUVToDirection in pbr_common.metal, u and v in [-1, 1]
+Vector3F faceDirection(uint32_t face, float u, float v) {
+    switch (face) {
+        case 0:
+            return Vector3F(1, v, -u);
+        case 1:
+            return Vector3F(-1, v, u);
+        case 2:
+            return Vector3F(u, 1, -v);
+        case 3:
+            return Vector3F(u, -1, v);
+        case 4:
+            return Vector3F(u, v, 1);
+        default:
+            return Vector3F(-u, v, -1);
+    }
+}
+
+// face and texture coordinates in [0, 1] of a direction
+void directionToFace(const Vector3F &d, uint32_t &face, float &s, float &t) {
+    const float ax = std::abs(d.x);
+    const float ay = std::abs(d.y);
+    const float az = std::abs(d.z);
+    float u, v;
+    if (ax >= ay && ax >= az) {
+        face = d.x > 0 ? 0 : 1;
+        u = (d.x > 0 ? -d.z : d.z) / ax;
+        v = d.y / ax;
+    } else if (ay >= az) {
+        face = d.y > 0 ? 2 : 3;
+        u = d.x / ay;
+        v = (d.y > 0 ? -d.z : d.z) / ay;
+    } else {
+        face = d.z > 0 ? 4 : 5;
+        u = (d.z > 0 ? d.x : -d.x) / az;
+        v = d.y / az;
+    }
+    s = (u + 1) * 0.5f;
+    t = (1 - v) * 0.5f;
+}
+
+// bilinear inside one face, clamped at its edges
+inline Texel bilinear(const EnvironmentCube &level, uint32_t face, float s, float t, float weight, Texel sum) {
+    const float *pixels = level.faces[face].data();
+    const auto last = static_cast<int32_t>(level.size) - 1;
+    const float x = s * level.size - 0.5f;
+    const float y = t * level.size - 0.5f;
+    const float fx = std::floor(x);
+    const float fy = std::floor(y);
+    const float wx = x - fx;
+    const float wy = y - fy;
+    const int32_t x0 = std::clamp(static_cast<int32_t>(fx), 0, last);
+    const int32_t x1 = std::clamp(static_cast<int32_t>(fx) + 1, 0, last);
+    const int32_t y0 = std::clamp(static_cast<int32_t>(fy), 0, last);
+    const int32_t y1 = std::clamp(static_cast<int32_t>(fy) + 1, 0, last);
+    const float *row0 = pixels + size_t(y0) * level.size * 4;
+    const float *row1 = pixels + size_t(y1) * level.size * 4;
+    sum = texelMadd(sum, texelLoad(row0 + x0 * 4), weight * (1 - wx) * (1 - wy));
+    sum = texelMadd(sum, texelLoad(row0 + x1 * 4), weight * wx * (1 - wy));
+    sum = texelMadd(sum, texelLoad(row1 + x0 * 4), weight * (1 - wx) * wy);
+    sum = texelMadd(sum, texelLoad(row1 + x1 * 4), weight * wx * wy);
+    return sum;
+}
+
+// linear between the two levels around lod
+inline Texel trilinear(const std::vector<EnvironmentCube> &chain, const Vector3F &direction, float lod, float weight,
+                       Texel sum) {
+    uint32_t face;
+    float s, t;
+    directionToFace(direction, face, s, t);
+    lod = std::clamp(lod, 0.f, float(chain.size() - 1));
+    const auto level = static_cast<uint32_t>(lod);
+    const float fraction = lod - level;
+    sum = bilinear(chain[level], face, s, t, weight * (1 - fraction), sum);
+    if (fraction > 0) {
+        sum = bilinear(chain[level + 1], face, s, t, weight * fraction, sum);
+    }
+    return sum;
+}
+
+float radicalInverse(uint32_t bits) {
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10f;
+}
+
+/**
+ * Light directions of the GGX lobe for N = V, as PrefilterEnvMap in pbr_common.metal samples it.
+ * Every sample reads the source level whose texels cover the solid angle of the sample,
+ * which removes the noise of a few samples (GPU Gems 3, chapter 20).
+ */
+std::vector<Sample> ggxSamples(float roughness, uint32_t sampleCount, uint32_t sourceSize) {
+    const float a = roughness * roughness;
+    const float a2 = a * a;
+    const float texelSolidAngle = 4 * float(M_PI) / (6.f * sourceSize * sourceSize);
+    std::vector<Sample> samples;
+    float totalWeight = 0;
+    for (uint32_t i = 0; i < sampleCount; i++) {
+        const float phi = 2 * float(M_PI) * float(i) / float(sampleCount);
+        const float xi = radicalInverse(i);
+        const float cosTheta = std::sqrt((1 - xi) / (1 + (a2 - 1) * xi));
+        const float sinTheta = std::sqrt(1 - cosTheta * cosTheta);
+        // L = 2 (V.H) H - V with V = N = +Z
+        const float nol = 2 * cosTheta * cosTheta - 1;
+        if (nol <= 0) {
+            continue;
+        }
+        const float denominator = cosTheta * cosTheta * (a2 - 1) + 1;
+        const float pdf = a2 / (float(M_PI) * denominator * denominator) / 4;
+        const float sampleSolidAngle = 1 / (float(sampleCount) * pdf + 1e-6f);
+        const float lod = std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1, 0.f);
+        samples.push_back({2 * cosTheta * sinTheta * std::cos(phi), 2 * cosTheta * sinTheta * std::sin(phi), nol, nol, lod});
+        totalWeight += nol;
+    }
+    for (auto &sample : samples) {
+        sample.weight /= totalWeight;
+    }
+    return samples;
+}
+
+// solid angle of the part of a face between its center and (x, y), in [-1, 1]
+float areaElement(float x, float y) {
+    return std::atan2(x * y, std::sqrt(x * x + y * y + 1));
+}
+
+// texels of level 0 in linear RGBA floats
+std::vector<float> decodeTexels(const Image &image) {
+    const auto &extent = image.extent();
+    const size_t count = size_t(extent.width) * extent.height;
+    const uint8_t *source = image.data().data() + image.mipmaps().at(0).offset;
+    std::vector<float> texels(count * 4);
+    switch (image.format()) {
+        case MTL::PixelFormatRGBA8Unorm:
+        case MTL::PixelFormatRGBA8Unorm_sRGB:
+        case MTL::PixelFormatBGRA8Unorm:
+        case MTL::PixelFormatBGRA8Unorm_sRGB: {
+            const bool srgb = image.format() == MTL::PixelFormatRGBA8Unorm_sRGB ||
+            image.format() == MTL::PixelFormatBGRA8Unorm_sRGB;
+            const bool bgra = image.format() == MTL::PixelFormatBGRA8Unorm ||
+            image.format() == MTL::PixelFormatBGRA8Unorm_sRGB;
+            std::array<float, 256> table{};
+            for (uint32_t i = 0; i < 256; i++) {
+                table[i] = srgb ? gammaToLinearSpace(i / 255.f) : i / 255.f;
+            }
+            for (size_t i = 0; i < count; i++) {
+                const uint8_t *texel = source + i * 4;
+                texels[i * 4 + 0] = table[texel[bgra ? 2 : 0]];
+                texels[i * 4 + 1] = table[texel[1]];
+                texels[i * 4 + 2] = table[texel[bgra ? 0 : 2]];
+                texels[i * 4 + 3] = texel[3] / 255.f;
+            }
+            break;
+        }
+        case MTL::PixelFormatRGBA16Float:
+            for (size_t i = 0; i < count * 4; i++) {
+                uint16_t half;
+                std::memcpy(&half, source + i * 2, sizeof(half));
+                texels[i] = compression::decodeHalf(half);
+            }
+            break;
+        case MTL::PixelFormatRGBA32Float:
+            std::memcpy(texels.data(), source, texels.size() * sizeof(float));
+            break;
+        default:
+            throw std::runtime_error("Unsupported environment format");
+    }
+    return texels;
+}
+
+// full chain of RGBA16Float levels of a face, tightly packed
+std::vector<Mipmap> specularLevels(uint32_t size, size_t &bytes) {
+    std::vector<Mipmap> levels;
+    bytes = 0;
+    for (uint32_t level = 0; level == 0 || (size >> level) > 0; level++) {
+        const uint32_t levelSize = std::max(size >> level, 1u);
+        levels.push_back({level, static_cast<uint32_t>(bytes), {levelSize, levelSize, 1}});
+        bytes += size_t(levelSize) * levelSize * 8;
+    }
+    return levels;
+}
+
+}
+
+//MARK: - Environment
+EnvironmentCube IBLBaker::fromFaces(const std::array<const Image *, 6> &faces) {
+    EnvironmentCube environment;
+    environment.size = faces[0] ? static_cast<uint32_t>(faces[0]->extent().width) : 0;
+    for (size_t i = 0; i < faces.size(); i++) {
+        const Image *face = faces[i];
+        if (face == nullptr || face->extent().width != environment.size || face->extent().height != environment.size) {
+            throw std::runtime_error("Environment faces must be square and of the same size");
+        }
+        environment.faces[i] = decodeTexels(*face);
+    }
+    return environment;
+}
+
+EnvironmentCube IBLBaker::fromEquirectangular(const Image &image, uint32_t size) {
+    const auto width = static_cast<uint32_t>(image.extent().width);
+    const auto height = static_cast<uint32_t>(image.extent().height);
+    const auto texels = decodeTexels(image);
+
+    EnvironmentCube environment;
+    environment.size = size;
+    for (auto &face : environment.faces) {
+        face.resize(size_t(size) * size * 4);
+    }
+    ThreadPool::shared().parallelFor(6 * size, [&](size_t task) {
+        const auto face = static_cast<uint32_t>(task / size);
+        const auto y = static_cast<uint32_t>(task % size);
+        float *row = environment.faces[face].data() + size_t(y) * size * 4;
+        for (uint32_t x = 0; x < size; x++) {
+            const auto direction = faceDirection(face, 2 * (x + 0.5f) / size - 1, 1 - 2 * (y + 0.5f) / size).normalized();
+            const float u = 0.5f + std::atan2(direction.x, -direction.z) / (2 * float(M_PI));
+            const float v = std::acos(std::clamp(direction.y, -1.f, 1.f)) / float(M_PI);
+            // bilinear, wrapping around horizontally
+            const float px = u * width - 0.5f;
+            const float py = std::clamp(v * height - 0.5f, 0.f, float(height - 1));
+            const float fx = std::floor(px);
+            const auto y0 = static_cast<uint32_t>(py);
+            const uint32_t y1 = std::min(y0 + 1, height - 1);
+            const uint32_t x0 = (static_cast<int32_t>(fx) % int32_t(width) + width) % width;
+            const uint32_t x1 = (x0 + 1) % width;
+            const float wx = px - fx;
+            const float wy = py - y0;
+            Texel sum = texelZero();
+            sum = texelMadd(sum, texelLoad(&texels[(size_t(y0) * width + x0) * 4]), (1 - wx) * (1 - wy));
+            sum = texelMadd(sum, texelLoad(&texels[(size_t(y0) * width + x1) * 4]), wx * (1 - wy));
+            sum = texelMadd(sum, texelLoad(&texels[(size_t(y1) * width + x0) * 4]), (1 - wx) * wy);
+            sum = texelMadd(sum, texelLoad(&texels[(size_t(y1) * width + x1) * 4]), wx * wy);
+            texelStore(row + x * 4, sum);
+        }
+    });
+    return environment;
+}
+
+std::vector<EnvironmentCube> IBLBaker::_chain(const EnvironmentCube &environment) {
+    std::vector<EnvironmentCube> chain{environment};
+    while (chain.back().size > 1) {
+        const auto &source = chain.back();
+        EnvironmentCube level;
+        level.size = source.size / 2;
+        ThreadPool::shared().parallelFor(6, [&](size_t face) {
+            const float *pixels = source.faces[face].data();
+            auto &destination = level.faces[face];
+            destination.resize(size_t(level.size) * level.size * 4);
+            for (uint32_t y = 0; y < level.size; y++) {
+                const float *row0 = pixels + size_t(2 * y) * source.size * 4;
+                const float *row1 = row0 + size_t(source.size) * 4;
+                for (uint32_t x = 0; x < level.size; x++) {
+                    Texel sum = texelZero();
+                    sum = texelMadd(sum, texelLoad(row0 + 8 * x), 0.25f);
+                    sum = texelMadd(sum, texelLoad(row0 + 8 * x + 4), 0.25f);
+                    sum = texelMadd(sum, texelLoad(row1 + 8 * x), 0.25f);
+                    sum = texelMadd(sum, texelLoad(row1 + 8 * x + 4), 0.25f);
+                    texelStore(&destination[(size_t(y) * level.size + x) * 4], sum);
+                }
+            }
+        });
+        chain.emplace_back(std::move(level));
+    }
+    return chain;
+}
+
+//MARK: - Diffuse
+SphericalHarmonics3 IBLBaker::projectSH(const EnvironmentCube &environment) {
+    const uint32_t size = environment.size;
+    const uint32_t blocks = (size + kRowsPerTask - 1) / kRowsPerTask;
+    std::vector<std::array<float, 27>> partials(6 * blocks);
+    ThreadPool::shared().parallelFor(partials.size(), [&](size_t task) {
+        const auto face = static_cast<uint32_t>(task / blocks);
+        const auto begin = static_cast<uint32_t>(task % blocks) * kRowsPerTask;
+        const uint32_t end = std::min(begin + kRowsPerTask, size);
+        SphericalHarmonics3 sh;
+        const float texel = 2.f / size;
+        for (uint32_t y = begin; y < end; y++) {
+            const float *row = environment.faces[face].data() + size_t(y) * size * 4;
+            const float v0 = 1 - y * texel;
+            for (uint32_t x = 0; x < size; x++) {
+                const float u0 = x * texel - 1;
+                const float solidAngle = std::abs(areaElement(u0, v0) - areaElement(u0, v0 - texel) -
+                                                  areaElement(u0 + texel, v0) + areaElement(u0 + texel, v0 - texel));
+                const auto direction = faceDirection(face, u0 + 0.5f * texel, v0 - 0.5f * texel).normalized();
+                sh.addLight(direction, Color(row[x * 4], row[x * 4 + 1], row[x * 4 + 2]), solidAngle);
+            }
+        }
+        partials[task] = sh.coefficients();
+    });
+
+    // summed in order, the result does not depend on the scheduling
+    std::array<float, 27> coefficients{};
+    for (const auto &partial : partials) {
+        for (size_t i = 0; i < coefficients.size(); i++) {
+            coefficients[i] += partial[i];
+        }
+    }
+    return SphericalHarmonics3(coefficients);
+}
+
+//MARK: - Specular
+std::array<std::unique_ptr<Image>, 6> IBLBaker::prefilterSpecular(const EnvironmentCube &environment,
+                                                                  uint32_t size, uint32_t sampleCount) {
+    return _prefilter(_chain(environment), size, sampleCount);
+}
+
+std::array<std::unique_ptr<Image>, 6> IBLBaker::_prefilter(const std::vector<EnvironmentCube> &chain,
+                                                           uint32_t size, uint32_t sampleCount) {
+    size_t bytes;
+    const auto levels = specularLevels(size, bytes);
+    std::array<std::vector<uint8_t>, 6> faces;
+    for (auto &face : faces) {
+        face.resize(bytes);
+    }
+
+    // level 0 is the environment resampled, every other one a GGX lobe of its roughness
+    const uint32_t sourceSize = chain[0].size;
+    const float baseLod = std::max(std::log2(float(sourceSize) / size), 0.f);
+    std::vector<std::vector<Sample>> samples(levels.size());
+    for (size_t level = 1; level < levels.size(); level++) {
+        samples[level] = ggxSamples(float(level) / float(levels.size() - 1), sampleCount, sourceSize);
+    }
+
+    struct Task {
+        uint32_t level;
+        uint32_t face;
+        uint32_t begin;
+        uint32_t end;
+    };
+    std::vector<Task> tasks;
+    // rough levels are small but cost the most per texel, they go first
+    for (auto level = static_cast<uint32_t>(levels.size()); level-- > 0;) {
+        const auto levelSize = static_cast<uint32_t>(levels[level].extent.width);
+        for (uint32_t face = 0; face < 6; face++) {
+            for (uint32_t begin = 0; begin < levelSize; begin += kRowsPerTask) {
+                tasks.push_back({level, face, begin, std::min(begin + kRowsPerTask, levelSize)});
+            }
+        }
+    }
+
+    ThreadPool::shared().parallelFor(tasks.size(), [&](size_t index) {
+        const auto &task = tasks[index];
+        const auto &level = levels[task.level];
+        const auto levelSize = static_cast<uint32_t>(level.extent.width);
+        const auto &lobe = samples[task.level];
+        uint8_t *destination = faces[task.face].data() + level.offset;
+        float texel[4];
+        for (uint32_t y = task.begin; y < task.end; y++) {
+            for (uint32_t x = 0; x < levelSize; x++) {
+                const auto n = faceDirection(task.face, 2 * (x + 0.5f) / levelSize - 1,
+                                             1 - 2 * (y + 0.5f) / levelSize).normalized();
+                Texel sum = texelZero();
+                if (task.level == 0) {
+                    sum = trilinear(chain, n, baseLod, 1, sum);
+                } else {
+                    const Vector3F up = std::abs(n.z) < 0.999f ? Vector3F(0, 0, 1) : Vector3F(1, 0, 0);
+                    const auto tangentX = up.cross(n).normalized();
+                    const auto tangentY = n.cross(tangentX);
+                    for (const auto &sample : lobe) {
+                        const auto l = tangentX * sample.x + tangentY * sample.y + n * sample.z;
+                        sum = trilinear(chain, l, sample.lod, sample.weight, sum);
+                    }
+                }
+                texelStore(texel, sum);
+                uint16_t halves[4];
+                for (int c = 0; c < 4; c++) {
+                    halves[c] = compression::encodeHalf(texel[c]);
+                }
+                std::memcpy(destination + (size_t(y) * levelSize + x) * 8, halves, sizeof(halves));
+            }
+        }
+    });
+
+    std::array<std::unique_ptr<Image>, 6> images;
+    for (size_t i = 0; i < faces.size(); i++) {
+        images[i] = std::make_unique<HalfImage>(std::move(faces[i]), std::vector<Mipmap>(levels));
+    }
+    return images;
+}
+
+//MARK: - Bake
+BakedEnvironment IBLBaker::bake(const EnvironmentCube &environment, const IBLBakeOptions &options) {
+    const uint32_t parameters[4] = {kCacheVersion, environment.size, options.specularSize, options.sampleCount};
+    uint64_t hash = loader::contentHash(parameters, sizeof(parameters), kCacheMagic);
+    for (const auto &face : environment.faces) {
+        hash = loader::contentHash(face.data(), face.size() * sizeof(float), hash);
+    }
+    std::string filename;
+    if (!options.cacheDirectory.empty()) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.ibl", static_cast<unsigned long long>(hash));
+        filename = options.cacheDirectory + "/" + name;
+    }
+
+    BakedEnvironment baked;
+    if (!filename.empty() && _readCache(filename, hash, options.specularSize, baked)) {
+        return baked;
+    }
+    const auto chain = _chain(environment);
+    const auto shLevel = std::find_if(chain.begin(), chain.end(), [](const EnvironmentCube &level) {
+        return level.size <= kSHSize;
+    });
+    baked.diffuseSphericalHarmonics = projectSH(*shLevel);
+    baked.specularFaces = _prefilter(chain, options.specularSize, options.sampleCount);
+    if (!filename.empty()) {
+        _writeCache(filename, hash, options.specularSize, baked);
+    }
+    return baked;
+}
+
+bool IBLBaker::_readCache(const std::string &filename, uint64_t hash, uint32_t size, BakedEnvironment &baked) {
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    size_t bytes;
+    auto levels = specularLevels(size, bytes);
+    CacheHeader header{};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || header.magic != kCacheMagic || header.version != kCacheVersion || header.hash != hash ||
+        header.size != size || header.levelCount != levels.size()) {
+        return false;
+    }
+    std::array<float, 27> coefficients{};
+    file.read(reinterpret_cast<char *>(coefficients.data()), sizeof(coefficients));
+    std::array<std::unique_ptr<Image>, 6> faces;
+    for (auto &face : faces) {
+        std::vector<uint8_t> data(bytes);
+        file.read(reinterpret_cast<char *>(data.data()), data.size());
+        face = std::make_unique<HalfImage>(std::move(data), std::vector<Mipmap>(levels));
+    }
+    if (!file) {
+        return false;
+    }
+    baked.diffuseSphericalHarmonics = SphericalHarmonics3(coefficients);
+    baked.specularFaces = std::move(faces);
+    return true;
+}
+
+void IBLBaker::_writeCache(const std::string &filename, uint64_t hash, uint32_t size, const BakedEnvironment &baked) {
+    const CacheHeader header{kCacheMagic, kCacheVersion, hash, size,
+        static_cast<uint32_t>(static_cast<const Image &>(*baked.specularFaces[0]).mipmaps().size())};
+    // written aside and renamed, a reader never sees a partial file
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG(WARNING) << "Failed to write baked environment " << filename << std::endl;
+            return;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        const auto &coefficients = baked.diffuseSphericalHarmonics.coefficients();
+        file.write(reinterpret_cast<const char *>(coefficients.data()), sizeof(coefficients));
+        for (const auto &face : baked.specularFaces) {
+            const auto &data = static_cast<const Image &>(*face).data();
+            file.write(reinterpret_cast<const char *>(data.data()), data.size());
+        }
+    }
+    std::rename(temporary.c_str(), filename.c_str());
+}
+
+std::shared_ptr<SampledTextureCube> BakedEnvironment::createSpecularTexture(MTL::Device &device,
+                                                                            MTL::CommandQueue &queue) const {
+    const auto &extent = specularFaces[0]->extent();
+    auto texture = std::make_shared<SampledTextureCube>(device, extent.width, extent.height, 1, true,
+                                                        MTL::PixelFormatRGBA16Float);
+    std::array<const Image *, 6> images{};
+    for (size_t i = 0; i < specularFaces.size(); i++) {
+        images[i] = specularFaces[i].get();
+    }
+    texture->setPixelBuffer(queue, images);
+    return texture;
+}
+
+}
@@ -0,0 +1,106 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef ibl_baker_hpp
+#define ibl_baker_hpp
+
+#include "image/image.h"
+#include "spherical_harmonics3.h"
+#include <array>
+#include <memory>
+#include <string>
+
+namespace vox {
+class SampledTextureCube;
+
+/**
+ * Environment in linear RGBA floats, six square faces in +X, -X, +Y, -Y, +Z, -Z order, oriented as Metal samples a cube.
+ */
+struct EnvironmentCube {
+    uint32_t size{0};
+    std::array<std::vector<float>, 6> faces{};
+};
+
+struct IBLBakeOptions {
+    /** Side of the largest specular level. */
+    uint32_t specularSize = 128;
+
+    /** GGX samples for every texel of the rough levels. */
+    uint32_t sampleCount = 128;
+
+    /** Directory of baked environments, which are read back instead of being baked again. Empty disables it. */
+    std::string cacheDirectory{};
+};
+
+/**
+ * Diffuse and specular lighting baked from an environment.
+ */
+struct BakedEnvironment {
+    /** Radiance projected to SH3, for AmbientLight::setDiffuseSphericalHarmonics. */
+    SphericalHarmonics3 diffuseSphericalHarmonics{};
+
+    /**
+     * RGBA16Float faces with a full mip chain.
+     * @remarks Level i is prefiltered for roughness i / (levels - 1), the level the shaders sample for a roughness.
+     */
+    std::array<std::unique_ptr<Image>, 6> specularFaces{};
+
+    /**
+     * Cube texture of the specular faces, for AmbientLight::setSpecularTexture.
+     */
+    std::shared_ptr<SampledTextureCube> createSpecularTexture(MTL::Device &device, MTL::CommandQueue &queue) const;
+};
+
+/**
+ * Bakes image based lighting on the CPU, the counterpart of TextureUtils::createSpecularTexture without a GPU round trip.
+ * @remarks All the work is spread over the shared thread pool.
+ */
+class IBLBaker {
+public:
+    /**
+     * Environment of six cube faces.
+     * @param faces - Square RGBA8, RGBA16Float or RGBA32Float images of the same size, sRGB formats are linearized
+     */
+    static EnvironmentCube fromFaces(const std::array<const Image *, 6> &faces);
+
+    /**
+     * Environment of a latitude-longitude panorama, the top row is +Y and the center looks down -Z.
+     * @param size - Side of the faces
+     */
+    static EnvironmentCube fromEquirectangular(const Image &image, uint32_t size);
+
+    /**
+     * Radiance projected to SH3, every texel weighted by the solid angle it covers.
+     */
+    static SphericalHarmonics3 projectSH(const EnvironmentCube &environment);
+
+    /**
+     * GGX prefiltered radiance, importance sampled from the mip chain of the environment.
+     * @param size - Side of level 0, which is the environment itself
+     */
+    static std::array<std::unique_ptr<Image>, 6> prefilterSpecular(const EnvironmentCube &environment,
+                                                                   uint32_t size, uint32_t sampleCount);
+
+    /**
+     * SH3 and specular faces of an environment, from the cache when it was baked before with the same options.
+     */
+    static BakedEnvironment bake(const EnvironmentCube &environment, const IBLBakeOptions &options = {});
+
+private:
+    // environment and its box filtered levels down to 1x1
+    static std::vector<EnvironmentCube> _chain(const EnvironmentCube &environment);
+
+    static std::array<std::unique_ptr<Image>, 6> _prefilter(const std::vector<EnvironmentCube> &chain,
+                                                            uint32_t size, uint32_t sampleCount);
+
+    static bool _readCache(const std::string &filename, uint64_t hash, uint32_t size, BakedEnvironment &baked);
+
+    static void _writeCache(const std::string &filename, uint64_t hash, uint32_t size, const BakedEnvironment &baked);
+};
+
+}
+
+#endif /* ibl_baker_hpp */
@@ -0,0 +1,276 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "gltf_accessor.h"
+#include <glog/logging.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace vox {
+namespace loader {
+namespace {
+template<class T>
+inline T load(const unsigned char *source) {
+    // glTF only aligns elements to the component size, memcpy keeps unaligned reads legal
+    T value;
+    memcpy(&value, source, sizeof(T));
+    return value;
+}
+
+template<class T, bool Normalized>
+inline float toFloat(T value) {
+    if constexpr (std::is_same_v<T, float> || !Normalized) {
+        return static_cast<float>(value);
+    } else if constexpr (std::is_signed_v<T>) {
+        return std::max(static_cast<float>(value) / static_cast<float>(std::numeric_limits<T>::max()), -1.f);
+    } else {
+        return static_cast<float>(value) / static_cast<float>(std::numeric_limits<T>::max());
+    }
+}
+
+// component count known at compile time, so the inner loop is unrolled and the outer one vectorized
+template<class T, bool Normalized, uint32_t N>
+void convertElements(const unsigned char *source, size_t sourceStride, size_t count,
+                     float *dst, size_t dstStride) {
+    for (size_t i = 0; i < count; i++) {
+        const unsigned char *element = source + i * sourceStride;
+        float *out = dst + i * dstStride;
+        for (uint32_t c = 0; c < N; c++) {
+            out[c] = toFloat<T, Normalized>(load<T>(element + c * sizeof(T)));
+        }
+    }
+}
+
+template<class T, bool Normalized>
+void convertElements(const unsigned char *source, size_t sourceStride, size_t count,
+                     float *dst, size_t dstStride, uint32_t components) {
+    switch (components) {
+        case 1:
+            convertElements<T, Normalized, 1>(source, sourceStride, count, dst, dstStride);
+            break;
+        case 2:
+            convertElements<T, Normalized, 2>(source, sourceStride, count, dst, dstStride);
+            break;
+        case 3:
+            convertElements<T, Normalized, 3>(source, sourceStride, count, dst, dstStride);
+            break;
+        case 4:
+            convertElements<T, Normalized, 4>(source, sourceStride, count, dst, dstStride);
+            break;
+        default:
+            for (size_t i = 0; i < count; i++) {
+                for (uint32_t c = 0; c < components; c++) {
+                    dst[i * dstStride + c] = toFloat<T, Normalized>(load<T>(source + i * sourceStride + c * sizeof(T)));
+                }
+            }
+            break;
+    }
+}
+
+template<class T>
+void convertElements(bool normalized, const unsigned char *source, size_t sourceStride, size_t count,
+                     float *dst, size_t dstStride, uint32_t components) {
+    if (normalized) {
+        convertElements<T, true>(source, sourceStride, count, dst, dstStride, components);
+    } else {
+        convertElements<T, false>(source, sourceStride, count, dst, dstStride, components);
+    }
+}
+
+bool convertElements(int componentType, bool normalized, const unsigned char *source, size_t sourceStride,
+                     size_t count, float *dst, size_t dstStride, uint32_t components) {
+    switch (componentType) {
+        case TINYGLTF_COMPONENT_TYPE_FLOAT:
+            if (sourceStride == sizeof(float) * components && dstStride == components) {
+                memcpy(dst, source, count * sourceStride);
+            } else {
+                convertElements<float, false>(source, sourceStride, count, dst, dstStride, components);
+            }
+            return true;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            convertElements<uint8_t>(normalized, source, sourceStride, count, dst, dstStride, components);
+            return true;
+        case TINYGLTF_COMPONENT_TYPE_BYTE:
+            convertElements<int8_t>(normalized, source, sourceStride, count, dst, dstStride, components);
+            return true;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+            convertElements<uint16_t>(normalized, source, sourceStride, count, dst, dstStride, components);
+            return true;
+        case TINYGLTF_COMPONENT_TYPE_SHORT:
+            convertElements<int16_t>(normalized, source, sourceStride, count, dst, dstStride, components);
+            return true;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            convertElements<uint32_t>(false, source, sourceStride, count, dst, dstStride, components);
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint32_t loadIndex(int componentType, const unsigned char *source) {
+    switch (componentType) {
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            return *source;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+            return load<uint16_t>(source);
+        default:
+            return load<uint32_t>(source);
+    }
+}
+
+template<class T>
+void convertIndices(const unsigned char *source, size_t sourceStride, size_t count, uint32_t *dst) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = load<T>(source + i * sourceStride);
+    }
+}
+
+bool validBufferView(const tinygltf::Model &model, int bufferView) {
+    if (bufferView < 0 || bufferView >= static_cast<int>(model.bufferViews.size())) {
+        LOG(ERROR) << "buffer view " << bufferView << " does not exist" << std::endl;
+        return false;
+    }
+    const int buffer = model.bufferViews[bufferView].buffer;
+    if (buffer < 0 || buffer >= static_cast<int>(model.buffers.size())) {
+        LOG(ERROR) << "buffer " << buffer << " does not exist" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const unsigned char *bufferData(const tinygltf::Model &model, int bufferView, size_t byteOffset, size_t size) {
+    if (!validBufferView(model, bufferView)) {
+        return nullptr;
+    }
+    const auto &view = model.bufferViews[bufferView];
+    const auto &buffer = model.buffers[view.buffer];
+    if (view.byteOffset + byteOffset + size > buffer.data.size()) {
+        LOG(ERROR) << "accessor reads outside of buffer " << view.buffer << std::endl;
+        return nullptr;
+    }
+    return buffer.data.data() + view.byteOffset + byteOffset;
+}
+
+} // namespace
+
+AccessorView::AccessorView(const tinygltf::Model &model, int accessor) {
+    const auto &gltfAccessor = model.accessors[accessor];
+    const int componentSize = tinygltf::GetComponentSizeInBytes(gltfAccessor.componentType);
+    const int components = tinygltf::GetNumComponentsInType(gltfAccessor.type);
+    if (componentSize <= 0 || components <= 0) {
+        LOG(ERROR) << "accessor " << accessor << " has unknown type" << std::endl;
+        return;
+    }
+    const size_t elementSize = componentSize * components;
+
+    count = gltfAccessor.count;
+    componentType = gltfAccessor.componentType;
+    normalized = gltfAccessor.normalized;
+    stride = elementSize;
+    if (gltfAccessor.bufferView >= 0) {
+        if (!validBufferView(model, gltfAccessor.bufferView)) {
+            return;
+        }
+        const int byteStride = gltfAccessor.ByteStride(model.bufferViews[gltfAccessor.bufferView]);
+        if (byteStride <= 0) {
+            LOG(ERROR) << "accessor " << accessor << " has invalid stride" << std::endl;
+            return;
+        }
+        stride = byteStride;
+        const size_t size = count == 0 ? 0 : (count - 1) * stride + elementSize;
+        data = bufferData(model, gltfAccessor.bufferView, gltfAccessor.byteOffset, size);
+        if (data == nullptr) {
+            return;
+        }
+    }
+
+    if (gltfAccessor.sparse.isSparse) {
+        const auto &sparse = gltfAccessor.sparse;
+        const int indexSize = tinygltf::GetComponentSizeInBytes(sparse.indices.componentType);
+        if (indexSize <= 0) {
+            return;
+        }
+        sparseIndices = bufferData(model, sparse.indices.bufferView, sparse.indices.byteOffset, sparse.count * indexSize);
+        sparseValues = bufferData(model, sparse.values.bufferView, sparse.values.byteOffset, sparse.count * elementSize);
+        if (sparseIndices == nullptr || sparseValues == nullptr) {
+            return;
+        }
+        sparseIndexType = sparse.indices.componentType;
+        sparseCount = sparse.count;
+    }
+    componentCount = components;
+}
+
+void convertToFloat(const AccessorView &view, float *dst, size_t dstStride, uint32_t dstComponents,
+                    float fill, size_t count) {
+    count = std::min(count, view.count);
+    const uint32_t components = std::min(view.componentCount, dstComponents);
+    if (view.data) {
+        if (!convertElements(view.componentType, view.normalized, view.data, view.stride,
+                             count, dst, dstStride, components)) {
+            LOG(ERROR) << "component type " << view.componentType << " can not be converted" << std::endl;
+            return;
+        }
+    } else {
+        // sparse accessor without buffer view starts from zeros
+        for (size_t i = 0; i < count; i++) {
+            std::fill(dst + i * dstStride, dst + i * dstStride + components, 0.f);
+        }
+    }
+    if (components < dstComponents) {
+        for (size_t i = 0; i < count; i++) {
+            std::fill(dst + i * dstStride + components, dst + i * dstStride + dstComponents, fill);
+        }
+    }
+
+    const size_t indexSize = tinygltf::GetComponentSizeInBytes(view.sparseIndexType);
+    const size_t valueStride = tinygltf::GetComponentSizeInBytes(view.componentType) * view.componentCount;
+    for (size_t i = 0; i < view.sparseCount; i++) {
+        const uint32_t index = loadIndex(view.sparseIndexType, view.sparseIndices + i * indexSize);
+        if (index < count) {
+            convertElements(view.componentType, view.normalized, view.sparseValues + i * valueStride,
+                            valueStride, 1, dst + index * dstStride, dstStride, components);
+        }
+    }
+}
+
+bool convertToIndices(const AccessorView &view, uint32_t *dst) {
+    if (view.data == nullptr || view.componentCount != 1) {
+        return false;
+    }
+    switch (view.componentType) {
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            if (view.stride == sizeof(uint32_t)) {
+                memcpy(dst, view.data, view.count * sizeof(uint32_t));
+            } else {
+                convertIndices<uint32_t>(view.data, view.stride, view.count, dst);
+            }
+            break;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+            convertIndices<uint16_t>(view.data, view.stride, view.count, dst);
+            break;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            convertIndices<uint8_t>(view.data, view.stride, view.count, dst);
+            break;
+        default:
+            return false;
+    }
+
+    const size_t indexSize = tinygltf::GetComponentSizeInBytes(view.sparseIndexType);
+    const size_t valueSize = tinygltf::GetComponentSizeInBytes(view.componentType);
+    for (size_t i = 0; i < view.sparseCount; i++) {
+        const uint32_t index = loadIndex(view.sparseIndexType, view.sparseIndices + i * indexSize);
+        if (index < view.count) {
+            dst[index] = loadIndex(view.componentType, view.sparseValues + i * valueSize);
+        }
+    }
+    return true;
+}
+
+}
+}
@@ -0,0 +1,72 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef gltf_accessor_hpp
+#define gltf_accessor_hpp
+
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+
+#include <tiny_gltf.h>
+
+namespace vox {
+namespace loader {
+/**
+ * Typed view of a glTF accessor which points into the buffer, nothing is copied.
+ * @remarks Handles byteStride, normalized integer components and sparse substitution.
+ */
+struct AccessorView {
+    /** First element, nullptr if the accessor has no buffer view and starts from zeros. */
+    const unsigned char *data{nullptr};
+    size_t count{0};
+    /** Distance in bytes between two elements. */
+    size_t stride{0};
+    int componentType{0};
+    uint32_t componentCount{0};
+    bool normalized{false};
+
+    size_t sparseCount{0};
+    const unsigned char *sparseIndices{nullptr};
+    int sparseIndexType{0};
+    const unsigned char *sparseValues{nullptr};
+
+    AccessorView() = default;
+
+    /**
+     * @param model - Model which owns the buffers
+     * @param accessor - Index of the accessor
+     */
+    AccessorView(const tinygltf::Model &model, int accessor);
+
+    /**
+     * Whether the accessor has a known type and stays inside its buffers.
+     */
+    bool valid() const {
+        return componentCount > 0;
+    }
+};
+
+/**
+ * Convert elements to float and write them with a stride, for example into an interleaved vertex buffer.
+ * @param view - Source accessor
+ * @param dst - First float of the first element in the destination
+ * @param dstStride - Distance in floats between two destination elements
+ * @param dstComponents - Number of floats written per element
+ * @param fill - Value of destination components the source does not have
+ * @param count - Number of elements, at most view.count
+ */
+void convertToFloat(const AccessorView &view, float *dst, size_t dstStride, uint32_t dstComponents,
+                    float fill, size_t count);
+
+/**
+ * Convert scalar integer elements to 32 bit indices.
+ * @returns False if the component type can not be an index.
+ */
+bool convertToIndices(const AccessorView &view, uint32_t *dst);
+
+}
+}
+
+#endif /* gltf_accessor_hpp */
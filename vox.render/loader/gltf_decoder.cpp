@@ -0,0 +1,364 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "gltf_decoder.h"
+#include "filesystem.h"
+#include "gltf_accessor.h"
+#include "mesh_cache.h"
+#include "image/image_cache.h"
+#include "mesh/mesh_optimizer.h"
+#include <glog/logging.h>
+#include <cassert>
+#include <cstring>
+
+#define KHR_LIGHTS_PUNCTUAL_EXTENSION "KHR_lights_punctual"
+
+namespace vox {
+namespace loader {
+namespace {
+bool loadImageDataFuncEmpty(tinygltf::Image *image, const int imageIndex,
+                            std::string *error, std::string *warning, int req_width, int req_height,
+                            const unsigned char *bytes, int size, void *userData) {
+    // Images are decoded in parallel by GLTFDecoder
+    return true;
+}
+
+AccessorView attributeView(const tinygltf::Model &model, const tinygltf::Primitive &primitive, const std::string &name) {
+    auto iter = primitive.attributes.find(name);
+    if (iter == primitive.attributes.end()) {
+        return AccessorView();
+    }
+    return AccessorView(model, iter->second);
+}
+
+} // namespace
+
+bool GLTFContent::isExtensionEnabled(const std::string &extension) const {
+    auto it = extensions.find(extension);
+    if (it != extensions.end()) {
+        return it->second;
+    } else {
+        return false;
+    }
+}
+
+GLTFDecoder::GLTFDecoder(ThreadPool &pool) :
+_pool(pool) {
+}
+
+float GLTFDecoder::progress() const {
+    if (_done) {
+        return 1;
+    }
+    const auto total = _total.load();
+    return total == 0 ? 0 : static_cast<float>(_finished.load()) / static_cast<float>(total);
+}
+
+std::unique_ptr<GLTFContent> GLTFDecoder::decodeFile(const std::string &filename) {
+    tinygltf::TinyGLTF gltfContext;
+    gltfContext.SetImageLoader(loadImageDataFuncEmpty, nullptr);
+
+    std::string gltf_file = vox::fs::path::get(vox::fs::path::Type::Assets) + filename;
+
+    std::string error, warning;
+    auto content = std::make_unique<GLTFContent>();
+    bool fileLoaded = gltfContext.LoadASCIIFromFile(&content->model, &error, &warning, gltf_file);
+
+    if (!fileLoaded) {
+        LOG(ERROR) << "Failed to load gltf file " << gltf_file.c_str() << std::endl;
+        _done = true;
+        return nullptr;
+    }
+
+    if (!error.empty()) {
+        LOG(ERROR) << "Error loading gltf model: " << error.c_str() << std::endl;
+        _done = true;
+        return nullptr;
+    }
+
+    if (!warning.empty()) {
+        LOG(WARNING) << warning.c_str() << std::endl;
+    }
+
+    size_t pos = filename.find_last_of('/');
+    content->path = filename.substr(0, pos);
+    
+    // the json and every buffer, a changed .bin invalidates the cache too
+    const auto source = fs::readAsset(filename);
+    uint64_t sourceHash = contentHash(source.data(), source.size());
+    for (const auto &buffer : content->model.buffers) {
+        sourceHash = contentHash(buffer.data.data(), buffer.data.size(), sourceHash);
+    }
+    std::string cacheName = filename;
+    std::replace(cacheName.begin(), cacheName.end(), '/', '_');
+    const std::string cacheFile = fs::path::get(fs::path::Type::Storage, cacheName + ".vmc");
+    
+    auto cache = MeshCache::open(cacheFile, sourceHash);
+    if (cache) {
+        _checkExtensions(*content);
+        // vertex streams are uploaded straight from the mapping
+        cache->read(*content, false);
+        content->meshCache = std::move(cache);
+        _decode(*content, false);
+    } else {
+        decode(*content);
+        if (!MeshCache::write(cacheFile, sourceHash, *content)) {
+            LOG(WARNING) << "Failed to write mesh cache " << cacheFile << std::endl;
+        }
+    }
+    return content;
+}
+
+void GLTFDecoder::decode(GLTFContent &content) {
+    _checkExtensions(content);
+    _decodeScene(content);
+    _decode(content, true);
+}
+
+void GLTFDecoder::_decode(GLTFContent &content, bool geometry) {
+    auto &model = content.model;
+    content.images.clear();
+    content.images.resize(model.images.size());
+    
+    // one job per image and per primitive
+    std::vector<std::pair<size_t, size_t>> primitives;
+    if (geometry) {
+        content.meshes.clear();
+        content.meshes.resize(model.meshes.size());
+        for (size_t i = 0; i < model.meshes.size(); i++) {
+            content.meshes[i].resize(model.meshes[i].primitives.size());
+            for (size_t j = 0; j < model.meshes[i].primitives.size(); j++) {
+                primitives.emplace_back(i, j);
+            }
+        }
+    }
+    const size_t imageCount = model.images.size();
+    _finished = 0;
+    _total = static_cast<uint32_t>(imageCount + primitives.size());
+    
+    _pool.parallelFor(imageCount + primitives.size(), [&](size_t job) {
+        if (job < imageCount) {
+            _decodeImage(content, job);
+        } else {
+            const auto &index = primitives[job - imageCount];
+            _decodePrimitive(model, model.meshes[index.first].primitives[index.second],
+                             content.meshes[index.first][index.second]);
+        }
+        _finished++;
+    });
+    _done = true;
+}
+
+void GLTFDecoder::_decodeScene(GLTFContent &content) {
+    const auto &model = content.model;
+    content.nodes.clear();
+    content.nodes.resize(model.nodes.size());
+    for (size_t i = 0; i < model.nodes.size(); i++) {
+        const auto &source = model.nodes[i];
+        auto &node = content.nodes[i];
+        node.name = source.name;
+        node.mesh = source.mesh;
+        node.skin = source.skin;
+        node.children = source.children;
+        if (source.translation.size() == 3) {
+            std::copy(source.translation.begin(), source.translation.end(), node.translation);
+        }
+        if (source.rotation.size() == 4) {
+            std::copy(source.rotation.begin(), source.rotation.end(), node.rotation);
+        }
+        if (source.scale.size() == 3) {
+            std::copy(source.scale.begin(), source.scale.end(), node.scale);
+        }
+        if (source.matrix.size() == 16) {
+            std::copy(source.matrix.begin(), source.matrix.end(), node.matrix);
+            node.hasMatrix = true;
+        }
+    }
+    
+    content.skins.clear();
+    content.skins.resize(model.skins.size());
+    for (size_t i = 0; i < model.skins.size(); i++) {
+        const auto &source = model.skins[i];
+        auto &skin = content.skins[i];
+        skin.name = source.name;
+        skin.joints = source.joints;
+        // Get inverse bind matrices from buffer
+        if (source.inverseBindMatrices > -1) {
+            const AccessorView matrices(model, source.inverseBindMatrices);
+            skin.inverseBindMatrices.resize(matrices.count);
+            static_assert(sizeof(Matrix4x4F) == sizeof(float) * 16, "matrices are written as packed floats");
+            if (matrices.valid() && !skin.inverseBindMatrices.empty()) {
+                convertToFloat(matrices, skin.inverseBindMatrices[0].data(), 16, 16, 0, matrices.count);
+            }
+        }
+    }
+    
+    content.sceneNodes.clear();
+    if (!model.scenes.empty()) {
+        content.sceneNodes = model.scenes[model.defaultScene > -1 ? model.defaultScene : 0].nodes;
+    }
+}
+
+void GLTFDecoder::_checkExtensions(GLTFContent &content) const {
+    content.extensions = {{KHR_LIGHTS_PUNCTUAL_EXTENSION, false}};
+    auto &gltfModel = content.model;
+    for (auto &used_extension: gltfModel.extensionsUsed) {
+        if (used_extension == "KHR_materials_pbrSpecularGlossiness") {
+            content.metallicRoughnessWorkflow = false;
+        }
+
+        auto it = content.extensions.find(used_extension);
+
+        // Check if extension isn't supported by the GLTFLoader
+        if (it == content.extensions.end()) {
+            // If extension is required then we shouldn't allow the scene to be loaded
+            if (std::find(gltfModel.extensionsRequired.begin(), gltfModel.extensionsRequired.end(),
+                          used_extension) != gltfModel.extensionsRequired.end()) {
+                throw std::runtime_error("Cannot load glTF file. Contains a required unsupported extension: " + used_extension);
+            } else {
+                // Otherwise, if extension isn't required (but is in the file) then print a warning to the user
+                LOG(WARNING) << "glTF file contains an unsupported extension, unexpected results may occur: "
+                << used_extension << std::endl;
+            }
+        } else {
+            // Extension is supported, so enable it
+            LOG(INFO) << "glTF file contains extension: " << used_extension << std::endl;
+            it->second = true;
+        }
+    }
+}
+
+void GLTFDecoder::_decodeImage(GLTFContent &content, size_t index) const {
+    tinygltf::Image &gltf_image = content.model.images[index];
+    std::shared_ptr<const Image> image{nullptr};
+
+    if (!gltf_image.image.empty()) {
+        // Image embedded in gltf file
+        auto mipmap = Mipmap{
+            /* .level = */ 0,
+            /* .offset = */ 0,
+            /* .extent = */ {/* .width = */ static_cast<uint32_t>(gltf_image.width),
+                /* .height = */ static_cast<uint32_t>(gltf_image.height),
+                /* .depth = */ 1u}};
+        std::vector<Mipmap> mipmaps{mipmap};
+        image = ImageCache::shared().add(std::make_unique<Image>(std::move(gltf_image.image), std::move(mipmaps)));
+    } else {
+        // Load image from uri
+        auto image_uri = content.path + "/" + gltf_image.uri;
+        try {
+            image = ImageCache::shared().load(image_uri);
+        } catch (const std::exception &e) {
+            LOG(ERROR) << "Failed to decode image " << image_uri << ": " << e.what() << std::endl;
+        }
+    }
+    content.images[index] = std::move(image);
+}
+
+void GLTFDecoder::_decodePrimitive(const tinygltf::Model &model, const tinygltf::Primitive &primitive,
+                                   GLTFPrimitive &result) {
+    result.material = primitive.material;
+    if (primitive.indices < 0) {
+        return;
+    }
+
+    // Position attribute is required
+    assert(primitive.attributes.find("POSITION") != primitive.attributes.end());
+    
+    const AccessorView positions = attributeView(model, primitive, "POSITION");
+    if (!positions.valid()) {
+        return;
+    }
+    struct Source {
+        AccessorView view;
+        Attributes semantic;
+        MTL::VertexFormat format;
+        uint32_t components;
+        float fill;
+    };
+    const Source sources[] = {
+        {positions, Position, MTL::VertexFormatFloat3, 3, 0},
+        {attributeView(model, primitive, "NORMAL"), Normal, MTL::VertexFormatFloat3, 3, 0},
+        {attributeView(model, primitive, "TEXCOORD_0"), UV_0, MTL::VertexFormatFloat2, 2, 0},
+        // Color buffer are either of type vec3 or vec4
+        {attributeView(model, primitive, "COLOR_0"), Color_0, MTL::VertexFormatFloat4, 4, 1},
+        {attributeView(model, primitive, "TANGENT"), Tangent, MTL::VertexFormatFloat4, 4, 0},
+        // Skinning
+        {attributeView(model, primitive, "JOINTS_0"), Joints_0, MTL::VertexFormatFloat4, 4, 0},
+        {attributeView(model, primitive, "WEIGHTS_0"), Weights_0, MTL::VertexFormatFloat4, 4, 0},
+    };
+    
+    uint32_t offset = 0;
+    for (const auto &source : sources) {
+        if (source.view.valid()) {
+            result.attributes.push_back({source.semantic, source.format, offset});
+            offset += sizeof(float) * source.components;
+        }
+    }
+    result.stride = offset;
+    
+    // every attribute is converted straight into its place in the interleaved buffer
+    const size_t vertexCount = positions.count;
+    const size_t floatStride = offset / sizeof(float);
+    // attributes shorter than the positions leave zeros
+    result.vertices.resize(vertexCount * floatStride);
+    offset = 0;
+    for (const auto &source : sources) {
+        if (!source.view.valid()) {
+            continue;
+        }
+        if (source.view.count < vertexCount) {
+            LOG(WARNING) << "attribute " << source.semantic << " has " << source.view.count
+            << " elements, mesh has " << vertexCount << std::endl;
+        }
+        convertToFloat(source.view, result.vertices.data() + offset / sizeof(float), floatStride,
+                       source.components, source.fill, vertexCount);
+        offset += sizeof(float) * source.components;
+    }
+    
+    const auto &posAccessor = model.accessors[primitive.attributes.at("POSITION")];
+    if (posAccessor.minValues.size() == 3 && posAccessor.maxValues.size() == 3) {
+        Point3F posMin = Point3F(posAccessor.minValues[0], posAccessor.minValues[1], posAccessor.minValues[2]);
+        Point3F posMax = Point3F(posAccessor.maxValues[0], posAccessor.maxValues[1], posAccessor.maxValues[2]);
+        result.bounds.merge(BoundingBox3F(posMin, posMax));
+    } else {
+        for (size_t v = 0; v < vertexCount; v++) {
+            const float *position = result.vertices.data() + v * floatStride;
+            result.bounds.merge(Point3F(position[0], position[1], position[2]));
+        }
+    }
+    
+    // Indices
+    const AccessorView indices(model, primitive.indices);
+    result.indices.resize(indices.count);
+    if (!indices.valid() || !convertToIndices(indices, result.indices.data())) {
+        LOG(ERROR) << "Index component type " << model.accessors[primitive.indices].componentType << " not supported!"
+        << std::endl;
+        result.indices.clear();
+        return;
+    }
+    
+    if (primitive.mode == TINYGLTF_MODE_TRIANGLES) {
+        // the interleaved vertex is welded as a whole, then triangles and vertices are reordered
+        std::vector<uint32_t> remap;
+        const MeshOptimizer::VertexStream stream{result.vertices.data(), result.stride, result.stride};
+        size_t uniqueCount = MeshOptimizer::weldVertices({stream}, vertexCount, remap);
+        MeshOptimizer::remapIndices(result.indices, remap);
+        MeshOptimizer::optimizeVertexCache(result.indices, uniqueCount);
+        std::vector<uint32_t> fetchRemap;
+        const size_t usedCount = MeshOptimizer::optimizeVertexFetch(result.indices, uniqueCount, fetchRemap);
+        MeshOptimizer::remapIndices(result.indices, fetchRemap);
+        // compose both remaps so that vertices move only once
+        for (auto &index : remap) {
+            index = fetchRemap[index];
+        }
+        std::vector<float> vertices(usedCount * floatStride);
+        MeshOptimizer::remapVertices(vertices.data(), result.vertices.data(), vertexCount, result.stride, remap);
+        result.vertices.swap(vertices);
+    }
+}
+
+}
+}
@@ -0,0 +1,173 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef gltf_decoder_hpp
+#define gltf_decoder_hpp
+
+#include "image/image.h"
+#include "bounding_box3.h"
+#include "matrix4x4.h"
+#include "shader_common.h"
+#include "thread_pool.h"
+
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+
+#include <tiny_gltf.h>
+
+#include <atomic>
+#include <unordered_map>
+
+namespace vox {
+namespace loader {
+/**
+ * Attribute of an interleaved vertex.
+ */
+struct GLTFVertexAttribute {
+    Attributes semantic;
+    MTL::VertexFormat format;
+    uint32_t offset;
+};
+
+/**
+ * Primitive converted on CPU, ready to be copied into GPU buffers.
+ */
+struct GLTFPrimitive {
+    std::vector<GLTFVertexAttribute> attributes{};
+    /** Stride in bytes of one vertex. */
+    uint32_t stride{0};
+    std::vector<float> vertices{};
+    /** Empty if the primitive can not be drawn. */
+    std::vector<uint32_t> indices{};
+    BoundingBox3F bounds{};
+    int material{-1};
+    
+    /** Set instead of vertices and indices when the streams stay in a mapped MeshCache. */
+    const float *mappedVertices{nullptr};
+    size_t mappedVertexCount{0};
+    const uint32_t *mappedIndices{nullptr};
+    size_t mappedIndexCount{0};
+    
+    const float *vertexData() const {
+        return mappedVertices ? mappedVertices : vertices.data();
+    }
+    
+    /** Number of floats. */
+    size_t vertexCount() const {
+        return mappedVertices ? mappedVertexCount : vertices.size();
+    }
+    
+    const uint32_t *indexData() const {
+        return mappedIndices ? mappedIndices : indices.data();
+    }
+    
+    size_t indexCount() const {
+        return mappedIndices ? mappedIndexCount : indices.size();
+    }
+};
+
+/**
+ * Node of the hierarchy, transform is identity where the file has none.
+ */
+struct GLTFNode {
+    std::string name{};
+    int mesh{-1};
+    int skin{-1};
+    std::vector<int> children{};
+    float translation[3]{0, 0, 0};
+    float rotation[4]{0, 0, 0, 1};
+    float scale[3]{1, 1, 1};
+    /** Column major, used instead of translation, rotation and scale if hasMatrix. */
+    float matrix[16]{};
+    bool hasMatrix{false};
+};
+
+class MeshCache;
+
+struct GLTFSkin {
+    std::string name{};
+    /** Node index of every joint. */
+    std::vector<int> joints{};
+    std::vector<Matrix4x4F> inverseBindMatrices{};
+};
+
+/**
+ * Result of the CPU stages of glTF loading.
+ */
+struct GLTFContent {
+    tinygltf::Model model{};
+    /** Directory of the file, relative to the assets. */
+    std::string path{};
+    bool metallicRoughnessWorkflow{true};
+    /** The extensions that can be loaded mapped to whether they are used by the file. */
+    std::unordered_map<std::string, bool> extensions{};
+
+    /** Decoded images shared through the ImageCache, nullptr if decoding failed. */
+    std::vector<std::shared_ptr<const Image>> images{};
+    /** Converted primitives of every mesh. */
+    std::vector<std::vector<GLTFPrimitive>> meshes{};
+    std::vector<GLTFNode> nodes{};
+    std::vector<GLTFSkin> skins{};
+    /** Root nodes of the default scene. */
+    std::vector<int> sceneNodes{};
+    /** Keeps the mapped vertex streams of the primitives alive. */
+    std::shared_ptr<const MeshCache> meshCache{};
+
+    bool isExtensionEnabled(const std::string &extension) const;
+};
+
+/**
+ * Parses glTF files and decodes images and vertex data on a ThreadPool.
+ * @remarks Nothing here touches the GPU, so it can run on any thread.
+ */
+class GLTFDecoder {
+public:
+    explicit GLTFDecoder(ThreadPool &pool = ThreadPool::shared());
+
+    /**
+     * Parse and decode a file.
+     * @remarks Meshes, skins and hierarchy come from the MeshCache in the storage directory when it was
+     * made from the same source, otherwise they are converted and the cache is written.
+     * @param filename - Path relative to the assets
+     * @returns nullptr if the file can not be parsed
+     */
+    std::unique_ptr<GLTFContent> decodeFile(const std::string &filename);
+
+    /**
+     * Check the extensions of the model, then decode images, primitives, skins and hierarchy.
+     * @remarks Throws if the model requires an unsupported extension.
+     */
+    void decode(GLTFContent &content);
+
+    /**
+     * Fraction of images and primitives already decoded, in [0, 1].
+     */
+    float progress() const;
+
+private:
+    void _checkExtensions(GLTFContent &content) const;
+
+    void _decodeImage(GLTFContent &content, size_t index) const;
+
+    /**
+     * Decode images, and primitives if geometry is true, in parallel.
+     */
+    void _decode(GLTFContent &content, bool geometry);
+
+    static void _decodeScene(GLTFContent &content);
+
+    static void _decodePrimitive(const tinygltf::Model &model, const tinygltf::Primitive &primitive,
+                                 GLTFPrimitive &result);
+
+    ThreadPool &_pool;
+    std::atomic<uint32_t> _finished{0};
+    std::atomic<uint32_t> _total{0};
+    std::atomic<bool> _done{false};
+};
+
+}
+}
+
+#endif /* gltf_decoder_hpp */
@@ -9,19 +9,28 @@
 #define TINYGLTF_NO_STB_IMAGE
 
 #include "gltf_loader.h"
+#include "gltf_accessor.h"
 #include "scene_animator.h"
 #include "material/pbr_material.h"
 #include "mesh/buffer_mesh.h"
-#include "filesystem.h"
+#include "mesh/mesh_optimizer.h"
 #include "metal_helpers.h"
+#include "texture/sampled_texture_streamer.h"
+#include "image/image_cache.h"
 #include "shader_common.h"
 #include <glog/logging.h>
 
-#define KHR_LIGHTS_PUNCTUAL_EXTENSION "KHR_lights_punctual"
-
 namespace vox {
 namespace loader {
 namespace {
+// keyframes of an animation sampler, invalid when the index is not an accessor
+AccessorView keyframeView(const tinygltf::Model &model, int accessor) {
+    if (accessor < 0 || static_cast<size_t>(accessor) >= model.accessors.size()) {
+        return AccessorView();
+    }
+    return AccessorView(model, accessor);
+}
+
 inline MTL::SamplerMinMagFilter find_min_filter(int min_filter) {
     switch (min_filter) {
         case TINYGLTF_TEXTURE_FILTER_NEAREST:
@@ -74,26 +83,14 @@ inline MTL::SamplerAddressMode find_wrap_mode(int wrap) {
     }
 };
 
-bool loadImageDataFuncEmpty(tinygltf::Image *image, const int imageIndex,
-                            std::string *error, std::string *warning, int req_width, int req_height,
-                            const unsigned char *bytes, int size, void *userData) {
-    // This function will be used for samples that don't require images to be loaded
-    return true;
+/// Fields of a sampler packed for the texture cache, textures with another sampler get their own sampler state.
+inline uint64_t find_sampler_key(const tinygltf::Sampler &sampler) {
+    // the wrap modes are never 0, which is left to textures without a sampler
+    return uint64_t(sampler.wrapS & 0xffff) << 48 | uint64_t(sampler.wrapT & 0xffff) << 32 |
+    uint64_t(sampler.minFilter & 0xffff) << 16 | uint64_t(sampler.magFilter & 0xffff);
 }
 } // namespace
 
-std::unordered_map<std::string, bool> GLTFLoader::_supportedExtensions = {
-    {KHR_LIGHTS_PUNCTUAL_EXTENSION, false}};
-
-bool GLTFLoader::isExtensionEnabled(const std::string &requested_extension) {
-    auto it = _supportedExtensions.find(requested_extension);
-    if (it != _supportedExtensions.end()) {
-        return it->second;
-    } else {
-        return false;
-    }
-}
-
 tinygltf::Value *GLTFLoader::getExtension(tinygltf::ExtensionMap &tinygltf_extensions, const std::string &extension) {
     auto it = tinygltf_extensions.find(extension);
     if (it != tinygltf_extensions.end()) {
@@ -108,92 +105,73 @@ _device(device),
 _queue(queue) {
 }
 
+float GLTFLoadRequest::progress() const {
+    return _decoder.progress();
+}
+
+bool GLTFLoadRequest::isReady() const {
+    return _content.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
 void GLTFLoader::loadFromFile(std::string filename, EntityPtr defaultSceneRoot, float scale) {
-    tinygltf::TinyGLTF gltfContext;
-    gltfContext.SetImageLoader(loadImageDataFuncEmpty, nullptr);
-    
-    std::string gltf_file = vox::fs::path::get(vox::fs::path::Type::Assets) + filename;
-    
-    std::string error, warning;
-    tinygltf::Model gltfModel;
-    bool fileLoaded = gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, gltf_file);
-    
-    if (!fileLoaded) {
-        LOG(ERROR) << "Failed to load gltf file " << gltf_file.c_str() << std::endl;
-        return;
+    if (finishLoad(loadFromFileAsync(filename), defaultSceneRoot) && scale != 1.0f) {
+        defaultSceneRoot->transform->setScale(defaultSceneRoot->transform->scale() * scale);
     }
-    
-    if (!error.empty()) {
-        LOG(ERROR) << "Error loading gltf model: " << error.c_str() << std::endl;
-        return;
-    }
-    
-    if (!warning.empty()) {
-        LOG(WARNING) << warning.c_str() << std::endl;
+}
+
+GLTFLoadRequestPtr GLTFLoader::loadFromFileAsync(std::string filename) {
+    auto request = std::make_shared<GLTFLoadRequest>();
+    // the job keeps the request alive, so it can be dropped before the decoding ends
+    request->_content = ThreadPool::shared().enqueue([request, filename]() {
+        return request->_decoder.decodeFile(filename);
+    });
+    return request;
+}
+
+bool GLTFLoader::finishLoad(const GLTFLoadRequestPtr &request, EntityPtr defaultSceneRoot) {
+    // rethrows the error of decoding, like a required unsupported extension
+    auto content = request->_content.get();
+    if (!content) {
+        return false;
     }
     
     _defaultSceneRoot = defaultSceneRoot;
-    size_t pos = filename.find_last_of('/');
-    _path = filename.substr(0, pos);
-    
-    loadScene(gltfModel);
+    loadScene(*content);
+    return true;
 }
 
-void GLTFLoader::loadScene(tinygltf::Model &gltfModel) {
-    // Check extensions
-    for (auto &used_extension: gltfModel.extensionsUsed) {
-        if (used_extension == "KHR_materials_pbrSpecularGlossiness") {
-            _metallicRoughnessWorkflow = false;
-        }
-        
-        auto it = _supportedExtensions.find(used_extension);
-        
-        // Check if extension isn't supported by the GLTFLoader
-        if (it == _supportedExtensions.end()) {
-            // If extension is required then we shouldn't allow the scene to be loaded
-            if (std::find(gltfModel.extensionsRequired.begin(), gltfModel.extensionsRequired.end(),
-                          used_extension) != gltfModel.extensionsRequired.end()) {
-                throw std::runtime_error("Cannot load glTF file. Contains a required unsupported extension: " + used_extension);
-            } else {
-                // Otherwise, if extension isn't required (but is in the file) then print a warning to the user
-                LOG(WARNING) << "glTF file contains an unsupported extension, unexpected results may occur: "
-                << used_extension << std::endl;;
-            }
-        } else {
-            // Extension is supported, so enable it
-            LOG(INFO) << "glTF file contains extension: " << used_extension << std::endl;;
-            it->second = true;
-        }
-    }
+void GLTFLoader::loadScene(GLTFContent &content) {
+    auto &gltfModel = content.model;
+    _metallicRoughnessWorkflow = content.metallicRoughnessWorkflow;
     
     // Load lights
     
-    // Load images
-    loadImages(gltfModel);
+    // Images are decoded by GLTFDecoder
+    for (auto &image : content.images) {
+        images.emplace_back(std::move(image));
+    }
     
     // Load textures && samplers
-    loadTextures(gltfModel);
+    loadTextures(content);
     
     // Load materials
     loadMaterials(gltfModel);
     
     // Load meshes
-    loadMeshes(gltfModel);
+    loadMeshes(content);
     
     // Load cameras
     
     // Load nodes && scenes
-    const tinygltf::Scene &scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
-    for (size_t i = 0; i < scene.nodes.size(); i++) {
-        const tinygltf::Node node = gltfModel.nodes[scene.nodes[i]];
-        loadNode(nullptr, node, scene.nodes[i], gltfModel);
+    for (auto nodeIndex : content.sceneNodes) {
+        loadNode(nullptr, nodeIndex, content);
     }
     
     // Load animations
     if (gltfModel.animations.size() > 0) {
         loadAnimations(gltfModel);
     }
-    loadSkins(gltfModel);
+    loadSkins(content);
     for (auto node: _linearNodes) {
         // Assign skins
         if (node.second.second > -1) {
@@ -207,8 +185,8 @@ void GLTFLoader::loadScene(tinygltf::Model &gltfModel) {
     }
 }
 
-void GLTFLoader::loadNode(EntityPtr parent, const tinygltf::Node &node, uint32_t nodeIndex,
-                          const tinygltf::Model &model) {
+void GLTFLoader::loadNode(EntityPtr parent, int nodeIndex, const GLTFContent &content) {
+    const GLTFNode &node = content.nodes[nodeIndex];
     EntityPtr newNode = nullptr;
     if (parent) {
         newNode = parent->createChild(node.name);
@@ -218,21 +196,12 @@ void GLTFLoader::loadNode(EntityPtr parent, const tinygltf::Node &node, uint32_t
     _linearNodes[nodeIndex] = std::make_pair(newNode, node.skin);
     
     // Generate local node matrix
-    if (node.translation.size() == 3) {
-        auto translation = node.translation;
-        newNode->transform->setPosition(Point3F(translation[0], translation[1], translation[2]));
-    }
-    if (node.rotation.size() == 4) {
-        auto rotation = node.rotation;
-        newNode->transform->setRotationQuaternion(QuaternionF(rotation[0], rotation[1], rotation[2], rotation[3]));
-    }
-    if (node.scale.size() == 3) {
-        auto scale = node.scale;
-        newNode->transform->setScale(Vector3F(scale[0], scale[1], scale[2]));
-    }
-    if (node.matrix.size() == 16) {
+    newNode->transform->setPosition(Point3F(node.translation[0], node.translation[1], node.translation[2]));
+    newNode->transform->setRotationQuaternion(QuaternionF(node.rotation[0], node.rotation[1], node.rotation[2], node.rotation[3]));
+    newNode->transform->setScale(Vector3F(node.scale[0], node.scale[1], node.scale[2]));
+    if (node.hasMatrix) {
         auto m = Matrix4x4F();
-        std::copy(node.matrix.begin(), node.matrix.end(), m.data());
+        std::copy(node.matrix, node.matrix + 16, m.data());
         newNode->transform->setLocalMatrix(m);
     }
     
@@ -246,34 +215,8 @@ void GLTFLoader::loadNode(EntityPtr parent, const tinygltf::Node &node, uint32_t
     }
     
     // Node with children
-    if (node.children.size() > 0) {
-        for (auto i = 0; i < node.children.size(); i++) {
-            loadNode(newNode, model.nodes[node.children[i]],
-                     node.children[i], model);
-        }
-    }
-}
-
-void GLTFLoader::loadImages(tinygltf::Model &gltfModel) {
-    for (tinygltf::Image &gltf_image: gltfModel.images) {
-        std::unique_ptr<Image> image{nullptr};
-        
-        if (!gltf_image.image.empty()) {
-            // Image embedded in gltf file
-            auto mipmap = Mipmap{
-                /* .level = */ 0,
-                /* .offset = */ 0,
-                /* .extent = */ {/* .width = */ static_cast<uint32_t>(gltf_image.width),
-                    /* .height = */ static_cast<uint32_t>(gltf_image.height),
-                    /* .depth = */ 1u}};
-            std::vector<Mipmap> mipmaps{mipmap};
-            image = std::make_unique<Image>(std::move(gltf_image.image), std::move(mipmaps));
-        } else {
-            // Load image from uri
-            auto image_uri = _path + "/" + gltf_image.uri;
-            image = Image::load(image_uri);
-        }
-        images.emplace_back(std::move(image));
+    for (auto child : node.children) {
+        loadNode(newNode, child, content);
     }
 }
 
@@ -286,15 +229,37 @@ void GLTFLoader::loadSampler(const tinygltf::Sampler &gltf_sampler, SampledTextu
     texture->setMagFilterMode(find_mag_filter(gltf_sampler.magFilter));
 }
 
-void GLTFLoader::loadTextures(tinygltf::Model &gltfModel) {
+void GLTFLoader::loadTextures(GLTFContent &content) {
+    auto &gltfModel = content.model;
     for (auto &gltf_texture: gltfModel.textures) {
-        auto image = images.at(gltf_texture.source).get();
-        SampledTexture2DPtr texture = image->createSampledTexture(_device, _queue);
+        const auto &image = images.at(gltf_texture.source);
+        if (!image) {
+            textures.emplace_back(nullptr);
+            continue;
+        }
+        SampledTexture2DPtr texture;
+        if (textureStreamer) {
+            // files are decoded again when their large levels are needed, embedded images stay in memory
+            const auto &uri = gltfModel.images.at(gltf_texture.source).uri;
+            TextureStreamer::Loader loader = nullptr;
+            if (!uri.empty() && uri.rfind("data:", 0) != 0) {
+                loader = TextureStreamer::fileLoader(content.path + "/" + uri);
+            }
+            texture = textureStreamer->add(image, std::move(loader));
+        } else {
+            // models using the same image and sampler share the texture
+            const uint64_t samplerKey = gltf_texture.sampler >= 0 ?
+            find_sampler_key(gltfModel.samplers.at(gltf_texture.sampler)) : 0;
+            texture = ImageCache::shared().texture(image, _device, _queue, samplerKey);
+        }
         if (gltf_texture.sampler >= 0) {
             loadSampler(gltfModel.samplers.at(gltf_texture.sampler), texture);
         }
         textures.emplace_back(std::move(texture));
     }
+    if (textureStreamer) {
+        std::fill(images.begin(), images.end(), nullptr);
+    }
 }
 
 void GLTFLoader::loadMaterials(tinygltf::Model &gltfModel) {
@@ -345,231 +310,53 @@ void GLTFLoader::loadMaterials(tinygltf::Model &gltfModel) {
     materials.push_back(std::make_shared<PBRMaterial>());
 }
 
-void GLTFLoader::loadMeshes(tinygltf::Model &model) {
-    for (auto &gltf_mesh: model.meshes) {
+void GLTFLoader::loadMeshes(GLTFContent &content) {
+    for (auto &primitives: content.meshes) {
         std::vector<std::pair<MeshPtr, MaterialPtr>> renderer{};
-        for (auto &primitive: gltf_mesh.primitives) {
-            if (primitive.indices < 0) {
+        for (auto &primitive: primitives) {
+            if (primitive.indexCount() == 0) {
                 continue;
             }
             
             auto bufferMesh = std::make_shared<BufferMesh>();
-            auto bound = BoundingBox3F();
-            std::vector<float> vertexBuffer{};
-            std::vector<uint32_t> indexBuffer{};
             auto vertexDescriptor = CLONE_METAL_CUSTOM_DELETER(MTL::VertexDescriptor, MTL::VertexDescriptor::alloc()->init());
-            // Vertices
-            {
-                const float *bufferPos = nullptr;
-                const float *bufferNormals = nullptr;
-                const float *bufferTexCoords = nullptr;
-                const float *bufferColors = nullptr;
-                const float *bufferTangents = nullptr;
-                uint32_t numColorComponents = 0;
-                const uint16_t *bufferJoints = nullptr;
-                const float *bufferWeights = nullptr;
-                
-                // Position attribute is required
-                assert(primitive.attributes.find("POSITION") != primitive.attributes.end());
-                
-                const tinygltf::Accessor &posAccessor = model.accessors[primitive.attributes.find("POSITION")->second];
-                const tinygltf::BufferView &posView = model.bufferViews[posAccessor.bufferView];
-                bufferPos = reinterpret_cast<const float *>(&(model.buffers[posView.buffer].data[posAccessor.byteOffset + posView.byteOffset]));
-                Point3F posMin = Point3F(posAccessor.minValues[0], posAccessor.minValues[1], posAccessor.minValues[2]);
-                Point3F posMax = Point3F(posAccessor.maxValues[0], posAccessor.maxValues[1], posAccessor.maxValues[2]);
-                bound.merge(BoundingBox3F(posMin, posMax));
-                
-                if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
-                    const tinygltf::Accessor &normAccessor = model.accessors[primitive.attributes.find("NORMAL")->second];
-                    const tinygltf::BufferView &normView = model.bufferViews[normAccessor.bufferView];
-                    bufferNormals = reinterpret_cast<const float *>(&(model.buffers[normView.buffer].data[normAccessor.byteOffset + normView.byteOffset]));
-                }
-                
-                if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
-                    const tinygltf::Accessor &uvAccessor = model.accessors[primitive.attributes.find("TEXCOORD_0")->second];
-                    const tinygltf::BufferView &uvView = model.bufferViews[uvAccessor.bufferView];
-                    bufferTexCoords = reinterpret_cast<const float *>(&(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
-                }
-                
-                if (primitive.attributes.find("COLOR_0") != primitive.attributes.end()) {
-                    const tinygltf::Accessor &colorAccessor = model.accessors[primitive.attributes.find("COLOR_0")->second];
-                    const tinygltf::BufferView &colorView = model.bufferViews[colorAccessor.bufferView];
-                    // Color buffer are either of type vec3 or vec4
-                    numColorComponents = colorAccessor.type == TINYGLTF_PARAMETER_TYPE_FLOAT_VEC3 ? 3 : 4;
-                    bufferColors = reinterpret_cast<const float *>(&(model.buffers[colorView.buffer].data[colorAccessor.byteOffset + colorView.byteOffset]));
-                }
-                
-                if (primitive.attributes.find("TANGENT") != primitive.attributes.end()) {
-                    const tinygltf::Accessor &tangentAccessor = model.accessors[primitive.attributes.find("TANGENT")->second];
-                    const tinygltf::BufferView &tangentView = model.bufferViews[tangentAccessor.bufferView];
-                    bufferTangents = reinterpret_cast<const float *>(&(model.buffers[tangentView.buffer].data[tangentAccessor.byteOffset + tangentView.byteOffset]));
-                }
-                
-                // Skinning
-                // Joints
-                if (primitive.attributes.find("JOINTS_0") != primitive.attributes.end()) {
-                    // TODO data type have problem
-                    const tinygltf::Accessor &jointAccessor = model.accessors[primitive.attributes.find("JOINTS_0")->second];
-                    const tinygltf::BufferView &jointView = model.bufferViews[jointAccessor.bufferView];
-                    bufferJoints = reinterpret_cast<const uint16_t *>(&(model.buffers[jointView.buffer].data[jointAccessor.byteOffset + jointView.byteOffset]));
-                }
-                
-                if (primitive.attributes.find("WEIGHTS_0") != primitive.attributes.end()) {
-                    const tinygltf::Accessor &uvAccessor = model.accessors[primitive.attributes.find("WEIGHTS_0")->second];
-                    const tinygltf::BufferView &uvView = model.bufferViews[uvAccessor.bufferView];
-                    bufferWeights = reinterpret_cast<const float *>(&(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
-                }
-                
-                vertexDescriptor->attributes()->object(Position)->setOffset(0);
-                vertexDescriptor->attributes()->object(Position)->setFormat(MTL::VertexFormatFloat3);
-                vertexDescriptor->attributes()->object(Position)->setBufferIndex(0);
-                
-                size_t offset = 12;
-                size_t elementCount = 3;
-                if (bufferNormals) {
-                    vertexDescriptor->attributes()->object(Normal)->setOffset(offset);
-                    vertexDescriptor->attributes()->object(Normal)->setFormat(MTL::VertexFormatFloat3);
-                    vertexDescriptor->attributes()->object(Normal)->setBufferIndex(0);
-                    
-                    offset += sizeof(float) * 3;
-                    elementCount += 3;
-                }
-                
-                if (bufferTexCoords) {
-                    vertexDescriptor->attributes()->object(UV_0)->setOffset(offset);
-                    vertexDescriptor->attributes()->object(UV_0)->setFormat(MTL::VertexFormatFloat2);
-                    vertexDescriptor->attributes()->object(UV_0)->setBufferIndex(0);
-                    
-                    offset += sizeof(float) * 2;
-                    elementCount += 2;
-                }
-                
-                if (bufferColors) {
-                    vertexDescriptor->attributes()->object(Color_0)->setOffset(offset);
-                    vertexDescriptor->attributes()->object(Color_0)->setFormat(MTL::VertexFormatFloat4);
-                    vertexDescriptor->attributes()->object(Color_0)->setBufferIndex(0);
-                    
-                    offset += sizeof(float) * 4;
-                    elementCount += 4;
-                }
-                
-                if (bufferTangents) {
-                    vertexDescriptor->attributes()->object(Tangent)->setOffset(offset);
-                    vertexDescriptor->attributes()->object(Tangent)->setFormat(MTL::VertexFormatFloat4);
-                    vertexDescriptor->attributes()->object(Tangent)->setBufferIndex(0);
-                    
-                    offset += sizeof(float) * 4;
-                    elementCount += 4;
-                }
-                
-                if (bufferJoints) {
-                    vertexDescriptor->attributes()->object(Joints_0)->setOffset(offset);
-                    vertexDescriptor->attributes()->object(Joints_0)->setFormat(MTL::VertexFormatFloat4);
-                    vertexDescriptor->attributes()->object(Joints_0)->setBufferIndex(0);
-                    
-                    offset += sizeof(float) * 4;
-                    elementCount += 4;
-                }
-                
-                if (bufferWeights) {
-                    vertexDescriptor->attributes()->object(Weights_0)->setOffset(offset);
-                    vertexDescriptor->attributes()->object(Weights_0)->setFormat(MTL::VertexFormatFloat4);
-                    vertexDescriptor->attributes()->object(Weights_0)->setBufferIndex(0);
-                    
-                    offset += sizeof(float) * 4;
-                    elementCount += 4;
-                }
-                vertexDescriptor->layouts()->object(0)->setStride(offset);
-                
-                bufferMesh->setVertexLayouts(vertexDescriptor);
-                
-                vertexBuffer.reserve(posAccessor.count * elementCount);
-                for (size_t v = 0; v < posAccessor.count; v++) {
-                    vertexBuffer.insert(vertexBuffer.end(), &bufferPos[v * 3], &bufferPos[v * 3 + 3]);
-                    if (bufferNormals) {
-                        vertexBuffer.insert(vertexBuffer.end(), &bufferNormals[v * 3], &bufferNormals[v * 3 + 3]);
-                    }
-                    if (bufferTexCoords) {
-                        vertexBuffer.insert(vertexBuffer.end(), &bufferTexCoords[v * 2], &bufferTexCoords[v * 2 + 2]);
-                    }
-                    if (bufferColors) {
-                        switch (numColorComponents) {
-                            case 3:
-                                vertexBuffer.insert(vertexBuffer.end(), &bufferColors[v * 3], &bufferColors[v * 3 + 3]);
-                                vertexBuffer.push_back(1.0);
-                            case 4:
-                                vertexBuffer.insert(vertexBuffer.end(), &bufferColors[v * 4], &bufferColors[v * 4 + 4]);
-                            default:
-                                LOG(ERROR) << "numColorComponents has problem" << std::endl;
-                        }
-                    }
-                    if (bufferTangents) {
-                        vertexBuffer.insert(vertexBuffer.end(), &bufferTangents[v * 4], &bufferTangents[v * 4 + 4]);
-                    }
-                    if (bufferJoints) {
-                        vertexBuffer.insert(vertexBuffer.end(), &bufferJoints[v * 4], &bufferJoints[v * 4 + 4]);
-                    }
-                    if (bufferWeights) {
-                        vertexBuffer.insert(vertexBuffer.end(), &bufferWeights[v * 4], &bufferWeights[v * 4 + 4]);
-                    }
-                }
+            for (const auto &attribute : primitive.attributes) {
+                vertexDescriptor->attributes()->object(attribute.semantic)->setOffset(attribute.offset);
+                vertexDescriptor->attributes()->object(attribute.semantic)->setFormat(attribute.format);
+                vertexDescriptor->attributes()->object(attribute.semantic)->setBufferIndex(0);
             }
-            // Indices
-            {
-                const tinygltf::Accessor &accessor = model.accessors[primitive.indices];
-                const tinygltf::BufferView &bufferView = model.bufferViews[accessor.bufferView];
-                const tinygltf::Buffer &buffer = model.buffers[bufferView.buffer];
-                
-                indexBuffer.reserve(accessor.count);
-                switch (accessor.componentType) {
-                    case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
-                        std::vector<uint32_t> buf32(accessor.count);
-                        memcpy(buf32.data(), &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint32_t));
-                        for (size_t index = 0; index < accessor.count; index++) {
-                            indexBuffer.push_back(buf32[index]);
-                        }
-                        break;
-                    }
-                    case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
-                        std::vector<uint16_t> buf16(accessor.count);
-                        memcpy(buf16.data(), &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint16_t));
-                        for (size_t index = 0; index < accessor.count; index++) {
-                            indexBuffer.push_back(buf16[index]);
-                        }
-                        break;
-                    }
-                    case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
-                        std::vector<uint8_t> buf8(accessor.count);
-                        memcpy(buf8.data(), &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint8_t));
-                        for (size_t index = 0; index < accessor.count; index++) {
-                            indexBuffer.push_back(buf8[index]);
-                        }
-                        break;
-                    }
-                    default:
-                        LOG(ERROR) << "Index component type " << accessor.componentType << " not supported!"
-                        << std::endl;
-                        return;
-                }
+            vertexDescriptor->layouts()->object(0)->setStride(primitive.stride);
+            bufferMesh->setVertexLayouts(vertexDescriptor);
+            
+            // 16 bit indices whenever every vertex is addressable
+            const size_t vertexCount = primitive.vertexCount() * sizeof(float) / primitive.stride;
+            const auto indexType = MeshOptimizer::fitsUInt16(vertexCount) ? MTL::IndexTypeUInt16 : MTL::IndexTypeUInt32;
+            std::shared_ptr<MTL::Buffer> iBuffer;
+            if (indexType == MTL::IndexTypeUInt16) {
+                const std::vector<uint16_t> indices(primitive.indexData(), primitive.indexData() + primitive.indexCount());
+                iBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _device.newBuffer(indices.data(),
+                                                                                    indices.size() * sizeof(uint16_t),
+                                                                                    MTL::ResourceOptionCPUCacheModeDefault));
+            } else {
+                iBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _device.newBuffer(primitive.indexData(),
+                                                                                    primitive.indexCount() * sizeof(uint32_t),
+                                                                                    MTL::ResourceOptionCPUCacheModeDefault));
             }
-            auto iBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _device.newBuffer(indexBuffer.data(),
-                                                                                     indexBuffer.size() * sizeof(uint32_t),
-                                                                                     MTL::ResourceOptionCPUCacheModeDefault));
-            auto vBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _device.newBuffer(vertexBuffer.data(),
-                                                                                     vertexBuffer.size() * sizeof(float),
+            auto vBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _device.newBuffer(primitive.vertexData(),
+                                                                                     primitive.vertexCount() * sizeof(float),
                                                                                      MTL::ResourceOptionCPUCacheModeDefault));
             bufferMesh->setVertexBufferBinding(vBuffer);
-            bufferMesh->addSubMesh(MTL::PrimitiveTypeTriangle, MTL::IndexTypeUInt32,
-                                   static_cast<uint32_t>(indexBuffer.size()), iBuffer);
-            bufferMesh->bounds = bound;
+            bufferMesh->addSubMesh(MTL::PrimitiveTypeTriangle, indexType,
+                                   static_cast<uint32_t>(primitive.indexCount()), iBuffer);
+            bufferMesh->bounds = primitive.bounds;
             renderer.emplace_back(std::make_pair(bufferMesh, primitive.material > -1 ? materials[primitive.material] : materials.back()));
         }
         renderers.push_back(renderer);
     }
 }
 
-void GLTFLoader::loadSkins(tinygltf::Model &gltfModel) {
-    for (tinygltf::Skin &source: gltfModel.skins) {
+void GLTFLoader::loadSkins(const GLTFContent &content) {
+    for (const GLTFSkin &source: content.skins) {
         GPUSkinnedMeshRenderer::SkinPtr newSkin = std::make_shared<GPUSkinnedMeshRenderer::Skin>();
         newSkin->name = source.name;
         
@@ -581,15 +368,8 @@ void GLTFLoader::loadSkins(tinygltf::Model &gltfModel) {
             }
         }
         
-        // Get inverse bind matrices from buffer
-        if (source.inverseBindMatrices > -1) {
-            const tinygltf::Accessor &accessor = gltfModel.accessors[source.inverseBindMatrices];
-            const tinygltf::BufferView &bufferView = gltfModel.bufferViews[accessor.bufferView];
-            const tinygltf::Buffer &buffer = gltfModel.buffers[bufferView.buffer];
-            newSkin->inverseBindMatrices.resize(accessor.count);
-            memcpy(newSkin->inverseBindMatrices.data(), &buffer.data[accessor.byteOffset + bufferView.byteOffset],
-                   accessor.count * sizeof(Matrix4x4F));
-        }
+        // Inverse bind matrices are read by GLTFDecoder
+        newSkin->inverseBindMatrices = source.inverseBindMatrices;
         
         skins.push_back(std::move(newSkin));
     }
@@ -617,16 +397,12 @@ void GLTFLoader::loadAnimations(tinygltf::Model &gltfModel) {
             
             // Read sampler input time values
             {
-                const tinygltf::Accessor &accessor = gltfModel.accessors[samp.input];
-                const tinygltf::BufferView &bufferView = gltfModel.bufferViews[accessor.bufferView];
-                const tinygltf::Buffer &buffer = gltfModel.buffers[bufferView.buffer];
-                
-                assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
-                
-                float *buf = new float[accessor.count];
-                memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(float));
-                for (size_t index = 0; index < accessor.count; index++) {
-                    sampler.inputs.push_back(buf[index]);
+                const AccessorView view = keyframeView(gltfModel, samp.input);
+                if (view.valid() && view.componentCount == 1) {
+                    sampler.inputs.resize(view.count);
+                    convertToFloat(view, sampler.inputs.data(), 1, 1, 0, view.count);
+                } else {
+                    LOG(ERROR) << "invalid keyframe times" << std::endl;
                 }
                 
                 for (auto input: sampler.inputs) {
@@ -641,33 +417,16 @@ void GLTFLoader::loadAnimations(tinygltf::Model &gltfModel) {
             
             // Read sampler output T/R/S values
             {
-                const tinygltf::Accessor &accessor = gltfModel.accessors[samp.output];
-                const tinygltf::BufferView &bufferView = gltfModel.bufferViews[accessor.bufferView];
-                const tinygltf::Buffer &buffer = gltfModel.buffers[bufferView.buffer];
-                
-                assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
-                
-                switch (accessor.type) {
-                    case TINYGLTF_TYPE_VEC3: {
-                        Vector3F *buf = new Vector3F[accessor.count];
-                        memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(Vector3F));
-                        for (size_t index = 0; index < accessor.count; index++) {
-                            sampler.outputsVec4.push_back(Vector4F(buf[index], 0.0f));
-                        }
-                        break;
-                    }
-                    case TINYGLTF_TYPE_VEC4: {
-                        Vector4F *buf = new Vector4F[accessor.count];
-                        memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(Vector4F));
-                        for (size_t index = 0; index < accessor.count; index++) {
-                            sampler.outputsVec4.push_back(buf[index]);
-                        }
-                        break;
-                    }
-                    default: {
-                        LOG(ERROR) << "unknown type" << std::endl;
-                        break;
-                    }
+                const AccessorView view = keyframeView(gltfModel, samp.output);
+                if (view.valid() && (view.componentCount == 3 || view.componentCount == 4)) {
+                    // normalized integer rotations are converted to float as well
+                    sampler.components = view.componentCount;
+                    sampler.outputs.resize(view.count * sampler.components);
+                    convertToFloat(view, sampler.outputs.data(), sampler.components, sampler.components, 0, view.count);
+                } else {
+                    // kept without outputs, channels index samplers by position
+                    LOG(ERROR) << "unknown type" << std::endl;
+                    sampler.components = 0;
                 }
             }
             
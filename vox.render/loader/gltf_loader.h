@@ -10,43 +10,85 @@
 #include "mesh/gpu_skinned_mesh_renderer.h"
 #include "entity.h"
 #include "texture/sampled_texture2d.h"
-
-#define TINYGLTF_NO_STB_IMAGE_WRITE
-
-#include <tiny_gltf.h>
+#include "gltf_decoder.h"
 
 namespace vox {
+class SampledTextureStreamer;
+
 namespace loader {
+/**
+ * Handle of a glTF file which is decoded in background.
+ */
+class GLTFLoadRequest {
+public:
+    /**
+     * Fraction of the CPU work already done, in [0, 1].
+     */
+    float progress() const;
+    
+    /**
+     * Whether GLTFLoader::finishLoad can run without waiting.
+     */
+    bool isReady() const;
+    
+private:
+    friend class GLTFLoader;
+    
+    GLTFDecoder _decoder{};
+    std::future<std::unique_ptr<GLTFContent>> _content{};
+};
+using GLTFLoadRequestPtr = std::shared_ptr<GLTFLoadRequest>;
 
 class GLTFLoader {
 public:
-    std::vector<std::unique_ptr<Image>> images;
+    std::vector<std::shared_ptr<const Image>> images;
     std::vector<SampledTexture2DPtr> textures;
     std::vector<MaterialPtr> materials;
     std::vector<std::vector<std::pair<MeshPtr, MaterialPtr>>> renderers;
     std::vector<GPUSkinnedMeshRenderer::SkinPtr> skins;
     
+    /**
+     * Streams the textures instead of uploading every level, when set.
+     * @remarks images is emptied, the streamer keeps what it needs.
+     */
+    SampledTextureStreamer *textureStreamer{nullptr};
+    
     GLTFLoader(MTL::Device &device, MTL::CommandQueue &queue);
     
+    /**
+     * Load the file on the calling thread.
+     * @param scale - Uniform scale applied to defaultSceneRoot
+     */
     void loadFromFile(std::string filename, EntityPtr defaultSceneRoot, float scale = 1.0f);
     
-private:
-    void loadScene(tinygltf::Model &gltfModel);
+    /**
+     * Start to parse the file and decode images and vertices on the shared ThreadPool.
+     * @param filename - Path relative to the assets
+     * @returns Request which is passed to finishLoad.
+     */
+    static GLTFLoadRequestPtr loadFromFileAsync(std::string filename);
     
-    void loadNode(EntityPtr parent, const tinygltf::Node &node, uint32_t nodeIndex,
-                  const tinygltf::Model &model);
+    /**
+     * Upload the decoded content and create entities, must be called on the main thread.
+     * @remarks Waits if the request is not ready yet.
+     * @returns False if the file can not be loaded.
+     */
+    bool finishLoad(const GLTFLoadRequestPtr &request, EntityPtr defaultSceneRoot);
     
-    void loadImages(tinygltf::Model &gltfModel);
+private:
+    void loadScene(GLTFContent &content);
+    
+    void loadNode(EntityPtr parent, int nodeIndex, const GLTFContent &content);
     
     void loadSampler(const tinygltf::Sampler &gltf_sampler, SampledTexture2DPtr texture) const;
     
-    void loadTextures(tinygltf::Model &gltfModel);
+    void loadTextures(GLTFContent &content);
     
     void loadMaterials(tinygltf::Model &gltfModel);
     
-    void loadMeshes(tinygltf::Model &gltfModel);
+    void loadMeshes(GLTFContent &content);
     
-    void loadSkins(tinygltf::Model &gltfModel);
+    void loadSkins(const GLTFContent &content);
     
     void loadAnimations(tinygltf::Model &gltfModel);
     
@@ -54,18 +96,6 @@ private:
     MTL::Device &_device;
     MTL::CommandQueue &_queue;
     
-    std::string _path{};
-    
-    /// The extensions that the GLTFLoader can load mapped to whether they should be enabled or not
-    static std::unordered_map<std::string, bool> _supportedExtensions;
-    
-    /**
-     * @brief Checks if the GLTFLoader supports an extension, and that it is present in the glTF file
-     * @param requested_extension The extension to check
-     * @returns True if the loader knows how to load the extension and it is present in the glTF file, false if not
-     */
-    bool isExtensionEnabled(const std::string &requested_extension);
-    
     /**
      * @brief Finds whether an extension exists inside a tinygltf extension map and returns the result
      * @param tinygltf_extensions The extension map associated with a given tinygltf object
@@ -0,0 +1,415 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "mesh_cache.h"
+#include <glog/logging.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vox {
+namespace loader {
+namespace {
+constexpr uint64_t kAlignment = 16;
+
+uint64_t align(uint64_t offset) {
+    return (offset + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+uint64_t rotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t mix(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+template<class T>
+void append(std::vector<unsigned char> &section, const T *values, size_t count) {
+    const auto bytes = reinterpret_cast<const unsigned char *>(values);
+    section.insert(section.end(), bytes, bytes + count * sizeof(T));
+}
+
+// range of count records of size stride starting at offset lies inside size
+bool inside(uint64_t offset, uint64_t count, uint64_t stride, uint64_t size) {
+    if (offset > size || (stride != 0 && count > (size - offset) / stride)) {
+        return false;
+    }
+    return true;
+}
+
+// index into count records, -1 stands for none where it is optional
+bool indexes(int32_t index, uint32_t count, bool optional = false) {
+    return (optional && index == -1) || (index >= 0 && static_cast<uint32_t>(index) < count);
+}
+
+bool indexesAll(const int32_t *indices, uint32_t count, uint32_t nodeCount) {
+    return std::all_of(indices, indices + count, [nodeCount](int32_t index) {
+        return indexes(index, nodeCount);
+    });
+}
+
+} // namespace
+
+uint64_t contentHash(const void *data, size_t size, uint64_t seed) {
+    constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+    auto bytes = static_cast<const unsigned char *>(data);
+    uint64_t hash = seed ^ (size * kPrime1);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash ^= rotateLeft(word * kPrime2, 31) * kPrime1;
+        hash = rotateLeft(hash, 27) * kPrime1 + kPrime2;
+    }
+    for (; i < size; i++) {
+        hash ^= bytes[i] * kPrime1;
+        hash = rotateLeft(hash, 11) * kPrime2;
+    }
+    return mix(hash);
+}
+
+//MARK: - Write
+bool MeshCache::write(const std::string &filename, uint64_t sourceHash, const GLTFContent &content) {
+    std::vector<MeshRecord> meshes;
+    std::vector<PrimitiveRecord> primitives;
+    std::vector<AttributeRecord> attributes;
+    std::vector<NodeRecord> nodes;
+    std::vector<SkinRecord> skins;
+    std::vector<int32_t> indices;
+    std::vector<float> matrices;
+    std::string strings;
+    std::vector<unsigned char> data;
+
+    for (const auto &mesh : content.meshes) {
+        meshes.push_back({static_cast<uint32_t>(primitives.size()), static_cast<uint32_t>(mesh.size())});
+        for (const auto &primitive : mesh) {
+            PrimitiveRecord record{};
+            record.vertexOffset = align(data.size());
+            record.vertexCount = primitive.vertexCount();
+            data.resize(record.vertexOffset);
+            append(data, primitive.vertexData(), primitive.vertexCount());
+            record.indexOffset = align(data.size());
+            record.indexCount = primitive.indexCount();
+            data.resize(record.indexOffset);
+            append(data, primitive.indexData(), primitive.indexCount());
+
+            record.stride = primitive.stride;
+            record.firstAttribute = static_cast<uint32_t>(attributes.size());
+            record.attributeCount = static_cast<uint32_t>(primitive.attributes.size());
+            record.material = primitive.material;
+            const auto &lower = primitive.bounds.lowerCorner;
+            const auto &upper = primitive.bounds.upperCorner;
+            std::copy(&lower.x, &lower.x + 3, record.boundsMin);
+            std::copy(&upper.x, &upper.x + 3, record.boundsMax);
+            for (const auto &attribute : primitive.attributes) {
+                attributes.push_back({static_cast<uint32_t>(attribute.semantic),
+                                      static_cast<uint32_t>(attribute.format), attribute.offset});
+            }
+            primitives.push_back(record);
+        }
+    }
+
+    for (const auto &node : content.nodes) {
+        NodeRecord record{};
+        record.nameOffset = static_cast<uint32_t>(strings.size());
+        record.nameLength = static_cast<uint32_t>(node.name.size());
+        strings += node.name;
+        record.mesh = node.mesh;
+        record.skin = node.skin;
+        record.firstChild = static_cast<uint32_t>(indices.size());
+        record.childCount = static_cast<uint32_t>(node.children.size());
+        indices.insert(indices.end(), node.children.begin(), node.children.end());
+        record.hasMatrix = node.hasMatrix;
+        std::copy(node.translation, node.translation + 3, record.translation);
+        std::copy(node.rotation, node.rotation + 4, record.rotation);
+        std::copy(node.scale, node.scale + 3, record.scale);
+        std::copy(node.matrix, node.matrix + 16, record.matrix);
+        nodes.push_back(record);
+    }
+
+    for (const auto &skin : content.skins) {
+        SkinRecord record{};
+        record.nameOffset = static_cast<uint32_t>(strings.size());
+        record.nameLength = static_cast<uint32_t>(skin.name.size());
+        strings += skin.name;
+        record.firstJoint = static_cast<uint32_t>(indices.size());
+        record.jointCount = static_cast<uint32_t>(skin.joints.size());
+        indices.insert(indices.end(), skin.joints.begin(), skin.joints.end());
+        record.firstMatrix = static_cast<uint32_t>(matrices.size() / 16);
+        record.matrixCount = static_cast<uint32_t>(skin.inverseBindMatrices.size());
+        for (const auto &matrix : skin.inverseBindMatrices) {
+            matrices.insert(matrices.end(), matrix.data(), matrix.data() + 16);
+        }
+        skins.push_back(record);
+    }
+
+    Header header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.sourceHash = sourceHash;
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+    header.primitiveCount = static_cast<uint32_t>(primitives.size());
+    header.attributeCount = static_cast<uint32_t>(attributes.size());
+    header.nodeCount = static_cast<uint32_t>(nodes.size());
+    header.skinCount = static_cast<uint32_t>(skins.size());
+    header.firstSceneNode = static_cast<uint32_t>(indices.size());
+    header.sceneNodeCount = static_cast<uint32_t>(content.sceneNodes.size());
+    indices.insert(indices.end(), content.sceneNodes.begin(), content.sceneNodes.end());
+    header.indexCount = static_cast<uint32_t>(indices.size());
+    header.matrixCount = static_cast<uint32_t>(matrices.size() / 16);
+    header.stringSize = static_cast<uint32_t>(strings.size());
+    header.materialCount = static_cast<uint32_t>(content.model.materials.size());
+
+    header.meshOffset = align(sizeof(Header));
+    header.primitiveOffset = align(header.meshOffset + meshes.size() * sizeof(MeshRecord));
+    header.attributeOffset = align(header.primitiveOffset + primitives.size() * sizeof(PrimitiveRecord));
+    header.nodeOffset = align(header.attributeOffset + attributes.size() * sizeof(AttributeRecord));
+    header.skinOffset = align(header.nodeOffset + nodes.size() * sizeof(NodeRecord));
+    header.indexOffset = align(header.skinOffset + skins.size() * sizeof(SkinRecord));
+    header.matrixOffset = align(header.indexOffset + indices.size() * sizeof(int32_t));
+    header.stringOffset = align(header.matrixOffset + matrices.size() * sizeof(float));
+    header.dataOffset = align(header.stringOffset + strings.size());
+    header.dataSize = data.size();
+    header.fileSize = header.dataOffset + data.size();
+
+    std::vector<unsigned char> file(header.fileSize, 0);
+    auto place = [&](uint64_t offset, const void *source, size_t size) {
+        if (size > 0) {
+            memcpy(file.data() + offset, source, size);
+        }
+    };
+    place(0, &header, sizeof(Header));
+    place(header.meshOffset, meshes.data(), meshes.size() * sizeof(MeshRecord));
+    place(header.primitiveOffset, primitives.data(), primitives.size() * sizeof(PrimitiveRecord));
+    place(header.attributeOffset, attributes.data(), attributes.size() * sizeof(AttributeRecord));
+    place(header.nodeOffset, nodes.data(), nodes.size() * sizeof(NodeRecord));
+    place(header.skinOffset, skins.data(), skins.size() * sizeof(SkinRecord));
+    place(header.indexOffset, indices.data(), indices.size() * sizeof(int32_t));
+    place(header.matrixOffset, matrices.data(), matrices.size() * sizeof(float));
+    place(header.stringOffset, strings.data(), strings.size());
+    place(header.dataOffset, data.data(), data.size());
+
+    // a reader never sees a half written file
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+        if (!stream) {
+            return false;
+        }
+        stream.write(reinterpret_cast<const char *>(file.data()), file.size());
+        if (!stream) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+//MARK: - Read
+std::unique_ptr<MeshCache> MeshCache::open(const std::string &filename, uint64_t sourceHash) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        close(fd);
+        return nullptr;
+    }
+    void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file alive
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::unique_ptr<MeshCache> cache(new MeshCache());
+    cache->_mapping = mapping;
+    cache->_size = info.st_size;
+    auto base = static_cast<const unsigned char *>(mapping);
+    cache->_header = reinterpret_cast<const Header *>(base);
+    const auto &header = *cache->_header;
+    if (header.magic != kMagic || header.version != kVersion || header.sourceHash != sourceHash) {
+        return nullptr;
+    }
+    if (!cache->_validate()) {
+        LOG(WARNING) << "damaged mesh cache " << filename << std::endl;
+        return nullptr;
+    }
+    cache->_meshes = reinterpret_cast<const MeshRecord *>(base + header.meshOffset);
+    cache->_primitives = reinterpret_cast<const PrimitiveRecord *>(base + header.primitiveOffset);
+    cache->_attributes = reinterpret_cast<const AttributeRecord *>(base + header.attributeOffset);
+    cache->_nodes = reinterpret_cast<const NodeRecord *>(base + header.nodeOffset);
+    cache->_skins = reinterpret_cast<const SkinRecord *>(base + header.skinOffset);
+    cache->_indices = reinterpret_cast<const int32_t *>(base + header.indexOffset);
+    cache->_matrices = reinterpret_cast<const float *>(base + header.matrixOffset);
+    cache->_strings = reinterpret_cast<const char *>(base + header.stringOffset);
+    cache->_data = base + header.dataOffset;
+
+    // records point into each other and into the source, check them once here so readers need no checks
+    for (uint32_t i = 0; i < header.meshCount; i++) {
+        const auto &mesh = cache->_meshes[i];
+        if (!inside(mesh.firstPrimitive, mesh.primitiveCount, 1, header.primitiveCount)) {
+            return nullptr;
+        }
+    }
+    for (uint32_t i = 0; i < header.primitiveCount; i++) {
+        const auto &primitive = cache->_primitives[i];
+        if (!inside(primitive.firstAttribute, primitive.attributeCount, 1, header.attributeCount) ||
+            !inside(primitive.vertexOffset, primitive.vertexCount, sizeof(float), header.dataSize) ||
+            !inside(primitive.indexOffset, primitive.indexCount, sizeof(uint32_t), header.dataSize) ||
+            !indexes(primitive.material, header.materialCount, true)) {
+            return nullptr;
+        }
+        // the indices go to the GPU and to the CPU passes unchecked
+        if (primitive.indexCount > 0) {
+            if (primitive.stride == 0 || primitive.stride % sizeof(float) != 0) {
+                return nullptr;
+            }
+            const uint64_t vertexCount = primitive.vertexCount / (primitive.stride / sizeof(float));
+            const uint32_t *indices = cache->indices(primitive);
+            if (*std::max_element(indices, indices + primitive.indexCount) >= vertexCount) {
+                return nullptr;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < header.nodeCount; i++) {
+        const auto &node = cache->_nodes[i];
+        if (!inside(node.firstChild, node.childCount, 1, header.indexCount) ||
+            !inside(node.nameOffset, node.nameLength, 1, header.stringSize) ||
+            !indexes(node.mesh, header.meshCount, true) || !indexes(node.skin, header.skinCount, true) ||
+            !indexesAll(cache->_indices + node.firstChild, node.childCount, header.nodeCount)) {
+            return nullptr;
+        }
+    }
+    for (uint32_t i = 0; i < header.skinCount; i++) {
+        const auto &skin = cache->_skins[i];
+        if (!inside(skin.firstJoint, skin.jointCount, 1, header.indexCount) ||
+            !inside(skin.firstMatrix, skin.matrixCount, 1, header.matrixCount) ||
+            !inside(skin.nameOffset, skin.nameLength, 1, header.stringSize) ||
+            !indexesAll(cache->_indices + skin.firstJoint, skin.jointCount, header.nodeCount)) {
+            return nullptr;
+        }
+    }
+    if (!inside(header.firstSceneNode, header.sceneNodeCount, 1, header.indexCount) ||
+        !indexesAll(cache->_indices + header.firstSceneNode, header.sceneNodeCount, header.nodeCount)) {
+        return nullptr;
+    }
+    return cache;
+}
+
+MeshCache::~MeshCache() {
+    if (_mapping) {
+        munmap(_mapping, _size);
+    }
+}
+
+bool MeshCache::_validate() const {
+    const auto &header = *_header;
+    if (header.fileSize != _size) {
+        return false;
+    }
+    const uint64_t offsets[] = {header.meshOffset, header.primitiveOffset, header.attributeOffset, header.nodeOffset,
+        header.skinOffset, header.indexOffset, header.matrixOffset, header.stringOffset, header.dataOffset};
+    for (auto offset : offsets) {
+        if (offset % kAlignment != 0) {
+            return false;
+        }
+    }
+    return inside(header.meshOffset, header.meshCount, sizeof(MeshRecord), _size) &&
+    inside(header.primitiveOffset, header.primitiveCount, sizeof(PrimitiveRecord), _size) &&
+    inside(header.attributeOffset, header.attributeCount, sizeof(AttributeRecord), _size) &&
+    inside(header.nodeOffset, header.nodeCount, sizeof(NodeRecord), _size) &&
+    inside(header.skinOffset, header.skinCount, sizeof(SkinRecord), _size) &&
+    inside(header.indexOffset, header.indexCount, sizeof(int32_t), _size) &&
+    inside(header.matrixOffset, header.matrixCount, sizeof(float) * 16, _size) &&
+    inside(header.stringOffset, header.stringSize, 1, _size) &&
+    inside(header.dataOffset, header.dataSize, 1, _size);
+}
+
+void MeshCache::read(GLTFContent &content, bool copyStreams) const {
+    const auto &header = *_header;
+    content.meshes.clear();
+    content.meshes.resize(header.meshCount);
+    for (uint32_t i = 0; i < header.meshCount; i++) {
+        const auto &mesh = _meshes[i];
+        auto &primitives = content.meshes[i];
+        primitives.resize(mesh.primitiveCount);
+        for (uint32_t j = 0; j < mesh.primitiveCount; j++) {
+            const auto &record = _primitives[mesh.firstPrimitive + j];
+            auto &primitive = primitives[j];
+            primitive.stride = record.stride;
+            primitive.material = record.material;
+            primitive.bounds = BoundingBox3F(Point3F(record.boundsMin[0], record.boundsMin[1], record.boundsMin[2]),
+                                             Point3F(record.boundsMax[0], record.boundsMax[1], record.boundsMax[2]));
+            const auto first = attributes(record);
+            for (uint32_t k = 0; k < record.attributeCount; k++) {
+                primitive.attributes.push_back({static_cast<Attributes>(first[k].semantic),
+                    static_cast<MTL::VertexFormat>(first[k].format), first[k].offset});
+            }
+            if (copyStreams) {
+                primitive.vertices.assign(vertices(record), vertices(record) + record.vertexCount);
+                primitive.indices.assign(indices(record), indices(record) + record.indexCount);
+            } else {
+                primitive.mappedVertices = vertices(record);
+                primitive.mappedVertexCount = record.vertexCount;
+                primitive.mappedIndices = indices(record);
+                primitive.mappedIndexCount = record.indexCount;
+            }
+        }
+    }
+
+    content.nodes.clear();
+    content.nodes.resize(header.nodeCount);
+    for (uint32_t i = 0; i < header.nodeCount; i++) {
+        const auto &record = _nodes[i];
+        auto &node = content.nodes[i];
+        node.name = std::string(string(record.nameOffset, record.nameLength));
+        node.mesh = record.mesh;
+        node.skin = record.skin;
+        node.children.assign(_indices + record.firstChild, _indices + record.firstChild + record.childCount);
+        std::copy(record.translation, record.translation + 3, node.translation);
+        std::copy(record.rotation, record.rotation + 4, node.rotation);
+        std::copy(record.scale, record.scale + 3, node.scale);
+        std::copy(record.matrix, record.matrix + 16, node.matrix);
+        node.hasMatrix = record.hasMatrix != 0;
+    }
+
+    content.skins.clear();
+    content.skins.resize(header.skinCount);
+    for (uint32_t i = 0; i < header.skinCount; i++) {
+        const auto &record = _skins[i];
+        auto &skin = content.skins[i];
+        skin.name = std::string(string(record.nameOffset, record.nameLength));
+        skin.joints.assign(_indices + record.firstJoint, _indices + record.firstJoint + record.jointCount);
+        skin.inverseBindMatrices.resize(record.matrixCount);
+        for (uint32_t j = 0; j < record.matrixCount; j++) {
+            std::copy(matrix(record.firstMatrix + j), matrix(record.firstMatrix + j) + 16,
+                      skin.inverseBindMatrices[j].data());
+        }
+    }
+
+    content.sceneNodes.assign(_indices + header.firstSceneNode, _indices + header.firstSceneNode + header.sceneNodeCount);
+}
+
+}
+}
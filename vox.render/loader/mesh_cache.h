@@ -0,0 +1,202 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef mesh_cache_hpp
+#define mesh_cache_hpp
+
+#include "gltf_decoder.h"
+#include <string_view>
+
+namespace vox {
+namespace loader {
+/**
+ * 64 bit hash of bytes, used to find out whether the source of a cache changed.
+ * @param seed - Hash of the previous bytes, to hash several blocks as one
+ */
+uint64_t contentHash(const void *data, size_t size, uint64_t seed = 0);
+
+/**
+ * Binary cache of processed meshes, skins and hierarchy, read back with mmap.
+ * @remarks All records are fixed size and the file is in native byte order, opening checks every range and index.
+ * Layout: header, then every section aligned to 16 bytes, see the Record types.
+ */
+class MeshCache {
+public:
+    static constexpr uint32_t kMagic = 0x434D5856; // "VXMC"
+    /** 2: primitives are welded and reordered by MeshOptimizer, 3: the material count is stored. */
+    static constexpr uint32_t kVersion = 3;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceHash;
+        uint64_t fileSize;
+        uint32_t meshCount;
+        uint32_t primitiveCount;
+        uint32_t attributeCount;
+        uint32_t nodeCount;
+        uint32_t skinCount;
+        uint32_t indexCount;
+        uint32_t matrixCount;
+        uint32_t firstSceneNode;
+        uint32_t sceneNodeCount;
+        uint32_t stringSize;
+        /** Materials of the source file, which primitives index. */
+        uint32_t materialCount;
+        uint64_t meshOffset;
+        uint64_t primitiveOffset;
+        uint64_t attributeOffset;
+        uint64_t nodeOffset;
+        uint64_t skinOffset;
+        uint64_t indexOffset;
+        uint64_t matrixOffset;
+        uint64_t stringOffset;
+        uint64_t dataOffset;
+        uint64_t dataSize;
+    };
+
+    struct MeshRecord {
+        uint32_t firstPrimitive;
+        uint32_t primitiveCount;
+    };
+
+    struct PrimitiveRecord {
+        /** Offsets relative to the data section. */
+        uint64_t vertexOffset;
+        uint64_t vertexCount;
+        uint64_t indexOffset;
+        uint64_t indexCount;
+        uint32_t stride;
+        uint32_t firstAttribute;
+        uint32_t attributeCount;
+        int32_t material;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    struct AttributeRecord {
+        uint32_t semantic;
+        uint32_t format;
+        uint32_t offset;
+    };
+
+    struct NodeRecord {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        int32_t mesh;
+        int32_t skin;
+        /** Range in the index section. */
+        uint32_t firstChild;
+        uint32_t childCount;
+        uint32_t hasMatrix;
+        float translation[3];
+        float rotation[4];
+        float scale[3];
+        float matrix[16];
+    };
+
+    struct SkinRecord {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        /** Range in the index section. */
+        uint32_t firstJoint;
+        uint32_t jointCount;
+        /** Range in the matrix section. */
+        uint32_t firstMatrix;
+        uint32_t matrixCount;
+    };
+
+    /**
+     * Write the meshes, nodes, skins and scene nodes of content.
+     */
+    static bool write(const std::string &filename, uint64_t sourceHash, const GLTFContent &content);
+
+    /**
+     * Map a cache file.
+     * @returns nullptr if the file is missing, damaged, of another version or made from another source.
+     */
+    static std::unique_ptr<MeshCache> open(const std::string &filename, uint64_t sourceHash);
+
+    ~MeshCache();
+
+    MeshCache(const MeshCache &) = delete;
+
+    MeshCache &operator=(const MeshCache &) = delete;
+
+    const Header &header() const {
+        return *_header;
+    }
+
+    const MeshRecord &mesh(size_t index) const {
+        return _meshes[index];
+    }
+
+    const PrimitiveRecord &primitive(size_t index) const {
+        return _primitives[index];
+    }
+
+    const AttributeRecord *attributes(const PrimitiveRecord &primitive) const {
+        return _attributes + primitive.firstAttribute;
+    }
+
+    const float *vertices(const PrimitiveRecord &primitive) const {
+        return reinterpret_cast<const float *>(_data + primitive.vertexOffset);
+    }
+
+    const uint32_t *indices(const PrimitiveRecord &primitive) const {
+        return reinterpret_cast<const uint32_t *>(_data + primitive.indexOffset);
+    }
+
+    const NodeRecord &node(size_t index) const {
+        return _nodes[index];
+    }
+
+    const SkinRecord &skin(size_t index) const {
+        return _skins[index];
+    }
+
+    const int32_t *indexSection() const {
+        return _indices;
+    }
+
+    const float *matrix(size_t index) const {
+        return _matrices + index * 16;
+    }
+
+    std::string_view string(uint32_t offset, uint32_t length) const {
+        return std::string_view(_strings + offset, length);
+    }
+
+    /**
+     * Copy the cached meshes, nodes, skins and scene nodes into content.
+     * @param copyStreams - If false the primitives point into the mapping, which must outlive them
+     */
+    void read(GLTFContent &content, bool copyStreams = true) const;
+
+private:
+    MeshCache() = default;
+
+    bool _validate() const;
+
+    void *_mapping{nullptr};
+    size_t _size{0};
+
+    const Header *_header{nullptr};
+    const MeshRecord *_meshes{nullptr};
+    const PrimitiveRecord *_primitives{nullptr};
+    const AttributeRecord *_attributes{nullptr};
+    const NodeRecord *_nodes{nullptr};
+    const SkinRecord *_skins{nullptr};
+    const int32_t *_indices{nullptr};
+    const float *_matrices{nullptr};
+    const char *_strings{nullptr};
+    const unsigned char *_data{nullptr};
+};
+
+}
+}
+
+#endif /* mesh_cache_hpp */
@@ -0,0 +1,82 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "lod_group.h"
+#include "mesh_renderer.h"
+#include "camera.h"
+#include "entity.h"
+#include "math_utils.h"
+#include <cmath>
+#include <limits>
+
+namespace vox {
+LODGroup::LODGroup(Entity *entity) :
+Component(entity) {
+}
+
+void LODGroup::setLods(const std::vector<LOD> &lods) {
+    _lods = lods;
+    _currentLod = -1;
+    auto renderer = entity()->getComponent<MeshRenderer>();
+    if (renderer != nullptr && !_lods.empty()) {
+        _currentLod = 0;
+        renderer->setMesh(_lods[0].mesh);
+    }
+}
+
+const std::vector<LODGroup::LOD> &LODGroup::lods() const {
+    return _lods;
+}
+
+int LODGroup::currentLod() const {
+    return _currentLod;
+}
+
+float LODGroup::screenRelativeHeight(const Camera *camera, const BoundingBox3F &bounds) {
+    const float diameter = bounds.diagonalLength();
+    if (camera->isOrthographic()) {
+        return diameter / (2 * camera->orthographicSize());
+    }
+    const auto position = camera->entity()->transform->worldPosition();
+    const float distance = bounds.midPoint().distanceTo(position);
+    if (distance <= diameter * 0.5f) {
+        // inside the bounding sphere
+        return std::numeric_limits<float>::max();
+    }
+    return diameter / (2 * distance * std::tan(degreesToRadians(camera->fieldOfView()) * 0.5f));
+}
+
+int LODGroup::selectLod(const std::vector<LOD> &lods, float screenRelativeHeight) {
+    for (size_t i = 0; i < lods.size(); i++) {
+        if (screenRelativeHeight >= lods[i].screenRelativeHeight) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool LODGroup::_update(Renderer *renderer, const Camera *camera) {
+    auto meshRenderer = entity()->getComponent<MeshRenderer>();
+    if (_lods.empty() || meshRenderer == nullptr || meshRenderer != renderer) {
+        return true;
+    }
+    const int level = selectLod(_lods, screenRelativeHeight(camera, renderer->bounds()) * lodBias);
+    if (level != _currentLod && level >= 0) {
+        meshRenderer->setMesh(_lods[level].mesh);
+    }
+    _currentLod = level;
+    return level >= 0;
+}
+
+void LODGroup::_onDisable() {
+    auto renderer = entity()->getComponent<MeshRenderer>();
+    if (renderer != nullptr && !_lods.empty()) {
+        renderer->setMesh(_lods[0].mesh);
+    }
+    _currentLod = 0;
+}
+
+}
@@ -0,0 +1,74 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef lod_group_hpp
+#define lod_group_hpp
+
+#include "component.h"
+#include "graphics/mesh.h"
+#include "bounding_box3.h"
+
+namespace vox {
+class Renderer;
+
+/**
+ * Switches the mesh of the MeshRenderer of the entity by the height of its bounds on screen.
+ * @remarks The level is picked for every camera while collecting render elements, shadow maps
+ * use the level of the camera they are rendered for.
+ */
+class LODGroup : public Component {
+public:
+    struct LOD {
+        MeshPtr mesh;
+        /** Smallest height of the bounds, as a fraction of the screen height, which still draws this level. */
+        float screenRelativeHeight;
+    };
+
+    /** Scales the projected height, larger values keep detailed levels longer. */
+    float lodBias = 1;
+
+    explicit LODGroup(Entity *entity);
+
+    /**
+     * Levels from the most detailed one, with decreasing screenRelativeHeight.
+     */
+    void setLods(const std::vector<LOD> &lods);
+
+    const std::vector<LOD> &lods() const;
+
+    /**
+     * Level drawn for the last camera, -1 if the bounds were smaller than the last level.
+     */
+    int currentLod() const;
+
+    /**
+     * Height of a sphere enclosing the bounds as a fraction of the screen height.
+     */
+    static float screenRelativeHeight(const Camera *camera, const BoundingBox3F &bounds);
+
+    /**
+     * First level whose screenRelativeHeight is reached, -1 if none.
+     */
+    static int selectLod(const std::vector<LOD> &lods, float screenRelativeHeight);
+
+public:
+    void _onDisable() override;
+
+private:
+    friend class ComponentsManager;
+
+    /**
+     * @returns Whether the renderer is drawn for the camera, renderers other than the MeshRenderer always are.
+     */
+    bool _update(Renderer *renderer, const Camera *camera);
+
+    std::vector<LOD> _lods{};
+    int _currentLod{0};
+};
+
+}
+
+#endif /* lod_group_hpp */
@@ -0,0 +1,276 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace vox {
+namespace {
+constexpr uint32_t kInvalid = std::numeric_limits<uint32_t>::max();
+
+uint64_t hashBytes(const unsigned char *data, size_t size, uint64_t hash) {
+    // FNV-1a
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+//MARK: - Forsyth
+constexpr int kCacheSize = 32;
+constexpr float kCacheDecayPower = 1.5f;
+constexpr float kLastTriangleScore = 0.75f;
+constexpr float kValenceBoostScale = 2.0f;
+constexpr float kValenceBoostPower = 0.5f;
+constexpr uint32_t kMaxAdjacencyScan = 64;
+
+float vertexScore(int cachePosition, uint32_t remainingTriangles) {
+    if (remainingTriangles == 0) {
+        return -1;
+    }
+    float score = 0;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // the vertices of the last triangle, a fixed score so that strips are not favoured too much
+            score = kLastTriangleScore;
+        } else {
+            const float scaler = 1.f / (kCacheSize - 3);
+            score = std::pow(1.f - (cachePosition - 3) * scaler, kCacheDecayPower);
+        }
+    }
+    // vertices with few triangles left are finished first, so that they leave the working set
+    score += kValenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -kValenceBoostPower);
+    return score;
+}
+
+}
+
+size_t MeshOptimizer::weldVertices(const std::vector<VertexStream> &streams, size_t vertexCount,
+                                   std::vector<uint32_t> &remap) {
+    remap.assign(vertexCount, kInvalid);
+    size_t tableSize = 1;
+    while (tableSize < vertexCount * 2) {
+        tableSize *= 2;
+    }
+    std::vector<uint32_t> table(tableSize, kInvalid);
+
+    const auto equal = [&](size_t a, size_t b) {
+        for (const auto &stream : streams) {
+            const auto data = static_cast<const unsigned char *>(stream.data);
+            if (memcmp(data + a * stream.stride, data + b * stream.stride, stream.size) != 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    size_t uniqueCount = 0;
+    for (size_t i = 0; i < vertexCount; i++) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (const auto &stream : streams) {
+            hash = hashBytes(static_cast<const unsigned char *>(stream.data) + i * stream.stride, stream.size, hash);
+        }
+        // linear probing
+        size_t bucket = hash & (tableSize - 1);
+        while (table[bucket] != kInvalid && !equal(table[bucket], i)) {
+            bucket = (bucket + 1) & (tableSize - 1);
+        }
+        if (table[bucket] == kInvalid) {
+            table[bucket] = static_cast<uint32_t>(i);
+            remap[i] = static_cast<uint32_t>(uniqueCount++);
+        } else {
+            remap[i] = remap[table[bucket]];
+        }
+    }
+    return uniqueCount;
+}
+
+size_t MeshOptimizer::optimizeVertexFetch(const std::vector<uint32_t> &indices, size_t vertexCount,
+                                          std::vector<uint32_t> &remap) {
+    remap.assign(vertexCount, kInvalid);
+    uint32_t next = 0;
+    for (const auto index : indices) {
+        assert(index < vertexCount);
+        if (remap[index] == kInvalid) {
+            remap[index] = next++;
+        }
+    }
+    return next;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // triangles of every vertex, compressed rows
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (const auto index : indices) {
+        remaining[index]++;
+    }
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < vertexCount; i++) {
+        offsets[i + 1] = offsets[i] + remaining[i];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++) {
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++) {
+        score[i] = vertexScore(-1, remaining[i]);
+    }
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> heads(offsets.begin(), offsets.end() - 1);
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    // room for the new triangle on top of a full cache
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> nextCache;
+    cache.reserve(kCacheSize + 3);
+    nextCache.reserve(kCacheSize + 3);
+
+    size_t best = 0;
+    float bestScore = -1;
+    for (size_t t = 0; t < triangleCount; t++) {
+        const float value = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+        if (value > bestScore) {
+            bestScore = value;
+            best = t;
+        }
+    }
+    size_t cursor = 0;
+    while (best != kInvalid) {
+        emitted[best] = true;
+        const uint32_t *triangle = &indices[best * 3];
+        result.insert(result.end(), triangle, triangle + 3);
+
+        // the triangle goes to the front of the LRU cache
+        nextCache.clear();
+        for (int k = 0; k < 3; k++) {
+            // degenerate triangles repeat a vertex
+            if (std::find(nextCache.begin(), nextCache.end(), triangle[k]) == nextCache.end()) {
+                nextCache.push_back(triangle[k]);
+            }
+        }
+        for (const auto vertex : cache) {
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]) {
+                nextCache.push_back(vertex);
+            }
+        }
+        for (int k = 0; k < 3; k++) {
+            remaining[triangle[k]]--;
+        }
+
+        // rescore the cached vertices and the triangles around them
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            const auto vertex = nextCache[i];
+            cachePosition[vertex] = i < kCacheSize ? static_cast<int>(i) : -1;
+            score[vertex] = vertexScore(cachePosition[vertex], remaining[vertex]);
+        }
+        bestScore = -1;
+        best = kInvalid;
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            const auto vertex = nextCache[i];
+            // emitted triangles are skipped lazily, the scan is bounded for vertices shared by many triangles
+            uint32_t &head = heads[vertex];
+            while (head < offsets[vertex + 1] && emitted[adjacency[head]]) {
+                head++;
+            }
+            const uint32_t end = std::min(offsets[vertex + 1], head + kMaxAdjacencyScan);
+            for (uint32_t j = head; j < end; j++) {
+                const auto t = adjacency[j];
+                if (emitted[t]) {
+                    continue;
+                }
+                const float value = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                if (value > bestScore) {
+                    bestScore = value;
+                    best = t;
+                }
+            }
+        }
+        if (nextCache.size() > kCacheSize) {
+            nextCache.resize(kCacheSize);
+        }
+        cache.swap(nextCache);
+
+        if (best == kInvalid) {
+            // nothing left around the cache, continue with the next triangle in the input
+            while (cursor < triangleCount && emitted[cursor]) {
+                cursor++;
+            }
+            best = cursor < triangleCount ? cursor : kInvalid;
+        }
+    }
+    indices.swap(result);
+}
+
+VertexCacheStatistics MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t> &indices, size_t vertexCount,
+                                                        uint32_t cacheSize) {
+    VertexCacheStatistics statistics;
+    if (indices.empty()) {
+        return statistics;
+    }
+
+    // the timestamp of the insertion tells whether a vertex is still among the last cacheSize
+    std::vector<uint32_t> insertedAt(vertexCount, 0);
+    std::vector<bool> used(vertexCount, false);
+    uint32_t timestamp = cacheSize + 1;
+    size_t usedCount = 0;
+    for (const auto index : indices) {
+        if (timestamp - insertedAt[index] > cacheSize) {
+            insertedAt[index] = timestamp++;
+            statistics.transformedVertices++;
+        }
+        if (!used[index]) {
+            used[index] = true;
+            usedCount++;
+        }
+    }
+    statistics.acmr = static_cast<float>(statistics.transformedVertices) / (indices.size() / 3);
+    statistics.atvr = static_cast<float>(statistics.transformedVertices) / usedCount;
+    return statistics;
+}
+
+void MeshOptimizer::remapIndices(std::vector<uint32_t> &indices, const std::vector<uint32_t> &remap) {
+    for (auto &index : indices) {
+        index = remap[index];
+        assert(index != kInvalid);
+    }
+}
+
+void MeshOptimizer::remapVertices(void *destination, const void *source, size_t vertexCount, size_t stride,
+                                  const std::vector<uint32_t> &remap) {
+    auto output = static_cast<unsigned char *>(destination);
+    auto input = static_cast<const unsigned char *>(source);
+    for (size_t i = 0; i < vertexCount; i++) {
+        if (remap[i] != kInvalid) {
+            memcpy(output + remap[i] * stride, input + i * stride, stride);
+        }
+    }
+}
+
+bool MeshOptimizer::fitsUInt16(size_t vertexCount) {
+    return vertexCount <= std::numeric_limits<uint16_t>::max() + size_t(1);
+}
+
+std::vector<uint16_t> MeshOptimizer::toUInt16(const std::vector<uint32_t> &indices) {
+    return std::vector<uint16_t>(indices.begin(), indices.end());
+}
+
+}
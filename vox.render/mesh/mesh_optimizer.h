@@ -0,0 +1,100 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef mesh_optimizer_hpp
+#define mesh_optimizer_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vox {
+/**
+ * Post-transform cache behaviour of an index buffer.
+ */
+struct VertexCacheStatistics {
+    /** Vertices transformed by a simulated FIFO cache. */
+    uint32_t transformedVertices{0};
+    /** Average cache miss ratio, transformed vertices per triangle, 0.5 at best and 3 at worst. */
+    float acmr{0};
+    /** Average transformed vertex ratio, transformed vertices per referenced vertex, 1 at best. */
+    float atvr{0};
+};
+
+/**
+ * Load time optimization of triangle lists: vertex welding, vertex cache and vertex fetch ordering.
+ * @remarks Everything works on CPU arrays, run it before uploading the mesh.
+ */
+class MeshOptimizer {
+public:
+    /**
+     * Attribute of every vertex, compared bytewise when welding.
+     */
+    struct VertexStream {
+        const void *data;
+        /** Bytes of the attribute. */
+        size_t size;
+        /** Bytes between two vertices. */
+        size_t stride;
+    };
+
+    /**
+     * Find vertices whose attributes are all equal.
+     * @param remap - Receives the new index of every vertex, first occurrences keep their order
+     * @returns Number of unique vertices
+     */
+    static size_t weldVertices(const std::vector<VertexStream> &streams, size_t vertexCount,
+                               std::vector<uint32_t> &remap);
+
+    /**
+     * Order vertices by first use in the index buffer, so that fetches walk the vertex buffer forward.
+     * @param remap - Receives the new index of every vertex, ~0u for vertices no triangle uses
+     * @returns Number of used vertices
+     */
+    static size_t optimizeVertexFetch(const std::vector<uint32_t> &indices, size_t vertexCount,
+                                      std::vector<uint32_t> &remap);
+
+    /**
+     * Reorder triangles for the post-transform vertex cache, with Tom Forsyth's linear-speed algorithm.
+     */
+    static void optimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount);
+
+    /**
+     * Simulate a FIFO post-transform cache.
+     */
+    static VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t> &indices, size_t vertexCount,
+                                                    uint32_t cacheSize = 16);
+
+    static void remapIndices(std::vector<uint32_t> &indices, const std::vector<uint32_t> &remap);
+
+    /**
+     * Move every vertex to its place in remap, vertices mapped to ~0u are dropped.
+     * @param destination - Room for newCount vertices, must not alias source
+     */
+    static void remapVertices(void *destination, const void *source, size_t vertexCount, size_t stride,
+                              const std::vector<uint32_t> &remap);
+
+    template<typename T>
+    static void remapVertices(std::vector<T> &values, const std::vector<uint32_t> &remap, size_t newCount) {
+        if (values.empty()) {
+            return;
+        }
+        std::vector<T> result(newCount);
+        remapVertices(result.data(), values.data(), values.size(), sizeof(T), remap);
+        values.swap(result);
+    }
+
+    /**
+     * Whether every index fits MTL::IndexTypeUInt16.
+     */
+    static bool fitsUInt16(size_t vertexCount);
+
+    static std::vector<uint16_t> toUInt16(const std::vector<uint32_t> &indices);
+};
+
+}
+
+#endif /* mesh_optimizer_hpp */
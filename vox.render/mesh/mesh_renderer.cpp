@@ -6,12 +6,15 @@
 
 #include "mesh_renderer.h"
 #include "graphics/mesh.h"
+#include "mesh/model_mesh.h"
+#include "shader/shader.h"
 #include "entity.h"
 #include "shader_common.h"
 
 namespace vox {
 MeshRenderer::MeshRenderer(Entity *entity) :
-Renderer(entity) {
+Renderer(entity),
+_positionQuantizationProperty(Shader::createProperty("u_positionQuantization", ShaderDataGroup::Renderer)) {
     
 }
 
@@ -43,6 +46,8 @@ void MeshRenderer::_render(std::vector<RenderElement> &opaqueQueue,
             shaderData.disableMacro(HAS_NORMAL);
             shaderData.disableMacro(HAS_TANGENT);
             shaderData.disableMacro(HAS_VERTEXCOLOR);
+            shaderData.disableMacro(HAS_COMPRESSED_NORMAL);
+            shaderData.disableMacro(HAS_QUANTIZED_POSITION);
             
             if (vertexDescriptor->attributes()->object(Attributes::UV_0)->format() != MTL::VertexFormatInvalid) {
                 shaderData.enableMacro(HAS_UV);
@@ -56,6 +61,16 @@ void MeshRenderer::_render(std::vector<RenderElement> &opaqueQueue,
             if (vertexDescriptor->attributes()->object(Attributes::Color_0)->format() != MTL::VertexFormatInvalid) {
                 shaderData.enableMacro(HAS_VERTEXCOLOR);
             }
+            if (vertexDescriptor->attributes()->object(Attributes::Normal)->format() == MTL::VertexFormatShort2Normalized) {
+                shaderData.enableMacro(HAS_COMPRESSED_NORMAL);
+            }
+            if (vertexDescriptor->attributes()->object(Attributes::Position)->format() == MTL::VertexFormatUShort4Normalized) {
+                auto modelMesh = std::dynamic_pointer_cast<ModelMesh>(_mesh);
+                if (modelMesh) {
+                    shaderData.enableMacro(HAS_QUANTIZED_POSITION);
+                    shaderData.setData(_positionQuantizationProperty, modelMesh->positionQuantization());
+                }
+            }
             _meshUpdateFlag->flag = false;
         }
         
@@ -31,6 +31,7 @@ private:
 private:
     MeshPtr _mesh;
     std::unique_ptr<UpdateFlag> _meshUpdateFlag;
+    ShaderProperty _positionQuantizationProperty;
 };
 
 }
@@ -0,0 +1,301 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "mesh_simplifier.h"
+#include "bounding_box3.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace vox {
+namespace {
+/**
+ * Symmetric 4x4 sum of squared plane distances, weighted by triangle area.
+ */
+struct Quadric {
+    double a2{0}, ab{0}, ac{0}, ad{0};
+    double b2{0}, bc{0}, bd{0};
+    double c2{0}, cd{0};
+    double d2{0};
+    double weight{0};
+
+    void addPlane(double a, double b, double c, double d, double w) {
+        a2 += w * a * a; ab += w * a * b; ac += w * a * c; ad += w * a * d;
+        b2 += w * b * b; bc += w * b * c; bd += w * b * d;
+        c2 += w * c * c; cd += w * c * d;
+        d2 += w * d * d;
+        weight += w;
+    }
+
+    Quadric &operator+=(const Quadric &other) {
+        a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+        b2 += other.b2; bc += other.bc; bd += other.bd;
+        c2 += other.c2; cd += other.cd;
+        d2 += other.d2;
+        weight += other.weight;
+        return *this;
+    }
+
+    double error(const Vector3F &p) const {
+        const double x = p.x, y = p.y, z = p.z;
+        const double value = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+        + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+        + c2 * z * z + 2 * cd * z
+        + d2;
+        return std::max(value, 0.0);
+    }
+
+    /** Mean squared distance to the planes. */
+    double meanError(const Vector3F &p) const {
+        return weight > 0 ? error(p) / weight : 0;
+    }
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    /** Area weighted, orders the collapses. */
+    double cost;
+    /** Mean squared distance, compared with the error limit. */
+    double error;
+};
+
+struct Normal {
+    double x, y, z;
+};
+
+Normal triangleNormal(const Vector3F &p0, const Vector3F &p1, const Vector3F &p2) {
+    const double ux = p1.x - p0.x, uy = p1.y - p0.y, uz = p1.z - p0.z;
+    const double vx = p2.x - p0.x, vy = p2.y - p0.y, vz = p2.z - p0.z;
+    return {uy * vz - uz * vy, uz * vx - ux * vz, ux * vy - uy * vx};
+}
+
+uint64_t edgeKey(uint32_t a, uint32_t b) {
+    return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
+
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(const std::vector<Vector3F> &positions,
+                                               const std::vector<uint32_t> &sourceIndices,
+                                               size_t targetIndexCount, float targetError,
+                                               float *resultError) {
+    std::vector<uint32_t> indices = sourceIndices;
+    const size_t vertexCount = positions.size();
+    if (resultError) {
+        *resultError = 0;
+    }
+
+    BoundingBox3F bounds;
+    for (const auto index : indices) {
+        bounds.merge(Point3F(positions[index].x, positions[index].y, positions[index].z));
+    }
+    const double extent = std::max(static_cast<double>(bounds.diagonalLength()), 1e-12);
+    const double maxError = targetError * extent * targetError * extent;
+
+    // plane of every triangle, the mean error reads as a squared distance
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const auto &p0 = positions[indices[i]];
+        const auto normal = triangleNormal(p0, positions[indices[i + 1]], positions[indices[i + 2]]);
+        const double length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        if (length == 0) {
+            continue;
+        }
+        const double a = normal.x / length, b = normal.y / length, c = normal.z / length;
+        Quadric quadric;
+        quadric.addPlane(a, b, c, -(a * p0.x + b * p0.y + c * p0.z), length * 0.5);
+        for (size_t k = 0; k < 3; k++) {
+            quadrics[indices[i + k]] += quadric;
+        }
+    }
+
+    // edges used by one triangle are borders or seams, more than two is non-manifold, both stay in place
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::unordered_map<uint64_t, uint32_t> edgeUse;
+        edgeUse.reserve(indices.size());
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            for (size_t k = 0; k < 3; k++) {
+                edgeUse[edgeKey(indices[i + k], indices[i + (k + 1) % 3])]++;
+            }
+        }
+        for (const auto &edge : edgeUse) {
+            if (edge.second != 2) {
+                locked[edge.first >> 32] = true;
+                locked[edge.first & 0xffffffff] = true;
+            }
+        }
+    }
+
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<uint32_t> offsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> neighbours;
+    std::vector<uint32_t> shared;
+    double appliedError = 0;
+
+    while (indices.size() > targetIndexCount) {
+        // triangles of every vertex, compressed rows
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (const auto index : indices) {
+            offsets[index + 1]++;
+        }
+        for (size_t i = 0; i < vertexCount; i++) {
+            offsets[i + 1] += offsets[i];
+        }
+        adjacency.resize(indices.size());
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); i++) {
+                adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        collapses.clear();
+        // every half edge gives one direction, its twin in the neighbour triangle the other one
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            for (size_t k = 0; k < 3; k++) {
+                const uint32_t from = indices[i + k];
+                const uint32_t to = indices[i + (k + 1) % 3];
+                if (!locked[from]) {
+                    Quadric quadric = quadrics[from];
+                    quadric += quadrics[to];
+                    collapses.push_back({from, to, quadric.error(positions[to]), quadric.meanError(positions[to])});
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) {
+            return a.cost < b.cost;
+        });
+
+        for (size_t i = 0; i < vertexCount; i++) {
+            remap[i] = static_cast<uint32_t>(i);
+        }
+        std::fill(touched.begin(), touched.end(), false);
+        size_t triangleCount = indices.size() / 3;
+        const size_t targetTriangleCount = targetIndexCount / 3;
+        size_t applied = 0;
+        for (const auto &collapse : collapses) {
+            if (triangleCount <= targetTriangleCount) {
+                break;
+            }
+            if (collapse.error > maxError) {
+                continue;
+            }
+            const uint32_t from = collapse.from;
+            const uint32_t to = collapse.to;
+            if (touched[from] || touched[to]) {
+                continue;
+            }
+
+            // reject collapses which fold a remaining triangle over
+            bool valid = true;
+            size_t removed = 0;
+            for (uint32_t j = offsets[from]; j < offsets[from + 1] && valid; j++) {
+                const uint32_t *triangle = &indices[adjacency[j] * 3];
+                if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+                    removed++;
+                    continue;
+                }
+                Vector3F corners[3];
+                Vector3F moved[3];
+                for (size_t k = 0; k < 3; k++) {
+                    corners[k] = positions[triangle[k]];
+                    moved[k] = triangle[k] == from ? positions[to] : corners[k];
+                }
+                const auto before = triangleNormal(corners[0], corners[1], corners[2]);
+                const auto after = triangleNormal(moved[0], moved[1], moved[2]);
+                const double dot = before.x * after.x + before.y * after.y + before.z * after.z;
+                const double lengths = std::sqrt((before.x * before.x + before.y * before.y + before.z * before.z)
+                                                 * (after.x * after.x + after.y * after.y + after.z * after.z));
+                valid = dot > 0.25 * lengths;
+            }
+            if (!valid || removed == 0) {
+                continue;
+            }
+            // link condition, the only shared neighbours are the apexes of the removed triangles
+            neighbours.clear();
+            for (uint32_t j = offsets[from]; j < offsets[from + 1]; j++) {
+                neighbours.insert(neighbours.end(), &indices[adjacency[j] * 3], &indices[adjacency[j] * 3] + 3);
+            }
+            std::sort(neighbours.begin(), neighbours.end());
+            neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+            shared.clear();
+            for (uint32_t j = offsets[to]; j < offsets[to + 1]; j++) {
+                for (size_t k = 0; k < 3; k++) {
+                    const uint32_t vertex = indices[adjacency[j] * 3 + k];
+                    if (vertex != from && vertex != to && std::binary_search(neighbours.begin(), neighbours.end(), vertex)) {
+                        shared.push_back(vertex);
+                    }
+                }
+            }
+            std::sort(shared.begin(), shared.end());
+            if (std::unique(shared.begin(), shared.end()) - shared.begin() != static_cast<ptrdiff_t>(removed)) {
+                continue;
+            }
+
+            remap[from] = to;
+            quadrics[to] += quadrics[from];
+            // the neighbourhood is final for this pass, later checks read the indices of the pass
+            for (uint32_t j = offsets[from]; j < offsets[from + 1]; j++) {
+                const uint32_t *triangle = &indices[adjacency[j] * 3];
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+            }
+            triangleCount -= removed;
+            appliedError = std::max(appliedError, collapse.error);
+            applied++;
+        }
+        if (applied == 0) {
+            break;
+        }
+
+        size_t write = 0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            const uint32_t a = remap[indices[i]];
+            const uint32_t b = remap[indices[i + 1]];
+            const uint32_t c = remap[indices[i + 2]];
+            if (a != b && b != c && c != a) {
+                indices[write++] = a;
+                indices[write++] = b;
+                indices[write++] = c;
+            }
+        }
+        indices.resize(write);
+    }
+
+    if (resultError) {
+        *resultError = static_cast<float>(std::sqrt(appliedError) / extent);
+    }
+    return indices;
+}
+
+std::vector<LodLevel> MeshSimplifier::generateLodChain(const std::vector<Vector3F> &positions,
+                                                       const std::vector<uint32_t> &indices,
+                                                       const std::vector<float> &ratios, float targetError) {
+    std::vector<LodLevel> levels(ratios.size());
+    const size_t triangleCount = indices.size() / 3;
+    for (size_t i = 0; i < ratios.size(); i++) {
+        const auto target = static_cast<size_t>(triangleCount * ratios[i]) * 3;
+        levels[i].indices = simplify(positions, indices, target, targetError, &levels[i].error);
+    }
+    return levels;
+}
+
+std::vector<std::vector<LodLevel>> MeshSimplifier::generateLodChains(const std::vector<Source> &sources,
+                                                                     const std::vector<float> &ratios,
+                                                                     float targetError, ThreadPool &pool) {
+    std::vector<std::vector<LodLevel>> chains(sources.size());
+    pool.parallelFor(sources.size(), [&](size_t i) {
+        chains[i] = generateLodChain(*sources[i].positions, *sources[i].indices, ratios, targetError);
+    });
+    return chains;
+}
+
+}
@@ -0,0 +1,65 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef mesh_simplifier_hpp
+#define mesh_simplifier_hpp
+
+#include "vector3.h"
+#include "thread_pool.h"
+#include <vector>
+
+namespace vox {
+/**
+ * Simplified index buffer of a mesh.
+ */
+struct LodLevel {
+    std::vector<uint32_t> indices{};
+    /** Square root of the largest mean squared distance of a moved vertex to its source planes, relative to the extent of the mesh. */
+    float error{0};
+};
+
+/**
+ * Quadric error metric simplification of triangle lists.
+ * @remarks Collapses keep the vertex buffer, a level only needs a new index buffer.
+ * Border vertices, which include attribute seams, are never moved, so weld the mesh before.
+ */
+class MeshSimplifier {
+public:
+    struct Source {
+        const std::vector<Vector3F> *positions;
+        const std::vector<uint32_t> *indices;
+    };
+
+    /**
+     * Collapse edges until the index count reaches the target or the next collapse exceeds the error.
+     * @param targetIndexCount - Wanted index count
+     * @param targetError - Largest error relative to the extent of the mesh
+     * @param resultError - Receives the error of the result, relative to the extent of the mesh
+     */
+    static std::vector<uint32_t> simplify(const std::vector<Vector3F> &positions,
+                                          const std::vector<uint32_t> &indices,
+                                          size_t targetIndexCount, float targetError = 1.f,
+                                          float *resultError = nullptr);
+
+    /**
+     * One level per ratio of the source triangle count, every level is simplified from the source.
+     */
+    static std::vector<LodLevel> generateLodChain(const std::vector<Vector3F> &positions,
+                                                  const std::vector<uint32_t> &indices,
+                                                  const std::vector<float> &ratios, float targetError = 1.f);
+
+    /**
+     * generateLodChain for many meshes, one job per mesh.
+     */
+    static std::vector<std::vector<LodLevel>> generateLodChains(const std::vector<Source> &sources,
+                                                                const std::vector<float> &ratios,
+                                                                float targetError = 1.f,
+                                                                ThreadPool &pool = ThreadPool::shared());
+};
+
+}
+
+#endif /* mesh_simplifier_hpp */
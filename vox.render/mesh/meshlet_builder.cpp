@@ -0,0 +1,240 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "meshlet_builder.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace vox {
+namespace {
+struct Float3 {
+    float x, y, z;
+};
+
+Float3 subtract(const Vector3F &a, const Vector3F &b) {
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+Float3 cross(const Float3 &a, const Float3 &b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+float dot(const Float3 &a, const Float3 &b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+}
+
+MeshletData MeshletBuilder::build(const std::vector<Vector3F> &positions, const std::vector<uint32_t> &indices,
+                                  size_t maxVertices, size_t maxTriangles) {
+    assert(maxVertices >= 3 && maxVertices <= 256 && maxTriangles >= 1);
+    MeshletData data;
+    const size_t triangleCount = indices.size() / 3;
+    const size_t vertexCount = positions.size();
+    data.indices.reserve(triangleCount * 3);
+    data.triangles.reserve(triangleCount * 3);
+
+    // triangles of every vertex, compressed rows
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        offsets[indices[i] + 1]++;
+    }
+    for (size_t i = 0; i < vertexCount; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++) {
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+    std::vector<Float3> centroids(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++) {
+        const auto &a = positions[indices[t * 3]];
+        const auto &b = positions[indices[t * 3 + 1]];
+        const auto &c = positions[indices[t * 3 + 2]];
+        centroids[t] = {(a.x + b.x + c.x) / 3, (a.y + b.y + c.y) / 3, (a.z + b.z + c.z) / 3};
+    }
+
+    std::vector<bool> used(triangleCount, false);
+    // local index of a vertex in the open meshlet, -1 if it is not in there
+    std::vector<int16_t> local(vertexCount, -1);
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint32_t> meshletTriangles;
+    Float3 centroidSum{0, 0, 0};
+
+    const auto flush = [&]() {
+        Meshlet meshlet;
+        meshlet.vertexOffset = static_cast<uint32_t>(data.vertices.size());
+        meshlet.triangleOffset = static_cast<uint32_t>(data.triangles.size() / 3);
+        meshlet.vertexCount = static_cast<uint32_t>(meshletVertices.size());
+        meshlet.triangleCount = static_cast<uint32_t>(meshletTriangles.size());
+        data.vertices.insert(data.vertices.end(), meshletVertices.begin(), meshletVertices.end());
+        for (const auto t : meshletTriangles) {
+            for (size_t k = 0; k < 3; k++) {
+                data.triangles.push_back(static_cast<uint8_t>(local[indices[t * 3 + k]]));
+                data.indices.push_back(indices[t * 3 + k]);
+            }
+        }
+        data.meshlets.push_back(meshlet);
+        for (const auto vertex : meshletVertices) {
+            local[vertex] = -1;
+        }
+        meshletVertices.clear();
+        meshletTriangles.clear();
+        centroidSum = {0, 0, 0};
+    };
+
+    const auto add = [&](uint32_t t) {
+        used[t] = true;
+        meshletTriangles.push_back(t);
+        for (size_t k = 0; k < 3; k++) {
+            const uint32_t vertex = indices[t * 3 + k];
+            if (local[vertex] < 0) {
+                local[vertex] = static_cast<int16_t>(meshletVertices.size());
+                meshletVertices.push_back(vertex);
+            }
+        }
+        centroidSum.x += centroids[t].x;
+        centroidSum.y += centroids[t].y;
+        centroidSum.z += centroids[t].z;
+    };
+
+    size_t cursor = 0;
+    while (true) {
+        if (meshletTriangles.empty()) {
+            while (cursor < triangleCount && used[cursor]) {
+                cursor++;
+            }
+            if (cursor == triangleCount) {
+                break;
+            }
+            add(static_cast<uint32_t>(cursor));
+            continue;
+        }
+
+        // grow over the shared vertices, fewest new vertices first, then closest to the meshlet
+        const float inverse = 1.f / meshletTriangles.size();
+        const Float3 center{centroidSum.x * inverse, centroidSum.y * inverse, centroidSum.z * inverse};
+        uint32_t best = std::numeric_limits<uint32_t>::max();
+        int bestExtra = 4;
+        float bestDistance = std::numeric_limits<float>::max();
+        for (const auto vertex : meshletVertices) {
+            for (uint32_t j = offsets[vertex]; j < offsets[vertex + 1]; j++) {
+                const uint32_t t = adjacency[j];
+                if (used[t]) {
+                    continue;
+                }
+                int extra = 0;
+                for (size_t k = 0; k < 3; k++) {
+                    extra += local[indices[t * 3 + k]] < 0;
+                }
+                if (meshletVertices.size() + extra > maxVertices || extra > bestExtra) {
+                    continue;
+                }
+                const Float3 offset{centroids[t].x - center.x, centroids[t].y - center.y, centroids[t].z - center.z};
+                const float distance = dot(offset, offset);
+                if (extra < bestExtra || distance < bestDistance) {
+                    best = t;
+                    bestExtra = extra;
+                    bestDistance = distance;
+                }
+            }
+        }
+        if (best == std::numeric_limits<uint32_t>::max()) {
+            flush();
+            continue;
+        }
+        add(best);
+        if (meshletTriangles.size() == maxTriangles) {
+            flush();
+        }
+    }
+    if (!meshletTriangles.empty()) {
+        flush();
+    }
+
+    data.bounds.reserve(data.meshlets.size());
+    for (const auto &meshlet : data.meshlets) {
+        data.bounds.push_back(computeBounds(positions, data, meshlet));
+    }
+    return data;
+}
+
+MeshletBounds MeshletBuilder::computeBounds(const std::vector<Vector3F> &positions, const MeshletData &data,
+                                            const Meshlet &meshlet) {
+    MeshletBounds bounds;
+    // sphere around the box of the vertices
+    Float3 lower{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    Float3 upper{-lower.x, -lower.y, -lower.z};
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+        const auto &p = positions[data.vertices[meshlet.vertexOffset + i]];
+        lower = {std::min(lower.x, p.x), std::min(lower.y, p.y), std::min(lower.z, p.z)};
+        upper = {std::max(upper.x, p.x), std::max(upper.y, p.y), std::max(upper.z, p.z)};
+    }
+    const Vector3F center((lower.x + upper.x) * 0.5f, (lower.y + upper.y) * 0.5f, (lower.z + upper.z) * 0.5f);
+    float radius2 = 0;
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+        const auto offset = subtract(positions[data.vertices[meshlet.vertexOffset + i]], center);
+        radius2 = std::max(radius2, dot(offset, offset));
+    }
+    bounds.center = Point3F(center.x, center.y, center.z);
+    bounds.radius = std::sqrt(radius2);
+
+    // normal cone
+    std::vector<Float3> normals;
+    normals.reserve(meshlet.triangleCount);
+    Float3 axis{0, 0, 0};
+    const auto corner = [&](uint32_t triangle, uint32_t k) -> const Vector3F & {
+        const uint8_t localIndex = data.triangles[(meshlet.triangleOffset + triangle) * 3 + k];
+        return positions[data.vertices[meshlet.vertexOffset + localIndex]];
+    };
+    for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+        const auto &p0 = corner(t, 0);
+        const auto normal = cross(subtract(corner(t, 1), p0), subtract(corner(t, 2), p0));
+        const float length = std::sqrt(dot(normal, normal));
+        // degenerate triangles are invisible
+        const float scale = length > 0 ? 1 / length : 0;
+        normals.push_back({normal.x * scale, normal.y * scale, normal.z * scale});
+        axis = {axis.x + normals.back().x, axis.y + normals.back().y, axis.z + normals.back().z};
+    }
+    const float axisLength = std::sqrt(dot(axis, axis));
+    bounds.coneApex = bounds.center;
+    bounds.coneAxis = Vector3F(0, 0, 0);
+    bounds.coneCutoff = 1;
+    if (axisLength == 0) {
+        return bounds;
+    }
+    axis = {axis.x / axisLength, axis.y / axisLength, axis.z / axisLength};
+    float minDot = 1;
+    for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+        if (dot(normals[t], normals[t]) > 0) {
+            minDot = std::min(minDot, dot(normals[t], axis));
+        }
+    }
+    if (minDot <= 0.1f) {
+        // normals spread over almost a hemisphere, some triangle always faces the camera
+        return bounds;
+    }
+    // apex behind the planes of every triangle, the cone of view directions from it covers the meshlet
+    float maxT = 0;
+    for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+        if (dot(normals[t], normals[t]) == 0) {
+            continue;
+        }
+        const float distance = dot(subtract(center, corner(t, 0)), normals[t]);
+        maxT = std::max(maxT, distance / dot(normals[t], axis));
+    }
+    bounds.coneApex = Point3F(center.x - axis.x * maxT, center.y - axis.y * maxT, center.z - axis.z * maxT);
+    bounds.coneAxis = Vector3F(axis.x, axis.y, axis.z);
+    bounds.coneCutoff = std::sqrt(1 - minDot * minDot);
+    return bounds;
+}
+
+}
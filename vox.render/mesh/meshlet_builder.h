@@ -0,0 +1,75 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef meshlet_builder_hpp
+#define meshlet_builder_hpp
+
+#include "vector3.h"
+#include "point3.h"
+#include <vector>
+
+namespace vox {
+/**
+ * Cluster of triangles, the layout mesh shaders expect.
+ */
+struct Meshlet {
+    /** First entry in MeshletData::vertices. */
+    uint32_t vertexOffset;
+    /** First entry in MeshletData::triangles, three local indices per triangle. */
+    uint32_t triangleOffset;
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+};
+
+/**
+ * Culling volumes of a meshlet in mesh space.
+ */
+struct MeshletBounds {
+    Point3F center;
+    float radius;
+    /** The meshlet is back facing if dot(normalize(coneApex - camera), coneAxis) >= coneCutoff. */
+    Point3F coneApex;
+    Vector3F coneAxis;
+    /** Sine of the spread of the normals, 1 when the normals are too spread to cull. */
+    float coneCutoff;
+};
+
+struct MeshletData {
+    std::vector<Meshlet> meshlets{};
+    std::vector<MeshletBounds> bounds{};
+    /** Mesh vertex of every meshlet local vertex. */
+    std::vector<uint32_t> vertices{};
+    /** Local vertex indices. */
+    std::vector<uint8_t> triangles{};
+    /**
+     * Index buffer in meshlet order, meshlet i draws triangleCount * 3 indices from triangleOffset * 3.
+     * @remarks Use it as the index buffer of the mesh so that culled ranges address it.
+     */
+    std::vector<uint32_t> indices{};
+};
+
+/**
+ * Splits triangle lists into meshlets grown over shared vertices.
+ */
+class MeshletBuilder {
+public:
+    static constexpr size_t kMaxVertices = 64;
+    static constexpr size_t kMaxTriangles = 124;
+
+    /**
+     * @param maxVertices - At most 256, local indices are bytes
+     * @param maxTriangles - Multiple of 4 keeps the triangle arrays aligned for the GPU
+     */
+    static MeshletData build(const std::vector<Vector3F> &positions, const std::vector<uint32_t> &indices,
+                             size_t maxVertices = kMaxVertices, size_t maxTriangles = kMaxTriangles);
+
+    static MeshletBounds computeBounds(const std::vector<Vector3F> &positions, const MeshletData &data,
+                                       const Meshlet &meshlet);
+};
+
+}
+
+#endif /* meshlet_builder_hpp */
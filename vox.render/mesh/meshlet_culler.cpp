@@ -0,0 +1,71 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "meshlet_culler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace vox {
+MeshletCuller::Statistics MeshletCuller::cull(const MeshletData &data, const Matrix4x4F &worldMatrix,
+                                              const BoundingFrustum &frustum, const Point3F &cameraPosition,
+                                              std::vector<MeshletRange> &ranges) {
+    Statistics statistics;
+    ranges.clear();
+
+    // spheres are tested in world space, cones in mesh space
+    const float scaleX = worldMatrix[0] * worldMatrix[0] + worldMatrix[1] * worldMatrix[1] + worldMatrix[2] * worldMatrix[2];
+    const float scaleY = worldMatrix[4] * worldMatrix[4] + worldMatrix[5] * worldMatrix[5] + worldMatrix[6] * worldMatrix[6];
+    const float scaleZ = worldMatrix[8] * worldMatrix[8] + worldMatrix[9] * worldMatrix[9] + worldMatrix[10] * worldMatrix[10];
+    const float scale = std::sqrt(std::max({scaleX, scaleY, scaleZ}));
+    const Point3F camera = worldMatrix.inverse() * cameraPosition;
+    BoundingPlane3F planes[6];
+    for (int i = 0; i < 6; i++) {
+        planes[i] = frustum.getPlane(i);
+    }
+
+    for (size_t i = 0; i < data.meshlets.size(); i++) {
+        const auto &bounds = data.bounds[i];
+        const auto &meshlet = data.meshlets[i];
+
+        if (bounds.coneCutoff < 1) {
+            const float x = bounds.coneApex.x - camera.x;
+            const float y = bounds.coneApex.y - camera.y;
+            const float z = bounds.coneApex.z - camera.z;
+            const float dot = x * bounds.coneAxis.x + y * bounds.coneAxis.y + z * bounds.coneAxis.z;
+            if (dot >= bounds.coneCutoff * std::sqrt(x * x + y * y + z * z)) {
+                statistics.backfaceCulled++;
+                continue;
+            }
+        }
+
+        const Point3F center = worldMatrix * bounds.center;
+        const float radius = bounds.radius * scale;
+        bool inside = true;
+        for (const auto &plane : planes) {
+            // plane normals point out of the frustum
+            if (plane.normal.x * center.x + plane.normal.y * center.y + plane.normal.z * center.z + plane.distance > radius) {
+                inside = false;
+                break;
+            }
+        }
+        if (!inside) {
+            statistics.frustumCulled++;
+            continue;
+        }
+
+        statistics.visibleMeshlets++;
+        statistics.visibleTriangles += meshlet.triangleCount;
+        const uint32_t firstIndex = meshlet.triangleOffset * 3;
+        if (!ranges.empty() && ranges.back().firstIndex + ranges.back().indexCount == firstIndex) {
+            ranges.back().indexCount += meshlet.triangleCount * 3;
+        } else {
+            ranges.push_back({firstIndex, meshlet.triangleCount * 3});
+        }
+    }
+    return statistics;
+}
+
+}
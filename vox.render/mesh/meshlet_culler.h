@@ -0,0 +1,48 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef meshlet_culler_hpp
+#define meshlet_culler_hpp
+
+#include "meshlet_builder.h"
+#include "bounding_frustum.h"
+#include "matrix4x4.h"
+
+namespace vox {
+/**
+ * Indices drawn with one call, into MeshletData::indices.
+ */
+struct MeshletRange {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+};
+
+/**
+ * Per view culling of meshlets on the CPU.
+ */
+class MeshletCuller {
+public:
+    struct Statistics {
+        uint32_t visibleMeshlets{0};
+        uint32_t visibleTriangles{0};
+        uint32_t frustumCulled{0};
+        uint32_t backfaceCulled{0};
+    };
+
+    /**
+     * Drop meshlets outside the frustum or facing away from the camera.
+     * @param worldMatrix - Transform of the mesh, the normal cones assume a uniform scale
+     * @param frustum - World space frustum of the view
+     * @param cameraPosition - World space position of a perspective camera
+     * @param ranges - Receives the visible indices, neighbouring meshlets are merged into one range
+     */
+    static Statistics cull(const MeshletData &data, const Matrix4x4F &worldMatrix, const BoundingFrustum &frustum,
+                           const Point3F &cameraPosition, std::vector<MeshletRange> &ranges);
+};
+
+}
+
+#endif /* meshlet_culler_hpp */
@@ -5,8 +5,9 @@
 //  property of any third parties.
 
 #include "model_mesh.h"
-#include "shader_common.h"
+#include "vertex_compression.h"
 #include "metal_helpers.h"
+#include <algorithm>
 
 namespace vox {
 bool ModelMesh::accessible() {
@@ -179,6 +180,46 @@ const std::vector<Vector2F> &ModelMesh::uvs(int channelIndex) {
     }
 }
 
+void ModelMesh::setBoneWeights(const std::vector<Vector4F> &boneWeights) {
+    if (!_accessible) {
+        assert(false && "Not allowed to access data while accessible is false.");
+    }
+    
+    if (boneWeights.size() != _vertexCount) {
+        assert(false && "The array provided needs to be the same size as vertex count.");
+    }
+    
+    _vertexChangeFlag |= ValueChanged::BoneWeight;
+    _boneWeights = boneWeights;
+}
+
+const std::vector<Vector4F> &ModelMesh::boneWeights() {
+    if (!_accessible) {
+        assert(false && "Not allowed to access data while accessible is false.");
+    }
+    return _boneWeights;
+}
+
+void ModelMesh::setBoneIndices(const std::vector<Vector4F> &boneIndices) {
+    if (!_accessible) {
+        assert(false && "Not allowed to access data while accessible is false.");
+    }
+    
+    if (boneIndices.size() != _vertexCount) {
+        assert(false && "The array provided needs to be the same size as vertex count.");
+    }
+    
+    _vertexChangeFlag |= ValueChanged::BoneIndex;
+    _boneIndices = boneIndices;
+}
+
+const std::vector<Vector4F> &ModelMesh::boneIndices() {
+    if (!_accessible) {
+        assert(false && "Not allowed to access data while accessible is false.");
+    }
+    return _boneIndices;
+}
+
 void ModelMesh::setIndices(const std::vector<uint32_t> &indices, MTL::PrimitiveType type) {
     if (!_accessible) {
         assert(false && "Not allowed to access data while accessible is false.");
@@ -191,6 +232,44 @@ const std::vector<uint32_t> ModelMesh::indices() {
     return _indices;
 }
 
+VertexCacheStatistics ModelMesh::optimize() {
+    if (!_accessible) {
+        assert(false && "Not allowed to access data while accessible is false.");
+    }
+    if (_indices.empty() || _primitiveType != MTL::PrimitiveTypeTriangle) {
+        return MeshOptimizer::analyzeVertexCache(_indices, _vertexCount);
+    }
+    
+    std::vector<MeshOptimizer::VertexStream> streams;
+    const auto addStream = [&](const auto &values) {
+        if (!values.empty()) {
+            streams.push_back({values.data(), sizeof(values[0]), sizeof(values[0])});
+        }
+    };
+    addStream(_positions);
+    addStream(_normals);
+    addStream(_colors);
+    addStream(_tangents);
+    for (int i = 0; i < 8; i++) {
+        addStream(_uvChannel(i));
+    }
+    addStream(_boneWeights);
+    addStream(_boneIndices);
+    
+    std::vector<uint32_t> remap;
+    size_t uniqueCount = MeshOptimizer::weldVertices(streams, _vertexCount, remap);
+    MeshOptimizer::remapIndices(_indices, remap);
+    _remapVertices(remap, uniqueCount);
+    
+    MeshOptimizer::optimizeVertexCache(_indices, _vertexCount);
+    uniqueCount = MeshOptimizer::optimizeVertexFetch(_indices, _vertexCount, remap);
+    MeshOptimizer::remapIndices(_indices, remap);
+    _remapVertices(remap, uniqueCount);
+    
+    _vertexChangeFlag = ValueChanged::All;
+    return MeshOptimizer::analyzeVertexCache(_indices, _vertexCount);
+}
+
 void ModelMesh::uploadData(bool noLongerAccessible) {
     if (!_accessible) {
         assert(false && "Not allowed to access data while accessible is false.");
@@ -199,20 +278,16 @@ void ModelMesh::uploadData(bool noLongerAccessible) {
     _vertexDescriptor = _updateVertexDescriptor();
     _vertexChangeFlag = ValueChanged::All;
     
-    auto vertexFloatCount = _elementCount * _vertexCount;
-    auto vertices = std::vector<float>(vertexFloatCount);
+    auto vertices = std::vector<uint8_t>(_vertexStride * _vertexCount);
     _updateVertices(vertices);
     
     auto newVertexBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _device.newBuffer(vertices.data(),
-                                                                                     vertexFloatCount * sizeof(float),
+                                                                                     vertices.size(),
                                                                                      MTL::ResourceOptionCPUCacheModeDefault));
     _setVertexBufferBinding(0, newVertexBuffer);
     
     
-    const auto indexBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _device.newBuffer(_indices.data(),
-                                                                                       _indices.size() * sizeof(uint32_t),
-                                                                                       MTL::ResourceOptionCPUCacheModeDefault));
-    addSubMesh(_primitiveType, MTL::IndexTypeUInt32, _indices.size(), indexBuffer);
+    _addIndexSubMesh(_indices);
     
     if (noLongerAccessible) {
         _accessible = false;
@@ -220,254 +295,291 @@ void ModelMesh::uploadData(bool noLongerAccessible) {
     }
 }
 
+void ModelMesh::setVertexCompression(int flags) {
+    _vertexCompression = flags;
+}
+
+int ModelMesh::vertexCompression() const {
+    return _vertexCompression;
+}
+
+uint32_t ModelMesh::vertexStride() const {
+    return _vertexStride;
+}
+
+const PositionQuantization &ModelMesh::positionQuantization() const {
+    return _positionQuantization;
+}
+
+void ModelMesh::_addIndexSubMesh(const std::vector<uint32_t> &indices) {
+    if (MeshOptimizer::fitsUInt16(_vertexCount)) {
+        const auto shortIndices = MeshOptimizer::toUInt16(indices);
+        const auto indexBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _device.newBuffer(shortIndices.data(),
+                                                                                           shortIndices.size() * sizeof(uint16_t),
+                                                                                           MTL::ResourceOptionCPUCacheModeDefault));
+        addSubMesh(_primitiveType, MTL::IndexTypeUInt16, shortIndices.size(), indexBuffer);
+    } else {
+        const auto indexBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _device.newBuffer(indices.data(),
+                                                                                           indices.size() * sizeof(uint32_t),
+                                                                                           MTL::ResourceOptionCPUCacheModeDefault));
+        addSubMesh(_primitiveType, MTL::IndexTypeUInt32, indices.size(), indexBuffer);
+    }
+}
+
+ModelMeshPtr ModelMesh::createLod(const std::vector<uint32_t> &indices) {
+    if (_vertexBufferBindings.empty()) {
+        assert(false && "Upload the mesh before creating levels of detail.");
+    }
+    auto lod = std::make_shared<ModelMesh>(_device, name);
+    lod->name = name;
+    lod->bounds = bounds;
+    lod->_vertexDescriptor = _vertexDescriptor;
+    lod->_vertexBufferBindings = _vertexBufferBindings;
+    lod->_vertexCount = _vertexCount;
+    lod->_vertexStride = _vertexStride;
+    lod->_vertexCompression = _vertexCompression;
+    lod->_positionQuantization = _positionQuantization;
+    lod->_primitiveType = _primitiveType;
+    lod->_addIndexSubMesh(indices);
+    lod->_accessible = false;
+    return lod;
+}
+
+void ModelMesh::_remapVertices(const std::vector<uint32_t> &remap, size_t newCount) {
+    MeshOptimizer::remapVertices(_positions, remap, newCount);
+    MeshOptimizer::remapVertices(_normals, remap, newCount);
+    MeshOptimizer::remapVertices(_colors, remap, newCount);
+    MeshOptimizer::remapVertices(_tangents, remap, newCount);
+    for (int i = 0; i < 8; i++) {
+        MeshOptimizer::remapVertices(_uvChannel(i), remap, newCount);
+    }
+    MeshOptimizer::remapVertices(_boneWeights, remap, newCount);
+    MeshOptimizer::remapVertices(_boneIndices, remap, newCount);
+    _vertexCount = newCount;
+}
+
+std::vector<Vector2F> &ModelMesh::_uvChannel(int channelIndex) {
+    std::vector<Vector2F> *channels[] = {&_uv, &_uv1, &_uv2, &_uv3, &_uv4, &_uv5, &_uv6, &_uv7};
+    return *channels[channelIndex];
+}
+
 std::shared_ptr<MTL::VertexDescriptor> ModelMesh::_updateVertexDescriptor() {
-    auto descriptor = CLONE_METAL_CUSTOM_DELETER(MTL::VertexDescriptor, MTL::VertexDescriptor::alloc()->init());
-    descriptor->attributes()->object(Attributes::Position)->setFormat(MTL::VertexFormatFloat3);
-    descriptor->attributes()->object(Attributes::Position)->setOffset(0);
-    descriptor->attributes()->object(Attributes::Position)->setBufferIndex(0);
+    const auto compressed = [&](VertexCompression::Enum flag) {
+        return (_vertexCompression & flag) != 0;
+    };
     
-    size_t offset = 12;
-    size_t elementCount = 3;
+    _vertexElements.clear();
+    uint32_t offset = 0;
+    const auto addElement = [&](Attributes semantic, MTL::VertexFormat format, uint32_t size, int changeFlag, int channel = -1) {
+        _vertexElements.push_back({semantic, format, offset, changeFlag, channel});
+        offset += size;
+    };
+    
+    if (compressed(VertexCompression::Position)) {
+        BoundingBox3F bounds;
+        for (const auto &position : _positions) {
+            bounds.merge(Point3F(position.x, position.y, position.z));
+        }
+        _positionQuantization = compression::positionQuantization(bounds);
+        addElement(Attributes::Position, MTL::VertexFormatUShort4Normalized, sizeof(uint16_t) * 4, ValueChanged::Position);
+    } else {
+        _positionQuantization = PositionQuantization{simd_make_float4(1, 1, 1, 0), simd_make_float4(0, 0, 0, 0)};
+        addElement(Attributes::Position, MTL::VertexFormatFloat3, sizeof(float) * 3, ValueChanged::Position);
+    }
     if (!_normals.empty()) {
-        descriptor->attributes()->object(Attributes::Normal)->setFormat(MTL::VertexFormatFloat3);
-        descriptor->attributes()->object(Attributes::Normal)->setOffset(offset);
-        descriptor->attributes()->object(Attributes::Normal)->setBufferIndex(0);
-        offset += sizeof(float) * 3;
-        elementCount += 3;
+        if (compressed(VertexCompression::Normal)) {
+            addElement(Attributes::Normal, MTL::VertexFormatShort2Normalized, sizeof(int16_t) * 2, ValueChanged::Normal);
+        } else {
+            addElement(Attributes::Normal, MTL::VertexFormatFloat3, sizeof(float) * 3, ValueChanged::Normal);
+        }
     }
-    
     if (!_colors.empty()) {
-        descriptor->attributes()->object(Attributes::Color_0)->setFormat(MTL::VertexFormatFloat4);
-        descriptor->attributes()->object(Attributes::Color_0)->setOffset(offset);
-        descriptor->attributes()->object(Attributes::Color_0)->setBufferIndex(0);
-        offset += sizeof(float) * 4;
-        elementCount += 4;
+        if (compressed(VertexCompression::Color)) {
+            addElement(Attributes::Color_0, MTL::VertexFormatUChar4Normalized, sizeof(uint8_t) * 4, ValueChanged::Color);
+        } else {
+            addElement(Attributes::Color_0, MTL::VertexFormatFloat4, sizeof(float) * 4, ValueChanged::Color);
+        }
     }
     if (!_boneWeights.empty()) {
-        descriptor->attributes()->object(Attributes::Weights_0)->setFormat(MTL::VertexFormatFloat4);
-        descriptor->attributes()->object(Attributes::Weights_0)->setOffset(offset);
-        descriptor->attributes()->object(Attributes::Weights_0)->setBufferIndex(0);
-        offset += sizeof(float) * 4;
-        elementCount += 4;
+        if (compressed(VertexCompression::Skin)) {
+            addElement(Attributes::Weights_0, MTL::VertexFormatUChar4Normalized, sizeof(uint8_t) * 4, ValueChanged::BoneWeight);
+        } else {
+            addElement(Attributes::Weights_0, MTL::VertexFormatFloat4, sizeof(float) * 4, ValueChanged::BoneWeight);
+        }
     }
     if (!_boneIndices.empty()) {
-        descriptor->attributes()->object(Attributes::Joints_0)->setFormat(MTL::VertexFormatShort4);
-        descriptor->attributes()->object(Attributes::Joints_0)->setOffset(offset);
-        descriptor->attributes()->object(Attributes::Joints_0)->setBufferIndex(0);
-        offset += sizeof(short) * 4;
-        elementCount += 1;
+        float maxIndex = 0;
+        for (const auto &indices : _boneIndices) {
+            maxIndex = std::max({maxIndex, indices.x, indices.y, indices.z, indices.w});
+        }
+        if (compressed(VertexCompression::Skin) && maxIndex < 256) {
+            addElement(Attributes::Joints_0, MTL::VertexFormatUChar4, sizeof(uint8_t) * 4, ValueChanged::BoneIndex);
+        } else {
+            addElement(Attributes::Joints_0, MTL::VertexFormatShort4, sizeof(int16_t) * 4, ValueChanged::BoneIndex);
+        }
     }
     if (!_tangents.empty()) {
-        descriptor->attributes()->object(Attributes::Tangent)->setFormat(MTL::VertexFormatFloat4);
-        descriptor->attributes()->object(Attributes::Tangent)->setOffset(offset);
-        descriptor->attributes()->object(Attributes::Tangent)->setBufferIndex(0);
-        offset += sizeof(float) * 4;
-        elementCount += 4;
-    }
-    if (!_uv.empty()) {
-        descriptor->attributes()->object(Attributes::UV_0)->setFormat(MTL::VertexFormatFloat2);
-        descriptor->attributes()->object(Attributes::UV_0)->setOffset(offset);
-        descriptor->attributes()->object(Attributes::UV_0)->setBufferIndex(0);
-        offset += sizeof(float) * 2;
-        elementCount += 2;
-    }
-    if (!_uv1.empty()) {
-        descriptor->attributes()->object(Attributes::UV_1)->setFormat(MTL::VertexFormatFloat2);
-        descriptor->attributes()->object(Attributes::UV_1)->setOffset(offset);
-        descriptor->attributes()->object(Attributes::UV_1)->setBufferIndex(0);
-        offset += sizeof(float) * 2;
-        elementCount += 2;
-    }
-    if (!_uv2.empty()) {
-        descriptor->attributes()->object(Attributes::UV_2)->setFormat(MTL::VertexFormatFloat2);
-        descriptor->attributes()->object(Attributes::UV_2)->setOffset(offset);
-        descriptor->attributes()->object(Attributes::UV_2)->setBufferIndex(0);
-        offset += sizeof(float) * 2;
-        elementCount += 2;
-    }
-    if (!_uv3.empty()) {
-        descriptor->attributes()->object(Attributes::UV_3)->setFormat(MTL::VertexFormatFloat2);
-        descriptor->attributes()->object(Attributes::UV_3)->setOffset(offset);
-        descriptor->attributes()->object(Attributes::UV_3)->setBufferIndex(0);
-        offset += sizeof(float) * 2;
-        elementCount += 2;
-    }
-    if (!_uv4.empty()) {
-        descriptor->attributes()->object(Attributes::UV_4)->setFormat(MTL::VertexFormatFloat2);
-        descriptor->attributes()->object(Attributes::UV_4)->setOffset(offset);
-        descriptor->attributes()->object(Attributes::UV_4)->setBufferIndex(0);
-        offset += sizeof(float) * 2;
-        elementCount += 2;
-    }
-    if (!_uv5.empty()) {
-        descriptor->attributes()->object(Attributes::UV_5)->setFormat(MTL::VertexFormatFloat2);
-        descriptor->attributes()->object(Attributes::UV_5)->setOffset(offset);
-        descriptor->attributes()->object(Attributes::UV_5)->setBufferIndex(0);
-        offset += sizeof(float) * 2;
-        elementCount += 2;
-    }
-    if (!_uv6.empty()) {
-        descriptor->attributes()->object(Attributes::UV_6)->setFormat(MTL::VertexFormatFloat2);
-        descriptor->attributes()->object(Attributes::UV_6)->setOffset(offset);
-        descriptor->attributes()->object(Attributes::UV_6)->setBufferIndex(0);
-        offset += sizeof(float) * 2;
-        elementCount += 2;
-    }
-    if (!_uv7.empty()) {
-        descriptor->attributes()->object(Attributes::UV_7)->setFormat(MTL::VertexFormatFloat2);
-        descriptor->attributes()->object(Attributes::UV_7)->setOffset(offset);
-        descriptor->attributes()->object(Attributes::UV_7)->setBufferIndex(0);
-        offset += sizeof(float) * 2;
-        elementCount += 2;
-    }
-    descriptor->layouts()->object(0)->setStride(offset);
-    
-    _elementCount = elementCount;
-    return descriptor;
-    
-    return descriptor;
-}
-
-void ModelMesh::_updateVertices(std::vector<float> &vertices) {
-    if ((_vertexChangeFlag & ValueChanged::Position) != 0) {
-        for (size_t i = 0; i < _vertexCount; i++) {
-            auto start = _elementCount * i;
-            const auto &position = _positions[i];
-            vertices[start] = position.x;
-            vertices[start + 1] = position.y;
-            vertices[start + 2] = position.z;
+        if (compressed(VertexCompression::Normal)) {
+            addElement(Attributes::Tangent, MTL::VertexFormatShort2Normalized, sizeof(int16_t) * 2, ValueChanged::Tangent);
+        } else {
+            addElement(Attributes::Tangent, MTL::VertexFormatFloat4, sizeof(float) * 4, ValueChanged::Tangent);
         }
     }
-    
-    size_t offset = 3;
-    
-    if (!_normals.empty()) {
-        if ((_vertexChangeFlag & ValueChanged::Normal) != 0) {
-            for (size_t i = 0; i < _vertexCount; i++) {
-                auto start = _elementCount * i + offset;
-                const auto &normal = _normals[i];
-                vertices[start] = normal.x;
-                vertices[start + 1] = normal.y;
-                vertices[start + 2] = normal.z;
-            }
+    const Attributes uvAttributes[] = {UV_0, UV_1, UV_2, UV_3, UV_4, UV_5, UV_6, UV_7};
+    for (int channel = 0; channel < 8; channel++) {
+        const auto &uv = _uvChannel(channel);
+        if (uv.empty()) {
+            continue;
+        }
+        const int changeFlag = ValueChanged::UV << channel;
+        if (compressed(VertexCompression::UV)) {
+            const bool normalized = std::all_of(uv.begin(), uv.end(), [](const Vector2F &value) {
+                return value.x >= 0 && value.x <= 1 && value.y >= 0 && value.y <= 1;
+            });
+            addElement(uvAttributes[channel], normalized ? MTL::VertexFormatUShort2Normalized : MTL::VertexFormatHalf2,
+                       sizeof(uint16_t) * 2, changeFlag, channel);
+        } else {
+            addElement(uvAttributes[channel], MTL::VertexFormatFloat2, sizeof(float) * 2, changeFlag, channel);
         }
-        offset += 3;
     }
     
-    if (!_colors.empty()) {
-        if ((_vertexChangeFlag & ValueChanged::Color) != 0) {
-            for (size_t i = 0; i < _vertexCount; i++) {
-                auto start = _elementCount * i + offset;
-                const auto &color = _colors[i];
-                vertices[start] = color.r;
-                vertices[start + 1] = color.g;
-                vertices[start + 2] = color.b;
-                vertices[start + 3] = color.a;
-            }
-        }
-        offset += 4;
+    auto descriptor = CLONE_METAL_CUSTOM_DELETER(MTL::VertexDescriptor, MTL::VertexDescriptor::alloc()->init());
+    for (const auto &element : _vertexElements) {
+        descriptor->attributes()->object(element.semantic)->setFormat(element.format);
+        descriptor->attributes()->object(element.semantic)->setOffset(element.offset);
+        descriptor->attributes()->object(element.semantic)->setBufferIndex(0);
     }
+    descriptor->layouts()->object(0)->setStride(offset);
     
-    if (!_tangents.empty()) {
-        if ((_vertexChangeFlag & ValueChanged::Tangent) != 0) {
-            for (size_t i = 0; i < _vertexCount; i++) {
-                auto start = _elementCount * i + offset;
-                const auto &tangent = _tangents[i];
-                vertices[start] = tangent.x;
-                vertices[start + 1] = tangent.y;
-                vertices[start + 2] = tangent.z;
-            }
-        }
-        offset += 4;
-    }
-    if (!_uv.empty()) {
-        if ((_vertexChangeFlag & ValueChanged::UV) != 0) {
-            for (size_t i = 0; i < _vertexCount; i++) {
-                auto start = _elementCount * i + offset;
-                const auto &uv = _uv[i];
-                vertices[start] = uv.x;
-                vertices[start + 1] = uv.y;
-            }
-        }
-        offset += 2;
-    }
-    if (!_uv1.empty()) {
-        if ((_vertexChangeFlag & ValueChanged::UV1) != 0) {
-            for (size_t i = 0; i < _vertexCount; i++) {
-                auto start = _elementCount * i + offset;
-                const auto &uv = _uv1[i];
-                vertices[start] = uv.x;
-                vertices[start + 1] = uv.y;
-            }
-        }
-        offset += 2;
-    }
-    if (!_uv2.empty()) {
-        if ((_vertexChangeFlag & ValueChanged::UV2) != 0) {
-            for (size_t i = 0; i < _vertexCount; i++) {
-                auto start = _elementCount * i + offset;
-                const auto &uv = _uv2[i];
-                vertices[start] = uv.x;
-                vertices[start + 1] = uv.y;
-                
-            }
-        }
-        offset += 2;
-    }
-    if (!_uv3.empty()) {
-        if ((_vertexChangeFlag & ValueChanged::UV3) != 0) {
-            for (size_t i = 0; i < _vertexCount; i++) {
-                auto start = _elementCount * i + offset;
-                const auto &uv = _uv3[i];
-                vertices[start] = uv.x;
-                vertices[start + 1] = uv.y;
-            }
-        }
-        offset += 2;
-    }
-    if (!_uv4.empty()) {
-        if ((_vertexChangeFlag & ValueChanged::UV4) != 0) {
-            for (size_t i = 0; i < _vertexCount; i++) {
-                auto start = _elementCount * i + offset;
-                const auto &uv = _uv4[i];
-                vertices[start] = uv.x;
-                vertices[start + 1] = uv.y;
-            }
-        }
-        offset += 2;
-    }
-    if (!_uv5.empty()) {
-        if ((_vertexChangeFlag & ValueChanged::UV5) != 0) {
-            for (size_t i = 0; i < _vertexCount; i++) {
-                auto start = _elementCount * i + offset;
-                const auto &uv = _uv5[i];
-                vertices[start] = uv.x;
-                vertices[start + 1] = uv.y;
-            }
-        }
-        offset += 2;
-    }
-    if (!_uv6.empty()) {
-        if ((_vertexChangeFlag & ValueChanged::UV6) != 0) {
-            for (size_t i = 0; i < _vertexCount; i++) {
-                auto start = _elementCount * i + offset;
-                const auto &uv = _uv6[i];
-                vertices[start] = uv.x;
-                vertices[start + 1] = uv.y;
-            }
+    _vertexStride = offset;
+    return descriptor;
+}
+
+namespace {
+template<typename T, typename F>
+void writeElements(std::vector<uint8_t> &vertices, size_t offset, size_t stride, const std::vector<T> &source, F encode) {
+    uint8_t *destination = vertices.data() + offset;
+    for (size_t i = 0; i < source.size(); i++, destination += stride) {
+        encode(source[i], destination);
+    }
+}
+
+template<typename T, size_t N>
+void store(uint8_t *destination, const T (&values)[N]) {
+    memcpy(destination, values, sizeof(values));
+}
+
+}
+
+void ModelMesh::_updateVertices(std::vector<uint8_t> &vertices) {
+    const size_t stride = _vertexStride;
+    for (const auto &element : _vertexElements) {
+        if ((_vertexChangeFlag & element.changeFlag) == 0) {
+            continue;
         }
-        offset += 2;
-    }
-    if (!_uv7.empty()) {
-        if ((_vertexChangeFlag & ValueChanged::UV7) != 0) {
-            for (size_t i = 0; i < _vertexCount; i++) {
-                auto start = _elementCount * i + offset;
-                const auto &uv = _uv7[i];
-                vertices[start] = uv.x;
-                vertices[start + 1] = uv.y;
+        
+        const auto offset = element.offset;
+        const auto format = element.format;
+        switch (element.semantic) {
+            case Attributes::Position:
+                if (format == MTL::VertexFormatUShort4Normalized) {
+                    writeElements(vertices, offset, stride, _positions, [&](const Vector3F &position, uint8_t *destination) {
+                        uint16_t encoded[4];
+                        compression::encodePosition(position, _positionQuantization, encoded);
+                        store(destination, encoded);
+                    });
+                } else {
+                    writeElements(vertices, offset, stride, _positions, [](const Vector3F &position, uint8_t *destination) {
+                        store(destination, {position.x, position.y, position.z});
+                    });
+                }
+                break;
+            case Attributes::Normal:
+                if (format == MTL::VertexFormatShort2Normalized) {
+                    writeElements(vertices, offset, stride, _normals, [](const Vector3F &normal, uint8_t *destination) {
+                        int16_t encoded[2];
+                        compression::encodeNormal(normal, encoded);
+                        store(destination, encoded);
+                    });
+                } else {
+                    writeElements(vertices, offset, stride, _normals, [](const Vector3F &normal, uint8_t *destination) {
+                        store(destination, {normal.x, normal.y, normal.z});
+                    });
+                }
+                break;
+            case Attributes::Color_0:
+                if (format == MTL::VertexFormatUChar4Normalized) {
+                    writeElements(vertices, offset, stride, _colors, [](const Color &color, uint8_t *destination) {
+                        store(destination, {compression::encodeUnorm8(color.r), compression::encodeUnorm8(color.g),
+                            compression::encodeUnorm8(color.b), compression::encodeUnorm8(color.a)});
+                    });
+                } else {
+                    writeElements(vertices, offset, stride, _colors, [](const Color &color, uint8_t *destination) {
+                        store(destination, {color.r, color.g, color.b, color.a});
+                    });
+                }
+                break;
+            case Attributes::Weights_0:
+                if (format == MTL::VertexFormatUChar4Normalized) {
+                    writeElements(vertices, offset, stride, _boneWeights, [](const Vector4F &weights, uint8_t *destination) {
+                        uint8_t encoded[4] = {compression::encodeUnorm8(weights.x), compression::encodeUnorm8(weights.y),
+                            compression::encodeUnorm8(weights.z), compression::encodeUnorm8(weights.w)};
+                        // keep the sum at 255 so that rounding does not scale the skinned vertex
+                        const int error = 255 - (encoded[0] + encoded[1] + encoded[2] + encoded[3]);
+                        auto &largest = *std::max_element(encoded, encoded + 4);
+                        largest = static_cast<uint8_t>(std::clamp(largest + error, 0, 255));
+                        store(destination, encoded);
+                    });
+                } else {
+                    writeElements(vertices, offset, stride, _boneWeights, [](const Vector4F &weights, uint8_t *destination) {
+                        store(destination, {weights.x, weights.y, weights.z, weights.w});
+                    });
+                }
+                break;
+            case Attributes::Joints_0:
+                if (format == MTL::VertexFormatUChar4) {
+                    writeElements(vertices, offset, stride, _boneIndices, [](const Vector4F &indices, uint8_t *destination) {
+                        store(destination, {static_cast<uint8_t>(indices.x), static_cast<uint8_t>(indices.y),
+                            static_cast<uint8_t>(indices.z), static_cast<uint8_t>(indices.w)});
+                    });
+                } else {
+                    writeElements(vertices, offset, stride, _boneIndices, [](const Vector4F &indices, uint8_t *destination) {
+                        store(destination, {static_cast<int16_t>(indices.x), static_cast<int16_t>(indices.y),
+                            static_cast<int16_t>(indices.z), static_cast<int16_t>(indices.w)});
+                    });
+                }
+                break;
+            case Attributes::Tangent:
+                if (format == MTL::VertexFormatShort2Normalized) {
+                    writeElements(vertices, offset, stride, _tangents, [](const Vector4F &tangent, uint8_t *destination) {
+                        int16_t encoded[2];
+                        compression::encodeTangent(tangent, encoded);
+                        store(destination, encoded);
+                    });
+                } else {
+                    writeElements(vertices, offset, stride, _tangents, [](const Vector4F &tangent, uint8_t *destination) {
+                        store(destination, {tangent.x, tangent.y, tangent.z, tangent.w});
+                    });
+                }
+                break;
+            default: {
+                const auto &uv = _uvChannel(element.channel);
+                if (format == MTL::VertexFormatUShort2Normalized) {
+                    writeElements(vertices, offset, stride, uv, [](const Vector2F &value, uint8_t *destination) {
+                        store(destination, {compression::encodeUnorm16(value.x), compression::encodeUnorm16(value.y)});
+                    });
+                } else if (format == MTL::VertexFormatHalf2) {
+                    writeElements(vertices, offset, stride, uv, [](const Vector2F &value, uint8_t *destination) {
+                        store(destination, {compression::encodeHalf(value.x), compression::encodeHalf(value.y)});
+                    });
+                } else {
+                    writeElements(vertices, offset, stride, uv, [](const Vector2F &value, uint8_t *destination) {
+                        store(destination, {value.x, value.y});
+                    });
+                }
+                break;
             }
         }
-        offset += 2;
     }
     
     _vertexChangeFlag = 0;
@@ -487,6 +599,8 @@ void ModelMesh::_releaseCache() {
     _uv5.clear();
     _uv6.clear();
     _uv7.clear();
+    _boneWeights.clear();
+    _boneIndices.clear();
 }
 
 }
@@ -12,6 +12,8 @@
 #include "vector3.h"
 #include "vector4.h"
 #include "color.h"
+#include "shader_common.h"
+#include "mesh_optimizer.h"
 
 namespace vox {
 struct ValueChanged {
@@ -35,6 +37,26 @@ struct ValueChanged {
     };
 };
 
+/**
+ * Attributes stored in compact formats, see vertex_compression.h.
+ */
+struct VertexCompression {
+    enum Enum {
+        None = 0x0,
+        /** Octahedral normals and tangents in 2 snorm16. */
+        Normal = 0x1,
+        /** unorm16 if the channel is inside [0, 1], half otherwise. */
+        UV = 0x2,
+        /** unorm8 colors. */
+        Color = 0x4,
+        /** unorm8 weights and uint8 joint indices if there are less than 256 joints. */
+        Skin = 0x8,
+        /** unorm16 positions relative to the bounds of the positions. */
+        Position = 0x10,
+        All = 0x1f
+    };
+};
+
 /**
  * Mesh containing common vertex elements of the model.
  */
@@ -120,6 +142,30 @@ public:
      */
     const std::vector<Vector2F> &uvs(int channelIndex = 0);
     
+    /**
+     * Set per-vertex bone weights for the mesh.
+     * @param boneWeights - The bone weights for the mesh.
+     */
+    void setBoneWeights(const std::vector<Vector4F> &boneWeights);
+    
+    /**
+     * Get bone weights for the mesh.
+     * @remarks Please call the setBoneWeights() method after modification to ensure that the modification takes effect.
+     */
+    const std::vector<Vector4F> &boneWeights();
+    
+    /**
+     * Set per-vertex bone indices for the mesh.
+     * @param boneIndices - The bone indices for the mesh.
+     */
+    void setBoneIndices(const std::vector<Vector4F> &boneIndices);
+    
+    /**
+     * Get bone indices for the mesh.
+     * @remarks Please call the setBoneIndices() method after modification to ensure that the modification takes effect.
+     */
+    const std::vector<Vector4F> &boneIndices();
+    
     /**
      * Set indices for the mesh.
      * @param indices - The indices for the mesh.
@@ -132,20 +178,68 @@ public:
      */
     const std::vector<uint32_t> indices();
     
+    /**
+     * Weld equal vertices, reorder triangles for the vertex cache and vertices by first use.
+     * @returns Vertex cache statistics of the optimized indices
+     * @remarks Only triangle lists are optimized, call it before uploadData.
+     */
+    VertexCacheStatistics optimize();
+    
     /**
      * Upload Mesh Data to the graphics API.
+     * @remarks Indices are uploaded as uint16 when every vertex is addressable.
      * @param noLongerAccessible - Whether to access data later. If true, you'll never access data anymore (free memory cache)
      */
     void uploadData(bool noLongerAccessible);
     
+    /**
+     * Mesh drawing the vertex buffer of this mesh with other indices, such as a level of detail.
+     * @param indices - Indices into the vertices of this mesh
+     * @remarks Call it after uploadData, the result is not accessible.
+     */
+    std::shared_ptr<ModelMesh> createLod(const std::vector<uint32_t> &indices);
+    
+    /**
+     * Combination of VertexCompression flags used by the next uploadData, None by default.
+     */
+    void setVertexCompression(int flags);
+    
+    int vertexCompression() const;
+    
+    /**
+     * Bytes per vertex of the uploaded vertex buffer.
+     */
+    uint32_t vertexStride() const;
+    
+    /**
+     * Scale and offset the shaders apply to positions compressed with VertexCompression::Position.
+     */
+    const PositionQuantization &positionQuantization() const;
+    
 private:
+    struct VertexElement {
+        Attributes semantic;
+        MTL::VertexFormat format;
+        uint32_t offset;
+        /** ValueChanged flag of the source data. */
+        int changeFlag;
+        /** UV channel, or -1. */
+        int channel;
+    };
+    
     MTL::Device &_device;
     
     std::shared_ptr<MTL::VertexDescriptor> _updateVertexDescriptor();
     
     size_t _vertexCount = 0;
     
-    void _updateVertices(std::vector<float> &vertices);
+    void _updateVertices(std::vector<uint8_t> &vertices);
+    
+    std::vector<Vector2F> &_uvChannel(int channelIndex);
+    
+    void _remapVertices(const std::vector<uint32_t> &remap, size_t newCount);
+    
+    void _addIndexSubMesh(const std::vector<uint32_t> &indices);
     
     void _releaseCache();
     
@@ -156,7 +250,10 @@ private:
     
     bool _accessible = true;
     int _vertexChangeFlag;
-    size_t _elementCount;
+    int _vertexCompression = VertexCompression::None;
+    std::vector<VertexElement> _vertexElements{};
+    uint32_t _vertexStride = 0;
+    PositionQuantization _positionQuantization{};
     std::vector<float> _vertices{};
     std::vector<uint32_t> _indices{};
     MTL::PrimitiveType _primitiveType;
@@ -782,6 +782,10 @@ void PrimitiveMesh::_initialize(const ModelMeshPtr &mesh,
     mesh->setNormals(normals);
     mesh->setUVs(uvs);
     mesh->setIndices(indices);
+    if (noLongerAccessible) {
+        // accessible meshes keep the generated vertex order for callers editing them
+        mesh->optimize();
+    }
     mesh->uploadData(noLongerAccessible);
 }
 
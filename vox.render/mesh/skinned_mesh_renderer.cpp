@@ -7,7 +7,6 @@
 #include "skinned_mesh_renderer.h"
 #include <ozz/animation/runtime/blending_job.h>
 #include <ozz/animation/runtime/local_to_model_job.h>
-#include <ozz/geometry/runtime/skinning_job.h>
 #include <glog/logging.h>
 #include "loader/animator_loader.h"
 #include "loader/fbx_loader.h"
@@ -56,9 +55,18 @@ Renderer(entity) {
 
 bool SkinnedMeshRenderer::loadSkeleton(const std::string &filename) {
     // Reading skeleton.
-    if (!ozz::loader::LoadSkeleton(filename.c_str(), &_skeleton)) {
+    ozz::animation::Skeleton skeleton;
+    if (!ozz::loader::LoadSkeleton(filename.c_str(), &skeleton)) {
         return false;
     }
+    setSkeleton(std::move(skeleton));
+    return true;
+}
+
+void SkinnedMeshRenderer::setSkeleton(ozz::animation::Skeleton &&skeleton) {
+    _skeleton = std::move(skeleton);
+    computeSkeletonBounds(_skeleton, &_skeletonBounds);
+    _setBoundsDirty();
     
     // Allocates runtime buffers.
     const int num_joints = _skeleton.num_joints();
@@ -69,8 +77,6 @@ bool SkinnedMeshRenderer::loadSkeleton(const std::string &filename) {
     
     // Allocates model space runtime buffers of blended data.
     _models.resize(num_joints);
-    
-    return true;
 }
 
 bool SkinnedMeshRenderer::addSkinnedMesh(const std::string &skin_filename,
@@ -97,77 +103,88 @@ bool SkinnedMeshRenderer::addSkinnedMesh(const std::string &skin_filename,
         }
     }
     
-    _meshes.insert(_meshes.end(), meshes.begin(), meshes.end());
-    // Computes the number of skinning matrices required to skin all meshes.
-    // A mesh is skinned by only a subset of joints, so the number of skinning
-    // matrices might be less that the number of skeleton joints.
-    // Mesh::joint_remaps is used to know how to order skinning matrices. So the
-    // number of matrices required is the size of joint_remaps.
-    size_t num_skinning_matrices = 0;
-    for (const ozz::loader::Mesh &mesh: _meshes) {
-        num_skinning_matrices = ozz::math::Max(num_skinning_matrices, mesh.joint_remaps.size());
+    // Skinning writes straight into shared buffers, only positions, normals
+    // and tangents change every frame.
+    auto &device = _entity->scene()->device();
+    for (const ozz::loader::Mesh &mesh: meshes) {
+        const size_t vertexCount = mesh.vertex_count();
+        auto vertexBuffer =
+        CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, device.newBuffer(std::max<size_t>(vertexCount, 1) * Skinning::kVertexStride,
+                                                                 MTL::ResourceOptionCPUCacheModeDefault));
+        auto uvBuffer =
+        CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, device.newBuffer(std::max<size_t>(vertexCount, 1) * Skinning::kUVStride,
+                                                                 MTL::ResourceOptionCPUCacheModeDefault));
+        Skinning::fillStatic(mesh, vertexBuffer->contents(), uvBuffer->contents());
+        
+        const size_t indexCount = mesh.triangle_indices.size();
+        auto indexBuffer =
+        CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, device.newBuffer(mesh.triangle_indices.data(),
+                                                                 indexCount * sizeof(ozz::loader::Mesh::TriangleIndices::value_type),
+                                                                 MTL::ResourceOptionCPUCacheModeDefault));
+        
+        auto renderMesh = std::make_shared<BufferMesh>();
+        renderMesh->setVertexBufferBinding(vertexBuffer, 0);
+        renderMesh->setVertexBufferBinding(uvBuffer, 1);
+        renderMesh->addSubMesh(MTL::PrimitiveTypeTriangle, MTL::IndexTypeUInt16, indexCount, indexBuffer);
+        renderMesh->setVertexLayouts(_vertexDescriptor);
+        
+        _vertexBuffers.push_back(vertexBuffer);
+        _uvBuffers.push_back(uvBuffer);
+        _indexBuffers.push_back(indexBuffer);
+        _renderMeshes.push_back(renderMesh);
     }
     
-    // Allocates skinning matrices.
-    _skinningMatrices.resize(num_skinning_matrices);
-    
-    const size_t bufferLength = _meshes.size();
-    _vertexBuffers.resize(bufferLength, nullptr);
-    _uvBuffers.resize(bufferLength, nullptr);
-    _indexBuffers.resize(bufferLength, nullptr);
+    _meshes.insert(_meshes.end(), meshes.begin(), meshes.end());
+    _skinningMatrices.resize(_meshes.size());
     
     return true;
 }
 
-void SkinnedMeshRenderer::update(float deltaTime) {
-    // Setups blending job.
-    ozz::animation::BlendingJob blend_job;
-    blend_job.threshold = _threshold;
-    blend_job.rest_pose = _skeleton.joint_rest_poses();
-    blend_job.output = ozz::make_span(_blendedLocals);
-    if (_animator == nullptr) {
-        _animator = entity()->getComponent<Animator>();
-    }
+bool SkinnedMeshRenderer::_updatePose() {
+    ozz::span<const ozz::animation::BlendingJob::Layer> layers;
     if (_animator) {
-        blend_job.layers = _animator->layers();
+        layers = _animator->layers();
     }
     
-    // Blends.
-    if (!blend_job.Run()) {
-        return;
+    _poseValid = Skinning::computeModels(_skeleton, layers, _threshold,
+                                         ozz::make_span(_blendedLocals), ozz::make_span(_models));
+    if (!_poseValid) {
+        return false;
     }
-    
-    // Converts from local space to model space matrices.
-    // Gets the output of the blending stage, and converts it to model space.
-    
-    // Setup local-to-model conversion job.
-    ozz::animation::LocalToModelJob ltm_job;
-    ltm_job.skeleton = &_skeleton;
-    ltm_job.input = ozz::make_span(_blendedLocals);
-    ltm_job.output = ozz::make_span(_models);
-    
-    // Runs ltm job.
-    if (!ltm_job.Run()) {
+    for (size_t index = 0; index < _meshes.size(); index++) {
+        Skinning::computeSkinningMatrices(_meshes[index], ozz::make_span(_models), _skinningMatrices[index]);
+    }
+    return true;
+}
+
+void SkinnedMeshRenderer::_appendSkinningRanges(std::vector<SkinningRange> &ranges) {
+    if (!_poseValid) {
         return;
     }
+    for (size_t index = 0; index < _meshes.size(); index++) {
+        Skinning::split(_meshes[index], ozz::make_span(_skinningMatrices[index]), _vertexBuffers[index]->contents(), ranges);
+    }
+}
+
+void SkinnedMeshRenderer::_onEnable() {
+    Renderer::_onEnable();
+    scene()->_componentsManager.addOnUpdateSkinnedMeshRenderer(this);
+}
+
+void SkinnedMeshRenderer::_onDisable() {
+    Renderer::_onDisable();
+    scene()->_componentsManager.removeOnUpdateSkinnedMeshRenderer(this);
 }
 
 void SkinnedMeshRenderer::_render(std::vector<RenderElement> &opaqueQueue,
                                   std::vector<RenderElement> &alphaTestQueue,
                                   std::vector<RenderElement> &transparentQueue) {
-    // Builds skinning matrices, based on the output of the animation stage.
-    // The mesh might not use (aka be skinned by) all skeleton joints. We use
-    // the joint remapping table (available from the mesh object) to reorder
-    // model-space matrices and build skinning ones.
+    // Vertex buffers were skinned by ComponentsManager::callSkinnedMeshRendererUpdate.
+    if (!_poseValid) {
+        return;
+    }
     for (size_t index = 0; index < _meshes.size(); index++) {
-        const auto &mesh = _meshes[index];
-        for (size_t i = 0; i < mesh.joint_remaps.size(); ++i) {
-            _skinningMatrices[i] = _models[mesh.joint_remaps[i]] * mesh.inverse_bind_poses[i];
-        }
-        
-        // Renders skin.
-        auto render_mesh = drawSkinnedMesh(index, mesh, ozz::make_span(_skinningMatrices),
-                                           ozz::math::Float4x4::identity());
+        const auto &render_mesh = _renderMeshes[index];
         const auto &vertexDescriptor = render_mesh->vertexDescriptor();
         
         shaderData.disableMacro(HAS_UV);
@@ -204,242 +221,13 @@ void SkinnedMeshRenderer::_render(std::vector<RenderElement> &opaqueQueue,
     }
 }
 
-namespace {
-// Volatile memory buffer that can be used within function scope.
-// Minimum alignment is 16 bytes.
-class ScratchBuffer {
-public:
-    ScratchBuffer() : buffer_(nullptr), size_(0) {
-    }
-    
-    ~ScratchBuffer() {
-        ozz::memory::default_allocator()->Deallocate(buffer_);
-    }
-    
-    // Resizes the buffer to the new size and return the memory address.
-    void *Resize(size_t _size) {
-        if (_size > size_) {
-            size_ = _size;
-            ozz::memory::default_allocator()->Deallocate(buffer_);
-            buffer_ = ozz::memory::default_allocator()->Allocate(_size, 16);
-        }
-        return buffer_;
-    }
-    
-private:
-    void *buffer_;
-    size_t size_;
-};
-
-const float kDefaultUVsArray[][2] = {
-    {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f},
-    {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f},
-    {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f},
-    {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f},
-    {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f},
-    {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f},
-    {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f},
-    {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f},
-    {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f},
-    {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f},
-    {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}, {0.f, 0.f}};
-} // namespace
-
-std::shared_ptr<Mesh> SkinnedMeshRenderer::drawSkinnedMesh(size_t index,
-                                                           const ozz::loader::Mesh &_mesh,
-                                                           const ozz::span<ozz::math::Float4x4> _skinning_matrices,
-                                                           const ozz::math::Float4x4 &_transform) {
-    ScratchBuffer vbo_buffer_;
-    ScratchBuffer uv_buffer_;
-    const int vertex_count = _mesh.vertex_count();
-    
-    // Positions and normals are interleaved to improve caching while executing
-    // skinning job.
-    const int32_t positions_offset = 0;
-    const int32_t normals_offset = sizeof(float) * 3;
-    const int32_t tangents_offset = sizeof(float) * 6;
-    const int32_t positions_stride = sizeof(float) * 9;
-    const int32_t normals_stride = positions_stride;
-    const int32_t tangents_stride = positions_stride;
-    const int32_t skinned_data_size = vertex_count * positions_stride;
-    void *vbo_map = vbo_buffer_.Resize(skinned_data_size);
-    
-    // Colors and uvs are contiguous. They aren't transformed, so they can be
-    // directly copied from source mesh which is non-interleaved as-well.
-    // Colors will be filled with white if _options.colors is false.
-    // UVs will be skipped if _options.textured is false.
-    const int32_t uvs_offset = 0;
-    const int32_t uvs_stride = sizeof(float) * 2;
-    const int32_t uvs_size = vertex_count * uvs_stride;
-    void *uv_map = uv_buffer_.Resize(uvs_size);
-    
-    // Iterate mesh parts and fills vbo.
-    // Runs a skinning job per mesh part. Triangle indices are shared
-    // across parts.
-    size_t processed_vertex_count = 0;
-    for (size_t i = 0; i < _mesh.parts.size(); ++i) {
-        const ozz::loader::Mesh::Part &part = _mesh.parts[i];
-        
-        // Skip this iteration if no vertex.
-        const size_t part_vertex_count = part.positions.size() / 3;
-        if (part_vertex_count == 0) {
-            continue;
-        }
-        
-        // Fills the job.
-        ozz::geometry::SkinningJob skinning_job;
-        skinning_job.vertex_count = static_cast<int>(part_vertex_count);
-        const int part_influences_count = part.influences_count();
-        
-        // Clamps joints influence count according to the option.
-        skinning_job.influences_count = part_influences_count;
-        
-        // Setup skinning matrices, that came from the animation stage before being
-        // multiplied by inverse model-space bind-pose.
-        skinning_job.joint_matrices = _skinning_matrices;
-        
-        // Setup joint's indices.
-        skinning_job.joint_indices = make_span(part.joint_indices);
-        skinning_job.joint_indices_stride =
-        sizeof(uint16_t) * part_influences_count;
-        
-        // Setup joint's weights.
-        if (part_influences_count > 1) {
-            skinning_job.joint_weights = make_span(part.joint_weights);
-            skinning_job.joint_weights_stride =
-            sizeof(float) * (part_influences_count - 1);
-        }
-        
-        // Setup input positions, coming from the loaded mesh.
-        skinning_job.in_positions = make_span(part.positions);
-        skinning_job.in_positions_stride =
-        sizeof(float) * ozz::loader::Mesh::Part::kPositionsCpnts;
-        
-        // Setup output positions, coming from the rendering output mesh buffers.
-        // We need to offset the buffer every loop.
-        float *out_positions_begin = reinterpret_cast<float *>(ozz::PointerStride(vbo_map,
-                                                                                  positions_offset + processed_vertex_count * positions_stride));
-        float *out_positions_end = ozz::PointerStride(
-                                                      out_positions_begin, part_vertex_count * positions_stride);
-        skinning_job.out_positions = {out_positions_begin, out_positions_end};
-        skinning_job.out_positions_stride = positions_stride;
-        
-        // Setup normals if input are provided.
-        float *out_normal_begin = reinterpret_cast<float *>(ozz::PointerStride(vbo_map,
-                                                                               normals_offset + processed_vertex_count * normals_stride));
-        float *out_normal_end = ozz::PointerStride(out_normal_begin, part_vertex_count * normals_stride);
-        
-        if (part.normals.size() / ozz::loader::Mesh::Part::kNormalsCpnts ==
-            part_vertex_count) {
-            // Setup input normals, coming from the loaded mesh.
-            skinning_job.in_normals = make_span(part.normals);
-            skinning_job.in_normals_stride =
-            sizeof(float) * ozz::loader::Mesh::Part::kNormalsCpnts;
-            
-            // Setup output normals, coming from the rendering output mesh buffers.
-            // We need to offset the buffer every loop.
-            skinning_job.out_normals = {out_normal_begin, out_normal_end};
-            skinning_job.out_normals_stride = normals_stride;
-        } else {
-            // Fills output with default normals.
-            for (float *normal = out_normal_begin; normal < out_normal_end;
-                 normal = ozz::PointerStride(normal, normals_stride)) {
-                normal[0] = 0.f;
-                normal[1] = 1.f;
-                normal[2] = 0.f;
-            }
-        }
-        
-        // Setup tangents if input are provided.
-        float *out_tangent_begin = reinterpret_cast<float *>(ozz::PointerStride(vbo_map,
-                                                                                tangents_offset + processed_vertex_count * tangents_stride));
-        float *out_tangent_end = ozz::PointerStride(out_tangent_begin, part_vertex_count * tangents_stride);
-        
-        if (part.tangents.size() / ozz::loader::Mesh::Part::kTangentsCpnts ==
-            part_vertex_count) {
-            // Setup input tangents, coming from the loaded mesh.
-            skinning_job.in_tangents = make_span(part.tangents);
-            skinning_job.in_tangents_stride =
-            sizeof(float) * ozz::loader::Mesh::Part::kTangentsCpnts;
-            
-            // Setup output tangents, coming from the rendering output mesh buffers.
-            // We need to offset the buffer every loop.
-            skinning_job.out_tangents = {out_tangent_begin, out_tangent_end};
-            skinning_job.out_tangents_stride = tangents_stride;
-        } else {
-            // Fills output with default tangents.
-            for (float *tangent = out_tangent_begin; tangent < out_tangent_end;
-                 tangent = ozz::PointerStride(tangent, tangents_stride)) {
-                tangent[0] = 1.f;
-                tangent[1] = 0.f;
-                tangent[2] = 0.f;
-            }
-        }
-        
-        // Execute the job, which should succeed unless a parameter is invalid.
-        if (!skinning_job.Run()) {
-            return nullptr;
-        }
-        
-        // Copies uvs which aren't affected by skinning.
-        if (true) {
-            if (part_vertex_count == part.uvs.size() / ozz::loader::Mesh::Part::kUVsCpnts) {
-                // Optimal path used when the right number of uvs is provided.
-                memcpy(ozz::PointerStride(uv_map, uvs_offset + processed_vertex_count * uvs_stride),
-                       array_begin(part.uvs), part_vertex_count * uvs_stride);
-            } else {
-                // Un-optimal path used when the right number of uvs is not provided.
-                assert(sizeof(kDefaultUVsArray[0]) == uvs_stride);
-                for (size_t j = 0; j < part_vertex_count;
-                     j += OZZ_ARRAY_SIZE(kDefaultUVsArray)) {
-                    const size_t this_loop_count = ozz::math::Min(OZZ_ARRAY_SIZE(kDefaultUVsArray), part_vertex_count - j);
-                    memcpy(ozz::PointerStride(uv_map, uvs_offset + (processed_vertex_count + j) * uvs_stride),
-                           kDefaultUVsArray, uvs_stride * this_loop_count);
-                }
-            }
-        }
-        
-        // Some more vertices were processed.
-        processed_vertex_count += part_vertex_count;
-    }
-    
-    if (_vertexBuffers[index] == nullptr) {
-        _vertexBuffers[index] =
-        CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _entity->scene()->device().newBuffer(vbo_map, skinned_data_size,
-                                                                                     MTL::ResourceOptionCPUCacheModeDefault));
-    } else {
-        memcpy(_vertexBuffers[index]->contents(), vbo_map, skinned_data_size);
-    }
-    
-    if (_uvBuffers[index] == nullptr) {
-        _uvBuffers[index] =
-        CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _entity->scene()->device().newBuffer(uv_map, uvs_size,
-                                                                                     MTL::ResourceOptionCPUCacheModeDefault));
+void SkinnedMeshRenderer::_updateBounds(BoundingBox3F &worldBounds) {
+    if (_skeleton.num_joints() > 0) {
+        worldBounds = _skeletonBounds.transform(_entity->transform->worldMatrix());
     } else {
-        memcpy(_uvBuffers[index]->contents(), uv_map, uvs_size);
+        worldBounds.lowerCorner = Point3F(0, 0, 0);
+        worldBounds.upperCorner = Point3F(0, 0, 0);
     }
-    
-    size_t indexCount = _mesh.triangle_indices.size();
-    if (_indexBuffers[index] == nullptr) {
-        _indexBuffers[index] =
-        CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _entity->scene()->device().newBuffer(_mesh.triangle_indices.data(),
-                                                                                     indexCount * sizeof(ozz::loader::Mesh::TriangleIndices::value_type),
-                                                                                     MTL::ResourceOptionCPUCacheModeDefault));
-    }
-    
-    auto submesh = SubMesh(MTL::PrimitiveTypeTriangle, MTL::IndexTypeUInt16, indexCount, _indexBuffers[index]);
-    
-    auto mesh = std::make_shared<BufferMesh>();
-    mesh->setVertexBufferBinding(_vertexBuffers[index], 0);
-    mesh->setVertexBufferBinding(_uvBuffers[index], 1);
-    mesh->addSubMesh(MTL::PrimitiveTypeTriangle, MTL::IndexTypeUInt16, indexCount, _indexBuffers[index]);
-    mesh->setVertexLayouts(_vertexDescriptor);
-    
-    return mesh;
-}
-
-void SkinnedMeshRenderer::_updateBounds(BoundingBox3F &worldBounds) {
-    SkinnedMeshRenderer::computeSkeletonBounds(_skeleton, &worldBounds);
 }
 
 void SkinnedMeshRenderer::computeSkeletonBounds(const ozz::animation::Skeleton &_skeleton,
@@ -9,6 +9,7 @@
 
 #include "renderer.h"
 #include "loader/fbx_mesh.h"
+#include "skinning.h"
 #include <ozz/animation/runtime/skeleton.h>
 #include <ozz/base/containers/vector.h>
 #include <ozz/base/maths/soa_transform.h>
@@ -25,10 +26,13 @@ public:
     
     void _updateBounds(BoundingBox3F &worldBounds) override;
     
-    void update(float deltaTime) override;
-    
     bool loadSkeleton(const std::string &filename);
     
+    /**
+     * Use a skeleton built at runtime, loadSkeleton reads it from a file.
+     */
+    void setSkeleton(ozz::animation::Skeleton &&skeleton);
+    
     bool addSkinnedMesh(const std::string &skin_filename,
                         const std::string &skel_filename);
     
@@ -49,18 +53,32 @@ private:
     static void computePostureBounds(ozz::span<const ozz::math::Float4x4> _matrices,
                                      BoundingBox3F *_bound);
     
-    // Renders a skinned mesh at a specified location.
-    std::shared_ptr<Mesh> drawSkinnedMesh(size_t index,
-                                          const ozz::loader::Mesh &_mesh,
-                                          const ozz::span<ozz::math::Float4x4> _skinning_matrices,
-                                          const ozz::math::Float4x4 &_transform);
+    // Blends the animator layers and builds the skinning matrices of every mesh.
+    // Runs as a job of the skinning stage, one per character.
+    bool _updatePose();
+    
+    // Appends the vertex ranges skinned by the workers into the vertex buffers.
+    void _appendSkinningRanges(std::vector<SkinningRange> &ranges);
+    
+    void _onEnable() override;
+    
+    void _onDisable() override;
     
 private:
+    friend class ComponentsManager;
+    
+    ssize_t _onUpdateIndex = -1;
+    bool _poseValid{false};
+    // the animator sampled since the last pose, culled renderers keep it until they are visible
+    bool _poseDirty{true};
     Animator *_animator{nullptr};
     
     // Runtime skeleton.
     ozz::animation::Skeleton _skeleton;
     
+    // Bind pose bounds of _skeleton in model space, moved by the entity transform.
+    BoundingBox3F _skeletonBounds;
+    
     // Blending job bind pose threshold.
     float _threshold;
     
@@ -71,15 +89,17 @@ private:
     // job after the blending stage.
     std::vector<ozz::math::Float4x4> _models;
     
-    // Buffer of skinning matrices, result of the joint multiplication of the
-    // inverse bind pose with the model space matrix.
-    std::vector<ozz::math::Float4x4> _skinningMatrices;
+    // Buffers of skinning matrices per mesh, result of the joint multiplication
+    // of the inverse bind pose with the model space matrix.
+    std::vector<std::vector<ozz::math::Float4x4>> _skinningMatrices;
     
     // The mesh used by the sample.
     std::vector<ozz::loader::Mesh> _meshes;
+    // Skinning writes the vertex buffers in place, uvs and indices are filled once.
     std::vector<std::shared_ptr<MTL::Buffer>> _vertexBuffers;
     std::vector<std::shared_ptr<MTL::Buffer>> _uvBuffers;
     std::vector<std::shared_ptr<MTL::Buffer>> _indexBuffers;
+    std::vector<std::shared_ptr<Mesh>> _renderMeshes;
     
     std::shared_ptr<MTL::VertexDescriptor> _vertexDescriptor{nullptr};
 };
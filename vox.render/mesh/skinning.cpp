@@ -0,0 +1,154 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "skinning.h"
+#include <ozz/animation/runtime/local_to_model_job.h>
+#include <ozz/geometry/runtime/skinning_job.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace vox {
+namespace {
+constexpr size_t kFloatsPerVertex = Skinning::kVertexStride / sizeof(float);
+constexpr size_t kNormalOffset = 3;
+constexpr size_t kTangentOffset = 6;
+
+// input attribute of the part starting at vertex first
+template<typename T>
+ozz::span<const T> tail(const ozz::vector<T> &values, size_t first, size_t components) {
+    return {values.data() + first * components, values.data() + values.size()};
+}
+
+bool hasNormals(const ozz::loader::Mesh::Part &part) {
+    return part.normals.size() / ozz::loader::Mesh::Part::kNormalsCpnts == static_cast<size_t>(part.vertex_count());
+}
+
+bool hasTangents(const ozz::loader::Mesh::Part &part) {
+    return part.tangents.size() / ozz::loader::Mesh::Part::kTangentsCpnts == static_cast<size_t>(part.vertex_count());
+}
+
+}
+
+bool Skinning::computeModels(const ozz::animation::Skeleton &skeleton,
+                             ozz::span<const ozz::animation::BlendingJob::Layer> layers, float threshold,
+                             ozz::span<ozz::math::SoaTransform> blended, ozz::span<ozz::math::Float4x4> models) {
+    ozz::animation::BlendingJob blendJob;
+    blendJob.threshold = threshold;
+    blendJob.layers = layers;
+    blendJob.rest_pose = skeleton.joint_rest_poses();
+    blendJob.output = blended;
+    if (!blendJob.Run()) {
+        return false;
+    }
+
+    ozz::animation::LocalToModelJob ltmJob;
+    ltmJob.skeleton = &skeleton;
+    ltmJob.input = blended;
+    ltmJob.output = models;
+    return ltmJob.Run();
+}
+
+void Skinning::computeSkinningMatrices(const ozz::loader::Mesh &mesh, ozz::span<const ozz::math::Float4x4> models,
+                                       std::vector<ozz::math::Float4x4> &matrices) {
+    // The mesh might not be skinned by all skeleton joints, the remapping table orders the model space matrices.
+    matrices.resize(mesh.joint_remaps.size());
+    for (size_t i = 0; i < mesh.joint_remaps.size(); ++i) {
+        matrices[i] = models[mesh.joint_remaps[i]] * mesh.inverse_bind_poses[i];
+    }
+}
+
+void Skinning::split(const ozz::loader::Mesh &mesh, ozz::span<const ozz::math::Float4x4> matrices, void *vertices,
+                     std::vector<SkinningRange> &ranges, size_t verticesPerRange) {
+    auto *destination = static_cast<float *>(vertices);
+    for (const auto &part : mesh.parts) {
+        const size_t vertexCount = part.vertex_count();
+        for (size_t first = 0; first < vertexCount; first += verticesPerRange) {
+            const size_t count = std::min(verticesPerRange, vertexCount - first);
+            ranges.push_back({&part, matrices, first, count, destination + first * kFloatsPerVertex});
+        }
+        // parts follow each other in the vertex buffer
+        destination += vertexCount * kFloatsPerVertex;
+    }
+}
+
+bool Skinning::skin(const SkinningRange &range) {
+    const auto &part = *range.part;
+    const int influencesCount = part.influences_count();
+
+    ozz::geometry::SkinningJob job;
+    job.vertex_count = static_cast<int>(range.count);
+    job.influences_count = influencesCount;
+    job.joint_matrices = range.matrices;
+    job.joint_indices = tail(part.joint_indices, range.first, influencesCount);
+    job.joint_indices_stride = sizeof(uint16_t) * influencesCount;
+    if (influencesCount > 1) {
+        job.joint_weights = tail(part.joint_weights, range.first, influencesCount - 1);
+        job.joint_weights_stride = sizeof(float) * (influencesCount - 1);
+    }
+
+    float *end = range.vertices + range.count * kFloatsPerVertex;
+    job.in_positions = tail(part.positions, range.first, ozz::loader::Mesh::Part::kPositionsCpnts);
+    job.in_positions_stride = sizeof(float) * ozz::loader::Mesh::Part::kPositionsCpnts;
+    job.out_positions = {range.vertices, end};
+    job.out_positions_stride = kVertexStride;
+    // without input the defaults written by fillStatic stay
+    if (hasNormals(part)) {
+        job.in_normals = tail(part.normals, range.first, ozz::loader::Mesh::Part::kNormalsCpnts);
+        job.in_normals_stride = sizeof(float) * ozz::loader::Mesh::Part::kNormalsCpnts;
+        job.out_normals = {range.vertices + kNormalOffset, end};
+        job.out_normals_stride = kVertexStride;
+    }
+    if (hasTangents(part)) {
+        job.in_tangents = tail(part.tangents, range.first, ozz::loader::Mesh::Part::kTangentsCpnts);
+        job.in_tangents_stride = sizeof(float) * ozz::loader::Mesh::Part::kTangentsCpnts;
+        job.out_tangents = {range.vertices + kTangentOffset, end};
+        job.out_tangents_stride = kVertexStride;
+    }
+    return job.Run();
+}
+
+bool Skinning::skin(const std::vector<SkinningRange> &ranges, ThreadPool &pool) {
+    std::atomic<bool> succeeded{true};
+    pool.parallelFor(ranges.size(), [&](size_t i) {
+        if (!skin(ranges[i])) {
+            succeeded = false;
+        }
+    });
+    return succeeded;
+}
+
+void Skinning::fillStatic(const ozz::loader::Mesh &mesh, void *vertices, void *uvs) {
+    auto *vertex = static_cast<float *>(vertices);
+    auto *uv = static_cast<float *>(uvs);
+    for (const auto &part : mesh.parts) {
+        const size_t vertexCount = part.vertex_count();
+        const bool normals = hasNormals(part);
+        const bool tangents = hasTangents(part);
+        for (size_t i = 0; i < vertexCount; i++, vertex += kFloatsPerVertex) {
+            if (!normals) {
+                vertex[kNormalOffset] = 0.f;
+                vertex[kNormalOffset + 1] = 1.f;
+                vertex[kNormalOffset + 2] = 0.f;
+            }
+            if (!tangents) {
+                vertex[kTangentOffset] = 1.f;
+                vertex[kTangentOffset + 1] = 0.f;
+                vertex[kTangentOffset + 2] = 0.f;
+            }
+        }
+
+        // uvs aren't affected by skinning
+        if (part.uvs.size() / ozz::loader::Mesh::Part::kUVsCpnts == vertexCount) {
+            memcpy(uv, part.uvs.data(), vertexCount * kUVStride);
+        } else {
+            std::fill(uv, uv + vertexCount * 2, 0.f);
+        }
+        uv += vertexCount * 2;
+    }
+}
+
+}
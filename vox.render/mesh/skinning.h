@@ -0,0 +1,81 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef skinning_hpp
+#define skinning_hpp
+
+#include "loader/fbx_mesh.h"
+#include "thread_pool.h"
+#include <ozz/animation/runtime/blending_job.h>
+#include <ozz/animation/runtime/skeleton.h>
+#include <ozz/base/maths/soa_transform.h>
+#include <ozz/base/span.h>
+#include <vector>
+
+namespace vox {
+/**
+ * Vertices of a mesh part which one job skins straight into the vertex buffer.
+ */
+struct SkinningRange {
+    const ozz::loader::Mesh::Part *part;
+    ozz::span<const ozz::math::Float4x4> matrices;
+    /** First vertex of the range in the part. */
+    size_t first;
+    size_t count;
+    /** Interleaved position, normal and tangent of the first vertex. */
+    float *vertices;
+};
+
+/**
+ * Animation and skinning of a character without the renderer, so that characters run as jobs.
+ */
+class Skinning {
+public:
+    /** Position, normal and tangent are interleaved. */
+    static constexpr size_t kVertexStride = sizeof(float) * 9;
+    static constexpr size_t kUVStride = sizeof(float) * 2;
+    static constexpr size_t kVerticesPerRange = 1024;
+
+    /**
+     * Blend the layers and convert the result to model space.
+     * @param blended - Local transforms of the blend, num_soa_joints of the skeleton
+     * @param models - Model space matrices, num_joints of the skeleton
+     */
+    static bool computeModels(const ozz::animation::Skeleton &skeleton,
+                              ozz::span<const ozz::animation::BlendingJob::Layer> layers, float threshold,
+                              ozz::span<ozz::math::SoaTransform> blended, ozz::span<ozz::math::Float4x4> models);
+
+    /**
+     * Model space matrices reordered by the joint remaps of the mesh and multiplied by its inverse bind poses.
+     */
+    static void computeSkinningMatrices(const ozz::loader::Mesh &mesh, ozz::span<const ozz::math::Float4x4> models,
+                                        std::vector<ozz::math::Float4x4> &matrices);
+
+    /**
+     * Split the parts of a mesh into ranges of at most verticesPerRange vertices.
+     * @param vertices - Vertex buffer of the mesh, kVertexStride per vertex
+     */
+    static void split(const ozz::loader::Mesh &mesh, ozz::span<const ozz::math::Float4x4> matrices, void *vertices,
+                      std::vector<SkinningRange> &ranges, size_t verticesPerRange = kVerticesPerRange);
+
+    static bool skin(const SkinningRange &range);
+
+    /**
+     * Skin all ranges on the pool, the calling thread takes part.
+     * @returns False if a range failed.
+     */
+    static bool skin(const std::vector<SkinningRange> &ranges, ThreadPool &pool = ThreadPool::shared());
+
+    /**
+     * Write what skinning never changes: uvs, and normals or tangents of parts which have none.
+     * @remarks Called once when the buffers are created.
+     */
+    static void fillStatic(const ozz::loader::Mesh &mesh, void *vertices, void *uvs);
+};
+
+}
+
+#endif /* skinning_hpp */
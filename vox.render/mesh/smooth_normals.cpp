@@ -0,0 +1,111 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "smooth_normals.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace vox {
+namespace {
+inline const float *position(const float *positions, size_t stride, uint32_t index) {
+    return reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(positions) + stride * index);
+}
+
+} // namespace
+
+SmoothNormals::SmoothNormals(const std::vector<uint32_t> &indices, size_t vertexCount) :
+_indices(indices) {
+    const size_t faceCount = indices.size() / 3;
+    _indices.resize(faceCount * 3);
+    _faceOffsets.assign(vertexCount + 1, 0);
+    for (const auto index : _indices) {
+        assert(index < vertexCount);
+        _faceOffsets[index + 1]++;
+    }
+    for (size_t i = 0; i < vertexCount; i++) {
+        _faceOffsets[i + 1] += _faceOffsets[i];
+    }
+
+    // faces in increasing order, the sums do not depend on the threads
+    _vertexFaces.resize(_indices.size());
+    std::vector<uint32_t> cursors(_faceOffsets.begin(), _faceOffsets.end() - 1);
+    for (size_t i = 0; i < _indices.size(); i++) {
+        _vertexFaces[cursors[_indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+    _faceNormals.resize(faceCount * 4);
+}
+
+void SmoothNormals::update(const float *positions, size_t positionStride, float *vertices, ThreadPool &pool) {
+    const size_t faceCount = _indices.size() / 3;
+    const size_t count = vertexCount();
+
+    // the cross product is twice the area, larger faces weigh more without a square root per face
+    constexpr size_t kFacesPerJob = kVerticesPerJob * 2;
+    pool.parallelFor((faceCount + kFacesPerJob - 1) / kFacesPerJob, [&](size_t job) {
+        const size_t end = std::min(faceCount, (job + 1) * kFacesPerJob);
+        for (size_t face = job * kFacesPerJob; face < end; face++) {
+            const float *p0 = position(positions, positionStride, _indices[face * 3]);
+            const float *p1 = position(positions, positionStride, _indices[face * 3 + 1]);
+            const float *p2 = position(positions, positionStride, _indices[face * 3 + 2]);
+            const float a[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            const float b[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            float *normal = _faceNormals.data() + face * 4;
+            normal[0] = a[1] * b[2] - a[2] * b[1];
+            normal[1] = a[2] * b[0] - a[0] * b[2];
+            normal[2] = a[0] * b[1] - a[1] * b[0];
+            normal[3] = 0;
+        }
+    });
+
+    pool.parallelFor((count + kVerticesPerJob - 1) / kVerticesPerJob, [&](size_t job) {
+        const size_t end = std::min(count, (job + 1) * kVerticesPerJob);
+        for (size_t i = job * kVerticesPerJob; i < end; i++) {
+            const float *p = position(positions, positionStride, static_cast<uint32_t>(i));
+            float *vertex = vertices + i * 6;
+#if defined(__SSE2__)
+            // a fourth float is read only where the stride leaves room for it
+            const __m128 source = positionStride >= sizeof(float) * 4 || i + 1 < count ?
+            _mm_loadu_ps(p) : _mm_setr_ps(p[0], p[1], p[2], 0);
+            __m128 sum = _mm_setzero_ps();
+            for (uint32_t f = _faceOffsets[i]; f < _faceOffsets[i + 1]; f++) {
+                sum = _mm_add_ps(sum, _mm_loadu_ps(_faceNormals.data() + size_t(_vertexFaces[f]) * 4));
+            }
+            __m128 squared = _mm_mul_ps(sum, sum);
+            squared = _mm_add_ss(_mm_add_ss(squared, _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(1, 1, 1, 1))),
+                                 _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(2, 2, 2, 2)));
+            const float length = std::sqrt(_mm_cvtss_f32(squared));
+            const __m128 normal = length > 0 ? _mm_div_ps(sum, _mm_set1_ps(length)) : sum;
+            // the fourth float of the position lands on the normal, which is written after it
+            _mm_storeu_ps(vertex, source);
+            _mm_storel_pi(reinterpret_cast<__m64 *>(vertex + 3), normal);
+            _mm_store_ss(vertex + 5, _mm_shuffle_ps(normal, normal, _MM_SHUFFLE(2, 2, 2, 2)));
+#else
+            float sum[3] = {0, 0, 0};
+            for (uint32_t f = _faceOffsets[i]; f < _faceOffsets[i + 1]; f++) {
+                const float *normal = _faceNormals.data() + size_t(_vertexFaces[f]) * 4;
+                sum[0] += normal[0];
+                sum[1] += normal[1];
+                sum[2] += normal[2];
+            }
+            const float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+            const float scale = length > 0 ? 1 / length : 0;
+            vertex[0] = p[0];
+            vertex[1] = p[1];
+            vertex[2] = p[2];
+            vertex[3] = sum[0] * scale;
+            vertex[4] = sum[1] * scale;
+            vertex[5] = sum[2] * scale;
+#endif
+        }
+    });
+}
+
+}
@@ -0,0 +1,58 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef smooth_normals_hpp
+#define smooth_normals_hpp
+
+#include "thread_pool.h"
+#include <cstdint>
+#include <vector>
+
+namespace vox {
+/**
+ * Area weighted vertex normals of a deforming triangle mesh whose topology never changes, as cloth.
+ * @remarks The faces around every vertex are listed once, so each vertex sums its own faces and
+ * vertices are spread over the pool without atomics, in the same order every frame.
+ */
+class SmoothNormals {
+public:
+    /** Position and normal are interleaved. */
+    static constexpr size_t kVertexStride = sizeof(float) * 6;
+    static constexpr size_t kVerticesPerJob = 4096;
+
+    SmoothNormals() = default;
+
+    /**
+     * @param indices - Triangle list
+     * @param vertexCount - Vertices the indices refer to
+     */
+    SmoothNormals(const std::vector<uint32_t> &indices, size_t vertexCount);
+
+    size_t vertexCount() const {
+        return _faceOffsets.empty() ? 0 : _faceOffsets.size() - 1;
+    }
+
+    /**
+     * Copy the positions into the vertices and recompute the normals, the calling thread takes part.
+     * @param positions - Three floats of the first position
+     * @param positionStride - Bytes from a position to the next, at least three floats
+     * @param vertices - vertexCount vertices of kVertexStride
+     */
+    void update(const float *positions, size_t positionStride, float *vertices,
+                ThreadPool &pool = ThreadPool::shared());
+
+private:
+    std::vector<uint32_t> _indices{};
+    // faces of vertex v are _vertexFaces[_faceOffsets[v], _faceOffsets[v + 1])
+    std::vector<uint32_t> _faceOffsets{};
+    std::vector<uint32_t> _vertexFaces{};
+    // unnormalized, four floats per face
+    std::vector<float> _faceNormals{};
+};
+
+}
+
+#endif /* smooth_normals_hpp */
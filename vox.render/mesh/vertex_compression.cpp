@@ -0,0 +1,162 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "vertex_compression.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace vox {
+namespace compression {
+int16_t encodeSnorm16(float value) {
+    return static_cast<int16_t>(std::round(std::clamp(value, -1.f, 1.f) * 32767.f));
+}
+
+float decodeSnorm16(int16_t value) {
+    return std::max(value / 32767.f, -1.f);
+}
+
+uint16_t encodeUnorm16(float value) {
+    return static_cast<uint16_t>(std::round(std::clamp(value, 0.f, 1.f) * 65535.f));
+}
+
+float decodeUnorm16(uint16_t value) {
+    return value / 65535.f;
+}
+
+uint8_t encodeUnorm8(float value) {
+    return static_cast<uint8_t>(std::round(std::clamp(value, 0.f, 1.f) * 255.f));
+}
+
+float decodeUnorm8(uint8_t value) {
+    return value / 255.f;
+}
+
+uint16_t encodeHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    const uint32_t magnitude = bits & 0x7fffffff;
+    if (magnitude >= 0x7f800000) {
+        // inf stays inf, nan stays a quiet nan
+        return sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0);
+    }
+    if (magnitude >= 0x477ff000) {
+        // rounds above 65504
+        return sign | 0x7c00;
+    }
+    if (magnitude < 0x38800000) {
+        // subnormal half, scale so that the mantissa is rounded by the float addition
+        float scaled;
+        memcpy(&scaled, &magnitude, sizeof(scaled));
+        scaled += 0.5f;
+        uint32_t scaledBits;
+        memcpy(&scaledBits, &scaled, sizeof(scaledBits));
+        return sign | static_cast<uint16_t>(scaledBits - 0x3f000000);
+    }
+    const uint32_t mantissaOdd = (magnitude >> 13) & 1;
+    // rebias exponent from 127 to 15 and round to nearest even
+    const uint32_t rounded = magnitude + 0xc8000fff + mantissaOdd;
+    return sign | static_cast<uint16_t>(rounded >> 13);
+}
+
+float decodeHalf(uint16_t value) {
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1f;
+    const uint32_t mantissa = value & 0x3ff;
+    uint32_t bits;
+    if (exponent == 0) {
+        const float result = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -result : result;
+    } else if (exponent == 0x1f) {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+//MARK: - Direction
+Vector2F octEncode(const Vector3F &direction) {
+    const float sum = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    if (sum == 0) {
+        return Vector2F(0, 0);
+    }
+    float x = direction.x / sum;
+    float y = direction.y / sum;
+    if (direction.z < 0) {
+        // fold the lower hemisphere over the diagonals
+        const float foldX = (1 - std::abs(y)) * (x >= 0 ? 1.f : -1.f);
+        const float foldY = (1 - std::abs(x)) * (y >= 0 ? 1.f : -1.f);
+        x = foldX;
+        y = foldY;
+    }
+    return Vector2F(x, y);
+}
+
+Vector3F octDecode(const Vector2F &encoded) {
+    Vector3F direction(encoded.x, encoded.y, 1 - std::abs(encoded.x) - std::abs(encoded.y));
+    const float t = std::max(-direction.z, 0.f);
+    direction.x += direction.x >= 0 ? -t : t;
+    direction.y += direction.y >= 0 ? -t : t;
+    return direction.normalized();
+}
+
+void encodeNormal(const Vector3F &normal, int16_t *out) {
+    const auto encoded = octEncode(normal);
+    out[0] = encodeSnorm16(encoded.x);
+    out[1] = encodeSnorm16(encoded.y);
+}
+
+Vector3F decodeNormal(const int16_t *encoded) {
+    return octDecode(Vector2F(decodeSnorm16(encoded[0]), decodeSnorm16(encoded[1])));
+}
+
+void encodeTangent(const Vector4F &tangent, int16_t *out) {
+    const auto encoded = octEncode(Vector3F(tangent.x, tangent.y, tangent.z));
+    out[0] = encodeSnorm16(encoded.x);
+    // y in [-1, 1] to magnitude in [0.5, 1], the sign carries w
+    const float magnitude = 0.5f + 0.25f * (encoded.y + 1);
+    out[1] = encodeSnorm16(tangent.w < 0 ? -magnitude : magnitude);
+}
+
+Vector4F decodeTangent(const int16_t *encoded) {
+    const float second = decodeSnorm16(encoded[1]);
+    const float y = (std::abs(second) - 0.5f) * 4 - 1;
+    const auto direction = octDecode(Vector2F(decodeSnorm16(encoded[0]), std::clamp(y, -1.f, 1.f)));
+    return Vector4F(direction.x, direction.y, direction.z, second < 0 ? -1 : 1);
+}
+
+//MARK: - Position
+PositionQuantization positionQuantization(const BoundingBox3F &bounds) {
+    PositionQuantization quantization;
+    const auto &lower = bounds.lowerCorner;
+    const auto &upper = bounds.upperCorner;
+    // flat axes keep a unit scale so that decoding stays finite
+    quantization.scale = simd_make_float4(upper.x > lower.x ? upper.x - lower.x : 1.f,
+                                          upper.y > lower.y ? upper.y - lower.y : 1.f,
+                                          upper.z > lower.z ? upper.z - lower.z : 1.f, 0);
+    quantization.offset = simd_make_float4(lower.x, lower.y, lower.z, 0);
+    return quantization;
+}
+
+void encodePosition(const Vector3F &position, const PositionQuantization &quantization, uint16_t *out) {
+    out[0] = encodeUnorm16((position.x - quantization.offset[0]) / quantization.scale[0]);
+    out[1] = encodeUnorm16((position.y - quantization.offset[1]) / quantization.scale[1]);
+    out[2] = encodeUnorm16((position.z - quantization.offset[2]) / quantization.scale[2]);
+    out[3] = 0;
+}
+
+Vector3F decodePosition(const uint16_t *encoded, const PositionQuantization &quantization) {
+    return Vector3F(decodeUnorm16(encoded[0]) * quantization.scale[0] + quantization.offset[0],
+                    decodeUnorm16(encoded[1]) * quantization.scale[1] + quantization.offset[1],
+                    decodeUnorm16(encoded[2]) * quantization.scale[2] + quantization.offset[2]);
+}
+
+}
+}
@@ -0,0 +1,78 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef vertex_compression_hpp
+#define vertex_compression_hpp
+
+#include "vector2.h"
+#include "vector3.h"
+#include "vector4.h"
+#include "bounding_box3.h"
+#include "shader_common.h"
+#include <cstdint>
+
+namespace vox {
+/**
+ * Encode and decode kernels of the compact vertex formats, the shader side is in function_common.metal.
+ */
+namespace compression {
+int16_t encodeSnorm16(float value);
+
+float decodeSnorm16(int16_t value);
+
+uint16_t encodeUnorm16(float value);
+
+float decodeUnorm16(uint16_t value);
+
+uint8_t encodeUnorm8(float value);
+
+float decodeUnorm8(uint8_t value);
+
+/**
+ * Float to IEEE half, rounding to nearest even, overflow goes to infinity.
+ */
+uint16_t encodeHalf(float value);
+
+float decodeHalf(uint16_t value);
+
+/**
+ * Octahedral mapping of a unit vector to [-1, 1]^2.
+ */
+Vector2F octEncode(const Vector3F &direction);
+
+Vector3F octDecode(const Vector2F &encoded);
+
+/**
+ * Normal as 2 snorm16, MTL::VertexFormatShort2Normalized.
+ */
+void encodeNormal(const Vector3F &normal, int16_t *out);
+
+Vector3F decodeNormal(const int16_t *encoded);
+
+/**
+ * Tangent as 2 snorm16 with the bitangent sign in w folded into the second component.
+ * @remarks The second component keeps 14 bits of precision.
+ */
+void encodeTangent(const Vector4F &tangent, int16_t *out);
+
+Vector4F decodeTangent(const int16_t *encoded);
+
+/**
+ * Scale and offset that map unorm16 positions back to the bounds.
+ */
+PositionQuantization positionQuantization(const BoundingBox3F &bounds);
+
+/**
+ * Position as 4 unorm16 relative to bounds, MTL::VertexFormatUShort4Normalized, w is unused.
+ */
+void encodePosition(const Vector3F &position, const PositionQuantization &quantization, uint16_t *out);
+
+Vector3F decodePosition(const uint16_t *encoded, const PositionQuantization &quantization);
+
+}
+}
+
+#endif /* vertex_compression_hpp */
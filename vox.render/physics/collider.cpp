@@ -70,7 +70,9 @@ void Collider::_onUpdate() {
         const auto &p = transform->worldPosition();
         auto q = transform->worldRotationQuaternion();
         q.normalize();
-        _nativeActor->setGlobalPose(PxTransform(PxVec3(p.x, p.y, p.z), PxQuat(q.x, q.y, q.z, q.w)));
+        const PxTransform pose(PxVec3(p.x, p.y, p.z), PxQuat(q.x, q.y, q.z, q.w));
+        _nativeActor->setGlobalPose(pose);
+        _onTeleport(pose);
         _updateFlag->flag = false;
         
         const auto worldScale = transform->lossyWorldScale();
@@ -29,7 +29,17 @@ public:
 public:
     void _onUpdate();
     
-    virtual void _onLateUpdate() {
+    /**
+     * Write the simulated pose to the entity.
+     * @param interpolation - Position of the frame between the last two steps, 1 is the last step
+     */
+    virtual void _onLateUpdate(float interpolation) {
+    }
+    
+    /**
+     * Called after the results of every step are fetched.
+     */
+    virtual void _onFetch() {
     }
     
     void _onEnable() override;
@@ -46,6 +56,12 @@ public:
 protected:
     friend class PhysicsManager;
     
+    /**
+     * Called when the pose of the entity was moved to the actor.
+     */
+    virtual void _onTeleport(const PxTransform &pose) {
+    }
+    
     ssize_t _index = -1;
     std::unique_ptr<UpdateFlag> _updateFlag;
     physx::PxRigidActor *_nativeActor;
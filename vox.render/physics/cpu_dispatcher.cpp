@@ -0,0 +1,104 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "cpu_dispatcher.h"
+#include "../thread_pool.h"
+#include <algorithm>
+#include <vector>
+
+namespace vox {
+namespace physics {
+CpuDispatcher &CpuDispatcher::shared() {
+    // leaked like the thread pool, tasks may still run while static objects are destroyed
+    static auto *dispatcher = new CpuDispatcher(static_cast<uint32_t>(ThreadPool::shared().threadCount()));
+    return *dispatcher;
+}
+
+CpuDispatcher::CpuDispatcher(uint32_t workerCount) :
+_workerCount(workerCount) {
+}
+
+CpuDispatcher::~CpuDispatcher() {
+    wait();
+}
+
+void CpuDispatcher::setWorkerCount(uint32_t workerCount) {
+    std::vector<std::function<void()>> started;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _workerCount = workerCount;
+        while (_running < _workerCount && !_pending.empty()) {
+            started.push_back(std::move(_pending.front()));
+            _pending.pop_front();
+            _running++;
+        }
+    }
+    for (auto &job : started) {
+        _start(std::move(job));
+    }
+}
+
+uint32_t CpuDispatcher::getWorkerCount() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _workerCount;
+}
+
+void CpuDispatcher::submitTask(physx::PxBaseTask &task) {
+    submit([&task]() {
+        task.run();
+        task.release();
+    });
+}
+
+void CpuDispatcher::submit(std::function<void()> job) {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_workerCount == 0) {
+            lock.unlock();
+            job();
+            return;
+        }
+        if (_running >= _workerCount) {
+            _pending.push_back(std::move(job));
+            return;
+        }
+        _running++;
+    }
+    _start(std::move(job));
+}
+
+void CpuDispatcher::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock, [this]() {
+        return _running == 0 && _pending.empty();
+    });
+}
+
+void CpuDispatcher::_start(std::function<void()> job) {
+    ThreadPool::shared().enqueue([this, job = std::move(job)]() mutable {
+        _run(std::move(job));
+    });
+}
+
+void CpuDispatcher::_run(std::function<void()> job) {
+    while (true) {
+        job();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        // a lowered count retires workers, the last one keeps draining so nothing is left queued
+        if (_pending.empty() || _running > std::max(_workerCount, 1u)) {
+            if (--_running == 0 && _pending.empty()) {
+                _idle.notify_all();
+            }
+            return;
+        }
+        job = std::move(_pending.front());
+        _pending.pop_front();
+    }
+}
+
+}
+}
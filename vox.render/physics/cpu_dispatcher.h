@@ -0,0 +1,79 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef cpu_dispatcher_hpp
+#define cpu_dispatcher_hpp
+
+#include <task/PxCpuDispatcher.h>
+#include <task/PxTask.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace vox {
+namespace physics {
+/**
+ * PhysX CPU dispatcher which runs tasks on the shared thread pool.
+ * @remarks At most workerCount jobs run at once, physics and cloth leave the other workers to rendering jobs.
+ */
+class CpuDispatcher : public physx::PxCpuDispatcher {
+public:
+    /**
+     * Dispatcher of the physics scenes and the cloth solvers, with as many workers as the shared thread pool.
+     */
+    static CpuDispatcher &shared();
+
+    /**
+     * @param workerCount - Jobs which may run at once, 0 runs every job on the thread which submits it
+     */
+    explicit CpuDispatcher(uint32_t workerCount);
+
+    /**
+     * Waits for the jobs which were submitted.
+     */
+    ~CpuDispatcher() override;
+
+    CpuDispatcher(const CpuDispatcher &) = delete;
+
+    CpuDispatcher &operator=(const CpuDispatcher &) = delete;
+
+    /**
+     * Change the number of jobs which may run at once, queued jobs start when it grows.
+     */
+    void setWorkerCount(uint32_t workerCount);
+
+    uint32_t getWorkerCount() const override;
+
+    void submitTask(physx::PxBaseTask &task) override;
+
+    /**
+     * Queue a job which is not a PhysX task, it counts against the same workers.
+     */
+    void submit(std::function<void()> job);
+
+    /**
+     * Block until every submitted job is finished.
+     */
+    void wait();
+
+private:
+    void _start(std::function<void()> job);
+
+    // runs the job and then the queued ones while the worker is still within the count
+    void _run(std::function<void()> job);
+
+    mutable std::mutex _mutex;
+    std::condition_variable _idle;
+    std::deque<std::function<void()>> _pending{};
+    uint32_t _workerCount;
+    uint32_t _running{0};
+};
+
+}
+}
+
+#endif /* cpu_dispatcher_hpp */
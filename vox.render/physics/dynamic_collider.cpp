@@ -16,8 +16,10 @@ Collider(entity) {
     auto q = entity->transform->worldRotationQuaternion();
     q.normalize();
     
-    _nativeActor = PhysicsManager::_nativePhysics()->createRigidDynamic(PxTransform(PxVec3(p.x, p.y, p.z),
-                                                                                    PxQuat(q.x, q.y, q.z, q.w)));
+    const PxTransform pose(PxVec3(p.x, p.y, p.z), PxQuat(q.x, q.y, q.z, q.w));
+    _nativeActor = PhysicsManager::_nativePhysics()->createRigidDynamic(pose);
+    _previousPose = pose;
+    _currentPose = pose;
 }
 
 float DynamicCollider::linearDamping() {
@@ -191,21 +193,35 @@ void DynamicCollider::wakeUp() {
     static_cast<PxRigidDynamic *>(_nativeActor)->wakeUp();
 }
 
-void DynamicCollider::_onLateUpdate() {
+void DynamicCollider::_onLateUpdate(float interpolation) {
     const auto &transform = entity()->transform;
     
-    PxTransform pose = _nativeActor->getGlobalPose();
-    transform->setWorldPosition(Point3F(pose.p.x, pose.p.y, pose.p.z));
-    transform->setWorldRotationQuaternion(QuaternionF(pose.q.x, pose.q.y, pose.q.z, pose.q.w));
+    const PxVec3 p = _previousPose.p + (_currentPose.p - _previousPose.p) * interpolation;
+    const QuaternionF q = slerp(QuaternionF(_previousPose.q.x, _previousPose.q.y, _previousPose.q.z, _previousPose.q.w),
+                                QuaternionF(_currentPose.q.x, _currentPose.q.y, _currentPose.q.z, _currentPose.q.w),
+                                interpolation);
+    transform->setWorldPosition(Point3F(p.x, p.y, p.z));
+    transform->setWorldRotationQuaternion(q);
     _updateFlag->flag = false;
     
 #ifdef _DEBUG
     if (_entity) {
-        _entity->transform->setPosition(Point3F(pose.p.x, pose.p.y, pose.p.z));
-        _entity->transform->setRotationQuaternion(QuaternionF(pose.q.x, pose.q.y, pose.q.z, pose.q.w));
+        _entity->transform->setPosition(Point3F(p.x, p.y, p.z));
+        _entity->transform->setRotationQuaternion(q);
     }
 #endif
 }
 
+void DynamicCollider::_onFetch() {
+    _previousPose = _currentPose;
+    _currentPose = _nativeActor->getGlobalPose();
+}
+
+void DynamicCollider::_onTeleport(const PxTransform &pose) {
+    // a moved entity starts from its new pose instead of sliding there
+    _previousPose = pose;
+    _currentPose = pose;
+}
+
 }
 }
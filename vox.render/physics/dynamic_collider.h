@@ -154,7 +154,15 @@ public:
     void wakeUp();
     
 private:
-    void _onLateUpdate() override;
+    void _onLateUpdate(float interpolation) override;
+    
+    void _onFetch() override;
+    
+    void _onTeleport(const PxTransform &pose) override;
+    
+    // poses of the last two steps, blended for rendering
+    PxTransform _previousPose;
+    PxTransform _currentPose;
 };
 
 }
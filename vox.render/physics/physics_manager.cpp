@@ -5,11 +5,16 @@
 //  property of any third parties.
 
 #include "physics_manager.h"
+#include "cpu_dispatcher.h"
 #include "shape/collider_shape.h"
 #include "character_controller/character_controller.h"
 #include "collider.h"
 #include "../entity.h"
 #include "../script.h"
+#include "../timer.h"
+#include "../thread_pool.h"
+#include <algorithm>
+#include <cmath>
 
 namespace vox {
 namespace physics {
@@ -72,6 +77,57 @@ public:
     void onAdvance(const PxRigidBody *const *, const PxTransform *, const PxU32) override {
     }
 };
+
+// shapes which are not made by a ColliderShape, like the ones of character controllers, may share an id
+Entity *findEntity(const std::vector<ColliderShapePtr> &shapes, const PxShape &shape, const PxRigidActor &actor) {
+    const uint32_t id = shape.getQueryFilterData().word0;
+    if (id >= shapes.size() || shapes[id] == nullptr) {
+        return nullptr;
+    }
+    auto collider = shapes[id]->collider();
+    return collider != nullptr && collider->handle() == &actor ? collider->entity() : nullptr;
+}
+
+/**
+ * Skips the shapes of entities outside of the layer mask before PhysX tests them.
+ */
+class LayerFilterCallback : public PxQueryFilterCallback {
+public:
+    LayerFilterCallback(const std::vector<ColliderShapePtr> &shapes, Layer layerMask) :
+    _shapes(shapes), _layerMask(static_cast<uint32_t>(layerMask)) {
+    }
+    
+    PxQueryHitType::Enum preFilter(const PxFilterData &, const PxShape *shape,
+                                   const PxRigidActor *actor, PxHitFlags &) override {
+        const auto entity = findEntity(_shapes, *shape, *actor);
+        return entity != nullptr && (entity->layer & _layerMask) ? PxQueryHitType::eBLOCK : PxQueryHitType::eNONE;
+    }
+    
+    PxQueryHitType::Enum postFilter(const PxFilterData &, const PxQueryHit &) override {
+        return PxQueryHitType::eBLOCK;
+    }
+    
+private:
+    const std::vector<ColliderShapePtr> &_shapes;
+    uint32_t _layerMask;
+};
+
+const PxQueryFilterData kQueryFilterData(PxQueryFlag::eSTATIC | PxQueryFlag::eDYNAMIC | PxQueryFlag::ePREFILTER);
+
+PxTransform makeTransform(const Point3F &position, const QuaternionF &rotation) {
+    return PxTransform(PxVec3(position.x, position.y, position.z),
+                       PxQuat(rotation.x, rotation.y, rotation.z, rotation.w));
+}
+
+HitResult makeHitResult(const PxLocationHit &hit, Entity *entity) {
+    HitResult result;
+    result.entity = entity;
+    result.distance = hit.distance;
+    result.point = Point3F(hit.position.x, hit.position.y, hit.position.z);
+    result.normal = Vector3F(hit.normal.x, hit.normal.y, hit.normal.z);
+    return result;
+}
+
 } // namespace
 
 uint32_t PhysicsManager::_idGenerator = 0;
@@ -86,8 +142,8 @@ PhysicsManager::PhysicsManager() {
     };
     
     onTriggerEnter = [&](PxShape *obj1, PxShape *obj2) {
-        const auto shape1 = _physicalObjectsMap[obj1->getQueryFilterData().word0];
-        const auto shape2 = _physicalObjectsMap[obj2->getQueryFilterData().word0];
+        const auto shape1 = _physicalObjects[obj1->getQueryFilterData().word0];
+        const auto shape2 = _physicalObjects[obj2->getQueryFilterData().word0];
         
         auto scripts = shape1->collider()->entity()->scripts();
         for (const auto &script: scripts) {
@@ -100,8 +156,8 @@ PhysicsManager::PhysicsManager() {
         }
     };
     onTriggerExit = [&](PxShape *obj1, PxShape *obj2) {
-        const auto shape1 = _physicalObjectsMap[obj1->getQueryFilterData().word0];
-        const auto shape2 = _physicalObjectsMap[obj2->getQueryFilterData().word0];
+        const auto shape1 = _physicalObjects[obj1->getQueryFilterData().word0];
+        const auto shape2 = _physicalObjects[obj2->getQueryFilterData().word0];
         
         auto scripts = shape1->collider()->entity()->scripts();
         for (const auto &script: scripts) {
@@ -122,7 +178,7 @@ PhysicsManager::PhysicsManager() {
     
     PxSceneDesc sceneDesc(_nativePhysics()->getTolerancesScale());
     sceneDesc.gravity = PxVec3(0.0f, -9.81f, 0.0f);
-    sceneDesc.cpuDispatcher = PxDefaultCpuDispatcherCreate(1);
+    sceneDesc.cpuDispatcher = &CpuDispatcher::shared();
     sceneDesc.filterShader = PxDefaultSimulationFilterShader;
     sceneDesc.simulationEventCallback = simulationEventCallback;
     sceneDesc.kineKineFilteringMode = PxPairFilteringMode::eKEEP;
@@ -133,9 +189,70 @@ PhysicsManager::PhysicsManager() {
     _nativeCharacterControllerManager = PxCreateControllerManager(*_nativePhysicsManager);
 }
 
+PhysicsManager::~PhysicsManager() {
+    // the owner fetches the step before its entities are released, a step left here is only waited for
+    waitForSimulation();
+}
+
 void PhysicsManager::update(float deltaTime) {
-    _nativePhysicsManager->simulate(deltaTime);
+    _accumulator += deltaTime;
+    while (_accumulator >= fixedTimeStep && _pendingTiming.steps < maxSubSteps) {
+        if (!_simulating) {
+            _simulate();
+        }
+        _fetch();
+        _accumulator -= fixedTimeStep;
+        _pendingTiming.steps++;
+    }
+    if (_accumulator >= fixedTimeStep) {
+        _accumulator = std::fmod(_accumulator, fixedTimeStep);
+    }
+    
+    if (asynchronous && !_simulating) {
+        _simulate();
+    }
+    
+    _timing = _pendingTiming;
+    _pendingTiming = PhysicsTiming();
+}
+
+void PhysicsManager::waitForSimulation() {
+    if (_simulating) {
+        Timer timer;
+        timer.start();
+        _nativePhysicsManager->checkResults(true);
+        _pendingTiming.wait += timer.stop<Timer::Milliseconds>();
+    }
+}
+
+void PhysicsManager::finishSimulation() {
+    if (_simulating) {
+        _fetch();
+    }
+}
+
+const PhysicsTiming &PhysicsManager::timing() const {
+    return _timing;
+}
+
+void PhysicsManager::_simulate() {
+    Timer timer;
+    timer.start();
+    _nativePhysicsManager->simulate(fixedTimeStep);
+    _simulating = true;
+    _pendingTiming.simulate += timer.stop<Timer::Milliseconds>();
+}
+
+void PhysicsManager::_fetch() {
+    waitForSimulation();
+    Timer timer;
+    timer.start();
     _nativePhysicsManager->fetchResults(true);
+    _simulating = false;
+    for (auto &collider: _colliders) {
+        collider->_onFetch();
+    }
+    _pendingTiming.fetch += timer.stop<Timer::Milliseconds>();
 }
 
 void PhysicsManager::callColliderOnUpdate() {
@@ -145,8 +262,9 @@ void PhysicsManager::callColliderOnUpdate() {
 }
 
 void PhysicsManager::callColliderOnLateUpdate() {
+    const float factor = interpolation ? _accumulator / fixedTimeStep : 1.f;
     for (auto &collider: _colliders) {
-        collider->_onLateUpdate();
+        collider->_onLateUpdate(factor);
     }
 }
 
@@ -157,11 +275,18 @@ void PhysicsManager::callCharacterControllerOnLateUpdate() {
 }
 
 void PhysicsManager::_addColliderShape(const ColliderShapePtr &colliderShape) {
-    _physicalObjectsMap[colliderShape->uniqueID()] = (colliderShape);
+    const uint32_t id = colliderShape->uniqueID();
+    if (id >= _physicalObjects.size()) {
+        _physicalObjects.resize(id + 1);
+    }
+    _physicalObjects[id] = colliderShape;
 }
 
 void PhysicsManager::_removeColliderShape(const ColliderShapePtr &colliderShape) {
-    _physicalObjectsMap.erase(colliderShape->uniqueID());
+    const uint32_t id = colliderShape->uniqueID();
+    if (id < _physicalObjects.size()) {
+        _physicalObjects[id] = nullptr;
+    }
 }
 
 void PhysicsManager::_addCollider(Collider *collider) {
@@ -191,122 +316,111 @@ void PhysicsManager::_removeCharacterController(CharacterController *characterCo
 
 //MARK: - Raycast
 bool PhysicsManager::raycast(const Ray3F &ray) {
-    return _raycast(ray, std::numeric_limits<float>::infinity(), nullptr);
+    return _raycast({ray}, nullptr);
 }
 
 bool PhysicsManager::raycast(const Ray3F &ray, HitResult &outHitResult) {
-    const auto layerMask = Layer::Everything;
-    
-    bool result = false;
-    _raycast(ray, std::numeric_limits<float>::infinity(),
-             [&](uint32_t idx, float distance, const Vector3F &normal, const Point3F &point) {
-        if (_physicalObjectsMap[idx]->collider()->entity()->layer & layerMask) {
-            result = true;
-            
-            outHitResult.entity = _physicalObjectsMap[idx]->collider()->entity();
-            outHitResult.distance = distance;
-            outHitResult.normal = normal;
-            outHitResult.point = point;
-        }
-    });
-    
-    if (!result) {
-        outHitResult.entity = nullptr;
-        outHitResult.distance = 0;
-        outHitResult.point = Point3F(0, 0, 0);
-        outHitResult.normal = Vector3F(0, 0, 0);
-    }
-    
-    return result;
+    return _raycast({ray}, &outHitResult);
 }
 
 bool PhysicsManager::raycast(const Ray3F &ray, float distance) {
-    return _raycast(ray, distance, nullptr);
+    return _raycast({ray, distance}, nullptr);
 }
 
 bool PhysicsManager::raycast(const Ray3F &ray, float distance, HitResult &outHitResult) {
-    const auto layerMask = Layer::Everything;
-    
-    bool result = false;
-    _raycast(ray, distance, [&](uint32_t idx, float distance, const Vector3F &normal, const Point3F &point) {
-        if (_physicalObjectsMap[idx]->collider()->entity()->layer & layerMask) {
-            result = true;
-            
-            outHitResult.entity = _physicalObjectsMap[idx]->collider()->entity();
-            outHitResult.distance = distance;
-            outHitResult.normal = normal;
-            outHitResult.point = point;
-        }
-    });
-    
-    if (!result) {
-        outHitResult.entity = nullptr;
-        outHitResult.distance = 0;
-        outHitResult.point = Point3F(0, 0, 0);
-        outHitResult.normal = Vector3F(0, 0, 0);
-    }
-    
-    return result;
+    return _raycast({ray, distance}, &outHitResult);
 }
 
 bool PhysicsManager::raycast(const Ray3F &ray, float distance, Layer layerMask) {
-    bool result = false;
-    _raycast(ray, distance, [&](uint32_t idx, float, const Vector3F &, const Point3F &) {
-        if (_physicalObjectsMap[idx]->collider()->entity()->layer & layerMask) {
-            result = true;
-        }
-    });
-    return result;
+    return _raycast({ray, distance, layerMask}, nullptr);
 }
 
 bool PhysicsManager::raycast(const Ray3F &ray, float distance, Layer layerMask, HitResult &outHitResult) {
-    bool result = false;
-    _raycast(ray, distance, [&](uint32_t idx, float distance, const Vector3F &normal, const Point3F &point) {
-        if (_physicalObjectsMap[idx]->collider()->entity()->layer & layerMask) {
-            result = true;
-            
-            outHitResult.entity = _physicalObjectsMap[idx]->collider()->entity();
-            outHitResult.distance = distance;
-            outHitResult.normal = normal;
-            outHitResult.point = point;
+    return _raycast({ray, distance, layerMask}, &outHitResult);
+}
+
+void PhysicsManager::raycast(const std::vector<RaycastQuery> &queries, std::vector<HitResult> &outHitResults) {
+    outHitResults.resize(queries.size());
+    _parallelQueries(queries.size(), [&](size_t i) {
+        _raycast(queries[i], &outHitResults[i]);
+    });
+}
+
+void PhysicsManager::sweep(const std::vector<SweepQuery> &queries, std::vector<HitResult> &outHitResults) {
+    outHitResults.resize(queries.size());
+    _parallelQueries(queries.size(), [&](size_t i) {
+        _sweep(queries[i], &outHitResults[i]);
+    });
+}
+
+void PhysicsManager::overlap(const std::vector<OverlapQuery> &queries, uint32_t maxHits,
+                             std::vector<Entity *> &outEntities) {
+    outEntities.assign(queries.size() * maxHits, nullptr);
+    if (maxHits == 0) {
+        return;
+    }
+    _parallelQueries(queries.size(), [&](size_t i) {
+        thread_local std::vector<PxOverlapHit> hits;
+        hits.resize(maxHits);
+        _overlap(queries[i], maxHits, hits.data(), outEntities.data() + i * maxHits);
+    });
+}
+
+template<class F>
+void PhysicsManager::_parallelQueries(size_t count, const F &function) {
+    // a job runs a chunk of queries, a single query is too short to be worth the hand off
+    constexpr size_t kChunkSize = 32;
+    ThreadPool::shared().parallelFor((count + kChunkSize - 1) / kChunkSize, [&](size_t chunk) {
+        const size_t end = std::min(count, (chunk + 1) * kChunkSize);
+        for (size_t i = chunk * kChunkSize; i < end; i++) {
+            function(i);
         }
     });
-    
-    if (!result) {
-        outHitResult.entity = nullptr;
-        outHitResult.distance = 0;
-        outHitResult.point = Point3F(0, 0, 0);
-        outHitResult.normal = Vector3F(0, 0, 0);
+}
+
+bool PhysicsManager::_raycast(const RaycastQuery &query, HitResult *outHitResult) const {
+    LayerFilterCallback filterCallback(_physicalObjects, query.layerMask);
+    PxRaycastHit hit = PxRaycastHit();
+    const auto &origin = query.ray.origin;
+    const auto &direction = query.ray.direction;
+    const bool result = PxSceneQueryExt::raycastSingle(*_nativePhysicsManager,
+                                                       PxVec3(origin.x, origin.y, origin.z),
+                                                       PxVec3(direction.x, direction.y, direction.z),
+                                                       query.distance, PxHitFlags(PxHitFlag::eDEFAULT),
+                                                       hit, kQueryFilterData, &filterCallback);
+    if (outHitResult) {
+        *outHitResult = result ? makeHitResult(hit, findEntity(_physicalObjects, *hit.shape, *hit.actor)) : HitResult();
     }
-    
     return result;
 }
 
-bool PhysicsManager::_raycast(const Ray3F &ray, float distance,
-                              std::function<void(uint32_t, float,
-                                                 const Vector3F &,
-                                                 const Point3F &)> outHitResult) {
-    PxRaycastHit hit = PxRaycastHit();
-    PxSceneQueryFilterData filterData = PxSceneQueryFilterData();
-    filterData.flags = PxQueryFlags(PxQueryFlag::eSTATIC | PxQueryFlag::eDYNAMIC);
-    
-    const auto &origin = ray.origin;
-    const auto &direction = ray.direction;
-    bool result = PxSceneQueryExt::raycastSingle(*_nativePhysicsManager,
-                                                 PxVec3(origin.x, origin.y, origin.z),
-                                                 PxVec3(direction.x, direction.y, direction.z),
-                                                 distance, PxHitFlags(PxHitFlag::eDEFAULT),
-                                                 hit, filterData);
-    
-    if (result && outHitResult != nullptr) {
-        outHitResult(hit.shape->getQueryFilterData().word0,
-                     hit.distance,
-                     Vector3F(hit.normal.x, hit.normal.y, hit.normal.z),
-                     Point3F(hit.position.x, hit.position.y, hit.position.z));
+bool PhysicsManager::_sweep(const SweepQuery &query, HitResult *outHitResult) const {
+    LayerFilterCallback filterCallback(_physicalObjects, query.layerMask);
+    PxSweepHit hit = PxSweepHit();
+    const bool result = PxSceneQueryExt::sweepSingle(*_nativePhysicsManager, query.geometry.any(),
+                                                     makeTransform(query.position, query.rotation),
+                                                     PxVec3(query.direction.x, query.direction.y, query.direction.z),
+                                                     query.distance, PxHitFlags(PxHitFlag::eDEFAULT),
+                                                     hit, kQueryFilterData, &filterCallback);
+    if (outHitResult) {
+        *outHitResult = result ? makeHitResult(hit, findEntity(_physicalObjects, *hit.shape, *hit.actor)) : HitResult();
     }
-    
     return result;
 }
 
+uint32_t PhysicsManager::_overlap(const OverlapQuery &query, uint32_t maxHits,
+                                  PxOverlapHit *hits, Entity **outEntities) const {
+    LayerFilterCallback filterCallback(_physicalObjects, query.layerMask);
+    const PxI32 count = PxSceneQueryExt::overlapMultiple(*_nativePhysicsManager, query.geometry.any(),
+                                                         makeTransform(query.position, query.rotation),
+                                                         hits, maxHits, kQueryFilterData, &filterCallback);
+    // -1 when there were more overlaps than the buffer holds
+    const uint32_t hitCount = count < 0 ? maxHits : static_cast<uint32_t>(count);
+    for (uint32_t i = 0; i < hitCount; i++) {
+        outEntities[i] = findEntity(_physicalObjects, *hits[i].shape, *hits[i].actor);
+    }
+    return hitCount;
+}
+
 }
 }
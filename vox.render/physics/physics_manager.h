@@ -8,16 +8,32 @@
 #define physics_manager_hpp
 
 #include "physics.h"
-#include <unordered_map>
 #include <vector>
 #include "ray3.h"
 #include "hit_result.h"
+#include "scene_query.h"
 #include "../layer.h"
 
 namespace vox {
 namespace physics {
+/**
+ * Simulation work of the last update, times in milliseconds.
+ * @remarks Waits issued by waitForSimulation() between two updates are counted in the later one.
+ */
+struct PhysicsTiming {
+    /** Issuing the simulate calls. */
+    float simulate{0};
+    /** Blocked until a step was finished by the workers. */
+    float wait{0};
+    /** Fetching the results, which runs the contact and trigger callbacks. */
+    float fetch{0};
+    /** Fixed steps which were fetched. */
+    uint32_t steps{0};
+};
+
 /**
  * A physics manager is a collection of bodies and constraints which can interact.
+ * @remarks The simulation runs on CpuDispatcher::shared(), whose worker count bounds the threads it takes.
  */
 class PhysicsManager {
 public:
@@ -26,6 +42,23 @@ public:
     
     PhysicsManager();
     
+    ~PhysicsManager();
+    
+    /** Length of a simulation step in seconds. */
+    float fixedTimeStep = 1.f / 60;
+    
+    /** Most steps fetched by one update, the rest of a longer frame is dropped instead of falling behind. */
+    uint32_t maxSubSteps = 4;
+    
+    /**
+     * Start the next step at the end of update, it runs on the workers while the frame is rendered.
+     * @remarks Forces and poses written after update apply to the step after the running one.
+     */
+    bool asynchronous = true;
+    
+    /** Blend the rendered poses of dynamic colliders between the last two steps. */
+    bool interpolation = true;
+    
 public:
     /**
      * Casts a ray through the Scene and returns the first hit.
@@ -78,12 +111,46 @@ public:
      */
     bool raycast(const Ray3F &ray, float distance, Layer layerMask, HitResult &outHitResult);
     
+    /**
+     * Casts rays in parallel on the shared thread pool.
+     * @param queries - The rays
+     * @param outHitResults - The first hit of every ray, the entity is null when nothing was hit
+     */
+    void raycast(const std::vector<RaycastQuery> &queries, std::vector<HitResult> &outHitResults);
+    
+    /**
+     * Sweeps shapes in parallel on the shared thread pool.
+     * @param queries - The shapes and their motion
+     * @param outHitResults - The first hit of every shape, the entity is null when nothing was hit
+     */
+    void sweep(const std::vector<SweepQuery> &queries, std::vector<HitResult> &outHitResults);
+    
+    /**
+     * Finds the colliders touched by shapes, in parallel on the shared thread pool.
+     * @param queries - The shapes
+     * @param maxHits - Most entities reported for one shape
+     * @param outEntities - maxHits entries for every shape, the ones after the touched entities are null
+     */
+    void overlap(const std::vector<OverlapQuery> &queries, uint32_t maxHits, std::vector<Entity *> &outEntities);
+    
 public:
     /**
-     * Call on every frame to update pose of objects.
+     * Call on every frame to advance the simulation by the fixed steps which are due.
      */
     void update(float deltaTime);
     
+    /**
+     * Block until the step running in the background is finished, its results are still fetched when it is due.
+     */
+    void waitForSimulation();
+    
+    /**
+     * Block until the step running in the background is finished and fetch it, so actors can be removed.
+     */
+    void finishSimulation();
+    
+    const PhysicsTiming &timing() const;
+    
     void callColliderOnUpdate();
     
     void callColliderOnLateUpdate();
@@ -135,19 +202,35 @@ private:
      */
     void _removeCharacterController(CharacterController *characterController);
     
-    bool _raycast(const Ray3F &ray, float distance,
-                  std::function<void(uint32_t, float,
-                                     const Vector3F &,
-                                     const Point3F &)> outHitResult);
+    void _simulate();
+    
+    void _fetch();
+    
+    bool _raycast(const RaycastQuery &query, HitResult *outHitResult) const;
+    
+    bool _sweep(const SweepQuery &query, HitResult *outHitResult) const;
+    
+    uint32_t _overlap(const OverlapQuery &query, uint32_t maxHits, PxOverlapHit *hits, Entity **outEntities) const;
+    
+    // runs function(i) for every query in chunks over the shared thread pool
+    template<class F>
+    static void _parallelQueries(size_t count, const F &function);
     
 private:
     PxControllerManager *_nativeCharacterControllerManager;
     PxScene *_nativePhysicsManager;
     
-    std::unordered_map<uint32_t, ColliderShapePtr> _physicalObjectsMap;
+    // shapes by uniqueID, ids of removed shapes and of other managers are null
+    std::vector<ColliderShapePtr> _physicalObjects;
     std::vector<Collider *> _colliders;
     std::vector<CharacterController *> _controllers;
     
+    float _accumulator{0};
+    bool _simulating{false};
+    PhysicsTiming _timing{};
+    // work since the last update, published to _timing when the update returns
+    PhysicsTiming _pendingTiming{};
+    
     std::function<void(PxShape *obj1, PxShape *obj2)> onContactEnter;
     std::function<void(PxShape *obj1, PxShape *obj2)> onContactExit;
     std::function<void(PxShape *obj1, PxShape *obj2)> onContactStay;
@@ -0,0 +1,56 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef scene_query_hpp
+#define scene_query_hpp
+
+#include "physics.h"
+#include "ray3.h"
+#include "point3.h"
+#include "quaternion.h"
+#include "../layer.h"
+#include <limits>
+
+namespace vox {
+namespace physics {
+/**
+ * Ray of a batched raycast.
+ */
+struct RaycastQuery {
+    Ray3F ray;
+    /** The max distance the ray should check. */
+    float distance = std::numeric_limits<float>::infinity();
+    /** Colliders of entities outside of the mask are not hit. */
+    Layer layerMask = Layer::Everything;
+};
+
+/**
+ * Shape moved along a direction by a batched sweep.
+ */
+struct SweepQuery {
+    PxGeometryHolder geometry;
+    Point3F position;
+    QuaternionF rotation;
+    /** Unit direction of the motion. */
+    Vector3F direction;
+    float distance = 0;
+    Layer layerMask = Layer::Everything;
+};
+
+/**
+ * Shape tested against the colliders it touches by a batched overlap.
+ */
+struct OverlapQuery {
+    PxGeometryHolder geometry;
+    Point3F position;
+    QuaternionF rotation;
+    Layer layerMask = Layer::Everything;
+};
+
+}
+}
+
+#endif /* scene_query_hpp */
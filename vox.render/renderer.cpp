@@ -24,6 +24,10 @@ BoundingBox3F Renderer::bounds() {
     return _bounds;
 }
 
+void Renderer::_setBoundsDirty() {
+    _transformChangeFlag->flag = true;
+}
+
 Renderer::Renderer(Entity *entity) :
 Component(entity),
 _transformChangeFlag(entity->transform->registerWorldChangeFlag()),
@@ -123,6 +123,11 @@ protected:
 protected:
     MaterialPtr _createInstanceMaterial(const MaterialPtr &material, size_t index);
     
+    /**
+     * Recompute the bounds on the next query, for bounds which change without the transform.
+     */
+    void _setBoundsDirty();
+    
     std::vector<std::shared_ptr<Material>> _materials;
     
 private:
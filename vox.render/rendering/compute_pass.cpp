@@ -85,8 +85,19 @@ void ComputePass::compute(MTL::ComputeCommandEncoder &commandEncoder) {
 void ComputePass::uploadUniforms(MTL::ComputeCommandEncoder &commandEncoder,
                                  const std::vector<ShaderUniform> &uniformBlock,
                                  const ShaderData &shaderData) {
+    const auto &block = shaderData.block();
+    std::optional<UniformRingBuffer::Allocation> allocation = std::nullopt;
     for (size_t i = 0; i < uniformBlock.size(); i++) {
         const auto &uniform = uniformBlock[i];
+        auto offset = block.offset(uniform.propertyId);
+        if (offset) {
+            if (!allocation) {
+                allocation = _scene->uniformRing().upload(block);
+            }
+            commandEncoder.setBuffer(allocation->buffer, allocation->offset + offset.value(), uniform.location);
+            continue;
+        }
+        
         auto data = shaderData.getData(uniform.propertyId);
         if (data) {
             process(uniform, data.value(), commandEncoder);
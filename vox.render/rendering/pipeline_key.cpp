@@ -0,0 +1,381 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "pipeline_key.h"
+#include "std_helpers.h"
+#include <algorithm>
+#include <tuple>
+
+namespace vox {
+namespace {
+constexpr uint32_t kManifestMagic = 0x4D505856; // "VXPM"
+constexpr uint32_t kManifestVersion = 1;
+// bounds for reading a damaged file
+constexpr size_t kMaxSourceLength = 1024;
+constexpr uint32_t kMaxArrayLength = 64;
+// Metal limits of the descriptor arrays the indices are looked up in
+constexpr uint32_t kMaxVertexAttributes = 31;
+constexpr uint32_t kMaxVertexBuffers = 31;
+constexpr uint32_t kMaxColorAttachments = 8;
+
+auto tie(const VertexAttributeKey &key) {
+    return std::tie(key.index, key.format, key.offset, key.bufferIndex);
+}
+
+auto tie(const VertexBufferLayoutKey &key) {
+    return std::tie(key.index, key.stride, key.stepFunction, key.stepRate);
+}
+
+auto tie(const ColorAttachmentKey &key) {
+    return std::tie(key.index, key.pixelFormat, key.writeMask, key.blendingEnabled,
+                    key.rgbBlendOperation, key.alphaBlendOperation,
+                    key.sourceRGBBlendFactor, key.sourceAlphaBlendFactor,
+                    key.destinationRGBBlendFactor, key.destinationAlphaBlendFactor);
+}
+
+auto tie(const RenderStateKey &key) {
+    return std::tie(key.depthPixelFormat, key.stencilPixelFormat, key.sampleCount,
+                    key.alphaToCoverageEnabled, key.inputPrimitiveTopology);
+}
+
+auto tie(const StencilKey &key) {
+    return std::tie(key.stencilCompareFunction, key.stencilFailureOperation, key.depthFailureOperation,
+                    key.depthStencilPassOperation, key.readMask, key.writeMask);
+}
+
+template<class Tuple>
+void hashTuple(size_t &seed, const Tuple &tuple) {
+    std::apply([&](const auto &... field) {
+        (hash_combine(seed, field), ...);
+    }, tuple);
+}
+
+//MARK: - Serialization
+static_assert(std::has_unique_object_representations_v<VertexAttributeKey> &&
+              std::has_unique_object_representations_v<VertexBufferLayoutKey> &&
+              std::has_unique_object_representations_v<ColorAttachmentKey>, "keys are saved as raw bytes");
+
+void writeKey(std::ostringstream &os, const FunctionKey &key) {
+    write(os, key.source);
+    write(os, key.macros.mask());
+    uint64_t mask = key.macros.mask();
+    while (mask) {
+        const auto macro = MacroName(__builtin_ctzll(mask));
+        mask &= mask - 1;
+        const auto value = key.macros.value(macro);
+        write(os, static_cast<int32_t>(value.first), static_cast<uint32_t>(value.second));
+    }
+}
+
+bool readKey(std::istringstream &is, FunctionKey &key) {
+    size_t length{0};
+    read(is, length);
+    if (!is || length > kMaxSourceLength) {
+        return false;
+    }
+    key.source.resize(length);
+    is.read(key.source.data(), length);
+    uint64_t mask{0};
+    read(is, mask);
+    if (MacroName::TOTAL_COUNT < 64 && (mask >> MacroName::TOTAL_COUNT) != 0) {
+        return false;
+    }
+    while (mask) {
+        const auto macro = MacroName(__builtin_ctzll(mask));
+        mask &= mask - 1;
+        int32_t value{0};
+        uint32_t type{0};
+        read(is, value, type);
+        key.macros.enable(macro, std::make_pair(value, static_cast<MTL::DataType>(type)));
+    }
+    return static_cast<bool>(is);
+}
+
+bool isValid(const VertexAttributeKey &key) {
+    return key.index < kMaxVertexAttributes && key.bufferIndex < kMaxVertexBuffers;
+}
+
+bool isValid(const VertexBufferLayoutKey &key) {
+    return key.index < kMaxVertexBuffers;
+}
+
+bool isValid(const ColorAttachmentKey &key) {
+    return key.index < kMaxColorAttachments;
+}
+
+template<class T>
+void writeArray(std::ostringstream &os, const std::vector<T> &values) {
+    write(os, static_cast<uint32_t>(values.size()));
+    os.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+template<class T>
+bool readArray(std::istringstream &is, std::vector<T> &values) {
+    uint32_t count{0};
+    read(is, count);
+    if (!is || count > kMaxArrayLength) {
+        return false;
+    }
+    values.resize(count);
+    is.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(T));
+    // the indices address descriptor arrays of fixed size when the pipeline is rebuilt
+    return is && std::all_of(values.begin(), values.end(), [](const T &value) {
+        return isValid(value);
+    });
+}
+
+void writeKey(std::ostringstream &os, const RenderPipelineKey &key) {
+    writeKey(os, key.vertexFunction);
+    write(os, static_cast<uint8_t>(key.fragmentFunction.has_value()));
+    if (key.fragmentFunction) {
+        writeKey(os, key.fragmentFunction.value());
+    }
+    writeArray(os, key.vertexLayout.attributes);
+    writeArray(os, key.vertexLayout.layouts);
+    writeArray(os, key.renderState.colorAttachments);
+    const auto &state = key.renderState;
+    write(os, state.depthPixelFormat, state.stencilPixelFormat, state.sampleCount,
+          state.alphaToCoverageEnabled, state.inputPrimitiveTopology);
+}
+
+bool readKey(std::istringstream &is, RenderPipelineKey &key) {
+    if (!readKey(is, key.vertexFunction)) {
+        return false;
+    }
+    uint8_t hasFragment{0};
+    read(is, hasFragment);
+    if (hasFragment) {
+        key.fragmentFunction = FunctionKey();
+        if (!readKey(is, key.fragmentFunction.value())) {
+            return false;
+        }
+    }
+    if (!readArray(is, key.vertexLayout.attributes) ||
+        !readArray(is, key.vertexLayout.layouts) ||
+        !readArray(is, key.renderState.colorAttachments)) {
+        return false;
+    }
+    auto &state = key.renderState;
+    read(is, state.depthPixelFormat, state.stencilPixelFormat, state.sampleCount,
+         state.alphaToCoverageEnabled, state.inputPrimitiveTopology);
+    return static_cast<bool>(is);
+}
+
+}
+
+//MARK: - Equality
+bool FunctionKey::operator==(const FunctionKey &other) const {
+    return source == other.source && macros == other.macros;
+}
+
+bool VertexAttributeKey::operator==(const VertexAttributeKey &other) const {
+    return tie(*this) == tie(other);
+}
+
+bool VertexBufferLayoutKey::operator==(const VertexBufferLayoutKey &other) const {
+    return tie(*this) == tie(other);
+}
+
+bool VertexLayoutKey::operator==(const VertexLayoutKey &other) const {
+    return attributes == other.attributes && layouts == other.layouts;
+}
+
+bool ColorAttachmentKey::operator==(const ColorAttachmentKey &other) const {
+    return tie(*this) == tie(other);
+}
+
+bool RenderStateKey::operator==(const RenderStateKey &other) const {
+    return colorAttachments == other.colorAttachments && tie(*this) == tie(other);
+}
+
+bool RenderPipelineKey::operator==(const RenderPipelineKey &other) const {
+    return vertexFunction == other.vertexFunction && fragmentFunction == other.fragmentFunction &&
+    vertexLayout == other.vertexLayout && renderState == other.renderState;
+}
+
+bool ComputePipelineKey::operator==(const ComputePipelineKey &other) const {
+    return computeFunction == other.computeFunction;
+}
+
+bool StencilKey::operator==(const StencilKey &other) const {
+    return tie(*this) == tie(other);
+}
+
+bool DepthStencilKey::operator==(const DepthStencilKey &other) const {
+    return depthCompareFunction == other.depthCompareFunction && depthWriteEnabled == other.depthWriteEnabled &&
+    frontFaceStencil == other.frontFaceStencil && backFaceStencil == other.backFaceStencil;
+}
+
+//MARK: - PipelineManifest
+bool PipelineManifest::record(const RenderPipelineKey &key) {
+    if (!_renderPipelineSet.insert(key).second) {
+        return false;
+    }
+    _renderPipelines.push_back(key);
+    return true;
+}
+
+bool PipelineManifest::record(const ComputePipelineKey &key) {
+    if (!_computePipelineSet.insert(key).second) {
+        return false;
+    }
+    _computePipelines.push_back(key);
+    return true;
+}
+
+void PipelineManifest::merge(const PipelineManifest &other) {
+    for (const auto &key : other._renderPipelines) {
+        record(key);
+    }
+    for (const auto &key : other._computePipelines) {
+        record(key);
+    }
+}
+
+bool PipelineManifest::contains(const RenderPipelineKey &key) const {
+    return _renderPipelineSet.find(key) != _renderPipelineSet.end();
+}
+
+bool PipelineManifest::contains(const ComputePipelineKey &key) const {
+    return _computePipelineSet.find(key) != _computePipelineSet.end();
+}
+
+const std::vector<RenderPipelineKey> &PipelineManifest::renderPipelines() const {
+    return _renderPipelines;
+}
+
+const std::vector<ComputePipelineKey> &PipelineManifest::computePipelines() const {
+    return _computePipelines;
+}
+
+size_t PipelineManifest::size() const {
+    return _renderPipelines.size() + _computePipelines.size();
+}
+
+void PipelineManifest::clear() {
+    _renderPipelines.clear();
+    _renderPipelineSet.clear();
+    _computePipelines.clear();
+    _computePipelineSet.clear();
+}
+
+std::vector<uint8_t> PipelineManifest::serialize() const {
+    std::ostringstream os;
+    write(os, kManifestMagic, kManifestVersion, static_cast<uint32_t>(MacroName::TOTAL_COUNT));
+    write(os, static_cast<uint32_t>(_renderPipelines.size()));
+    for (const auto &key : _renderPipelines) {
+        writeKey(os, key);
+    }
+    write(os, static_cast<uint32_t>(_computePipelines.size()));
+    for (const auto &key : _computePipelines) {
+        writeKey(os, key.computeFunction);
+    }
+
+    const auto str = os.str();
+    return std::vector<uint8_t>(str.begin(), str.end());
+}
+
+bool PipelineManifest::deserialize(const std::vector<uint8_t> &data) {
+    clear();
+    std::istringstream is(std::string(data.begin(), data.end()));
+    uint32_t magic{0};
+    uint32_t version{0};
+    uint32_t macroCount{0};
+    read(is, magic, version, macroCount);
+    // macro names are saved by index, a manifest written with other macros can't be replayed
+    if (!is || magic != kManifestMagic || version != kManifestVersion || macroCount != MacroName::TOTAL_COUNT) {
+        return false;
+    }
+
+    PipelineManifest manifest;
+    uint32_t count{0};
+    read(is, count);
+    for (uint32_t i = 0; i < count && is; i++) {
+        RenderPipelineKey key;
+        if (!readKey(is, key)) {
+            return false;
+        }
+        manifest.record(key);
+    }
+    count = 0;
+    read(is, count);
+    for (uint32_t i = 0; i < count && is; i++) {
+        ComputePipelineKey key;
+        if (!readKey(is, key.computeFunction)) {
+            return false;
+        }
+        manifest.record(key);
+    }
+    if (!is) {
+        return false;
+    }
+    *this = std::move(manifest);
+    return true;
+}
+
+bool PipelineManifest::save(const std::string &filename) const {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    const auto data = serialize();
+    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+    return static_cast<bool>(file);
+}
+
+bool PipelineManifest::load(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        clear();
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return deserialize(data);
+}
+
+}
+
+//MARK: - Hash
+namespace std {
+size_t hash<vox::FunctionKey>::operator()(const vox::FunctionKey &key) const {
+    size_t seed{0};
+    vox::hash_combine(seed, key.source);
+    vox::hash_combine(seed, key.macros.hash());
+    return seed;
+}
+
+size_t hash<vox::RenderPipelineKey>::operator()(const vox::RenderPipelineKey &key) const {
+    size_t seed{0};
+    vox::hash_combine(seed, key.vertexFunction);
+    if (key.fragmentFunction) {
+        vox::hash_combine(seed, key.fragmentFunction.value());
+    }
+    for (const auto &attribute : key.vertexLayout.attributes) {
+        vox::hashTuple(seed, vox::tie(attribute));
+    }
+    for (const auto &layout : key.vertexLayout.layouts) {
+        vox::hashTuple(seed, vox::tie(layout));
+    }
+    for (const auto &attachment : key.renderState.colorAttachments) {
+        vox::hashTuple(seed, vox::tie(attachment));
+    }
+    vox::hashTuple(seed, vox::tie(key.renderState));
+    return seed;
+}
+
+size_t hash<vox::ComputePipelineKey>::operator()(const vox::ComputePipelineKey &key) const {
+    return hash<vox::FunctionKey>{}(key.computeFunction);
+}
+
+size_t hash<vox::DepthStencilKey>::operator()(const vox::DepthStencilKey &key) const {
+    size_t seed{0};
+    vox::hash_combine(seed, key.depthCompareFunction);
+    vox::hash_combine(seed, key.depthWriteEnabled);
+    vox::hashTuple(seed, vox::tie(key.frontFaceStencil));
+    vox::hashTuple(seed, vox::tie(key.backFaceStencil));
+    return seed;
+}
+}
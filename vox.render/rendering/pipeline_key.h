@@ -0,0 +1,193 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef pipeline_key_hpp
+#define pipeline_key_hpp
+
+#include "shader/shader_macro_collection.h"
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace vox {
+/**
+ * Everything which is needed to specialize a shader function.
+ */
+struct FunctionKey {
+    std::string source{};
+    ShaderMacroCollection macros{};
+
+    bool operator==(const FunctionKey &other) const;
+};
+
+/**
+ * Backend enums are stored as plain integers, so keys can be compared, hashed and saved without a device.
+ */
+struct VertexAttributeKey {
+    uint32_t index{0};
+    uint32_t format{0};
+    uint32_t offset{0};
+    uint32_t bufferIndex{0};
+
+    bool operator==(const VertexAttributeKey &other) const;
+};
+
+struct VertexBufferLayoutKey {
+    uint32_t index{0};
+    uint32_t stride{0};
+    uint32_t stepFunction{0};
+    uint32_t stepRate{1};
+
+    bool operator==(const VertexBufferLayoutKey &other) const;
+};
+
+struct VertexLayoutKey {
+    std::vector<VertexAttributeKey> attributes{};
+    std::vector<VertexBufferLayoutKey> layouts{};
+
+    bool operator==(const VertexLayoutKey &other) const;
+};
+
+struct ColorAttachmentKey {
+    uint32_t index{0};
+    uint32_t pixelFormat{0};
+    uint32_t writeMask{0};
+    uint32_t blendingEnabled{0};
+    uint32_t rgbBlendOperation{0};
+    uint32_t alphaBlendOperation{0};
+    uint32_t sourceRGBBlendFactor{0};
+    uint32_t sourceAlphaBlendFactor{0};
+    uint32_t destinationRGBBlendFactor{0};
+    uint32_t destinationAlphaBlendFactor{0};
+
+    bool operator==(const ColorAttachmentKey &other) const;
+};
+
+struct RenderStateKey {
+    std::vector<ColorAttachmentKey> colorAttachments{};
+    uint32_t depthPixelFormat{0};
+    uint32_t stencilPixelFormat{0};
+    uint32_t sampleCount{1};
+    uint32_t alphaToCoverageEnabled{0};
+    uint32_t inputPrimitiveTopology{0};
+
+    bool operator==(const RenderStateKey &other) const;
+};
+
+struct RenderPipelineKey {
+    FunctionKey vertexFunction{};
+    std::optional<FunctionKey> fragmentFunction{std::nullopt};
+    VertexLayoutKey vertexLayout{};
+    RenderStateKey renderState{};
+
+    bool operator==(const RenderPipelineKey &other) const;
+};
+
+struct ComputePipelineKey {
+    FunctionKey computeFunction{};
+
+    bool operator==(const ComputePipelineKey &other) const;
+};
+
+struct StencilKey {
+    uint32_t stencilCompareFunction{0};
+    uint32_t stencilFailureOperation{0};
+    uint32_t depthFailureOperation{0};
+    uint32_t depthStencilPassOperation{0};
+    uint32_t readMask{0};
+    uint32_t writeMask{0};
+
+    bool operator==(const StencilKey &other) const;
+};
+
+struct DepthStencilKey {
+    uint32_t depthCompareFunction{0};
+    uint32_t depthWriteEnabled{0};
+    StencilKey frontFaceStencil{};
+    StencilKey backFaceStencil{};
+
+    bool operator==(const DepthStencilKey &other) const;
+};
+
+}
+
+namespace std {
+template<>
+struct hash<vox::FunctionKey> {
+    size_t operator()(const vox::FunctionKey &key) const;
+};
+
+template<>
+struct hash<vox::RenderPipelineKey> {
+    size_t operator()(const vox::RenderPipelineKey &key) const;
+};
+
+template<>
+struct hash<vox::ComputePipelineKey> {
+    size_t operator()(const vox::ComputePipelineKey &key) const;
+};
+
+template<>
+struct hash<vox::DepthStencilKey> {
+    size_t operator()(const vox::DepthStencilKey &key) const;
+};
+}
+
+namespace vox {
+/**
+ * List of pipeline permutations which were used, in the order of first use.
+ * @remarks Saved on exit and replayed at the next launch to compile the pipelines before they are drawn.
+ */
+class PipelineManifest {
+public:
+    /**
+     * Add permutation, return false if it is already recorded.
+     */
+    bool record(const RenderPipelineKey &key);
+
+    bool record(const ComputePipelineKey &key);
+
+    /**
+     * Add every permutation of other manifest.
+     */
+    void merge(const PipelineManifest &other);
+
+    bool contains(const RenderPipelineKey &key) const;
+
+    bool contains(const ComputePipelineKey &key) const;
+
+    const std::vector<RenderPipelineKey> &renderPipelines() const;
+
+    const std::vector<ComputePipelineKey> &computePipelines() const;
+
+    size_t size() const;
+
+    void clear();
+
+public:
+    std::vector<uint8_t> serialize() const;
+
+    /**
+     * Replace content with serialized data.
+     * @return false if data is not a manifest of this version, the manifest is left empty.
+     */
+    bool deserialize(const std::vector<uint8_t> &data);
+
+    bool save(const std::string &filename) const;
+
+    bool load(const std::string &filename);
+
+private:
+    std::vector<RenderPipelineKey> _renderPipelines{};
+    std::unordered_set<RenderPipelineKey> _renderPipelineSet{};
+    std::vector<ComputePipelineKey> _computePipelines{};
+    std::unordered_set<ComputePipelineKey> _computePipelineSet{};
+};
+
+}
+
+#endif /* pipeline_key_hpp */
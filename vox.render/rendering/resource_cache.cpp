@@ -6,53 +6,73 @@
 
 #include "resource_cache.h"
 #include <Metal/Metal.hpp>
+#include <glog/logging.h>
 #include "std_helpers.h"
 #include "metal_helpers.h"
 
 //MARK: - ResourceCache
 namespace vox {
+namespace {
+constexpr uint32_t kMaxVertexAttributes = 31;
+constexpr uint32_t kMaxVertexBufferLayouts = 31;
+constexpr uint32_t kMaxColorAttachments = 8;
+
+StencilKey makeStencilKey(const MTL::StencilDescriptor *descriptor) {
+    StencilKey key;
+    if (descriptor) {
+        key.stencilCompareFunction = static_cast<uint32_t>(descriptor->stencilCompareFunction());
+        key.stencilFailureOperation = static_cast<uint32_t>(descriptor->stencilFailureOperation());
+        key.depthFailureOperation = static_cast<uint32_t>(descriptor->depthFailureOperation());
+        key.depthStencilPassOperation = static_cast<uint32_t>(descriptor->depthStencilPassOperation());
+        key.readMask = descriptor->readMask();
+        key.writeMask = descriptor->writeMask();
+    }
+    return key;
+}
+
+DepthStencilKey makeDepthStencilKey(const MTL::DepthStencilDescriptor &descriptor) {
+    DepthStencilKey key;
+    key.depthCompareFunction = static_cast<uint32_t>(descriptor.depthCompareFunction());
+    key.depthWriteEnabled = descriptor.isDepthWriteEnabled();
+    key.frontFaceStencil = makeStencilKey(descriptor.frontFaceStencil());
+    key.backFaceStencil = makeStencilKey(descriptor.backFaceStencil());
+    return key;
+}
+
+}
+
 ResourceCache::ResourceCache(MTL::Device *device) :
 _device{device} {
 }
 
+ResourceCache::~ResourceCache() {
+    _cancelPrewarm = true;
+    waitPrewarm();
+}
+
 RenderPipelineState *
 ResourceCache::requestPipelineState(const MTL::RenderPipelineDescriptor &descriptor) {
-    size_t hash = descriptor.hash();
-    
-    auto iter = _state.renderPipelineStates.find(hash);
-    if (iter == _state.renderPipelineStates.end()) {
-        auto pipelineState = std::make_unique<RenderPipelineState>(_device, descriptor);
-        _state.renderPipelineStates[hash] = std::move(pipelineState);
-        return _state.renderPipelineStates[hash].get();
-    } else {
-        return iter->second.get();
-    }
+    return _requestPipelineState(_makeKey(descriptor), descriptor);
 }
 
 ComputePipelineState *
 ResourceCache::requestPipelineState(const MTL::ComputePipelineDescriptor &descriptor) {
-    size_t hash = descriptor.hash();
-    
-    auto iter = _state.computePipelineStates.find(hash);
-    if (iter == _state.computePipelineStates.end()) {
-        auto pipelineState = std::make_unique<ComputePipelineState>(_device, descriptor);
-        _state.computePipelineStates[hash] = std::move(pipelineState);
-        return _state.computePipelineStates[hash].get();
-    } else {
-        return iter->second.get();
-    }
+    ComputePipelineKey key;
+    key.computeFunction = _functionKey(descriptor.computeFunction());
+    return _requestPipelineState(key, descriptor);
 }
 
 MTL::DepthStencilState*
 ResourceCache::requestDepthStencilState(const MTL::DepthStencilDescriptor &descriptor) {
-    size_t hash = descriptor.hash();
-    
-    auto iter = _state.depthStencilStates.find(hash);
+    const auto key = makeDepthStencilKey(descriptor);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iter = _state.depthStencilStates.find(key);
     if (iter == _state.depthStencilStates.end()) {
         auto depthStencilState = CLONE_METAL_CUSTOM_DELETER(MTL::DepthStencilState,
                                                             _device->newDepthStencilState(&descriptor));
-        _state.depthStencilStates[hash] = std::move(depthStencilState);
-        return _state.depthStencilStates[hash].get();
+        _state.depthStencilStates[key] = std::move(depthStencilState);
+        return _state.depthStencilStates[key].get();
     } else {
         return iter->second.get();
     }
@@ -61,44 +81,285 @@ ResourceCache::requestDepthStencilState(const MTL::DepthStencilDescriptor &descr
 MTL::Function *ResourceCache::requestFunction(MTL::Library &library,
                                               const std::string &source,
                                               const ShaderMacroCollection &macroInfo) {
-    std::size_t hash{0U};
-    hash_combine(hash, std::hash<std::string>{}(source));
-    hash_combine(hash, macroInfo.hash());
-    
-    auto iter = _state.functions.find(hash);
-    if (iter == _state.functions.end()) {
-        NS::Error *error;
-        auto functionConstants = _makeFunctionConstants(macroInfo);
-        auto shader =
-        CLONE_METAL_CUSTOM_DELETER(MTL::Function,
-                                   library.newFunction(NS::String::string(source.c_str(),
-                                                                          NS::StringEncoding::UTF8StringEncoding),
-                                                       functionConstants.get(), &error));
-        _state.functions[hash] = std::move(shader);
-        return _state.functions[hash].get();
-    } else {
-        return iter->second.get();
+    FunctionKey key;
+    key.source = source;
+    key.macros = macroInfo;
+    return _requestFunction(library, key);
+}
+
+MTL::Function *ResourceCache::_requestFunction(MTL::Library &library, const FunctionKey &key) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto iter = _state.functions.find(key);
+        if (iter != _state.functions.end()) {
+            return iter->second.get();
+        }
     }
+
+    NS::Error *error{nullptr};
+    auto functionConstants = _makeFunctionConstants(key.macros);
+    auto function = library.newFunction(NS::String::string(key.source.c_str(), NS::StringEncoding::UTF8StringEncoding),
+                                        functionConstants.get(), &error);
+    if (function == nullptr) {
+        LOG(ERROR) << "Error: failed to create Metal function " << key.source << ": "
+        << (error ? error->localizedDescription()->utf8String() : "unknown error");
+        // the failure is cached too, the library is not searched again on every request
+        std::lock_guard<std::mutex> lock(_mutex);
+        _state.functions.emplace(key, nullptr);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto result = _state.functions.emplace(key, CLONE_METAL_CUSTOM_DELETER(MTL::Function, function));
+    if (result.first->second != nullptr) {
+        _state.functionKeys.emplace(result.first->second.get(), key);
+    }
+    return result.first->second.get();
+}
+
+RenderPipelineState *ResourceCache::_requestPipelineState(const RenderPipelineKey &key,
+                                                          const MTL::RenderPipelineDescriptor &descriptor) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto iter = _state.renderPipelineStates.find(key);
+        if (iter != _state.renderPipelineStates.end()) {
+            return iter->second.get();
+        }
+    }
+
+    // compile without holding the lock, prewarm may be building another one
+    auto pipelineState = std::make_unique<RenderPipelineState>(_device, descriptor);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _manifest.record(key);
+    auto result = _state.renderPipelineStates.emplace(key, std::move(pipelineState));
+    return result.first->second.get();
+}
+
+ComputePipelineState *ResourceCache::_requestPipelineState(const ComputePipelineKey &key,
+                                                           const MTL::ComputePipelineDescriptor &descriptor) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto iter = _state.computePipelineStates.find(key);
+        if (iter != _state.computePipelineStates.end()) {
+            return iter->second.get();
+        }
+    }
+
+    auto pipelineState = std::make_unique<ComputePipelineState>(_device, descriptor);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _manifest.record(key);
+    auto result = _state.computePipelineStates.emplace(key, std::move(pipelineState));
+    return result.first->second.get();
+}
+
+//MARK: - Key
+FunctionKey ResourceCache::_functionKey(const MTL::Function *function) const {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto iter = _state.functionKeys.find(function);
+        if (iter != _state.functionKeys.end()) {
+            return iter->second;
+        }
+    }
+
+    // created outside of the cache, so it has no macros
+    FunctionKey key;
+    key.source = function->name()->utf8String();
+    return key;
+}
+
+RenderPipelineKey ResourceCache::_makeKey(const MTL::RenderPipelineDescriptor &descriptor) const {
+    RenderPipelineKey key;
+    key.vertexFunction = _functionKey(descriptor.vertexFunction());
+    if (descriptor.fragmentFunction()) {
+        key.fragmentFunction = _functionKey(descriptor.fragmentFunction());
+    }
+
+    auto vertexDescriptor = descriptor.vertexDescriptor();
+    if (vertexDescriptor) {
+        for (uint32_t i = 0; i < kMaxVertexAttributes; i++) {
+            auto attribute = vertexDescriptor->attributes()->object(i);
+            if (attribute->format() != MTL::VertexFormatInvalid) {
+                VertexAttributeKey attributeKey;
+                attributeKey.index = i;
+                attributeKey.format = static_cast<uint32_t>(attribute->format());
+                attributeKey.offset = static_cast<uint32_t>(attribute->offset());
+                attributeKey.bufferIndex = static_cast<uint32_t>(attribute->bufferIndex());
+                key.vertexLayout.attributes.push_back(attributeKey);
+            }
+        }
+        for (uint32_t i = 0; i < kMaxVertexBufferLayouts; i++) {
+            auto layout = vertexDescriptor->layouts()->object(i);
+            if (layout->stride() != 0) {
+                VertexBufferLayoutKey layoutKey;
+                layoutKey.index = i;
+                layoutKey.stride = static_cast<uint32_t>(layout->stride());
+                layoutKey.stepFunction = static_cast<uint32_t>(layout->stepFunction());
+                layoutKey.stepRate = static_cast<uint32_t>(layout->stepRate());
+                key.vertexLayout.layouts.push_back(layoutKey);
+            }
+        }
+    }
+
+    auto &state = key.renderState;
+    for (uint32_t i = 0; i < kMaxColorAttachments; i++) {
+        auto attachment = descriptor.colorAttachments()->object(i);
+        if (attachment->pixelFormat() != MTL::PixelFormatInvalid) {
+            ColorAttachmentKey attachmentKey;
+            attachmentKey.index = i;
+            attachmentKey.pixelFormat = static_cast<uint32_t>(attachment->pixelFormat());
+            attachmentKey.writeMask = static_cast<uint32_t>(attachment->writeMask());
+            attachmentKey.blendingEnabled = attachment->isBlendingEnabled();
+            attachmentKey.rgbBlendOperation = static_cast<uint32_t>(attachment->rgbBlendOperation());
+            attachmentKey.alphaBlendOperation = static_cast<uint32_t>(attachment->alphaBlendOperation());
+            attachmentKey.sourceRGBBlendFactor = static_cast<uint32_t>(attachment->sourceRGBBlendFactor());
+            attachmentKey.sourceAlphaBlendFactor = static_cast<uint32_t>(attachment->sourceAlphaBlendFactor());
+            attachmentKey.destinationRGBBlendFactor = static_cast<uint32_t>(attachment->destinationRGBBlendFactor());
+            attachmentKey.destinationAlphaBlendFactor = static_cast<uint32_t>(attachment->destinationAlphaBlendFactor());
+            state.colorAttachments.push_back(attachmentKey);
+        }
+    }
+    state.depthPixelFormat = static_cast<uint32_t>(descriptor.depthAttachmentPixelFormat());
+    state.stencilPixelFormat = static_cast<uint32_t>(descriptor.stencilAttachmentPixelFormat());
+    state.sampleCount = static_cast<uint32_t>(descriptor.sampleCount());
+    state.alphaToCoverageEnabled = descriptor.isAlphaToCoverageEnabled();
+    state.inputPrimitiveTopology = static_cast<uint32_t>(descriptor.inputPrimitiveTopology());
+    return key;
+}
+
+std::shared_ptr<MTL::RenderPipelineDescriptor>
+ResourceCache::_makeDescriptor(MTL::Library &library, const RenderPipelineKey &key) {
+    auto vertexFunction = _requestFunction(library, key.vertexFunction);
+    if (vertexFunction == nullptr) {
+        return nullptr;
+    }
+    MTL::Function *fragmentFunction{nullptr};
+    if (key.fragmentFunction) {
+        fragmentFunction = _requestFunction(library, key.fragmentFunction.value());
+        if (fragmentFunction == nullptr) {
+            return nullptr;
+        }
+    }
+
+    auto descriptor = CLONE_METAL_CUSTOM_DELETER(MTL::RenderPipelineDescriptor,
+                                                 MTL::RenderPipelineDescriptor::alloc()->init());
+    descriptor->setVertexFunction(vertexFunction);
+    descriptor->setFragmentFunction(fragmentFunction);
+
+    if (!key.vertexLayout.attributes.empty()) {
+        auto vertexDescriptor = CLONE_METAL_CUSTOM_DELETER(MTL::VertexDescriptor, MTL::VertexDescriptor::alloc()->init());
+        for (const auto &attributeKey : key.vertexLayout.attributes) {
+            auto attribute = vertexDescriptor->attributes()->object(attributeKey.index);
+            attribute->setFormat(static_cast<MTL::VertexFormat>(attributeKey.format));
+            attribute->setOffset(attributeKey.offset);
+            attribute->setBufferIndex(attributeKey.bufferIndex);
+        }
+        for (const auto &layoutKey : key.vertexLayout.layouts) {
+            auto layout = vertexDescriptor->layouts()->object(layoutKey.index);
+            layout->setStride(layoutKey.stride);
+            layout->setStepFunction(static_cast<MTL::VertexStepFunction>(layoutKey.stepFunction));
+            layout->setStepRate(layoutKey.stepRate);
+        }
+        descriptor->setVertexDescriptor(vertexDescriptor.get());
+    }
+
+    const auto &state = key.renderState;
+    for (const auto &attachmentKey : state.colorAttachments) {
+        auto attachment = descriptor->colorAttachments()->object(attachmentKey.index);
+        attachment->setPixelFormat(static_cast<MTL::PixelFormat>(attachmentKey.pixelFormat));
+        attachment->setWriteMask(static_cast<MTL::ColorWriteMask>(attachmentKey.writeMask));
+        attachment->setBlendingEnabled(attachmentKey.blendingEnabled != 0);
+        attachment->setRgbBlendOperation(static_cast<MTL::BlendOperation>(attachmentKey.rgbBlendOperation));
+        attachment->setAlphaBlendOperation(static_cast<MTL::BlendOperation>(attachmentKey.alphaBlendOperation));
+        attachment->setSourceRGBBlendFactor(static_cast<MTL::BlendFactor>(attachmentKey.sourceRGBBlendFactor));
+        attachment->setSourceAlphaBlendFactor(static_cast<MTL::BlendFactor>(attachmentKey.sourceAlphaBlendFactor));
+        attachment->setDestinationRGBBlendFactor(static_cast<MTL::BlendFactor>(attachmentKey.destinationRGBBlendFactor));
+        attachment->setDestinationAlphaBlendFactor(static_cast<MTL::BlendFactor>(attachmentKey.destinationAlphaBlendFactor));
+    }
+    descriptor->setDepthAttachmentPixelFormat(static_cast<MTL::PixelFormat>(state.depthPixelFormat));
+    descriptor->setStencilAttachmentPixelFormat(static_cast<MTL::PixelFormat>(state.stencilPixelFormat));
+    descriptor->setSampleCount(state.sampleCount);
+    descriptor->setAlphaToCoverageEnabled(state.alphaToCoverageEnabled != 0);
+    descriptor->setInputPrimitiveTopology(static_cast<MTL::PrimitiveTopologyClass>(state.inputPrimitiveTopology));
+    return descriptor;
+}
+
+//MARK: - Prewarm
+PipelineManifest ResourceCache::manifest() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _manifest;
+}
+
+void ResourceCache::prewarm(MTL::Library &library, const PipelineManifest &manifest) {
+    waitPrewarm();
+    _cancelPrewarm = false;
+    _prewarmTask = std::async(std::launch::async, [this, &library, manifest]() {
+        auto pool = NS::AutoreleasePool::alloc()->init();
+        auto count = _prewarm(library, manifest);
+        pool->release();
+        return count;
+    });
+}
+
+bool ResourceCache::isPrewarming() const {
+    return _prewarmTask.valid() &&
+    _prewarmTask.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+size_t ResourceCache::waitPrewarm() {
+    if (_prewarmTask.valid()) {
+        return _prewarmTask.get();
+    }
+    return 0;
+}
+
+size_t ResourceCache::_prewarm(MTL::Library &library, const PipelineManifest &manifest) {
+    size_t count = 0;
+    for (const auto &key : manifest.renderPipelines()) {
+        if (_cancelPrewarm) {
+            return count;
+        }
+        auto descriptor = _makeDescriptor(library, key);
+        if (descriptor) {
+            _requestPipelineState(key, *descriptor);
+            count++;
+        }
+    }
+
+    for (const auto &key : manifest.computePipelines()) {
+        if (_cancelPrewarm) {
+            return count;
+        }
+        auto function = _requestFunction(library, key.computeFunction);
+        if (function) {
+            auto descriptor = CLONE_METAL_CUSTOM_DELETER(MTL::ComputePipelineDescriptor,
+                                                         MTL::ComputePipelineDescriptor::alloc()->init());
+            descriptor->setComputeFunction(function);
+            _requestPipelineState(key, *descriptor);
+            count++;
+        }
+    }
+    return count;
 }
 
 std::shared_ptr<MTL::FunctionConstantValues>
 ResourceCache::_makeFunctionConstants(const ShaderMacroCollection &macroInfo) {
     auto functionConstants = ShaderMacroCollection::createDefaultFunction();
-    std::for_each(macroInfo._value.begin(), macroInfo._value.end(),
-                  [&](const std::pair<MacroName, std::pair<int, MTL::DataType>> &info) {
-        if (info.second.second == MTL::DataTypeBool) {
-            bool property;
-            if (info.second.first == 1) {
-                property = true;
-            } else {
-                property = false;
-            }
-            functionConstants->setConstantValue(&property, MTL::DataTypeBool, info.first);
+    uint64_t mask = macroInfo.mask();
+    while (mask) {
+        const auto macro = MacroName(__builtin_ctzll(mask));
+        mask &= mask - 1;
+        const auto info = macroInfo.value(macro);
+        if (info.second == MTL::DataTypeBool) {
+            bool property = info.first == 1;
+            functionConstants->setConstantValue(&property, MTL::DataTypeBool, macro);
         } else {
-            auto &property = info.second.first;
-            functionConstants->setConstantValue(&property, info.second.second, info.first);
+            auto &property = info.first;
+            functionConstants->setConstantValue(&property, info.second, macro);
         }
-    });
+    }
     return functionConstants;
 }
 
@@ -10,6 +10,10 @@
 #include "shader/shader_macro_collection.h"
 #include "render_pipeline_state.h"
 #include "compute_pipeline_state.h"
+#include "pipeline_key.h"
+#include <atomic>
+#include <future>
+#include <mutex>
 #include <unordered_map>
 
 namespace vox {
@@ -20,13 +24,17 @@ class ShaderProgram;
  *
  */
 struct ResourceCacheState {
-    std::unordered_map<std::size_t, std::shared_ptr<MTL::DepthStencilState>> depthStencilStates;
+    std::unordered_map<DepthStencilKey, std::shared_ptr<MTL::DepthStencilState>> depthStencilStates;
     
-    std::unordered_map<std::size_t, std::shared_ptr<MTL::Function>> functions;
+    // null for functions which could not be created
+    std::unordered_map<FunctionKey, std::shared_ptr<MTL::Function>> functions;
     
-    std::unordered_map<std::size_t, std::unique_ptr<RenderPipelineState>> renderPipelineStates;
+    // reverse lookup used to build pipeline keys from descriptors
+    std::unordered_map<const MTL::Function *, FunctionKey> functionKeys;
     
-    std::unordered_map<std::size_t, std::unique_ptr<ComputePipelineState>> computePipelineStates;
+    std::unordered_map<RenderPipelineKey, std::unique_ptr<RenderPipelineState>> renderPipelineStates;
+    
+    std::unordered_map<ComputePipelineKey, std::unique_ptr<ComputePipelineState>> computePipelineStates;
 };
 
 /**
@@ -36,15 +44,17 @@ struct ResourceCacheState {
  * and objects. For every object requested, there is a templated version on request_resource.
  * Some objects may need building if they are not found in the cache.
  *
- * The resource cache is also linked with ResourceRecord and ResourceReplay. Replay can warm-up
- * the cache on app startup by creating all necessary objects.
- * The cache holds pointers to objects and has a mapping from such pointers to hashes.
+ * Objects are keyed by the full description (shader source, macros, vertex layout and render state), so
+ * hash collisions can't return a wrong object. Every pipeline which is created is recorded in a
+ * PipelineManifest, which can be saved and replayed by prewarm on the next launch.
  * It can only be destroyed in bulk, single elements cannot be removed.
  */
 class ResourceCache {
 public:
     ResourceCache(MTL::Device *device);
     
+    ~ResourceCache();
+    
     ResourceCache(const ResourceCache &) = delete;
     
     ResourceCache(ResourceCache &&) = delete;
@@ -67,7 +77,46 @@ public:
     requestFunction(MTL::Library &library, const std::string &source,
                     const ShaderMacroCollection &macroInfo);
     
+public:
+    /**
+     * Pipelines created by this cache so far.
+     */
+    PipelineManifest manifest() const;
+    
+    /**
+     * Create every pipeline of manifest on a background thread.
+     * @remarks Requests made meanwhile are served as usual, pipelines which are not ready yet are compiled
+     * on the calling thread.
+     * @param library - Library which contains the shader sources of manifest
+     * @param manifest - Pipelines to create
+     */
+    void prewarm(MTL::Library &library, const PipelineManifest &manifest);
+    
+    bool isPrewarming() const;
+    
+    /**
+     * Block until prewarm is finished.
+     * @return Number of pipelines created by the last prewarm.
+     */
+    size_t waitPrewarm();
+    
 private:
+    MTL::Function *_requestFunction(MTL::Library &library, const FunctionKey &key);
+    
+    RenderPipelineState *_requestPipelineState(const RenderPipelineKey &key,
+                                               const MTL::RenderPipelineDescriptor &descriptor);
+    
+    ComputePipelineState *_requestPipelineState(const ComputePipelineKey &key,
+                                                const MTL::ComputePipelineDescriptor &descriptor);
+    
+    FunctionKey _functionKey(const MTL::Function *function) const;
+    
+    RenderPipelineKey _makeKey(const MTL::RenderPipelineDescriptor &descriptor) const;
+    
+    std::shared_ptr<MTL::RenderPipelineDescriptor> _makeDescriptor(MTL::Library &library, const RenderPipelineKey &key);
+    
+    size_t _prewarm(MTL::Library &library, const PipelineManifest &manifest);
+    
     std::shared_ptr<MTL::FunctionConstantValues>
     _makeFunctionConstants(const ShaderMacroCollection &macroInfo);
     
@@ -75,6 +124,15 @@ private:
     MTL::Device *_device;
     
     ResourceCacheState _state;
+    
+    PipelineManifest _manifest;
+    
+    // guards _state and _manifest, objects are built outside of the lock
+    mutable std::mutex _mutex;
+    
+    std::future<size_t> _prewarmTask;
+    
+    std::atomic<bool> _cancelPrewarm{false};
 };
 
 }
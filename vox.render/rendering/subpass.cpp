@@ -35,9 +35,25 @@ void Subpass::setRenderPass(RenderPass *pass) {
 
 void Subpass::uploadUniforms(MTL::RenderCommandEncoder &commandEncoder,
                              const std::vector<ShaderUniform> &uniformBlock,
-                             const ShaderData &shaderData) {    
+                             const ShaderData &shaderData) {
+    const auto &block = shaderData.block();
+    std::optional<UniformRingBuffer::Allocation> allocation = std::nullopt;
     for (size_t i = 0; i < uniformBlock.size(); i++) {
         const auto &uniform = uniformBlock[i];
+        auto offset = block.offset(uniform.propertyId);
+        if (offset) {
+            // the whole block is copied once, then every uniform is bound at its slot
+            if (!allocation) {
+                allocation = _scene->uniformRing().upload(block);
+            }
+            if (uniform.type == MTL::FunctionTypeVertex) {
+                commandEncoder.setVertexBuffer(allocation->buffer, allocation->offset + offset.value(), uniform.location);
+            } else {
+                commandEncoder.setFragmentBuffer(allocation->buffer, allocation->offset + offset.value(), uniform.location);
+            }
+            continue;
+        }
+        
         auto data = shaderData.getData(uniform.propertyId);
         if (data) {
             process(uniform, data.value(), commandEncoder);
@@ -0,0 +1,60 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "uniform_ring_buffer.h"
+#include "metal_helpers.h"
+#include <cstring>
+
+namespace vox {
+UniformRingBuffer::UniformRingBuffer(MTL::Device &device,
+                                     size_t chunkSize,
+                                     uint32_t framesInFlight) :
+_device(device),
+_chunkSize(chunkSize),
+_frames(framesInFlight) {
+}
+
+void UniformRingBuffer::beginFrame() {
+    _frameIndex = (_frameIndex + 1) % _frames.size();
+    _frameSerial += 1;
+    auto &frame = _frames[_frameIndex];
+    frame.chunk = 0;
+    frame.cursor = 0;
+}
+
+UniformRingBuffer::Allocation UniformRingBuffer::upload(const ShaderDataBlock &block) {
+    auto &record = block.uploadRecord();
+    if (record.owner == this && record.serial == _frameSerial && !block.isDirty()) {
+        return {static_cast<MTL::Buffer *>(const_cast<void *>(record.buffer)), record.offset};
+    }
+    
+    auto &frame = _frames[_frameIndex];
+    const size_t alignment = block.alignment();
+    size_t offset = (frame.cursor + alignment - 1) / alignment * alignment;
+    while (frame.chunk < frame.chunks.size() && offset + block.size() > frame.chunks[frame.chunk]->length()) {
+        frame.chunk += 1;
+        offset = 0;
+    }
+    if (frame.chunk == frame.chunks.size()) {
+        auto buffer = CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _device.newBuffer(std::max(_chunkSize, block.size()),
+                                                                                MTL::ResourceStorageModeShared));
+        frame.chunks.emplace_back(std::move(buffer));
+        offset = 0;
+    }
+    
+    auto buffer = frame.chunks[frame.chunk].get();
+    std::memcpy(static_cast<uint8_t *>(buffer->contents()) + offset, block.data(), block.size());
+    frame.cursor = offset + block.size();
+    
+    record.owner = this;
+    record.serial = _frameSerial;
+    record.buffer = buffer;
+    record.offset = offset;
+    block.clearDirty();
+    return {buffer, offset};
+}
+
+}
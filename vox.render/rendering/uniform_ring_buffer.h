@@ -0,0 +1,65 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef uniform_ring_buffer_hpp
+#define uniform_ring_buffer_hpp
+
+#include "shader/shader_data_block.h"
+#include <Metal/Metal.hpp>
+#include <memory>
+#include <vector>
+
+namespace vox {
+/**
+ * Per-frame uniform memory which ShaderDataBlock are copied into before draw.
+ * @remarks Each frame in flight owns a list of shared buffers, so data written for one frame is never
+ * overwritten while the GPU may still read it.
+ */
+class UniformRingBuffer {
+public:
+    struct Allocation {
+        MTL::Buffer *buffer{nullptr};
+        size_t offset{0};
+    };
+    
+    UniformRingBuffer(MTL::Device &device,
+                      size_t chunkSize = 1024 * 1024,
+                      uint32_t framesInFlight = 3);
+    
+    UniformRingBuffer(const UniformRingBuffer &) = delete;
+    
+    UniformRingBuffer &operator=(const UniformRingBuffer &) = delete;
+    
+    /**
+     * Advance to the memory of next frame.
+     */
+    void beginFrame();
+    
+    /**
+     * Copy block into the buffer of current frame.
+     * @remarks A block which was not written since it was uploaded in the current frame is not copied again.
+     * @param block - Packed shader data
+     * @return Buffer and offset of the block
+     */
+    Allocation upload(const ShaderDataBlock &block);
+    
+private:
+    struct Frame {
+        std::vector<std::shared_ptr<MTL::Buffer>> chunks{};
+        size_t chunk{0};
+        size_t cursor{0};
+    };
+    
+    MTL::Device &_device;
+    size_t _chunkSize;
+    std::vector<Frame> _frames;
+    size_t _frameIndex{0};
+    uint64_t _frameSerial{1};
+};
+
+}
+
+#endif /* uniform_ring_buffer_hpp */
@@ -15,42 +15,14 @@
 #include <glog/logging.h>
 #include "entity.h"
 #include "camera.h"
+#include "texture/sampled_texture_streamer.h"
 
 namespace vox {
 Scene::Scene(MTL::Device &device) :
 _device(device),
-_ambientLight(this) {
+_ambientLight(this),
+_uniformRing(device) {
     _vertexUploader = {
-        toAnyUploader<bool, MTL::RenderCommandEncoder>([](const bool &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setVertexBytes(&x, sizeof(bool), location);
-        }),
-        toAnyUploader<int32_t, MTL::RenderCommandEncoder>([](const int &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setVertexBytes(&x, sizeof(int), location);
-        }),
-        toAnyUploader<uint32_t, MTL::RenderCommandEncoder>([](const int &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setVertexBytes(&x, sizeof(int), location);
-        }),
-        toAnyUploader<float, MTL::RenderCommandEncoder>([](const float &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setVertexBytes(&x, sizeof(float), location);
-        }),
-        toAnyUploader<Vector2F, MTL::RenderCommandEncoder>([](const Vector2F &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setVertexBytes(&x, sizeof(Vector2F), location);
-        }),
-        toAnyUploader<Vector3F, MTL::RenderCommandEncoder>([](const Vector3F &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setVertexBytes(&x, sizeof(Vector4F), location); // float3 simd is extented from float4
-        }),
-        toAnyUploader<Point3F, MTL::RenderCommandEncoder>([](const Point3F &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setVertexBytes(&x, sizeof(Vector4F), location); // float3 simd is extented from float4
-        }),
-        toAnyUploader<Vector4F, MTL::RenderCommandEncoder>([](const Vector4F &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setVertexBytes(&x, sizeof(Vector4F), location);
-        }),
-        toAnyUploader<Color, MTL::RenderCommandEncoder>([](const Color &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setVertexBytes(&x, sizeof(Color), location);
-        }),
-        toAnyUploader<Matrix4x4F, MTL::RenderCommandEncoder>([](const Matrix4x4F &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setVertexBytes(&x, sizeof(Matrix4x4F), location);
-        }),
         toAnyUploader<std::shared_ptr<MTL::Buffer>, MTL::RenderCommandEncoder>([](const std::shared_ptr<MTL::Buffer> &x, size_t location,
                                                                                   MTL::RenderCommandEncoder &encoder) {
             encoder.setVertexBuffer(x.get(), 0, location);
@@ -63,36 +35,6 @@ _ambientLight(this) {
     };
     
     _fragmentUploader = {
-        toAnyUploader<bool, MTL::RenderCommandEncoder>([](const bool &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setFragmentBytes(&x, sizeof(bool), location);
-        }),
-        toAnyUploader<int32_t, MTL::RenderCommandEncoder>([](const int &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setFragmentBytes(&x, sizeof(int), location);
-        }),
-        toAnyUploader<uint32_t, MTL::RenderCommandEncoder>([](const int &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setFragmentBytes(&x, sizeof(int), location);
-        }),
-        toAnyUploader<float, MTL::RenderCommandEncoder>([](const float &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setFragmentBytes(&x, sizeof(float), location);
-        }),
-        toAnyUploader<Vector2F, MTL::RenderCommandEncoder>([](const Vector2F &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setFragmentBytes(&x, sizeof(Vector2F), location);
-        }),
-        toAnyUploader<Vector3F, MTL::RenderCommandEncoder>([](const Vector3F &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setFragmentBytes(&x, sizeof(Vector4F), location); // float3 simd is extented from float4
-        }),
-        toAnyUploader<Point3F, MTL::RenderCommandEncoder>([](const Point3F &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setFragmentBytes(&x, sizeof(Vector4F), location); // float3 simd is extented from float4
-        }),
-        toAnyUploader<Vector4F, MTL::RenderCommandEncoder>([](const Vector4F &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setFragmentBytes(&x, sizeof(Vector4F), location);
-        }),
-        toAnyUploader<Color, MTL::RenderCommandEncoder>([](const Color &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setFragmentBytes(&x, sizeof(Color), location);
-        }),
-        toAnyUploader<Matrix4x4F, MTL::RenderCommandEncoder>([](const Matrix4x4F &x, size_t location, MTL::RenderCommandEncoder &encoder) {
-            encoder.setFragmentBytes(&x, sizeof(Matrix4x4F), location);
-        }),
         toAnyUploader<std::shared_ptr<MTL::Buffer>, MTL::RenderCommandEncoder>([](const std::shared_ptr<MTL::Buffer> &x, size_t location,
                                                                                   MTL::RenderCommandEncoder &encoder) {
             encoder.setFragmentBuffer(x.get(), 0, location);
@@ -105,33 +47,6 @@ _ambientLight(this) {
     };
     
     _computeUploader = {
-        toAnyUploader<int32_t, MTL::ComputeCommandEncoder>([](const int32_t &x, size_t location, MTL::ComputeCommandEncoder &encoder) {
-            encoder.setBytes(&x, sizeof(int32_t), location);
-        }),
-        toAnyUploader<uint32_t, MTL::ComputeCommandEncoder>([](const uint32_t &x, size_t location, MTL::ComputeCommandEncoder &encoder) {
-            encoder.setBytes(&x, sizeof(uint32_t), location);
-        }),
-        toAnyUploader<float, MTL::ComputeCommandEncoder>([](const float &x, size_t location, MTL::ComputeCommandEncoder &encoder) {
-            encoder.setBytes(&x, sizeof(float), location);
-        }),
-        toAnyUploader<Vector2F, MTL::ComputeCommandEncoder>([](const Vector2F &x, size_t location, MTL::ComputeCommandEncoder &encoder) {
-            encoder.setBytes(&x, sizeof(Vector2F), location);
-        }),
-        toAnyUploader<Vector3F, MTL::ComputeCommandEncoder>([](const Vector3F &x, size_t location, MTL::ComputeCommandEncoder &encoder) {
-            encoder.setBytes(&x, sizeof(Vector4F), location); // float3 simd is extented from float4
-        }),
-        toAnyUploader<Point3F, MTL::ComputeCommandEncoder>([](const Point3F &x, size_t location, MTL::ComputeCommandEncoder &encoder) {
-            encoder.setBytes(&x, sizeof(Vector4F), location); // float3 simd is extented from float4
-        }),
-        toAnyUploader<Vector4F, MTL::ComputeCommandEncoder>([](const Vector4F &x, size_t location, MTL::ComputeCommandEncoder &encoder) {
-            encoder.setBytes(&x, sizeof(Vector4F), location);
-        }),
-        toAnyUploader<Color, MTL::ComputeCommandEncoder>([](const Color &x, size_t location, MTL::ComputeCommandEncoder &encoder) {
-            encoder.setBytes(&x, sizeof(Color), location);
-        }),
-        toAnyUploader<Matrix4x4F, MTL::ComputeCommandEncoder>([](const Matrix4x4F &x, size_t location, MTL::ComputeCommandEncoder &encoder) {
-            encoder.setBytes(&x, sizeof(Matrix4x4F), location);
-        }),
         toAnyUploader<std::shared_ptr<MTL::Buffer>, MTL::ComputeCommandEncoder>([](const std::shared_ptr<MTL::Buffer> &x, size_t location,
                                                                                    MTL::ComputeCommandEncoder &encoder) {
             encoder.setBuffer(x.get(), 0, location);
@@ -142,7 +57,11 @@ _ambientLight(this) {
             encoder.setSamplerState(&x->sampler(), location);
         }),
     };
-    _ambientLight.registerUploader(this);
+}
+
+Scene::~Scene() {
+    // the root entities are released first and remove their actors, which PhysX forbids during a step
+    _physicsManager.finishSimulation();
 }
 
 MTL::Device &Scene::device() {
@@ -164,6 +83,10 @@ Scene::computeUploader() {
     return _computeUploader;
 }
 
+UniformRingBuffer &Scene::uniformRing() {
+    return _uniformRing;
+}
+
 AmbientLight &Scene::ambientLight() {
     return _ambientLight;
 }
@@ -296,6 +219,7 @@ void Scene::updateShaderData() {
 }
 
 void Scene::update(float deltaTime) {
+    _uniformRing.beginFrame();
     _componentsManager.callScriptOnStart();
     
     _physicsManager.callColliderOnUpdate();
@@ -304,11 +228,16 @@ void Scene::update(float deltaTime) {
     _physicsManager.callCharacterControllerOnLateUpdate();
     
     _componentsManager.callScriptOnUpdate(deltaTime);
-    _componentsManager.callAnimatorUpdate(deltaTime);
+    _componentsManager.callAnimatorUpdate(deltaTime, _activeCameras);
     _componentsManager.callSceneAnimatorUpdate(deltaTime);
+    _componentsManager.callSkinnedMeshRendererUpdate(_activeCameras);
     _componentsManager.callScriptOnLateUpdate(deltaTime);
     
     _componentsManager.callRendererOnUpdate(deltaTime);
+    if (textureStreamer) {
+        _componentsManager.callTextureStreamingRequest(*textureStreamer, _activeCameras);
+        textureStreamer->update();
+    }
     
     updateShaderData();
 }
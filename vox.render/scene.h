@@ -19,6 +19,7 @@
 #include "physics/physics_manager.h"
 #include "lighting/ambient_light.h"
 #include "shader/shader_data.h"
+#include "rendering/uniform_ring_buffer.h"
 #include "background.h"
 
 namespace vox {
@@ -38,12 +39,17 @@ public:
     /** Scene-related shader data. */
     ShaderData shaderData = ShaderData();
     
+    /** Streams the textures added to it by the screen size of the renderers which use them, when set. */
+    SampledTextureStreamer *textureStreamer{nullptr};
+    
     /**
      * Create scene.
      * @param device - Device
      */
     Scene(MTL::Device &device);
     
+    ~Scene();
+    
     MTL::Device &device();
     
     /**
@@ -118,7 +124,15 @@ public:
     
     void updateShaderData();
     
+    /**
+     * Per-frame memory for packed shader data, shared by all passes.
+     */
+    UniformRingBuffer &uniformRing();
+    
 public:
+    /**
+     * Uploaders bind the properties ShaderData keeps as std::any, values packed into the ShaderDataBlock never reach them.
+     */
     template<class T, class F>
     inline void registerVertexUploader(F const &f) {
         std::cout << "Register uploader for type "
@@ -180,6 +194,7 @@ private:
     AmbientLight _ambientLight;
     
     MTL::Device &_device;
+    UniformRingBuffer _uniformRing;
 };
 
 }        // namespace vox
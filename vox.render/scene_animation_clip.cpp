@@ -5,9 +5,23 @@
 //  property of any third parties.
 
 #include "scene_animation_clip.h"
-#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
 
 namespace vox {
+namespace {
+QuaternionF toQuaternion(const float *value) {
+    QuaternionF q;
+    q.x = value[0];
+    q.y = value[1];
+    q.z = value[2];
+    q.w = value[3];
+    return q;
+}
+
+}
+
 SceneAnimationClip::SceneAnimationClip(const std::string &name) :
 _name(name) {
 }
@@ -16,49 +30,145 @@ const std::string &SceneAnimationClip::name() const {
     return _name;
 }
 
+uint32_t SceneAnimationClip::findKey(const std::vector<float> &inputs, float time, uint32_t &cursor) {
+    if (inputs.size() < 2) {
+        cursor = 0;
+        return 0;
+    }
+    const auto last = static_cast<uint32_t>(inputs.size() - 2);
+    // playback mostly stays in the interval of the last frame or moves to the next one
+    uint32_t key = std::min(cursor, last);
+    if (inputs[key] <= time) {
+        if (time <= inputs[key + 1] || key == last) {
+            cursor = key;
+            return key;
+        }
+        if (time <= inputs[key + 2]) {
+            cursor = key + 1;
+            return key + 1;
+        }
+    } else if (key == 0) {
+        return 0;
+    }
+    const auto upper = std::upper_bound(inputs.begin(), inputs.end(), time);
+    key = static_cast<uint32_t>(std::max<ptrdiff_t>(upper - inputs.begin() - 1, 0));
+    cursor = std::min(key, last);
+    return cursor;
+}
+
 void SceneAnimationClip::update(float deltaTime) {
     _currentTime += deltaTime;
     if (_currentTime > _end) {
-        _currentTime -= _end;
+        _currentTime = _end > 0 ? std::fmod(_currentTime, _end) : 0;
+    }
+    if (_targetsDirty) {
+        _buildTargets();
+    }
+
+    float value[4];
+    for (const auto &target : _targets) {
+        auto transform = target.transform;
+        auto position = transform->position();
+        auto rotation = transform->rotationQuaternion();
+        auto scale = transform->scale();
+        if (target.translation >= 0 && _sample(target.translation, value)) {
+            position = Point3F(value[0], value[1], value[2]);
+        }
+        if (target.rotation >= 0 && _sample(target.rotation, value)) {
+            rotation = toQuaternion(value);
+        }
+        if (target.scale >= 0 && _sample(target.scale, value)) {
+            scale = Vector3F(value[0], value[1], value[2]);
+        }
+        transform->setTRS(position, rotation, scale);
+    }
+}
+
+bool SceneAnimationClip::_sample(size_t channelIndex, float *value) {
+    const auto &channel = _channels[channelIndex];
+    const auto &sampler = _samplers[channel.samplerIndex];
+    const auto &inputs = sampler.inputs;
+    const uint32_t components = sampler.components;
+    const bool cubic = sampler.interpolation == AnimationSampler::CUBICSPLINE;
+    // cubic spline keys hold in-tangent, value and out-tangent
+    const uint32_t keyStride = cubic ? components * 3 : components;
+    const float *outputs = sampler.outputs.data() + (cubic ? components : 0);
+    if (inputs.empty() || sampler.outputs.size() < inputs.size() * keyStride ||
+        (channel.path == AnimationChannel::ROTATION && components != 4)) {
+        return false;
     }
-    
-    for (auto &channel: _channels) {
-        AnimationSampler &sampler = _samplers[channel.samplerIndex];
-        for (size_t i = 0; i < sampler.inputs.size() - 1; i++) {
-            if (sampler.interpolation != AnimationSampler::LINEAR) {
-                std::cout << "This sample only supports linear interpolations\n";
-                continue;
-            }
-            
-            // Get the input keyframe values for the current time stamp
-            if ((_currentTime >= sampler.inputs[i]) && (_currentTime <= sampler.inputs[i + 1])) {
-                float a = (_currentTime - sampler.inputs[i]) / (sampler.inputs[i + 1] - sampler.inputs[i]);
-                if (channel.path == AnimationChannel::TRANSLATION) {
-                    auto interp = lerp(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], a);
-                    channel.node->transform->setPosition(Point3F(interp.x, interp.y, interp.z));
-                }
-                if (channel.path == AnimationChannel::ROTATION) {
-                    QuaternionF q1;
-                    q1.x = sampler.outputsVec4[i].x;
-                    q1.y = sampler.outputsVec4[i].y;
-                    q1.z = sampler.outputsVec4[i].z;
-                    q1.w = sampler.outputsVec4[i].w;
-                    
-                    QuaternionF q2;
-                    q2.x = sampler.outputsVec4[i + 1].x;
-                    q2.y = sampler.outputsVec4[i + 1].y;
-                    q2.z = sampler.outputsVec4[i + 1].z;
-                    q2.w = sampler.outputsVec4[i + 1].w;
-                    
-                    channel.node->transform->setRotationQuaternion(slerp(q1, q2, a).normalized());
-                }
-                if (channel.path == AnimationChannel::SCALE) {
-                    auto interp = lerp(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], a);
-                    channel.node->transform->setScale(Vector3F(interp.x, interp.y, interp.z));
-                }
-            }
+
+    const uint32_t key = findKey(inputs, _currentTime, _cursors[channelIndex]);
+    const float *v0 = outputs + key * keyStride;
+    if (inputs.size() == 1 || sampler.interpolation == AnimationSampler::STEP || _currentTime <= inputs[key]) {
+        std::copy(v0, v0 + components, value);
+        return true;
+    }
+    const float *v1 = v0 + keyStride;
+    const float duration = inputs[key + 1] - inputs[key];
+    if (_currentTime >= inputs[key + 1] || duration <= 0) {
+        std::copy(v1, v1 + components, value);
+        return true;
+    }
+    const float t = (_currentTime - inputs[key]) / duration;
+
+    if (cubic) {
+        const float *outTangent = v0 + components;
+        const float *inTangent = v1 - components;
+        const float t2 = t * t;
+        const float t3 = t2 * t;
+        const float h00 = 2 * t3 - 3 * t2 + 1;
+        const float h10 = (t3 - 2 * t2 + t) * duration;
+        const float h01 = -2 * t3 + 3 * t2;
+        const float h11 = (t3 - t2) * duration;
+        for (uint32_t i = 0; i < components; i++) {
+            value[i] = h00 * v0[i] + h10 * outTangent[i] + h01 * v1[i] + h11 * inTangent[i];
+        }
+        if (channel.path == AnimationChannel::ROTATION) {
+            const auto q = toQuaternion(value).normalized();
+            value[0] = q.x;
+            value[1] = q.y;
+            value[2] = q.z;
+            value[3] = q.w;
+        }
+    } else if (channel.path == AnimationChannel::ROTATION) {
+        const auto q = slerp(toQuaternion(v0), toQuaternion(v1), t).normalized();
+        value[0] = q.x;
+        value[1] = q.y;
+        value[2] = q.z;
+        value[3] = q.w;
+    } else {
+        for (uint32_t i = 0; i < components; i++) {
+            value[i] = v0[i] + (v1[i] - v0[i]) * t;
+        }
+    }
+    return true;
+}
+
+void SceneAnimationClip::_buildTargets() {
+    _targets.clear();
+    std::unordered_map<Entity *, size_t> targetIndices;
+    for (size_t i = 0; i < _channels.size(); i++) {
+        const auto &channel = _channels[i];
+        const auto result = targetIndices.emplace(channel.node.get(), _targets.size());
+        if (result.second) {
+            _targets.push_back({channel.node->transform});
+        }
+        auto &target = _targets[result.first->second];
+        const int index = static_cast<int>(i);
+        switch (channel.path) {
+            case AnimationChannel::TRANSLATION:
+                target.translation = index;
+                break;
+            case AnimationChannel::ROTATION:
+                target.rotation = index;
+                break;
+            case AnimationChannel::SCALE:
+                target.scale = index;
+                break;
         }
     }
+    _targetsDirty = false;
 }
 
 float SceneAnimationClip::start() const {
@@ -83,6 +193,8 @@ void SceneAnimationClip::addSampler(const AnimationSampler &sampler) {
 
 void SceneAnimationClip::addChannel(const AnimationChannel &channel) {
     _channels.push_back(channel);
+    _cursors.push_back(0);
+    _targetsDirty = true;
 }
 
 }
@@ -22,13 +22,23 @@ public:
         uint32_t samplerIndex;
     };
     
+    /**
+     * Keys of a sampler, times and values are kept in separate arrays.
+     */
     struct AnimationSampler {
         enum InterpolationType {
             LINEAR, STEP, CUBICSPLINE
         };
         InterpolationType interpolation;
+        /** Key times in ascending order. */
         std::vector<float> inputs;
-        std::vector<Vector4F> outputsVec4;
+        /**
+         * Tightly packed key values, components floats per value.
+         * @remarks Cubic spline keys hold in-tangent, value and out-tangent.
+         */
+        std::vector<float> outputs;
+        /** 3 for translation and scale, 4 for rotation. */
+        uint32_t components = 4;
     };
     
 public:
@@ -50,10 +60,32 @@ public:
     
     void addChannel(const AnimationChannel &channel);
     
+    /**
+     * Index of the key interval [inputs[i], inputs[i + 1]] which contains the time, clamped to the first and last interval.
+     * @param cursor - Interval found last time, checked with its successor before a binary search, updated to the result
+     */
+    static uint32_t findKey(const std::vector<float> &inputs, float time, uint32_t &cursor);
+    
 private:
+    // channels animating the same node, written to its transform at once
+    struct Target {
+        Transform *transform;
+        int translation = -1;
+        int rotation = -1;
+        int scale = -1;
+    };
+    
+    void _buildTargets();
+    
+    // false if the sampler has no usable keys
+    bool _sample(size_t channelIndex, float *value);
+    
     std::string _name;
     std::vector<AnimationSampler> _samplers;
     std::vector<AnimationChannel> _channels;
+    std::vector<uint32_t> _cursors;
+    std::vector<Target> _targets;
+    bool _targetsDirty = false;
     float _start = std::numeric_limits<float>::max();
     float _end = std::numeric_limits<float>::min();
     
@@ -56,8 +56,12 @@ class Renderer;
 
 class MeshRenderer;
 
+class LODGroup;
+
 class GPUSkinnedMeshRenderer;
 
+class SkinnedMeshRenderer;
+
 class Script;
 
 class Animator;
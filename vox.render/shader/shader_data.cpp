@@ -32,7 +32,7 @@ std::optional<std::any> ShaderData::getData(uint32_t uniqueID) const {
         return functorIter->second();
     }
     
-    return std::nullopt;
+    return _block.getAny(uniqueID);
 }
 
 void ShaderData::setBufferFunctor(const std::string &property_name,
@@ -50,19 +50,6 @@ void ShaderData::setBufferFunctor(ShaderProperty property,
     _shaderBufferFunctors.insert(std::make_pair(property.uniqueId, functor));
 }
 
-void ShaderData::setData(const std::string &property_name, std::any value) {
-    auto property = Shader::getPropertyByName(property_name);
-    if (property.has_value()) {
-        setData(property.value(), value);
-    } else {
-        assert(false && "can't find property");
-    }
-}
-
-void ShaderData::setData(ShaderProperty property, std::any value) {
-    _properties[property.uniqueId] = value;
-}
-
 void ShaderData::setSampledTexure(const std::string &property, const SampledTexturePtr &value) {
     setData(property, value);
 }
@@ -71,20 +58,33 @@ void ShaderData::setSampledTexure(ShaderProperty property, const SampledTextureP
     setData(property, value);
 }
 
+void ShaderData::forEachSampledTexture(const std::function<void(const SampledTexturePtr &)> &function) const {
+    for (const auto &property : _properties) {
+        if (const auto texture = std::any_cast<SampledTexturePtr>(&property.second)) {
+            function(*texture);
+        }
+    }
+}
+
+const ShaderDataBlock &ShaderData::block() const {
+    return _block;
+}
+
+std::optional<ShaderProperty> ShaderData::_getPropertyByName(const std::string &property_name) {
+    return Shader::getPropertyByName(property_name);
+}
+
 //MARK: - Macro
 void ShaderData::enableMacro(MacroName macroName) {
-    _macroCollection._value.insert(std::make_pair(macroName, std::make_pair(1, MTL::DataTypeBool)));
+    _macroCollection.enable(macroName, std::make_pair(1, MTL::DataTypeBool));
 }
 
 void ShaderData::enableMacro(MacroName macroName, std::pair<int, MTL::DataType> value) {
-    _macroCollection._value.insert(std::make_pair(macroName, value));
+    _macroCollection.enable(macroName, value);
 }
 
 void ShaderData::disableMacro(MacroName macroName) {
-    auto iter = _macroCollection._value.find(macroName);
-    if (iter != _macroCollection._value.end()) {
-        _macroCollection._value.erase(iter);
-    }
+    _macroCollection.disable(macroName);
 }
 
 void ShaderData::mergeMacro(const ShaderMacroCollection &macros,
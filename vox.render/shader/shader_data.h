@@ -8,15 +8,19 @@
 #define shader_data_hpp
 
 #include "shader_data_group.h"
+#include "shader_data_block.h"
 #include "shader_macro_collection.h"
 #include "shader_property.h"
 #include "texture/sampled_texture.h"
 #include <any>
+#include <cassert>
 #include <unordered_map>
 
 namespace vox {
 /**
  * Shader data collection,Correspondence includes shader properties data and macros data.
+ * @remarks Values which can be copied to the GPU byte by byte are packed into a ShaderDataBlock,
+ * textures, buffers and other resources are kept as std::any.
  */
 class ShaderData {
 public:
@@ -32,14 +36,41 @@ public:
     void setBufferFunctor(ShaderProperty property,
                           std::function<std::shared_ptr<MTL::Buffer>()> functor);
     
-    void setData(const std::string &property, std::any value);
+    template<class T>
+    void setData(const std::string &property_name, const T &value) {
+        auto property = _getPropertyByName(property_name);
+        if (property.has_value()) {
+            setData(property.value(), value);
+        } else {
+            assert(false && "can't find property");
+        }
+    }
     
-    void setData(ShaderProperty property, std::any value);
+    template<class T>
+    void setData(const ShaderProperty &property, const T &value) {
+        if constexpr (is_uniform_value_v<T>) {
+            _block.set(property.uniqueId, value);
+            _properties.erase(property.uniqueId);
+        } else {
+            _properties[property.uniqueId] = value;
+            _block.remove(property.uniqueId);
+        }
+    }
     
     void setSampledTexure(const std::string &property, const SampledTexturePtr &value);
     
     void setSampledTexure(ShaderProperty property, const SampledTexturePtr &value);
-        
+    
+    /**
+     * Call function for every sampled texture property.
+     */
+    void forEachSampledTexture(const std::function<void(const SampledTexturePtr &)> &function) const;
+    
+    /**
+     * Packed uniform values.
+     */
+    const ShaderDataBlock &block() const;
+    
 public:
     /**
      * Enable macro.
@@ -65,6 +96,9 @@ public:
                     ShaderMacroCollection &result) const;
     
 private:
+    static std::optional<ShaderProperty> _getPropertyByName(const std::string &property_name);
+    
+    ShaderDataBlock _block{};
     std::unordered_map<int, std::any> _properties{};
     std::unordered_map<uint32_t, std::function<std::shared_ptr<MTL::Buffer>()>> _shaderBufferFunctors{};
     ShaderMacroCollection _macroCollection;
@@ -0,0 +1,126 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "shader_data_block.h"
+#include <algorithm>
+
+namespace vox {
+ShaderDataBlock::ShaderDataBlock(size_t alignment) :
+_alignment(alignment) {
+}
+
+std::optional<std::any> ShaderDataBlock::getAny(int propertyId) const {
+    auto slot = _find(propertyId);
+    if (slot == nullptr) {
+        return std::nullopt;
+    }
+    return slot->toAny(_data.data() + slot->offset);
+}
+
+bool ShaderDataBlock::has(int propertyId) const {
+    return _find(propertyId) != nullptr;
+}
+
+std::optional<size_t> ShaderDataBlock::offset(int propertyId) const {
+    auto slot = _find(propertyId);
+    if (slot == nullptr) {
+        return std::nullopt;
+    }
+    return slot->offset;
+}
+
+void ShaderDataBlock::remove(int propertyId) {
+    if (propertyId < 0 || propertyId >= static_cast<int>(_slotIndex.size())) {
+        return;
+    }
+    auto index = _slotIndex[propertyId];
+    if (index != kInvalidSlot) {
+        // keep the capacity so that the property can come back without growing the block
+        _slots[index].size = 0;
+        _slots[index].toAny = nullptr;
+    }
+}
+
+const uint8_t *ShaderDataBlock::data() const {
+    return _data.data();
+}
+
+size_t ShaderDataBlock::size() const {
+    return _data.size();
+}
+
+size_t ShaderDataBlock::alignment() const {
+    return _alignment;
+}
+
+bool ShaderDataBlock::isDirty() const {
+    return _dirtyBegin < _dirtyEnd;
+}
+
+std::pair<size_t, size_t> ShaderDataBlock::dirtyRange() const {
+    return std::make_pair(_dirtyBegin, _dirtyEnd);
+}
+
+void ShaderDataBlock::clearDirty() const {
+    _dirtyBegin = 0;
+    _dirtyEnd = 0;
+}
+
+ShaderDataBlock::UploadRecord &ShaderDataBlock::uploadRecord() const {
+    return _uploadRecord;
+}
+
+const ShaderDataBlock::Slot *ShaderDataBlock::_find(int propertyId) const {
+    if (propertyId < 0 || propertyId >= static_cast<int>(_slotIndex.size())) {
+        return nullptr;
+    }
+    auto index = _slotIndex[propertyId];
+    if (index == kInvalidSlot || _slots[index].size == 0) {
+        return nullptr;
+    }
+    return &_slots[index];
+}
+
+ShaderDataBlock::Slot &ShaderDataBlock::_slot(int propertyId, size_t size) {
+    if (propertyId >= static_cast<int>(_slotIndex.size())) {
+        _slotIndex.resize(propertyId + 1, kInvalidSlot);
+    }
+
+    auto &index = _slotIndex[propertyId];
+    if (index != kInvalidSlot && _slots[index].capacity >= size) {
+        return _slots[index];
+    }
+
+    // new slot at the end of the block, a slot which is too small is abandoned
+    const size_t capacity = (size + _alignment - 1) / _alignment * _alignment;
+    Slot slot;
+    slot.offset = static_cast<uint32_t>(_data.size());
+    slot.capacity = static_cast<uint32_t>(capacity);
+    _data.resize(_data.size() + capacity, 0);
+    if (index == kInvalidSlot) {
+        index = static_cast<int32_t>(_slots.size());
+        _slots.push_back(slot);
+    } else {
+        _slots[index] = slot;
+    }
+    // the layout changed, everything has to be copied again
+    _dirtyBegin = 0;
+    _dirtyEnd = _data.size();
+    return _slots[index];
+}
+
+void ShaderDataBlock::_write(size_t offset, const void *value, size_t size) {
+    std::memcpy(_data.data() + offset, value, size);
+    if (isDirty()) {
+        _dirtyBegin = std::min(_dirtyBegin, offset);
+        _dirtyEnd = std::max(_dirtyEnd, offset + size);
+    } else {
+        _dirtyBegin = offset;
+        _dirtyEnd = offset + size;
+    }
+}
+
+}
@@ -0,0 +1,195 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef shader_data_block_hpp
+#define shader_data_block_hpp
+
+#include "vector2.h"
+#include "vector3.h"
+#include "vector4.h"
+#include "point3.h"
+#include "color.h"
+#include "matrix4x4.h"
+#include <any>
+#include <array>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace vox {
+/**
+ * Whether a value can be packed into a ShaderDataBlock, i.e. it is uploaded to the GPU by copying its bytes.
+ */
+template<class T>
+struct is_uniform_value : std::bool_constant<std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>> {
+};
+
+template<>
+struct is_uniform_value<Vector2F> : std::true_type {
+};
+
+template<>
+struct is_uniform_value<Vector3F> : std::true_type {
+};
+
+template<>
+struct is_uniform_value<Vector4F> : std::true_type {
+};
+
+template<>
+struct is_uniform_value<Point3F> : std::true_type {
+};
+
+template<>
+struct is_uniform_value<Color> : std::true_type {
+};
+
+template<>
+struct is_uniform_value<Matrix4x4F> : std::true_type {
+};
+
+template<class T, size_t N>
+struct is_uniform_value<std::array<T, N>> : is_uniform_value<T> {
+};
+
+template<class T>
+inline constexpr bool is_uniform_value_v = is_uniform_value<T>::value;
+
+/**
+ * Size of the value on the GPU side.
+ */
+template<class T>
+struct uniform_size : std::integral_constant<size_t, sizeof(T)> {
+};
+
+// float3 simd is extented from float4
+template<>
+struct uniform_size<Vector3F> : std::integral_constant<size_t, sizeof(Vector4F)> {
+};
+
+template<>
+struct uniform_size<Point3F> : std::integral_constant<size_t, sizeof(Vector4F)> {
+};
+
+/**
+ * Contiguous byte storage for the uniform values of one ShaderData.
+ * @remarks Every property owns a slot aligned to the buffer offset alignment of the GPU, so the whole block can be
+ * copied into a uniform buffer with one memcpy and every slot bound at "base + offset".
+ * Writes never allocate once the slot exists and grow a dirty byte range.
+ */
+class ShaderDataBlock {
+public:
+    /** Offset alignment required by Metal for constant buffers on macOS. */
+    static constexpr size_t kDefaultAlignment = 256;
+
+    /**
+     * Where the block was copied last time, owned by the uploader.
+     */
+    struct UploadRecord {
+        const void *owner{nullptr};
+        uint64_t serial{0};
+        const void *buffer{nullptr};
+        size_t offset{0};
+    };
+
+    explicit ShaderDataBlock(size_t alignment = kDefaultAlignment);
+
+    /**
+     * Write value of property.
+     * @param propertyId - Unique id of shader property
+     * @param value - Value
+     */
+    template<class T>
+    void set(int propertyId, const T &value) {
+        static_assert(is_uniform_value_v<T>, "value can't be packed into uniform block");
+        auto &slot = _slot(propertyId, uniform_size<T>::value);
+        slot.size = static_cast<uint32_t>(uniform_size<T>::value);
+        slot.toAny = [](const void *data) {
+            T value;
+            std::memcpy(reinterpret_cast<void *>(&value), data, sizeof(T));
+            return std::any(value);
+        };
+        _write(slot.offset, &value, sizeof(T));
+    }
+
+    /**
+     * Read value of property.
+     * @remarks T must be the type which was written.
+     */
+    template<class T>
+    std::optional<T> get(int propertyId) const {
+        auto slot = _find(propertyId);
+        if (slot == nullptr || slot->size != uniform_size<T>::value) {
+            return std::nullopt;
+        }
+        T value;
+        std::memcpy(reinterpret_cast<void *>(&value), _data.data() + slot->offset, sizeof(T));
+        return value;
+    }
+
+    /**
+     * Read value of property as std::any.
+     */
+    std::optional<std::any> getAny(int propertyId) const;
+
+    bool has(int propertyId) const;
+
+    /**
+     * Byte offset of property inside the block.
+     */
+    std::optional<size_t> offset(int propertyId) const;
+
+    void remove(int propertyId);
+
+    const uint8_t *data() const;
+
+    size_t size() const;
+
+    size_t alignment() const;
+
+public:
+    bool isDirty() const;
+
+    /**
+     * Bytes written since the last clearDirty, as [begin, end).
+     */
+    std::pair<size_t, size_t> dirtyRange() const;
+
+    void clearDirty() const;
+
+    UploadRecord &uploadRecord() const;
+
+private:
+    struct Slot {
+        uint32_t offset{0};
+        uint32_t size{0};
+        uint32_t capacity{0};
+        std::any (*toAny)(const void *){nullptr};
+    };
+
+    static constexpr int32_t kInvalidSlot = -1;
+
+    const Slot *_find(int propertyId) const;
+
+    Slot &_slot(int propertyId, size_t size);
+
+    void _write(size_t offset, const void *value, size_t size);
+
+    size_t _alignment;
+    std::vector<uint8_t> _data{};
+    std::vector<Slot> _slots{};
+    // property unique id -> index of slot
+    std::vector<int32_t> _slotIndex{};
+
+    mutable size_t _dirtyBegin{0};
+    mutable size_t _dirtyEnd{0};
+    mutable UploadRecord _uploadRecord{};
+};
+
+}
+
+#endif /* shader_data_block_hpp */
@@ -5,7 +5,6 @@
 //  property of any third parties.
 
 #include "shader_macro_collection.h"
-#include "std_helpers.h"
 #include "metal_helpers.h"
 
 namespace vox {
@@ -14,6 +13,8 @@ std::unordered_map<MacroName, std::pair<int, MTL::DataType>> ShaderMacroCollecti
     {HAS_NORMAL, {0, MTL::DataTypeBool}},
     {HAS_TANGENT, {0, MTL::DataTypeBool}},
     {HAS_VERTEXCOLOR, {0, MTL::DataTypeBool}},
+    {HAS_COMPRESSED_NORMAL, {0, MTL::DataTypeBool}},
+    {HAS_QUANTIZED_POSITION, {0, MTL::DataTypeBool}},
     
     // Blend Shape
     {HAS_BLENDSHAPE, {0, MTL::DataTypeBool}},
@@ -88,20 +89,80 @@ std::shared_ptr<MTL::FunctionConstantValues> ShaderMacroCollection::createDefaul
 
 void ShaderMacroCollection::unionCollection(const ShaderMacroCollection &left, const ShaderMacroCollection &right,
                                             ShaderMacroCollection &result) {
-    result._value.insert(left._value.begin(), left._value.end());
-    result._value.insert(right._value.begin(), right._value.end());
+    result._merge(left);
+    result._merge(right);
 }
 
-size_t ShaderMacroCollection::hash() const {
-    std::size_t hash{0U};
-    for (int i = 0; i < MacroName::TOTAL_COUNT; i++) {
-        auto iter = _value.find(MacroName(i));
-        if (iter != _value.end()) {
-            hash_combine(hash, iter->first);
-        }
+void ShaderMacroCollection::enable(MacroName macroName, std::pair<int, MTL::DataType> value) {
+    const uint64_t bit = uint64_t(1) << macroName;
+    if (_mask & bit) {
+        _hash ^= _slotHash(macroName, _values[macroName], _types[macroName]);
+    }
+    _mask |= bit;
+    _values[macroName] = value.first;
+    _types[macroName] = static_cast<uint8_t>(value.second);
+    _hash ^= _slotHash(macroName, _values[macroName], _types[macroName]);
+}
+
+void ShaderMacroCollection::disable(MacroName macroName) {
+    const uint64_t bit = uint64_t(1) << macroName;
+    if (_mask & bit) {
+        _hash ^= _slotHash(macroName, _values[macroName], _types[macroName]);
+        _mask &= ~bit;
+        _values[macroName] = 0;
+        _types[macroName] = 0;
     }
-    return hash;
 }
 
+bool ShaderMacroCollection::isEnabled(MacroName macroName) const {
+    return _mask & (uint64_t(1) << macroName);
+}
+
+std::pair<int, MTL::DataType> ShaderMacroCollection::value(MacroName macroName) const {
+    return std::make_pair(_values[macroName], static_cast<MTL::DataType>(_types[macroName]));
+}
+
+size_t ShaderMacroCollection::count() const {
+    return __builtin_popcountll(_mask);
+}
+
+uint64_t ShaderMacroCollection::mask() const {
+    return _mask;
+}
+
+size_t ShaderMacroCollection::hash() const {
+    return _hash;
+}
+
+bool ShaderMacroCollection::operator==(const ShaderMacroCollection &other) const {
+    // disabled slots are always zero, so whole arrays can be compared
+    return _hash == other._hash && _mask == other._mask &&
+    _values == other._values && _types == other._types;
+}
+
+bool ShaderMacroCollection::operator!=(const ShaderMacroCollection &other) const {
+    return !(*this == other);
+}
+
+uint64_t ShaderMacroCollection::_slotHash(uint32_t index, int value, uint8_t type) {
+    // splitmix64 finalizer over (index, type, value)
+    uint64_t x = (uint64_t(index) << 40) ^ (uint64_t(type) << 32) ^ uint64_t(uint32_t(value));
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+void ShaderMacroCollection::_merge(const ShaderMacroCollection &other) {
+    uint64_t added = other._mask & ~_mask;
+    _mask |= added;
+    while (added) {
+        const uint32_t index = __builtin_ctzll(added);
+        added &= added - 1;
+        _values[index] = other._values[index];
+        _types[index] = other._types[index];
+        _hash ^= _slotHash(index, _values[index], _types[index]);
+    }
+}
 
 }
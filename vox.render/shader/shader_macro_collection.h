@@ -7,6 +7,7 @@
 #ifndef shader_macro_collection_hpp
 #define shader_macro_collection_hpp
 
+#include <array>
 #include <unordered_map>
 #include <Metal/Metal.hpp>
 #include "macro_name.h"
@@ -14,29 +15,68 @@
 namespace vox {
 /**
  * Shader macro collection.
+ * @remarks Enabled macros are kept in a 64-bit mask with a dense value array indexed by MacroName,
+ * and the hash is maintained incrementally, so union and compare are a few word operations.
  */
 struct ShaderMacroCollection {
+    static_assert(MacroName::TOTAL_COUNT <= 64, "macro mask is a single 64-bit word");
+
     static std::unordered_map<MacroName, std::pair<int, MTL::DataType>> defaultValue;
-    
+
     static std::shared_ptr<MTL::FunctionConstantValues> createDefaultFunction();
-    
+
     /**
      * Union of two macro collection.
+     * @remarks Macros already in result win over left, and left wins over right.
      * @param left - input macro collection
      * @param right - input macro collection
      * @param result - union output macro collection
      */
     static void unionCollection(const ShaderMacroCollection &left, const ShaderMacroCollection &right,
                                 ShaderMacroCollection &result);
-    
+
+    /**
+     * Enable macro, or update its value when it is already enabled.
+     * @param macroName - Macro name
+     * @param value - Macro value and type
+     */
+    void enable(MacroName macroName, std::pair<int, MTL::DataType> value);
+
+    /**
+     * Disable macro.
+     * @param macroName - Macro name
+     */
+    void disable(MacroName macroName);
+
+    bool isEnabled(MacroName macroName) const;
+
+    /**
+     * Value of enabled macro.
+     */
+    std::pair<int, MTL::DataType> value(MacroName macroName) const;
+
+    /**
+     * Number of enabled macros.
+     */
+    size_t count() const;
+
+    uint64_t mask() const;
+
     size_t hash() const;
-    
+
+    bool operator==(const ShaderMacroCollection &other) const;
+
+    bool operator!=(const ShaderMacroCollection &other) const;
+
 private:
-    friend class ResourceCache;
-    
-    friend class ShaderData;
-    
-    std::unordered_map<MacroName, std::pair<int, MTL::DataType>> _value{};
+    static uint64_t _slotHash(uint32_t index, int value, uint8_t type);
+
+    void _merge(const ShaderMacroCollection &other);
+
+    uint64_t _mask{0};
+    uint64_t _hash{0};
+    std::array<int32_t, MacroName::TOTAL_COUNT> _values{};
+    std::array<uint8_t, MacroName::TOTAL_COUNT> _types{};
 };
 
 }
@@ -43,26 +43,6 @@ _shadowMapProp(Shader::createProperty("u_shadowMap", ShaderDataGroup::Scene)),
 _cubeShadowMapProp(Shader::createProperty("u_cubeShadowMap", ShaderDataGroup::Scene)),
 _shadowDataProp(Shader::createProperty("u_shadowData", ShaderDataGroup::Scene)),
 _cubeShadowDataProp(Shader::createProperty("u_cubeShadowData", ShaderDataGroup::Scene)) {
-    scene->registerVertexUploader<std::array<ShadowManager::ShadowData, MAX_SHADOW>>([](const std::array<ShadowManager::ShadowData, MAX_SHADOW> &x,
-                                                                                        size_t location, MTL::RenderCommandEncoder &encoder) {
-        encoder.setVertexBytes(&x, sizeof(std::array<ShadowManager::ShadowData, MAX_SHADOW>), location);
-    });
-    
-    scene->registerFragmentUploader<std::array<ShadowManager::ShadowData, MAX_SHADOW>>([](const std::array<ShadowManager::ShadowData, MAX_SHADOW> &x,
-                                                                                          size_t location, MTL::RenderCommandEncoder &encoder) {
-        encoder.setFragmentBytes(&x, sizeof(std::array<ShadowManager::ShadowData, MAX_SHADOW>), location);
-    });
-    
-    scene->registerVertexUploader<std::array<ShadowManager::CubeShadowData, MAX_CUBE_SHADOW>>([](const std::array<ShadowManager::CubeShadowData, MAX_CUBE_SHADOW> &x,
-                                                                                                 size_t location, MTL::RenderCommandEncoder &encoder) {
-        encoder.setVertexBytes(&x, sizeof(std::array<CubeShadowData, MAX_CUBE_SHADOW>), location);
-    });
-    
-    scene->registerFragmentUploader<std::array<ShadowManager::CubeShadowData, MAX_CUBE_SHADOW>>([](const std::array<ShadowManager::CubeShadowData, MAX_CUBE_SHADOW> &x,
-                                                                                                   size_t location, MTL::RenderCommandEncoder &encoder) {
-        encoder.setFragmentBytes(&x, sizeof(std::array<CubeShadowData, MAX_CUBE_SHADOW>), location);
-    });
-    
     _renderPassDescriptor = CLONE_METAL_CUSTOM_DELETER(MTL::RenderPassDescriptor, MTL::RenderPassDescriptor::alloc()->init());
     _renderPassDescriptor->depthAttachment()->setLoadAction(MTL::LoadActionClear);
     _renderPass = std::make_unique<RenderPass>(_library, *_renderPassDescriptor);
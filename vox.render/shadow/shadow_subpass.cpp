@@ -8,6 +8,7 @@
 #include "rendering/render_pass.h"
 #include "shadow_manager.h"
 #include "renderer.h"
+#include "mesh/model_mesh.h"
 #include "camera.h"
 #include "material.h"
 #include "metal_helpers.h"
@@ -68,7 +69,7 @@ void ShadowSubpass::drawMeshes(MTL::RenderCommandEncoder &renderEncoder) {
     std::vector<RenderElement> opaqueQueue;
     std::vector<RenderElement> alphaTestQueue;
     std::vector<RenderElement> transparentQueue;
-    _scene->_componentsManager.callRender(BoundingFrustum(_vp), opaqueQueue, alphaTestQueue, transparentQueue);
+    _scene->_componentsManager.callRender(BoundingFrustum(_vp), _camera, opaqueQueue, alphaTestQueue, transparentQueue);
     
     for (auto &element: opaqueQueue) {
         auto macros = compileMacros;
@@ -86,6 +87,11 @@ void ShadowSubpass::drawMeshes(MTL::RenderCommandEncoder &renderEncoder) {
             // manully
             auto &mesh = element.mesh;
             _shadowGenDescriptor->setVertexDescriptor(mesh->vertexDescriptor().get());
+            if (macros.isEnabled(HAS_QUANTIZED_POSITION)) {
+                // only enabled by MeshRenderer for a ModelMesh
+                const auto &quantization = std::static_pointer_cast<ModelMesh>(mesh)->positionQuantization();
+                renderEncoder.setVertexBytes(&quantization, sizeof(PositionQuantization), 13);
+            }
             auto _shadowGenPipelineState = _pass->resourceCache().requestPipelineState(*_shadowGenDescriptor);
             renderEncoder.setRenderPipelineState(&_shadowGenPipelineState->handle());
             
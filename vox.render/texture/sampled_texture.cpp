@@ -168,6 +168,7 @@ uint32_t bytesPerPixel(MTL::PixelFormat format) {
         case MTL::PixelFormatRG32Sint:
         case MTL::PixelFormatRGBA16Uint:
         case MTL::PixelFormatRGBA16Sint:
+        case MTL::PixelFormatRGBA16Float:
             return 8;
             break;
             
@@ -183,4 +184,98 @@ uint32_t bytesPerPixel(MTL::PixelFormat format) {
     }
 }
 
+bool astcBlockSize(MTL::PixelFormat format, uint32_t &blockWidth, uint32_t &blockHeight) {
+    switch (format) {
+        case MTL::PixelFormatASTC_4x4_LDR:
+        case MTL::PixelFormatASTC_4x4_sRGB:
+            blockWidth = 4;
+            blockHeight = 4;
+            return true;
+        case MTL::PixelFormatASTC_5x4_LDR:
+        case MTL::PixelFormatASTC_5x4_sRGB:
+            blockWidth = 5;
+            blockHeight = 4;
+            return true;
+        case MTL::PixelFormatASTC_5x5_LDR:
+        case MTL::PixelFormatASTC_5x5_sRGB:
+            blockWidth = 5;
+            blockHeight = 5;
+            return true;
+        case MTL::PixelFormatASTC_6x5_LDR:
+        case MTL::PixelFormatASTC_6x5_sRGB:
+            blockWidth = 6;
+            blockHeight = 5;
+            return true;
+        case MTL::PixelFormatASTC_6x6_LDR:
+        case MTL::PixelFormatASTC_6x6_sRGB:
+            blockWidth = 6;
+            blockHeight = 6;
+            return true;
+        case MTL::PixelFormatASTC_8x5_LDR:
+        case MTL::PixelFormatASTC_8x5_sRGB:
+            blockWidth = 8;
+            blockHeight = 5;
+            return true;
+        case MTL::PixelFormatASTC_8x6_LDR:
+        case MTL::PixelFormatASTC_8x6_sRGB:
+            blockWidth = 8;
+            blockHeight = 6;
+            return true;
+        case MTL::PixelFormatASTC_8x8_LDR:
+        case MTL::PixelFormatASTC_8x8_sRGB:
+            blockWidth = 8;
+            blockHeight = 8;
+            return true;
+        case MTL::PixelFormatASTC_10x5_LDR:
+        case MTL::PixelFormatASTC_10x5_sRGB:
+            blockWidth = 10;
+            blockHeight = 5;
+            return true;
+        case MTL::PixelFormatASTC_10x6_LDR:
+        case MTL::PixelFormatASTC_10x6_sRGB:
+            blockWidth = 10;
+            blockHeight = 6;
+            return true;
+        case MTL::PixelFormatASTC_10x8_LDR:
+        case MTL::PixelFormatASTC_10x8_sRGB:
+            blockWidth = 10;
+            blockHeight = 8;
+            return true;
+        case MTL::PixelFormatASTC_10x10_LDR:
+        case MTL::PixelFormatASTC_10x10_sRGB:
+            blockWidth = 10;
+            blockHeight = 10;
+            return true;
+        case MTL::PixelFormatASTC_12x10_LDR:
+        case MTL::PixelFormatASTC_12x10_sRGB:
+            blockWidth = 12;
+            blockHeight = 10;
+            return true;
+        case MTL::PixelFormatASTC_12x12_LDR:
+        case MTL::PixelFormatASTC_12x12_sRGB:
+            blockWidth = 12;
+            blockHeight = 12;
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint32_t bytesPerRow(MTL::PixelFormat format, uint32_t width) {
+    uint32_t blockWidth, blockHeight;
+    if (astcBlockSize(format, blockWidth, blockHeight)) {
+        // partial blocks at the edge are stored whole
+        return (width + blockWidth - 1) / blockWidth * 16;
+    }
+    return bytesPerPixel(format) * width;
+}
+
+uint32_t bytesPerImage(MTL::PixelFormat format, uint32_t width, uint32_t height) {
+    uint32_t blockWidth, blockHeight;
+    if (astcBlockSize(format, blockWidth, blockHeight)) {
+        return bytesPerRow(format, width) * ((height + blockHeight - 1) / blockHeight);
+    }
+    return bytesPerRow(format, width) * height;
+}
+
 }
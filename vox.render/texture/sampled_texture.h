@@ -12,6 +12,22 @@
 namespace vox {
 uint32_t bytesPerPixel(MTL::PixelFormat format);
 
+/**
+ * Texels covered by a block of 16 bytes.
+ * @returns false for the formats which store single pixels.
+ */
+bool astcBlockSize(MTL::PixelFormat format, uint32_t &blockWidth, uint32_t &blockHeight);
+
+/**
+ * Bytes of a row of pixels, or of a row of blocks for the block compressed formats.
+ */
+uint32_t bytesPerRow(MTL::PixelFormat format, uint32_t width);
+
+/**
+ * Bytes of a whole image of the given extent, as the blit encoder reads it from a buffer.
+ */
+uint32_t bytesPerImage(MTL::PixelFormat format, uint32_t width, uint32_t height);
+
 class SampledTexture {
 public:
     SampledTexture(MTL::Device &device);
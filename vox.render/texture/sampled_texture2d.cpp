@@ -57,8 +57,8 @@ void SampledTexture2D::setPixelBuffer(MTL::CommandQueue &queue,
     auto commandBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::CommandBuffer, queue.commandBuffer());
     auto blit = CLONE_METAL_CUSTOM_DELETER(MTL::BlitCommandEncoder, commandBuffer->blitCommandEncoder());
     blit->copyFromBuffer(stagingBuffer.get(), offset,
-                         bytesPerPixel(_textureDesc->pixelFormat()) * width,
-                         bytesPerPixel(_textureDesc->pixelFormat()) * width * height, MTL::Size(width, height, 1),
+                         bytesPerRow(_textureDesc->pixelFormat(), width),
+                         bytesPerImage(_textureDesc->pixelFormat(), width, height), MTL::Size(width, height, 1),
                          _nativeTexture.get(), 0, mipLevel, MTL::Origin(x, y, 0));
     blit->endEncoding();
     commandBuffer->commit();
@@ -66,24 +66,57 @@ void SampledTexture2D::setPixelBuffer(MTL::CommandQueue &queue,
 }
 
 void SampledTexture2D::setImageSource(MTL::CommandQueue &queue, const Image *image) {
-    std::vector<std::shared_ptr<MTL::Buffer>> stagingBuffers;
+    setImageSource(queue, image, 0);
+}
+
+void SampledTexture2D::setImageSource(MTL::CommandQueue &queue, const Image *image, uint32_t firstLevel) {
+    const auto &mipmaps = image->mipmaps();
+    const auto &extent = mipmaps.at(firstLevel).extent;
+    const auto levelCount = static_cast<uint32_t>(mipmaps.size()) - firstLevel;
+    if (_textureDesc->width() != extent.width || _textureDesc->height() != extent.height ||
+        _textureDesc->mipmapLevelCount() != levelCount) {
+        _textureDesc->setWidth(extent.width);
+        _textureDesc->setHeight(extent.height);
+        _textureDesc->setMipmapLevelCount(levelCount);
+        _nativeTexture = CLONE_METAL_CUSTOM_DELETER(MTL::Texture, _device.newTexture(_textureDesc.get()));
+    }
     
+    // one staging buffer holds every level
+    auto stagingBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _device.newBuffer(image->data().data(), image->data().size(),
+                                                                                   MTL::ResourceOptionCPUCacheModeDefault));
     auto commandBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::CommandBuffer, queue.commandBuffer());
     auto blit = CLONE_METAL_CUSTOM_DELETER(MTL::BlitCommandEncoder, commandBuffer->blitCommandEncoder());
-    for (const auto &mipmap: image->mipmaps()) {
-        auto stagingBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::Buffer, _device.newBuffer(image->data().data(), image->data().size(),
-                                                                                       MTL::ResourceOptionCPUCacheModeDefault));
-        stagingBuffers.push_back(stagingBuffer);
+    for (uint32_t level = firstLevel; level < mipmaps.size(); level++) {
+        const auto &mipmap = mipmaps[level];
         blit->copyFromBuffer(stagingBuffer.get(), mipmap.offset,
-                             bytesPerPixel(_textureDesc->pixelFormat()) * mipmap.extent.width,
-                             bytesPerPixel(_textureDesc->pixelFormat()) * mipmap.extent.width * mipmap.extent.height,
+                             bytesPerRow(_textureDesc->pixelFormat(), mipmap.extent.width),
+                             bytesPerImage(_textureDesc->pixelFormat(), mipmap.extent.width, mipmap.extent.height),
                              MTL::Size(mipmap.extent.width, mipmap.extent.height, 1),
-                             _nativeTexture.get(), 0, mipmap.level, MTL::Origin(0, 0, 0));
+                             _nativeTexture.get(), 0, level - firstLevel, MTL::Origin(0, 0, 0));
     }
     blit->endEncoding();
     commandBuffer->commit();
     commandBuffer->waitUntilCompleted();
 }
 
+void SampledTexture2D::trimLevels(MTL::CommandQueue &queue, uint32_t levels) {
+    const auto levelCount = static_cast<uint32_t>(_textureDesc->mipmapLevelCount());
+    if (levels == 0 || levels >= levelCount) {
+        return;
+    }
+    _textureDesc->setWidth(std::max<NS::UInteger>(1, _textureDesc->width() >> levels));
+    _textureDesc->setHeight(std::max<NS::UInteger>(1, _textureDesc->height() >> levels));
+    _textureDesc->setMipmapLevelCount(levelCount - levels);
+    auto trimmed = CLONE_METAL_CUSTOM_DELETER(MTL::Texture, _device.newTexture(_textureDesc.get()));
+    
+    auto commandBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::CommandBuffer, queue.commandBuffer());
+    auto blit = CLONE_METAL_CUSTOM_DELETER(MTL::BlitCommandEncoder, commandBuffer->blitCommandEncoder());
+    blit->copyFromTexture(_nativeTexture.get(), 0, levels, trimmed.get(), 0, 0,
+                          _textureDesc->arrayLength(), levelCount - levels);
+    blit->endEncoding();
+    commandBuffer->commit();
+    commandBuffer->waitUntilCompleted();
+    _nativeTexture = trimmed;
+}
 
 }
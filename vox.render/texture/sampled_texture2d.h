@@ -41,6 +41,18 @@ public:
     
     void setImageSource(MTL::CommandQueue &queue, const Image *data);
     
+    /**
+     * Upload levels firstLevel and smaller of an image, which become the levels of the texture from 0.
+     * @remarks The native texture is created again when its size changes.
+     */
+    void setImageSource(MTL::CommandQueue &queue, const Image *image, uint32_t firstLevel);
+    
+    /**
+     * Release the largest levels, the others are copied on the GPU into a smaller native texture.
+     * @param levels - Number of levels to drop
+     */
+    void trimLevels(MTL::CommandQueue &queue, uint32_t levels);
+    
 protected:
     SampledTexture2D(MTL::Device &device);
 };
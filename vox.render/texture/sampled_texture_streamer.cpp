@@ -0,0 +1,55 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "sampled_texture_streamer.h"
+
+namespace vox {
+SampledTextureStreamer::SampledTextureStreamer(MTL::Device &device, MTL::CommandQueue &queue, size_t budget) :
+_device(device),
+_queue(queue),
+_streamer(*this, budget) {
+}
+
+SampledTexture2DPtr SampledTextureStreamer::add(std::shared_ptr<const Image> image, TextureStreamer::Loader loader) {
+    const auto id = _streamer.add(std::move(image), std::move(loader));
+    const auto &texture = _textures.at(id);
+    _ids[texture.get()] = id;
+    return texture;
+}
+
+void SampledTextureStreamer::request(const SampledTexture *texture, float screenPixels) {
+    const auto iter = _ids.find(texture);
+    if (iter != _ids.end()) {
+        _streamer.request(iter->second, _streamer.requiredLevel(iter->second, screenPixels));
+    }
+}
+
+void SampledTextureStreamer::update() {
+    _streamer.update();
+}
+
+TextureStreamer &SampledTextureStreamer::streamer() {
+    return _streamer;
+}
+
+void SampledTextureStreamer::upload(uint32_t texture, const Image &image, uint32_t firstLevel) {
+    if (texture >= _textures.size()) {
+        // called by TextureStreamer::add for a new texture
+        const auto &extent = image.mipmaps().at(firstLevel).extent;
+        _textures.push_back(std::make_shared<SampledTexture2D>(_device, extent.width, extent.height, 1,
+                                                               image.mipmaps().size() > 1, image.format()));
+        _firstLevels.push_back(firstLevel);
+    }
+    _textures[texture]->setImageSource(_queue, &image, firstLevel);
+    _firstLevels[texture] = firstLevel;
+}
+
+void SampledTextureStreamer::trim(uint32_t texture, uint32_t firstLevel) {
+    _textures.at(texture)->trimLevels(_queue, firstLevel - _firstLevels[texture]);
+    _firstLevels[texture] = firstLevel;
+}
+
+}
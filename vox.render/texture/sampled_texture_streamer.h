@@ -0,0 +1,59 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef sampled_texture_streamer_hpp
+#define sampled_texture_streamer_hpp
+
+#include "texture/sampled_texture2d.h"
+#include "texture/texture_streamer.h"
+#include <unordered_map>
+
+namespace vox {
+/**
+ * Streams SampledTexture2D objects, which keep their identity while their levels are replaced.
+ */
+class SampledTextureStreamer : public TextureStreamingBackend {
+public:
+    /**
+     * @param budget - Bytes of the resident levels of all streamed textures
+     */
+    SampledTextureStreamer(MTL::Device &device, MTL::CommandQueue &queue, size_t budget);
+    
+    /**
+     * Create a texture holding the small levels of an image.
+     * @param loader - Source of the larger levels, the image is kept in memory instead when it is empty
+     */
+    SampledTexture2DPtr add(std::shared_ptr<const Image> image, TextureStreamer::Loader loader = nullptr);
+    
+    /**
+     * Ask for the level which draws a texture over screenPixels pixels, textures which are not streamed are ignored.
+     */
+    void request(const SampledTexture *texture, float screenPixels);
+    
+    /**
+     * Called once per frame after the requests.
+     */
+    void update();
+    
+    TextureStreamer &streamer();
+    
+    void upload(uint32_t texture, const Image &image, uint32_t firstLevel) override;
+    
+    void trim(uint32_t texture, uint32_t firstLevel) override;
+    
+private:
+    MTL::Device &_device;
+    MTL::CommandQueue &_queue;
+    std::vector<SampledTexture2DPtr> _textures{};
+    // first level held by each native texture
+    std::vector<uint32_t> _firstLevels{};
+    std::unordered_map<const SampledTexture *, uint32_t> _ids{};
+    TextureStreamer _streamer;
+};
+
+}
+
+#endif /* sampled_texture_streamer_hpp */
@@ -6,6 +6,7 @@
 
 #include "sampled_texturecube.h"
 #include "metal_helpers.h"
+#include <algorithm>
 #include <array>
 
 namespace vox {
@@ -54,7 +55,7 @@ SampledTexture2DViewPtr SampledTextureCube::textureView2D(uint32_t mipmapLevel,
     });
 }
 
-void SampledTextureCube::setPixelBuffer(MTL::CommandQueue &queue, std::array<Image *, 6> images) {
+void SampledTextureCube::setPixelBuffer(MTL::CommandQueue &queue, std::array<const Image *, 6> images) {
     std::vector<std::shared_ptr<MTL::Buffer>> stagingBuffers;
     
     auto commandBuffer = CLONE_METAL_CUSTOM_DELETER(MTL::CommandBuffer, queue.commandBuffer());
@@ -67,14 +68,18 @@ void SampledTextureCube::setPixelBuffer(MTL::CommandQueue &queue, std::array<Ima
                                                                                        MTL::ResourceOptionCPUCacheModeDefault));
         stagingBuffers.push_back(stagingBuffer);
         
-        auto width = image->mipmaps().at(0).extent.width;
-        auto height = image->mipmaps().at(0).extent.height;
-        auto offset = image->mipmaps().at(0).offset;
-        blit->copyFromBuffer(stagingBuffer.get(), offset,
-                             bytesPerPixel(_textureDesc->pixelFormat()) * width,
-                             bytesPerPixel(_textureDesc->pixelFormat()) * width * height,
-                             MTL::Size(width, height, 1),
-                             _nativeTexture.get(), i, 0, MTL::Origin(0, 0, 0));
+        // every level the image and the texture both have
+        const auto levels = std::min<size_t>(image->mipmaps().size(), _textureDesc->mipmapLevelCount());
+        for (uint32_t level = 0; level < levels; level++) {
+            auto width = image->mipmaps().at(level).extent.width;
+            auto height = image->mipmaps().at(level).extent.height;
+            auto offset = image->mipmaps().at(level).offset;
+            blit->copyFromBuffer(stagingBuffer.get(), offset,
+                                 bytesPerRow(_textureDesc->pixelFormat(), width),
+                                 bytesPerImage(_textureDesc->pixelFormat(), width, height),
+                                 MTL::Size(width, height, 1),
+                                 _nativeTexture.get(), i, level, MTL::Origin(0, 0, 0));
+        }
     }
     blit->endEncoding();
     commandBuffer->commit();
@@ -34,7 +34,7 @@ public:
     
     SampledTexture2DViewPtr textureView2D(uint32_t mipmapLevel, uint32_t layer);
     
-    void setPixelBuffer(MTL::CommandQueue &queue, std::array<Image *, 6> images);
+    void setPixelBuffer(MTL::CommandQueue &queue, std::array<const Image *, 6> images);
 };
 
 using SampledTextureCubePtr = std::shared_ptr<SampledTextureCube>;
@@ -0,0 +1,265 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "texture_streamer.h"
+#include "thread_pool.h"
+#include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+
+namespace vox {
+TextureStreamer::Loader TextureStreamer::fileLoader(const std::string &uri, bool flipY) {
+    return [uri, flipY]() {
+        return Image::load(uri, flipY);
+    };
+}
+
+TextureStreamer::TextureStreamer(TextureStreamingBackend &backend, size_t budget, bool async) :
+_backend(backend),
+_budget(budget),
+_async(async) {
+}
+
+size_t TextureStreamer::budget() const {
+    return _budget;
+}
+
+void TextureStreamer::setBudget(size_t budget) {
+    _budget = budget;
+}
+
+uint32_t TextureStreamer::add(std::shared_ptr<const Image> image, Loader loader) {
+    if (_needsMipmaps(*image)) {
+        // the image may be shared through the image cache
+        auto chain = std::make_shared<Image>(*image);
+        chain->generateMipmaps();
+        image = std::move(chain);
+    }
+
+    Entry entry;
+    entry.levelBytes = _levelBytes(*image);
+    entry.size = static_cast<uint32_t>(std::max(image->extent().width, image->extent().height));
+    const auto levels = static_cast<uint32_t>(entry.levelBytes.size());
+    while (entry.minimumLevel + 1 < levels && (entry.size >> entry.minimumLevel) > residentSize) {
+        entry.minimumLevel++;
+    }
+    entry.residentLevel = entry.minimumLevel;
+    entry.requestedLevel = levels;
+    entry.targetLevel = entry.minimumLevel;
+    entry.lastUsed = _frame;
+    if (loader) {
+        entry.loader = std::move(loader);
+    } else {
+        entry.source = image;
+    }
+
+    const auto texture = static_cast<uint32_t>(_entries.size());
+    _backend.upload(texture, *image, entry.minimumLevel);
+    _statistics.residentBytes += _bytes(entry, entry.minimumLevel);
+    _entries.emplace_back(std::move(entry));
+    return texture;
+}
+
+size_t TextureStreamer::textureCount() const {
+    return _entries.size();
+}
+
+void TextureStreamer::request(uint32_t texture, uint32_t level) {
+    auto &entry = _entries.at(texture);
+    entry.requestedLevel = std::min(entry.requestedLevel, level);
+    entry.lastUsed = _frame;
+}
+
+uint32_t TextureStreamer::requiredLevel(uint32_t texture, float screenPixels) const {
+    const auto &entry = _entries.at(texture);
+    const auto lastLevel = static_cast<uint32_t>(entry.levelBytes.size() - 1);
+    if (screenPixels <= 1) {
+        return lastLevel;
+    }
+    const float level = std::floor(std::log2(entry.size / screenPixels));
+    return level <= 0 ? 0 : std::min(lastLevel, static_cast<uint32_t>(level));
+}
+
+void TextureStreamer::update() {
+    for (uint32_t i = 0; i < _entries.size(); i++) {
+        auto &entry = _entries[i];
+        if (entry.loading && entry.pending.valid() &&
+            entry.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            _finishLoad(i, entry.pending.get().get());
+        }
+    }
+
+    // textures which were not requested fall back to the levels they always keep
+    std::vector<uint32_t> growing;
+    for (uint32_t i = 0; i < _entries.size(); i++) {
+        auto &entry = _entries[i];
+        entry.targetLevel = std::min(entry.requestedLevel, entry.minimumLevel);
+        entry.requestedLevel = static_cast<uint32_t>(entry.levelBytes.size());
+        if (entry.targetLevel < entry.residentLevel && !entry.loading && (entry.loader || entry.source)) {
+            growing.push_back(i);
+        }
+    }
+    // most missing levels first
+    std::stable_sort(growing.begin(), growing.end(), [&](uint32_t a, uint32_t b) {
+        return _entries[a].residentLevel - _entries[a].targetLevel > _entries[b].residentLevel - _entries[b].targetLevel;
+    });
+
+    _reserve(0);
+    _statistics.starved = 0;
+    for (const auto i : growing) {
+        if (_statistics.pendingLoads >= maxPendingLoads) {
+            break;
+        }
+        const auto &entry = _entries[i];
+        uint32_t level = entry.targetLevel;
+        while (level < entry.residentLevel && !_reserve(_bytes(entry, level) - _bytes(entry, entry.residentLevel))) {
+            level++;
+        }
+        if (level > entry.targetLevel) {
+            _statistics.starved++;
+        }
+        if (level < entry.residentLevel) {
+            _load(i, level);
+        }
+    }
+    _frame++;
+}
+
+void TextureStreamer::finishLoads() {
+    for (uint32_t i = 0; i < _entries.size(); i++) {
+        auto &entry = _entries[i];
+        if (entry.loading && entry.pending.valid()) {
+            _finishLoad(i, entry.pending.get().get());
+        }
+    }
+}
+
+uint32_t TextureStreamer::residentLevel(uint32_t texture) const {
+    return _entries.at(texture).residentLevel;
+}
+
+uint32_t TextureStreamer::levelCount(uint32_t texture) const {
+    return static_cast<uint32_t>(_entries.at(texture).levelBytes.size());
+}
+
+const TextureStreamingStatistics &TextureStreamer::statistics() const {
+    return _statistics;
+}
+
+std::vector<size_t> TextureStreamer::_levelBytes(const Image &image) {
+    // levels are stored in any order, each one ends where the next offset or the data starts
+    std::vector<size_t> offsets;
+    for (const auto &mipmap : image.mipmaps()) {
+        offsets.push_back(mipmap.offset);
+    }
+    offsets.push_back(image.data().size());
+    std::sort(offsets.begin(), offsets.end());
+
+    std::vector<size_t> bytes;
+    for (const auto &mipmap : image.mipmaps()) {
+        const auto end = std::upper_bound(offsets.begin(), offsets.end(), size_t(mipmap.offset));
+        bytes.push_back(end == offsets.end() ? 0 : *end - mipmap.offset);
+    }
+    return bytes;
+}
+
+bool TextureStreamer::_needsMipmaps(const Image &image) {
+    const auto &extent = image.extent();
+    return image.mipmaps().size() == 1 && extent.width * extent.height > 1 &&
+    (image.format() == MTL::PixelFormatRGBA8Unorm || image.format() == MTL::PixelFormatRGBA8Unorm_sRGB);
+}
+
+void TextureStreamer::_generateMipmaps(Image &image) {
+    if (_needsMipmaps(image)) {
+        image.generateMipmaps();
+    }
+}
+
+std::unique_ptr<Image> TextureStreamer::_decode(const Loader &loader) {
+    try {
+        auto image = loader();
+        if (image) {
+            _generateMipmaps(*image);
+        }
+        return image;
+    } catch (const std::exception &e) {
+        LOG(ERROR) << "Failed to stream texture: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+size_t TextureStreamer::_bytes(const Entry &entry, uint32_t firstLevel) {
+    size_t bytes = 0;
+    for (size_t i = firstLevel; i < entry.levelBytes.size(); i++) {
+        bytes += entry.levelBytes[i];
+    }
+    return bytes;
+}
+
+bool TextureStreamer::_reserve(size_t extra) {
+    while (_statistics.residentBytes + _statistics.pendingBytes + extra > _budget) {
+        // least recently used texture holding more than it needs
+        Entry *victim = nullptr;
+        uint32_t victimIndex = 0;
+        for (uint32_t i = 0; i < _entries.size(); i++) {
+            auto &entry = _entries[i];
+            if (entry.loading || entry.residentLevel >= entry.targetLevel) {
+                continue;
+            }
+            if (victim == nullptr || entry.lastUsed < victim->lastUsed) {
+                victim = &entry;
+                victimIndex = i;
+            }
+        }
+        if (victim == nullptr) {
+            return false;
+        }
+        _statistics.residentBytes -= _bytes(*victim, victim->residentLevel) - _bytes(*victim, victim->targetLevel);
+        _statistics.evictions++;
+        victim->residentLevel = victim->targetLevel;
+        _backend.trim(victimIndex, victim->residentLevel);
+    }
+    return true;
+}
+
+void TextureStreamer::_load(uint32_t texture, uint32_t level) {
+    auto &entry = _entries[texture];
+    entry.loading = true;
+    entry.loadingLevel = level;
+    entry.loadingBytes = _bytes(entry, level) - _bytes(entry, entry.residentLevel);
+    _statistics.pendingBytes += entry.loadingBytes;
+    _statistics.pendingLoads++;
+
+    if (entry.source) {
+        _finishLoad(texture, entry.source.get());
+    } else if (_async) {
+        entry.pending = ThreadPool::shared().enqueue([loader = entry.loader]() {
+            return _decode(loader);
+        });
+    } else {
+        _finishLoad(texture, _decode(entry.loader).get());
+    }
+}
+
+void TextureStreamer::_finishLoad(uint32_t texture, const Image *image) {
+    auto &entry = _entries[texture];
+    entry.loading = false;
+    _statistics.pendingBytes -= entry.loadingBytes;
+    _statistics.pendingLoads--;
+
+    if (image == nullptr || image->mipmaps().size() != entry.levelBytes.size()) {
+        // keep what is resident and stop streaming this texture
+        LOG(ERROR) << "Streamed texture " << texture << " does not match its resident levels" << std::endl;
+        entry.loader = nullptr;
+        entry.minimumLevel = entry.residentLevel;
+        return;
+    }
+    _backend.upload(texture, *image, entry.loadingLevel);
+    _statistics.residentBytes += entry.loadingBytes;
+    entry.residentLevel = entry.loadingLevel;
+}
+
+}
@@ -0,0 +1,175 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef texture_streamer_hpp
+#define texture_streamer_hpp
+
+#include "image/image.h"
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace vox {
+/**
+ * GPU side of texture streaming, makes the levels chosen by TextureStreamer resident.
+ */
+class TextureStreamingBackend {
+public:
+    virtual ~TextureStreamingBackend() = default;
+
+    /**
+     * Make levels firstLevel and smaller of a texture resident, replacing the levels it holds.
+     * @param texture - Id returned by TextureStreamer::add
+     * @param image - Whole mip chain of the texture
+     */
+    virtual void upload(uint32_t texture, const Image &image, uint32_t firstLevel) = 0;
+
+    /**
+     * Release the levels larger than firstLevel, the smaller ones stay resident.
+     */
+    virtual void trim(uint32_t texture, uint32_t firstLevel) = 0;
+};
+
+struct TextureStreamingStatistics {
+    /** Bytes of the resident levels of every texture. */
+    size_t residentBytes{0};
+    /** Bytes the loads in flight add once they are uploaded. */
+    size_t pendingBytes{0};
+    uint32_t pendingLoads{0};
+    /** Textures which gave up levels to stay in the budget, since the streamer was created. */
+    uint32_t evictions{0};
+    /** Requests of the last update which got a smaller level than asked because of the budget. */
+    uint32_t starved{0};
+};
+
+/**
+ * Keeps the small levels of every texture resident and loads the larger ones when they are requested.
+ * @remarks Textures which were not requested lately give their levels back first when the budget is reached.
+ * The decoding runs on the shared thread pool, the backend is only called from add() and update().
+ */
+class TextureStreamer {
+public:
+    /**
+     * Decodes the whole texture again, called on a worker thread.
+     * @remarks Mipmaps are generated for images with a single RGBA8 level.
+     */
+    using Loader = std::function<std::unique_ptr<Image>()>;
+
+    /**
+     * Loader of a KTX, ASTC, PNG or JPG file.
+     * @param uri - Path relative to the assets
+     */
+    static Loader fileLoader(const std::string &uri, bool flipY = false);
+
+    /**
+     * @param budget - Bytes of the resident levels of all textures
+     * @param async - Run loaders on the shared thread pool, otherwise inside update()
+     */
+    TextureStreamer(TextureStreamingBackend &backend, size_t budget, bool async = true);
+
+    /** Largest side of the levels which are uploaded by add() and never evicted. */
+    uint32_t residentSize = 64;
+
+    /** Loads in flight at the same time. */
+    uint32_t maxPendingLoads = 4;
+
+    size_t budget() const;
+
+    /**
+     * Levels above the budget are evicted by the next update.
+     */
+    void setBudget(size_t budget);
+
+    /**
+     * Register a texture and upload its small levels.
+     * @param image - Decoded texture, mipmaps are generated on a copy for a single RGBA8 level
+     * @param loader - Source of the larger levels, the image is kept in memory instead when it is empty
+     * @returns Id of the texture for the backend and request().
+     */
+    uint32_t add(std::shared_ptr<const Image> image, Loader loader = nullptr);
+
+    size_t textureCount() const;
+
+    /**
+     * Ask for a level of a texture in this frame, the most detailed level asked for wins.
+     */
+    void request(uint32_t texture, uint32_t level);
+
+    /**
+     * Level which draws the texture over screenPixels pixels with about one texel per pixel.
+     */
+    uint32_t requiredLevel(uint32_t texture, float screenPixels) const;
+
+    /**
+     * Upload finished loads, then evict and start loads for the requests of this frame.
+     */
+    void update();
+
+    /**
+     * Wait for the loads in flight and upload them.
+     */
+    void finishLoads();
+
+    /** Largest resident level. */
+    uint32_t residentLevel(uint32_t texture) const;
+
+    uint32_t levelCount(uint32_t texture) const;
+
+    const TextureStreamingStatistics &statistics() const;
+
+private:
+    struct Entry {
+        // bytes of each level
+        std::vector<size_t> levelBytes{};
+        uint32_t size{0};
+        // levels from minimumLevel are always resident
+        uint32_t minimumLevel{0};
+        uint32_t residentLevel{0};
+        // largest level requested in this frame, or the level count
+        uint32_t requestedLevel{0};
+        uint32_t targetLevel{0};
+        uint64_t lastUsed{0};
+
+        Loader loader{nullptr};
+        // in memory source when there is no loader
+        std::shared_ptr<const Image> source{nullptr};
+
+        bool loading{false};
+        uint32_t loadingLevel{0};
+        size_t loadingBytes{0};
+        std::future<std::unique_ptr<Image>> pending{};
+    };
+
+    static std::vector<size_t> _levelBytes(const Image &image);
+
+    // whether the image is a single RGBA8 level, which gets a full chain
+    static bool _needsMipmaps(const Image &image);
+
+    static void _generateMipmaps(Image &image);
+
+    static std::unique_ptr<Image> _decode(const Loader &loader);
+
+    static size_t _bytes(const Entry &entry, uint32_t firstLevel);
+
+    // evict least recently used levels until extra bytes fit into the budget
+    bool _reserve(size_t extra);
+
+    void _load(uint32_t texture, uint32_t level);
+
+    void _finishLoad(uint32_t texture, const Image *image);
+
+    TextureStreamingBackend &_backend;
+    size_t _budget;
+    bool _async;
+    uint64_t _frame{0};
+    std::vector<Entry> _entries{};
+    TextureStreamingStatistics _statistics{};
+};
+
+}
+
+#endif /* texture_streamer_hpp */
@@ -0,0 +1,62 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "thread_pool.h"
+
+namespace vox {
+ThreadPool &ThreadPool::shared() {
+    // leaked, jobs may still run while static objects are destroyed
+    static auto *pool = new ThreadPool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    return *pool;
+}
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    threadCount = std::max(threadCount, size_t(1));
+    _workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        _workers.emplace_back(&ThreadPool::_workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_all();
+    for (auto &worker : _workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::_push(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push(std::move(job));
+    }
+    _condition.notify_one();
+}
+
+void ThreadPool::_workerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() {
+                return _stop || !_jobs.empty();
+            });
+            // remaining jobs are finished before the workers exit
+            if (_jobs.empty()) {
+                return;
+            }
+            job = std::move(_jobs.front());
+            _jobs.pop();
+        }
+        job();
+    }
+}
+
+}
@@ -0,0 +1,147 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef thread_pool_hpp
+#define thread_pool_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace vox {
+/**
+ * Fixed set of worker threads which run queued jobs.
+ * @remarks vox.math/parallel.h stays for the math and geometry libraries, which are built below vox.render and
+ * switch between TBB, OpenMP and a thread per range at compile time. Engine systems use this pool, whose workers
+ * persist across frames and which allows parallelFor from inside a job.
+ */
+class ThreadPool {
+public:
+    /**
+     * Pool shared by the engine, with one worker less than the hardware threads.
+     */
+    static ThreadPool &shared();
+
+    /**
+     * @param threadCount - Number of workers, at least one
+     */
+    explicit ThreadPool(size_t threadCount);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t threadCount() const {
+        return _workers.size();
+    }
+
+    /**
+     * Queue a job.
+     * @returns The future of the job result, an exception thrown by the job is rethrown by its get.
+     */
+    template<class F>
+    auto enqueue(F &&job) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+        auto future = task->get_future();
+        _push([task]() {
+            (*task)();
+        });
+        return future;
+    }
+
+    /**
+     * Call function(i) for i in [0, count), the calling thread takes part and returns when all calls are done.
+     * @remarks Safe to call from a job of the same pool, the caller never waits for a job which is not started.
+     * If a call throws, the indices which are not started yet are skipped and the first exception is rethrown
+     * on the calling thread once every started call returned.
+     */
+    template<class F>
+    void parallelFor(size_t count, const F &function) {
+        if (count == 0) {
+            return;
+        }
+        if (count == 1 || _workers.empty()) {
+            for (size_t i = 0; i < count; i++) {
+                function(i);
+            }
+            return;
+        }
+
+        struct State {
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> finished{0};
+            std::atomic<bool> failed{false};
+            std::exception_ptr error{nullptr};
+            std::mutex mutex;
+            std::condition_variable done;
+        };
+        auto state = std::make_shared<State>();
+        auto run = [state, count, &function]() {
+            size_t ran = 0;
+            for (size_t i = state->next++; i < count; i = state->next++) {
+                // an exception must not leave a worker, the calls after it are only counted
+                if (!state->failed.load(std::memory_order_relaxed)) {
+                    try {
+                        function(i);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        if (!state->error) {
+                            state->error = std::current_exception();
+                        }
+                        state->failed = true;
+                    }
+                }
+                ran++;
+            }
+            if (ran > 0 && state->finished.fetch_add(ran) + ran == count) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->done.notify_all();
+            }
+        };
+
+        const size_t helpers = std::min(count - 1, _workers.size());
+        for (size_t i = 0; i < helpers; i++) {
+            // late helpers find no index left and return without touching function
+            _push(run);
+        }
+        run();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [&]() {
+            return state->finished.load() == count;
+        });
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+
+private:
+    void _push(std::function<void()> job);
+
+    void _workerLoop();
+
+    std::vector<std::thread> _workers{};
+    std::queue<std::function<void()>> _jobs{};
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stop{false};
+};
+
+}
+
+#endif /* thread_pool_hpp */
@@ -164,6 +164,15 @@ void Transform::setLocalMatrix(const Matrix4x4F &value) {
     _updateAllWorldFlag();
 }
 
+void Transform::setTRS(const Point3F &position, const QuaternionF &rotation, const Vector3F &scale) {
+    _position = position;
+    _rotationQuaternion = rotation;
+    _scale = scale;
+    _setDirtyFlagTrue(TransformFlag::LocalMatrix | TransformFlag::LocalEuler);
+    _setDirtyFlagFalse(TransformFlag::LocalQuat);
+    _updateAllWorldFlag();
+}
+
 Matrix4x4F Transform::worldMatrix() {
     if (_isContainDirtyFlag(TransformFlag::WorldMatrix)) {
         const auto parent = _getParentTransform();
@@ -121,6 +121,11 @@ public:
     
     void setLocalMatrix(const Matrix4x4F &value);
     
+    /**
+     * Set local position, rotation and scale, the world dirty flags are propagated once.
+     */
+    void setTRS(const Point3F &position, const QuaternionF &rotation, const Vector3F &scale);
+    
     /**
      * World matrix.
      * @remarks Need to re-assign after modification to ensure that the modification takes effect.
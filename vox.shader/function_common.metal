@@ -20,3 +20,16 @@ float4x4 getJointMatrix(sampler smp, texture2d<float> joint_tex,
     
     return float4x4(m0, m1, m2, m3);
 }
+
+// see vertex_compression.h for the encoders
+float3 decodeOctahedral(float2 encoded) {
+    float3 n = float3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = max(-n.z, 0.0);
+    n.xy += select(float2(t), float2(-t), n.xy >= 0.0);
+    return normalize(n);
+}
+
+float4 decodeOctahedralTangent(float2 encoded) {
+    float y = clamp((abs(encoded.y) - 0.5) * 4.0 - 1.0, -1.0, 1.0);
+    return float4(decodeOctahedral(float2(encoded.x, y)), encoded.y < 0.0 ? -1.0 : 1.0);
+}
@@ -16,6 +16,8 @@ constant bool hasUV [[function_constant(HAS_UV)]];
 constant bool hasNormal [[function_constant(HAS_NORMAL)]];
 constant bool hasTangent [[function_constant(HAS_TANGENT)]];
 constant bool hasVertexColor [[function_constant(HAS_VERTEXCOLOR)]];
+constant bool hasCompressedNormal [[function_constant(HAS_COMPRESSED_NORMAL)]];
+constant bool hasQuantizedPosition [[function_constant(HAS_QUANTIZED_POSITION)]];
 constant bool omitNormal [[function_constant(OMIT_NORMAL)]];
 constant bool notOmitNormalAndHasNormal = !omitNormal && hasNormal;
 constant bool notOmitNormalAndHasTangent = !omitNormal && hasTangent;
@@ -76,4 +78,8 @@ constant bool hasCubeShadow = cubeShadowMapCount > 0;
 float4x4 getJointMatrix(sampler smp, texture2d<float> joint_tex,
                         float index, int u_jointCount);
 
+float3 decodeOctahedral(float2 encoded);
+
+float4 decodeOctahedralTangent(float2 encoded);
+
 #endif // function_constant_h
@@ -18,6 +18,8 @@ enum MacroName {
     HAS_NORMAL,
     HAS_TANGENT,
     HAS_VERTEXCOLOR,
+    HAS_COMPRESSED_NORMAL,
+    HAS_QUANTIZED_POSITION,
     
     // Blend Shape
     HAS_BLENDSHAPE,
@@ -59,19 +59,24 @@ vertex VertexOut vertex_pbr(const VertexIn in [[stage_in]],
                             texture2d<float> u_jointTexture [[texture(0), function_constant(hasSkinAndHasJointTexture)]],
                             constant int &u_jointCount [[buffer(21), function_constant(hasSkinAndHasJointTexture)]],
                             constant matrix_float4x4 *u_jointMatrix [[buffer(22), function_constant(hasSkinNotHasJointTexture)]],
-                            constant float *u_blendShapeWeights [[buffer(23), function_constant(hasBlendShape)]]) {
+                            constant float *u_blendShapeWeights [[buffer(23), function_constant(hasBlendShape)]],
+                            constant PositionQuantization &u_positionQuantization [[buffer(24), function_constant(hasQuantizedPosition)]]) {
     VertexOut out;
     
     // begin position
-    float4 position = float4( in.position, 1.0);
+    float3 localPosition = in.position;
+    if (hasQuantizedPosition) {
+        localPosition = localPosition * u_positionQuantization.scale.xyz + u_positionQuantization.offset.xyz;
+    }
+    float4 position = float4( localPosition, 1.0);
     
     //begin normal
     float3 normal;
     float4 tangent;
     if (hasNormal) {
-        normal = in.NORMAL;
+        normal = hasCompressedNormal ? decodeOctahedral(in.NORMAL.xy) : in.NORMAL;
         if (hasTangent && hasNormalTexture) {
-            tangent = in.TANGENT;
+            tangent = hasCompressedNormal ? decodeOctahedralTangent(in.TANGENT.xy) : in.TANGENT;
         }
     }
     
@@ -159,7 +164,7 @@ vertex VertexOut vertex_pbr(const VertexIn in [[stage_in]],
     }
     
     if (hasShadow) {
-        out.view_pos = (u_MVMat * float4( in.position, 1.0)).xyz;
+        out.view_pos = (u_MVMat * float4( localPosition, 1.0)).xyz;
     }
     
     out.position = u_MVPMat * position;
@@ -27,6 +27,14 @@ typedef enum {
     UV_7 = 14,
 } Attributes;
 
+/**
+ * Maps unorm16 positions to object space: position * scale + offset.
+ */
+struct PositionQuantization {
+    vector_float4 scale;
+    vector_float4 offset;
+};
+
 struct EnvMapLight {
     vector_float3 diffuse;
     float diffuseIntensity;
@@ -32,6 +32,11 @@ typedef struct {
 
 vertex float4 vertex_depth(const VertexIn vertexIn [[ stage_in ]],
                            constant matrix_float4x4 &vp [[buffer(11)]],
-                           constant matrix_float4x4 &modelMatrix [[buffer(12)]]) {
-    return vp * modelMatrix * float4(vertexIn.position, 1.0);
+                           constant matrix_float4x4 &modelMatrix [[buffer(12)]],
+                           constant PositionQuantization &u_positionQuantization [[buffer(13), function_constant(hasQuantizedPosition)]]) {
+    float3 position = vertexIn.position;
+    if (hasQuantizedPosition) {
+        position = position * u_positionQuantization.scale.xyz + u_positionQuantization.offset.xyz;
+    }
+    return vp * modelMatrix * float4(position, 1.0);
 }
@@ -42,11 +42,16 @@ vertex VertexOut vertex_unlit(const VertexIn in [[stage_in]],
                               texture2d<float> u_jointTexture [[texture(0), function_constant(hasSkinAndHasJointTexture)]],
                               constant int &u_jointCount [[buffer(11), function_constant(hasSkinAndHasJointTexture)]],
                               constant matrix_float4x4 *u_jointMatrix [[buffer(12), function_constant(hasSkinNotHasJointTexture)]],
-                              constant float *u_blendShapeWeights [[buffer(13), function_constant(hasBlendShape)]]) {
+                              constant float *u_blendShapeWeights [[buffer(13), function_constant(hasBlendShape)]],
+                              constant PositionQuantization &u_positionQuantization [[buffer(14), function_constant(hasQuantizedPosition)]]) {
     VertexOut out;
     
     // begin position
-    float4 position = float4( in.position, 1.0);
+    float3 localPosition = in.position;
+    if (hasQuantizedPosition) {
+        localPosition = localPosition * u_positionQuantization.scale.xyz + u_positionQuantization.offset.xyz;
+    }
+    float4 position = float4( localPosition, 1.0);
     
     //blendshape
     if (hasBlendShape) {